@@ -87,6 +87,7 @@ enum PropertyId {
 	srcY,
 	crtcW,
 	crtcH,
+	fbDamageClips,
 };
 
 struct Property {
@@ -247,6 +248,7 @@ private:
 	std::shared_ptr<Property> _srcYProperty;
 	std::shared_ptr<Property> _crtcWProperty;
 	std::shared_ptr<Property> _crtcHProperty;
+	std::shared_ptr<Property> _fbDamageClipsProperty;
 
 public:
 	id_allocator<uint32_t> allocator;
@@ -285,6 +287,7 @@ public:
 	Property *srcYProperty();
 	Property *crtcWProperty();
 	Property *crtcHProperty();
+	Property *fbDamageClipsProperty();
 };
 
 /**
@@ -559,7 +562,13 @@ protected:
 	~FrameBuffer() = default;
 
 public:
-	virtual void notifyDirty() = 0;
+	/**
+	 * Called when userspace updated (parts of) the framebuffer's contents.
+	 *
+	 * @param clips Damaged rectangles in framebuffer coordinates. If this is empty,
+	 *              the entire framebuffer is damaged.
+	 */
+	virtual void notifyDirty(std::vector<drm_mode_rect> clips) = 0;
 };
 
 struct Plane : ModeObject {
@@ -609,6 +618,8 @@ struct PlaneState {
 	uint32_t src_y;
 	uint32_t src_w;
 	uint32_t src_h;
+	// Array of drm_mode_rect; only valid for the commit that set it.
+	std::shared_ptr<Blob> fbDamageClips;
 };
 
 /**
@@ -708,6 +719,28 @@ drm_mode_modeinfo makeModeInfo(const char *name, uint32_t type,
 void addDmtModes(std::vector<drm_mode_modeinfo> &supported_modes,
 		unsigned int max_width, unsigned max_height);
 
+// ---------------------------------------------
+// Damage tracking
+// ---------------------------------------------
+
+/**
+ * Returns the FB_DAMAGE_CLIPS attached to @p state.
+ *
+ * An empty vector means that the plane's entire framebuffer is damaged.
+ */
+std::vector<drm_mode_rect> getDamageClips(PlaneState *state);
+
+/**
+ * Clips damage rectangles to a @p width x @p height framebuffer and coalesces them.
+ *
+ * Rectangles are merged if their bounding box is not larger than the rectangles themselves,
+ * i.e., if they overlap or touch. If too many rectangles remain, they are replaced by
+ * their bounding box. An empty input is treated as full damage; an empty result means
+ * that nothing needs to be updated.
+ */
+std::vector<drm_mode_rect> mergeDamageClips(std::vector<drm_mode_rect> clips,
+		uint32_t width, uint32_t height);
+
 // Copies 16-byte aligned buffers. Expected to be faster than plain memcpy().
 extern "C" void fastCopy16(void *, const void *, size_t);
 
@@ -1,4 +1,5 @@
 
+#include <algorithm>
 #include <assert.h>
 #include <stdio.h>
 #include <deque>
@@ -252,6 +253,22 @@ drm_core::Device::Device() {
 		};
 	};
 	registerProperty(_crtcHProperty = std::make_shared<CrtcHProperty>());
+
+	struct FbDamageClipsProperty : drm_core::Property {
+		FbDamageClipsProperty()
+		: drm_core::Property{fbDamageClips, drm_core::BlobPropertyType{}, "FB_DAMAGE_CLIPS"} { }
+
+		bool validate(const Assignment& assignment) override {
+			if(!assignment.blobValue)
+				return true;
+			return !(assignment.blobValue->size() % sizeof(drm_mode_rect));
+		};
+
+		void writeToState(const Assignment assignment, std::unique_ptr<AtomicState> &state) override {
+			state->plane(assignment.object->id())->fbDamageClips = assignment.blobValue;
+		}
+	};
+	registerProperty(_fbDamageClipsProperty = std::make_shared<FbDamageClipsProperty>());
 }
 
 void drm_core::Device::setupCrtc(drm_core::Crtc *crtc) {
@@ -398,6 +415,10 @@ drm_core::Property *drm_core::Device::srcYProperty() {
 	return _srcYProperty.get();
 }
 
+drm_core::Property *drm_core::Device::fbDamageClipsProperty() {
+	return _fbDamageClipsProperty.get();
+}
+
 drm_core::Property *drm_core::Device::crtcWProperty() {
 	return _crtcWProperty.get();
 }
@@ -722,6 +743,7 @@ std::vector<drm_core::Assignment> drm_core::Plane::getAssignments(std::shared_pt
 	assignments.push_back(drm_core::Assignment::withInt(this->sharedModeObject(), dev->crtcXProperty(), drmState()->crtc_x));
 	assignments.push_back(drm_core::Assignment::withInt(this->sharedModeObject(), dev->crtcYProperty(), drmState()->crtc_y));
 	assignments.push_back(drm_core::Assignment::withModeObj(this->sharedModeObject(), dev->fbIdProperty(), drmState()->fb));
+	assignments.push_back(drm_core::Assignment::withBlob(this->sharedModeObject(), dev->fbDamageClipsProperty(), nullptr));
 
 	return assignments;
 }
@@ -854,6 +876,8 @@ std::shared_ptr<drm_core::PlaneState> drm_core::AtomicState::plane(uint32_t id)
 		auto plane = _device->findObject(id)->asPlane();
 		assert(plane->drmState());
 		auto plane_state = PlaneState(*plane->drmState());
+		// Damage only applies to the commit that sets it.
+		plane_state.fbDamageClips = nullptr;
 		auto plane_state_shared = std::make_shared<drm_core::PlaneState>(plane_state);
 		_planeStates.insert({id, plane_state_shared});
 		return plane_state_shared;
@@ -1360,7 +1384,11 @@ drm_core::File::ioctl(void *object, managarm::fs::CntRequest req,
 		} else {
 			auto fb = obj->asFrameBuffer();
 			assert(fb);
-			fb->notifyDirty();
+
+			std::vector<drm_mode_rect> clips;
+			for(auto &clip : req.drm_clips())
+				clips.push_back({clip.x1(), clip.y1(), clip.x2(), clip.y2()});
+			fb->notifyDirty(std::move(clips));
 		}
 
 		auto ser = resp.SerializeAsString();
@@ -2297,3 +2325,75 @@ void drm_core::addDmtModes(std::vector<drm_mode_modeinfo> &supported_modes,
 	}
 }
 
+
+// ----------------------------------------------------------------
+// Damage tracking
+// ----------------------------------------------------------------
+
+namespace {
+
+// Beyond this, tracking individual rectangles costs more than it saves.
+constexpr size_t maxDamageClips = 16;
+
+int64_t rectArea(const drm_mode_rect &r) {
+	return int64_t(r.x2 - r.x1) * int64_t(r.y2 - r.y1);
+}
+
+drm_mode_rect boundingRect(const drm_mode_rect &a, const drm_mode_rect &b) {
+	return {std::min(a.x1, b.x1), std::min(a.y1, b.y1),
+			std::max(a.x2, b.x2), std::max(a.y2, b.y2)};
+}
+
+} // anonymous namespace
+
+std::vector<drm_mode_rect> drm_core::getDamageClips(PlaneState *state) {
+	std::vector<drm_mode_rect> clips;
+	if(!state->fbDamageClips)
+		return clips;
+
+	clips.resize(state->fbDamageClips->size() / sizeof(drm_mode_rect));
+	memcpy(clips.data(), state->fbDamageClips->data(), clips.size() * sizeof(drm_mode_rect));
+	return clips;
+}
+
+std::vector<drm_mode_rect> drm_core::mergeDamageClips(std::vector<drm_mode_rect> clips,
+		uint32_t width, uint32_t height) {
+	if(clips.empty())
+		return {{0, 0, static_cast<int32_t>(width), static_cast<int32_t>(height)}};
+
+	std::vector<drm_mode_rect> merged;
+	for(auto clip : clips) {
+		clip.x1 = std::clamp(clip.x1, 0, static_cast<int32_t>(width));
+		clip.y1 = std::clamp(clip.y1, 0, static_cast<int32_t>(height));
+		clip.x2 = std::clamp(clip.x2, 0, static_cast<int32_t>(width));
+		clip.y2 = std::clamp(clip.y2, 0, static_cast<int32_t>(height));
+		if(clip.x1 >= clip.x2 || clip.y1 >= clip.y2)
+			continue;
+
+		// Merge with existing rectangles until there is nothing left to merge.
+		// Each merge can only make the rectangle larger, so this terminates.
+		bool progress = true;
+		while(progress) {
+			progress = false;
+			for(auto it = merged.begin(); it != merged.end(); ++it) {
+				auto box = boundingRect(clip, *it);
+				if(rectArea(box) > rectArea(clip) + rectArea(*it))
+					continue;
+				clip = box;
+				merged.erase(it);
+				progress = true;
+				break;
+			}
+		}
+		merged.push_back(clip);
+	}
+
+	if(merged.size() > maxDamageClips) {
+		auto box = merged.front();
+		for(auto &clip : merged)
+			box = boundingRect(box, clip);
+		merged = {box};
+	}
+
+	return merged;
+}
@@ -3,6 +3,7 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <string.h>
+#include <algorithm>
 #include <vector>
 
 #include <arch/dma_structs.hpp>
@@ -67,10 +68,18 @@ enum {
 	DEVICE_NEEDS_RESET = 64
 };
 
+// Device-independent feature bits.
+enum {
+	VIRTIO_F_INDIRECT_DESC = 28,
+	VIRTIO_F_EVENT_IDX = 29,
+	VIRTIO_F_VERSION_1 = 32
+};
+
 enum {
 	// Bits of the spec::Descriptor::flags field.
 	VIRTQ_DESC_F_NEXT = 1, // descriptor is part of a chain
 	VIRTQ_DESC_F_WRITE = 2, // buffer is written by device
+	VIRTQ_DESC_F_INDIRECT = 4, // buffer contains an indirect descriptor table
 
 	// Bits of the spec::UsedRing::flags field.
 	VIRTQ_USED_F_NO_NOTIFY = 1 // no need to notify the device
@@ -135,6 +144,15 @@ struct QueueInfo {
 	ptrdiff_t notifyOffset;
 };
 
+// Features that are implemented by Queue (instead of by individual drivers).
+// They are negotiated by Transport::finalizeFeatures().
+struct RingFeatures {
+	// VIRTIO_F_INDIRECT_DESC: chains can be stored in an IndirectTable.
+	bool indirect = false;
+	// VIRTIO_F_EVENT_IDX: notifications and interrupts are suppressed via event indices.
+	bool eventIndex = false;
+};
+
 /* This class represents a virtio device.
  * 
  * Usual initialization works as follows:
@@ -165,6 +183,18 @@ struct Transport {
 	virtual Queue *setupQueue(unsigned int index) = 0;
 
 	virtual void runDevice() = 0;
+
+	// Only valid after finalizeFeatures().
+	RingFeatures ringFeatures() {
+		return _ringFeatures;
+	}
+
+protected:
+	// Acknowledges the features in RingFeatures that the device supports.
+	// Called by finalizeFeatures() implementations.
+	void _negotiateRingFeatures();
+
+	RingFeatures _ringFeatures;
 };
 
 struct DeviceSpace {
@@ -215,15 +245,18 @@ struct DeviceToHostType { };
 inline constexpr HostToDeviceType hostToDevice;
 inline constexpr DeviceToHostType deviceToHost;
 
-// Handle to a virtq descriptor.
+// Handle to a virtq descriptor (or to a descriptor of an IndirectTable).
 struct Handle {
 	Handle()
-	: _queue{nullptr}, _tableIndex{0} { }
+	: _table{nullptr}, _tableIndex{0} { }
 
 	Handle(Queue *queue, size_t table_index);
 
+	Handle(spec::Descriptor *table, size_t table_index)
+	: _table{table}, _tableIndex{table_index} { }
+
 	explicit operator bool() {
-		return _queue;
+		return _table;
 	}
 
 	size_t tableIndex() {
@@ -238,10 +271,44 @@ struct Handle {
 	void setupLink(Handle other);
 
 private:
-	Queue *_queue;
+	spec::Descriptor *_table;
 	size_t _tableIndex;
 };
 
+// Descriptor table that is referenced by a single descriptor of a virtq.
+// This allows long chains to consume only a single slot of the virtq.
+// Obtained from Queue::obtainIndirectTable(); it is returned to the Queue
+// once the device returns the descriptor that references it.
+struct IndirectTable {
+	friend struct Queue;
+
+	// Indirect tables occupy a single page.
+	static constexpr size_t maxDescriptors = 0x1000 / sizeof(spec::Descriptor);
+
+	IndirectTable(size_t capacity);
+
+	IndirectTable(const IndirectTable &) = delete;
+
+	IndirectTable &operator= (const IndirectTable &) = delete;
+
+	size_t capacity() {
+		return _capacity;
+	}
+
+	size_t numDescriptors() {
+		return _numDescriptors;
+	}
+
+	// Allocates the next descriptor of the table. The table must not be full.
+	Handle obtainDescriptor();
+
+private:
+	spec::Descriptor *_table;
+	uintptr_t _physical;
+	size_t _capacity;
+	size_t _numDescriptors;
+};
+
 // Helper class to create Handle chains.
 struct Chain {
 	Chain() = default;
@@ -283,6 +350,12 @@ async::result<void> scatterGather(HostToDeviceType, Chain &chain, Queue *queue,
 async::result<void> scatterGather(DeviceToHostType, Chain &chain, Queue *queue,
 		arch::dma_buffer_view view);
 
+// Same as above but obtain descriptors from an indirect table.
+void scatterGather(HostToDeviceType, Chain &chain, IndirectTable *table,
+		arch::dma_buffer_view view);
+void scatterGather(DeviceToHostType, Chain &chain, IndirectTable *table,
+		arch::dma_buffer_view view);
+
 struct Request {
 	void (*complete)(Request *);
 };
@@ -292,7 +365,7 @@ struct Queue {
 	friend struct Handle;
 
 	Queue(unsigned int queue_index, size_t queue_size, spec::Descriptor *table,
-			spec::AvailableRing *available, spec::UsedRing *used);
+			spec::AvailableRing *available, spec::UsedRing *used, RingFeatures features);
 protected:
 	~Queue() = default;
 
@@ -310,6 +383,23 @@ public:
 	// The descriptor is automatically freed when the device returns it.
 	async::result<Handle> obtainDescriptor();
 
+	// Whether IndirectTables can be used with this virtq.
+	bool supportsIndirect() {
+		return _features.indirect;
+	}
+
+	// Maximal number of descriptors in IndirectTables of this virtq.
+	size_t maxIndirectDescriptors() {
+		return std::min(IndirectTable::maxDescriptors, _queueSize);
+	}
+
+	// Allocates an empty IndirectTable. Requires supportsIndirect().
+	IndirectTable *obtainIndirectTable();
+
+	// Makes a descriptor refer to the chain stored in an IndirectTable.
+	// Ownership of the table is transferred to the descriptor.
+	void setupIndirect(Handle descriptor, IndirectTable *table);
+
 	// Posts a descriptor to the virtq's available ring.
 	void postDescriptor(Handle descriptor, Request *request,
 			void (*complete)(Request *));
@@ -341,6 +431,9 @@ protected:
 	virtual void notifyTransport() = 0;
 
 private:
+	// Completes all requests that the device has put into the used ring.
+	void _drainUsedRing();
+
 	// Index of this queue as part of its owning device.
 	unsigned int _queueIndex;
 
@@ -361,8 +454,17 @@ private:
 
 	std::vector<Request *> _activeRequests;
 
+	// IndirectTables referenced by posted descriptors (indexed by descriptor).
+	std::vector<IndirectTable *> _activeIndirectTables;
+	std::vector<IndirectTable *> _freeIndirectTables;
+
 	// Keeps track of which entries in the used ring have already been processed.
 	uint16_t _progressHead;
+
+	RingFeatures _features;
+
+	// Head of the available ring at the time of the last notify().
+	uint16_t _notifiedHead;
 };
 
 } // namespace virtio_core
@@ -154,7 +154,7 @@ void LegacyPciTransport::acknowledgeDriverFeature(unsigned int feature) {
 }
 
 void LegacyPciTransport::finalizeFeatures() {
-	// Does nothing for now.
+	_negotiateRingFeatures();
 }
 
 void LegacyPciTransport::claimQueues(unsigned int max_index) {
@@ -251,7 +251,8 @@ async::detached LegacyPciTransport::_processIrqs() {
 LegacyPciQueue::LegacyPciQueue(LegacyPciTransport *transport,
 		unsigned int queue_index, size_t queue_size,
 		spec::Descriptor *table, spec::AvailableRing *available, spec::UsedRing *used)
-: Queue{queue_index, queue_size, table, available, used}, _transport{transport} { }
+: Queue{queue_index, queue_size, table, available, used, transport->ringFeatures()},
+		_transport{transport} { }
 
 void LegacyPciQueue::notifyTransport() {
 	_transport->_legacySpace.store(PCI_L_QUEUE_NOTIFY, queueIndex());
@@ -371,8 +372,9 @@ void StandardPciTransport::acknowledgeDriverFeature(unsigned int feature) {
 }
 
 void StandardPciTransport::finalizeFeatures() {
-	assert(checkDeviceFeature(32));
-	acknowledgeDriverFeature(32);
+	assert(checkDeviceFeature(VIRTIO_F_VERSION_1));
+	acknowledgeDriverFeature(VIRTIO_F_VERSION_1);
+	_negotiateRingFeatures();
 
 	_commonSpace().store(PCI_DEVICE_STATUS, _commonSpace().load(PCI_DEVICE_STATUS) | FEATURES_OK);
 	auto confirm = _commonSpace().load(PCI_DEVICE_STATUS);
@@ -580,7 +582,7 @@ StandardPciQueue::StandardPciQueue(StandardPciTransport *transport,
 		unsigned int queue_index, size_t queue_size,
 		spec::Descriptor *table, spec::AvailableRing *available, spec::UsedRing *used,
 		arch::scalar_register<uint16_t> notify_register)
-: Queue{queue_index, queue_size, table, available, used},
+: Queue{queue_index, queue_size, table, available, used, transport->ringFeatures()},
 		_transport{transport}, _notifyRegister{notify_register} { }
 
 void StandardPciQueue::notifyTransport() {
@@ -696,12 +698,27 @@ discover(protocols::hw::Device hw_device, DiscoverMode mode) {
 	throw std::runtime_error("Cannot construct a suitable virtio::Transport");
 }
 
+// --------------------------------------------------------
+// Transport
+// --------------------------------------------------------
+
+void Transport::_negotiateRingFeatures() {
+	if(checkDeviceFeature(VIRTIO_F_INDIRECT_DESC)) {
+		acknowledgeDriverFeature(VIRTIO_F_INDIRECT_DESC);
+		_ringFeatures.indirect = true;
+	}
+	if(checkDeviceFeature(VIRTIO_F_EVENT_IDX)) {
+		acknowledgeDriverFeature(VIRTIO_F_EVENT_IDX);
+		_ringFeatures.eventIndex = true;
+	}
+}
+
 // --------------------------------------------------------
 // Handle
 // --------------------------------------------------------
 
 Handle::Handle(Queue *queue, size_t table_index)
-: _queue{queue}, _tableIndex{table_index} { }
+: _table{queue->_table}, _tableIndex{table_index} { }
 
 void Handle::setupBuffer(HostToDeviceType, arch::dma_buffer_view view) {
 	assert(view.size());
@@ -709,7 +726,7 @@ void Handle::setupBuffer(HostToDeviceType, arch::dma_buffer_view view) {
 	uintptr_t physical;
 	HEL_CHECK(helPointerPhysical(view.data(), &physical));
 
-	auto descriptor = _queue->_table + _tableIndex;
+	auto descriptor = _table + _tableIndex;
 	descriptor->address.store(physical);
 	descriptor->length.store(view.size());
 }
@@ -720,14 +737,14 @@ void Handle::setupBuffer(DeviceToHostType, arch::dma_buffer_view view) {
 	uintptr_t physical;
 	HEL_CHECK(helPointerPhysical(view.data(), &physical));
 
-	auto descriptor = _queue->_table + _tableIndex;
+	auto descriptor = _table + _tableIndex;
 	descriptor->address.store(physical);
 	descriptor->length.store(view.size());
 	descriptor->flags.store(descriptor->flags.load() | VIRTQ_DESC_F_WRITE);
 }
 
 void Handle::setupLink(Handle other) {
-	auto descriptor = _queue->_table + _tableIndex;
+	auto descriptor = _table + _tableIndex;
 	descriptor->next.store(other._tableIndex);
 	descriptor->flags.store(descriptor->flags.load() | VIRTQ_DESC_F_NEXT);
 }
@@ -758,13 +775,71 @@ async::result<void> scatterGather(DeviceToHostType, Chain &chain, Queue *queue,
 	}
 }
 
+void scatterGather(HostToDeviceType, Chain &chain, IndirectTable *table,
+		arch::dma_buffer_view view) {
+	constexpr size_t page_size = 0x1000;
+	size_t offset = 0;
+	while(offset < view.size()) {
+		auto address = reinterpret_cast<uintptr_t>(view.data()) + offset;
+		auto chunk = std::min(view.size() - offset, page_size - (address & (page_size - 1)));
+		chain.append(table->obtainDescriptor());
+		chain.setupBuffer(hostToDevice, view.subview(offset, chunk));
+		offset += chunk;
+	}
+}
+
+void scatterGather(DeviceToHostType, Chain &chain, IndirectTable *table,
+		arch::dma_buffer_view view) {
+	constexpr size_t page_size = 0x1000;
+	size_t offset = 0;
+	while(offset < view.size()) {
+		auto address = reinterpret_cast<uintptr_t>(view.data()) + offset;
+		auto chunk = std::min(view.size() - offset, page_size - (address & (page_size - 1)));
+		chain.append(table->obtainDescriptor());
+		chain.setupBuffer(deviceToHost, view.subview(offset, chunk));
+		offset += chunk;
+	}
+}
+
+// --------------------------------------------------------
+// IndirectTable
+// --------------------------------------------------------
+
+IndirectTable::IndirectTable(size_t capacity)
+: _capacity{capacity}, _numDescriptors{0} {
+	assert(capacity <= maxDescriptors);
+
+	HelHandle memory;
+	void *window;
+	HEL_CHECK(helAllocateMemory(0x1000, kHelAllocContinuous, nullptr, &memory));
+	HEL_CHECK(helMapMemory(memory, kHelNullHandle, nullptr,
+			0, 0x1000, kHelMapProtRead | kHelMapProtWrite, &window));
+	HEL_CHECK(helCloseDescriptor(kHelThisUniverse, memory));
+
+	_table = new (window) spec::Descriptor[_capacity];
+	HEL_CHECK(helPointerPhysical(_table, &_physical));
+}
+
+Handle IndirectTable::obtainDescriptor() {
+	assert(_numDescriptors < _capacity);
+	auto table_index = _numDescriptors++;
+
+	auto descriptor = _table + table_index;
+	descriptor->address.store(0);
+	descriptor->length.store(0);
+	descriptor->flags.store(0);
+
+	return Handle{_table, table_index};
+}
+
 // --------------------------------------------------------
 // Queue
 // --------------------------------------------------------
 
 Queue::Queue(unsigned int queue_index, size_t queue_size, spec::Descriptor *table,
-		spec::AvailableRing *available, spec::UsedRing *used)
-: _queueIndex{queue_index}, _queueSize{queue_size}, _progressHead{0} {
+		spec::AvailableRing *available, spec::UsedRing *used, RingFeatures features)
+: _queueIndex{queue_index}, _queueSize{queue_size}, _progressHead{0},
+		_features{features}, _notifiedHead{0} {
 	// Construct the hardware state.
 	_table = new (table) spec::Descriptor[_queueSize];
 	_availableRing = new (available) spec::AvailableRing;
@@ -791,6 +866,7 @@ Queue::Queue(unsigned int queue_index, size_t queue_size, spec::Descriptor *tabl
 	for(size_t i = 0; i < _queueSize; i++)
 		_descriptorStack.push_back(i);
 	_activeRequests.resize(_queueSize);
+	_activeIndirectTables.resize(_queueSize);
 }
 
 async::result<Handle> Queue::obtainDescriptor() {
@@ -812,6 +888,28 @@ async::result<Handle> Queue::obtainDescriptor() {
 	}
 }
 
+IndirectTable *Queue::obtainIndirectTable() {
+	assert(_features.indirect);
+	if(_freeIndirectTables.empty())
+		return new IndirectTable{maxIndirectDescriptors()};
+
+	auto table = _freeIndirectTables.back();
+	_freeIndirectTables.pop_back();
+	return table;
+}
+
+void Queue::setupIndirect(Handle handle, IndirectTable *table) {
+	assert(_features.indirect);
+	assert(table->_numDescriptors);
+	assert(!_activeIndirectTables[handle.tableIndex()]);
+	_activeIndirectTables[handle.tableIndex()] = table;
+
+	auto descriptor = _table + handle.tableIndex();
+	descriptor->address.store(table->_physical);
+	descriptor->length.store(table->_numDescriptors * sizeof(spec::Descriptor));
+	descriptor->flags.store(VIRTQ_DESC_F_INDIRECT);
+}
+
 void Queue::postDescriptor(Handle handle, Request *request,
 		void (*complete)(Request *)) {
 	request->complete = complete;
@@ -829,12 +927,42 @@ void Queue::postDescriptor(Handle handle, Request *request,
 }
 
 void Queue::notify() {
+	if(_features.eventIndex) {
+		// The device's event index must be read after the available head is written.
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+		auto head = _availableRing->headIndex.load();
+		auto event = _usedExtra->eventIndex.load();
+
+		// Only notify if the device asked to be notified about one of the
+		// descriptors that were posted since the last notify().
+		if(static_cast<uint16_t>(head - event - 1) < static_cast<uint16_t>(head - _notifiedHead))
+			notifyTransport();
+		_notifiedHead = head;
+		return;
+	}
+
 	asm volatile ( "" : : : "memory" );
 	if(!(_usedRing->flags.load() & VIRTQ_USED_F_NO_NOTIFY))
 		notifyTransport();
 }
 
 void Queue::processInterrupt() {
+	while(true) {
+		_drainUsedRing();
+		if(!_features.eventIndex)
+			return;
+
+		// Ask for an interrupt once the device uses the next element.
+		_availableExtra->eventIndex.store(_progressHead);
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+		// The device might have used elements before it observed the new event index.
+		if(_progressHead == _usedRing->headIndex.load())
+			return;
+	}
+}
+
+void Queue::_drainUsedRing() {
 	while(true) {
 		auto used_head = _usedRing->headIndex.load();
 
@@ -862,6 +990,13 @@ void Queue::processInterrupt() {
 		_descriptorStack.push_back(chain_index);
 		_descriptorDoorbell.raise();
 
+		// Free the indirect table (if any).
+		if(auto indirect = _activeIndirectTables[table_index]; indirect) {
+			_activeIndirectTables[table_index] = nullptr;
+			indirect->_numDescriptors = 0;
+			_freeIndirectTables.push_back(indirect);
+		}
+
 		// Call the completion handler.
 		request->complete(request);
 
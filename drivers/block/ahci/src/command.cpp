@@ -15,7 +15,7 @@ Command::Command(uint64_t sector, size_t numSectors, size_t numBytes, void *buff
 		CommandType type) : sector_{sector}, numSectors_{numSectors}, numBytes_{numBytes},
 	buffer_{buffer}, type_{type}, event_{} {
 
-	// TODO: Requests larger than 64k need to be split
+	// Larger requests are split by Port::transfer_().
 	assert(numBytes < 65536);
 
 	if (logCommands) {
@@ -33,7 +33,7 @@ void Command::notifyCompletion() {
 	event_.raise();
 }
 
-void Command::prepare(commandTable& table, commandHeader& header) {
+void Command::prepare(commandTable& table, commandHeader& header, int ncqTag) {
 	auto tablePhys = helix::ptrToPhysical(&table);
 	assert(tablePhys < std::numeric_limits<uint32_t>::max() &&
 			numSectors_ < std::numeric_limits<uint16_t>::max());
@@ -63,19 +63,35 @@ void Command::prepare(commandTable& table, commandHeader& header) {
 
 	switch (type_) {
 		case CommandType::read:
-			table.commandFis.command = 0x25; // READ DMA EXT
+			table.commandFis.command = ncqTag >= 0 ? 0x60 // READ FPDMA QUEUED
+					: 0x25; // READ DMA EXT
 			break;
 		case CommandType::write:
-			table.commandFis.command = 0x35; // WRITE DMA EXT
+			table.commandFis.command = ncqTag >= 0 ? 0x61 // WRITE FPDMA QUEUED
+					: 0x35; // WRITE DMA EXT
 			header.configBytes[0] |= 1 << 6; // Indicates we are writing
 			break;
 		case CommandType::identify:
 			table.commandFis.command = 0xEC; // IDENTIFY DEVICE
 			break;
+		case CommandType::readLog:
+			table.commandFis.command = 0x2F; // READ LOG EXT
+			break;
 		default:
 			assert(!"unknown command type");
 	}
 
+	if (ncqTag >= 0) {
+		assert(type_ == CommandType::read || type_ == CommandType::write);
+		assert(ncqTag < 32);
+
+		// FPDMA QUEUED commands carry the sector count in the features field
+		// and the tag in the count field.
+		table.commandFis.features = numSectors_ & 0xFF;
+		table.commandFis.featuresUpper = (numSectors_ >> 8) & 0xFF;
+		table.commandFis.sectorCount = static_cast<uint16_t>(ncqTag << 3);
+	}
+
 	if (logCommands) {
 		printf("block/ahci: submitting %zu byte %s to %p at sector %" PRIu64 "\n",
 				numBytes_, cmdTypeToString(type_), buffer_, sector_);
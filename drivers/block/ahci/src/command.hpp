@@ -7,7 +7,8 @@
 enum class CommandType {
 	read,
 	write,
-	identify
+	identify,
+	readLog
 };
 
 struct Command {
@@ -22,13 +23,27 @@ public:
 		assert(type == CommandType::identify);
 	}
 
-	void prepare(commandTable& table, commandHeader& header);
+	// Reads the NCQ command error log (log address 0x10).
+	Command(ncqErrorLog *buffer, CommandType type)
+		: Command(0x10, 1, sizeof(ncqErrorLog), reinterpret_cast<void *>(buffer), type) {
+		assert(type == CommandType::readLog);
+	}
+
+	// If ncqTag is non-negative, reads and writes are issued as FPDMA QUEUED commands.
+	void prepare(commandTable& table, commandHeader& header, int ncqTag = -1);
 	void notifyCompletion(); 
 
+	// Counts how often the command failed and was re-issued.
+	int numRetries = 0;
+
 	auto getFuture() {
 		return event_.wait();
 	}
 
+	CommandType getType() const {
+		return type_;
+	}
+
 private:
 	size_t writeScatterGather_(commandTable& table);
 
@@ -49,6 +64,8 @@ constexpr const char *cmdTypeToString(CommandType type) {
 			return "write";
 		case CommandType::identify:
 			return "identify";
+		case CommandType::readLog:
+			return "read log";
 		default:
 			assert(!"unknown command type");
 	}
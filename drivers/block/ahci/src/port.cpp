@@ -1,4 +1,7 @@
+#include <algorithm>
 #include <inttypes.h>
+#include <memory>
+#include <vector>
 
 #include <helix/memory.hpp>
 #include <helix/timer.hpp>
@@ -16,6 +19,7 @@ namespace regs {
 	constexpr arch::scalar_register<uint32_t> tfd{0x20};
 	constexpr arch::scalar_register<uint32_t> status{0x28};
 	constexpr arch::scalar_register<uint32_t> sErr{0x30};
+	constexpr arch::scalar_register<uint32_t> sActive{0x34};
 	constexpr arch::scalar_register<uint32_t> commandIssue{0x38};
 }
 
@@ -35,6 +39,7 @@ namespace flags {
 		constexpr int hostDataError   = 1 << 28;
 		constexpr int ifFatalError    = 1 << 27;
 		constexpr int ifNonFatalError = 1 << 26;
+		constexpr int setDeviceBits   = 1 << 3;
 		constexpr int d2hFis          = 1;
 	}
 
@@ -47,12 +52,19 @@ namespace flags {
 namespace {
 	constexpr size_t sectorSize = 512;
 	constexpr bool logCommands  = false;
+	// How often a command that failed with an NCQ error is re-issued.
+	constexpr int maxRetries    = 3;
+	// Commands transfer less than 64 KiB (the PRDT has one entry per page, plus one
+	// for misaligned buffers). Larger transfers are split into multiple commands.
+	constexpr size_t maxCommandSectors = (65536 - 1) / sectorSize;
 }
 
 // TODO: We can use a more appropriate block size, but this breaks other parts of the OS.
-Port::Port(int64_t parentId, int portIndex, size_t numCommandSlots, bool staggeredSpinUp, arch::mem_space regs)
+Port::Port(int64_t parentId, int portIndex, size_t numCommandSlots, bool staggeredSpinUp,
+		bool hbaSupportsNcq, arch::mem_space regs)
 	: BlockDevice{::sectorSize, parentId},  regs_{regs}, numCommandSlots_{numCommandSlots},
-	commandsInFlight_{0}, portIndex_{portIndex}, staggeredSpinUp_{staggeredSpinUp} {
+	queueDepth_{numCommandSlots}, commandsInFlight_{0}, portIndex_{portIndex},
+	staggeredSpinUp_{staggeredSpinUp}, hbaSupportsNcq_{hbaSupportsNcq} {
 
 }
 
@@ -168,6 +180,16 @@ async::detached Port::run() {
 			portIndex_, model.c_str(), logicalSize, physicalSize, sectorCount);
 	assert(logicalSize == 512 && "block/ahci: logical sector size > 512 is not supported");
 
+	// Use native command queueing if both the HBA and the device support it.
+	// NCQ tags are equal to the slot numbers, hence the queue depth also limits the slots.
+	if (hbaSupportsNcq_ && identify->supportsNcq()) {
+		useNcq_ = true;
+		queueDepth_ = std::min(numCommandSlots_, identify->getQueueDepth());
+	}
+
+	printf("block/ahci: Port %d uses %s, queue depth %zu\n", portIndex_,
+			useNcq_ ? "NCQ" : "non-queued commands", queueDepth_);
+
 	// Clear errors
 	regs_.store(regs::sErr, ~0);
 
@@ -177,6 +199,7 @@ async::detached Port::run() {
 	auto ie = regs_.load(regs::interruptEnable);
 	regs_.store(regs::interruptEnable, ie
 			| flags::is::d2hFis
+			| flags::is::setDeviceBits
 			| flags::is::taskFileError
 			| flags::is::hostDataError
 			| flags::is::hostFatalError
@@ -190,7 +213,7 @@ async::detached Port::run() {
 }
 
 async::result<size_t> Port::findFreeSlot_() {
-	while (commandsInFlight_ >= numCommandSlots_) {
+	while (recovering_ || commandsInFlight_ >= queueDepth_) {
 		if (logCommands) {
 			printf("block/ahci: submission queue full, waiting...\n");
 		}
@@ -201,13 +224,13 @@ async::result<size_t> Port::findFreeSlot_() {
 	// We can't look at CI here, as the HBA might clear it before we have
 	// a chance to notify completion, so the array slot will still be occupied.
 	// TODO: We could use a bitmask and CLZ for this.
-	for (size_t i = 0; i < numCommandSlots_; i++) {
+	for (size_t i = 0; i < queueDepth_; i++) {
 		if (!submittedCmds_[i]) {
 			co_return i;
 		}
 	}
 
-	assert(!"commandsInFlight < numCommandSlots, but submission queue was full");
+	assert(!"commandsInFlight < queueDepth, but submission queue was full");
 	co_return 0;
 }
 
@@ -223,15 +246,25 @@ void Port::handleIrq() {
 	}
 
 	if (logCommands) {
-		printf("block/ahci: Port %d handling IRQ: PxIS %x, PxIE %x, TFD %x, CI %x, CAS %x\n",
+		printf("block/ahci: Port %d handling IRQ: PxIS %x, PxIE %x, TFD %x, CI %x, SACT %x, CAS %x\n",
 				portIndex_, is, regs_.load(regs::interruptEnable), regs_.load(regs::tfd),
-				regs_.load(regs::commandIssue), regs_.load(regs::commandAndStatus));
+				regs_.load(regs::commandIssue), regs_.load(regs::sActive),
+				regs_.load(regs::commandAndStatus));
 	}
 
-	// Notify all completed commands
+	// While recovering, the port is stopped and commands are completed by polling.
+	if (recovering_) {
+		regs_.store(regs::interruptStatus, is);
+		return;
+	}
+
+	// Notify all completed commands. Queued commands stay active until the device
+	// clears their PxSACT bit through a Set Device Bits FIS.
 	auto numCompleted = 0;
 	auto cmdActiveMask = regs_.load(regs::commandIssue);
-	for (size_t i = 0; i < numCommandSlots_; i++) {
+	if (useNcq_)
+		cmdActiveMask |= regs_.load(regs::sActive);
+	for (size_t i = 0; i < queueDepth_; i++) {
 		if (submittedCmds_[i] && !(cmdActiveMask & (1 << i))) {
 			Command *cmd = std::exchange(submittedCmds_[i], nullptr);
 			cmd->notifyCompletion();
@@ -242,16 +275,96 @@ void Port::handleIrq() {
 	// If the buffer has gone from full to not full, wake the tasks waiting for a free slot.
 	// TODO: If we have a lot of waiters, this will cause many spurious wakeups. Ideally, we only
 	// notify a certain number of tasks, and the rest can stay asleep.
-	if (commandsInFlight_ == numCommandSlots_ && numCompleted > 0) {
+	if (commandsInFlight_ == queueDepth_ && numCompleted > 0) {
 		freeSlotDoorbell_.raise();
 	}
 
 	commandsInFlight_ -= numCompleted;
 
+	// An NCQ error aborts all outstanding commands. The HBA stops processing
+	// the command list until we restart it (AHCI spec: 6.3.2).
+	if (useNcq_ && (is & flags::is::taskFileError)) {
+		recovering_ = true;
+		recoverFromError_();
+	}
+
 	// Acknowledge the interrupt
 	regs_.store(regs::interruptStatus, is);
 }
 
+async::detached Port::recoverFromError_() {
+	assert(recovering_);
+	printf("block/ahci: Port %d encountered NCQ error, TFD %x, PxSERR %x, PxSACT %x\n",
+			portIndex_, regs_.load(regs::tfd), regs_.load(regs::sErr),
+			regs_.load(regs::sActive));
+
+	// Clearing PxCMD.ST also clears PxCI and PxSACT.
+	auto cas = regs_.load(regs::commandAndStatus);
+	regs_.store(regs::commandAndStatus, cas & ~flags::cmd::start);
+
+	auto success = co_await helix::kindaBusyWait(500'000'000, [&](){
+		return !(regs_.load(regs::commandAndStatus) & flags::cmd::cmdListRunning); });
+	if (!success) {
+		printf("\e[31mblock/ahci: Port %d failed to stop after NCQ error\e[39m\n", portIndex_);
+		abort();
+	}
+
+	regs_.store(regs::sErr, ~0);
+	regs_.store(regs::interruptStatus, regs_.load(regs::interruptStatus));
+
+	// TODO: Issue a COMRESET if the device does not leave the error state by itself.
+	auto tfd = regs_.load(regs::tfd);
+	if ((tfd & flags::tfd::bsy) || (tfd & flags::tfd::drq)) {
+		printf("\e[31mblock/ahci: Port %d is busy after NCQ error, TFD %x\e[39m\n",
+				portIndex_, tfd);
+		abort();
+	}
+
+	cas = regs_.load(regs::commandAndStatus);
+	regs_.store(regs::commandAndStatus, cas | flags::cmd::start);
+
+	// Reading the NCQ command error log clears the error condition on the device.
+	// All slots are idle now, so we can borrow slot 0 and poll for completion.
+	arch::dma_object<ncqErrorLog> errorLog{nullptr};
+	Command logCmd{errorLog.data(), CommandType::readLog};
+	logCmd.prepare(commandTables_[0], commandList_->slots[0]);
+	regs_.store(regs::commandIssue, 1);
+
+	success = co_await helix::kindaBusyWait(500'000'000, [&](){
+		return !(regs_.load(regs::commandIssue) & 1)
+				|| (regs_.load(regs::interruptStatus) & flags::is::taskFileError); });
+	if (!success || (regs_.load(regs::interruptStatus) & flags::is::taskFileError)) {
+		printf("\e[31mblock/ahci: Port %d failed to read NCQ error log, TFD %x\e[39m\n",
+				portIndex_, regs_.load(regs::tfd));
+		abort();
+	}
+	regs_.store(regs::interruptStatus, regs_.load(regs::interruptStatus));
+
+	if (errorLog->isNonQueued()) {
+		printf("block/ahci: Port %d NCQ error log does not name a command\n", portIndex_);
+	} else {
+		auto tag = errorLog->getTag();
+		auto failedCmd = tag < queueDepth_ ? submittedCmds_[tag] : nullptr;
+		printf("block/ahci: Port %d NCQ command %zu (%s) failed, status %x, error %x\n",
+				portIndex_, tag, failedCmd ? cmdTypeToString(failedCmd->getType()) : "none",
+				errorLog->status, errorLog->error);
+		if (failedCmd && ++failedCmd->numRetries > maxRetries) {
+			printf("\e[31mblock/ahci: Port %d giving up on NCQ command %zu\e[39m\n",
+					portIndex_, tag);
+			abort();
+		}
+	}
+
+	// The device aborted all outstanding commands; re-issue them in their old slots.
+	for (size_t i = 0; i < queueDepth_; i++) {
+		if (submittedCmds_[i])
+			issueCommand_(i, submittedCmds_[i]);
+	}
+
+	recovering_ = false;
+	freeSlotDoorbell_.raise();
+}
+
 async::detached Port::submitPendingLoop_() {
 	while (true) {
 		auto cmd =	co_await pendingCmdQueue_.async_get();
@@ -265,29 +378,50 @@ async::result<void> Port::submitCommand_(Command *cmd) {
 	assert(!(regs_.load(regs::commandIssue) & (1 << slot)));
 	assert(!submittedCmds_[slot]);
 
-	// Setup command table and FIS
-	cmd->prepare(commandTables_[slot], commandList_->slots[slot]);
-
-	// Issue command
 	submittedCmds_[slot] = cmd;
 	commandsInFlight_++;
-	regs_.store(regs::commandIssue, 1 << slot);
+	issueCommand_(slot, cmd);
 
 	co_return;
 }
 
+void Port::issueCommand_(size_t slot, Command *cmd) {
+	// Setup command table and FIS; the NCQ tag is the slot number
+	cmd->prepare(commandTables_[slot], commandList_->slots[slot],
+			useNcq_ ? static_cast<int>(slot) : -1);
+
+	// Issue command; PxSACT must be set before PxCI (AHCI spec: 5.3.2.11)
+	if (useNcq_)
+		regs_.store(regs::sActive, 1 << slot);
+	regs_.store(regs::commandIssue, 1 << slot);
+}
+
 async::result<void> Port::readSectors(uint64_t sector, void *buffer, size_t numSectors) {
-	Command cmd{sector, numSectors, numSectors * sectorSize,
-			buffer, CommandType::read};
-	pendingCmdQueue_.put(&cmd);
-	co_await cmd.getFuture();
+	co_await transfer_(sector, buffer, numSectors, CommandType::read);
 }
 
 async::result<void> Port::writeSectors(uint64_t sector, const void *buffer, size_t numSectors) {
-	Command cmd{sector, numSectors, numSectors * sectorSize,
-			const_cast<void *>(buffer), CommandType::write};
-	pendingCmdQueue_.put(&cmd);
-	co_await cmd.getFuture();
+	co_await transfer_(sector, const_cast<void *>(buffer), numSectors, CommandType::write);
+}
+
+size_t Port::maxTransferSize() {
+	return maxCommandSectors * sectorSize;
+}
+
+async::result<void> Port::transfer_(uint64_t sector, void *buffer, size_t numSectors,
+		CommandType type) {
+	// Queue all commands before waiting such that they can be executed concurrently.
+	std::vector<std::unique_ptr<Command>> cmds;
+	for(size_t progress = 0; progress < numSectors; progress += maxCommandSectors) {
+		auto chunk = std::min(numSectors - progress, maxCommandSectors);
+		auto cmd = std::make_unique<Command>(sector + progress, chunk, chunk * sectorSize,
+				static_cast<char *>(buffer) + progress * sectorSize, type);
+		pendingCmdQueue_.put(cmd.get());
+		cmds.push_back(std::move(cmd));
+	}
+
+	for(auto &cmd : cmds)
+		co_await cmd->getFuture();
 }
 
 async::result<size_t> Port::getSize() {
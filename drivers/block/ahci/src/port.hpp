@@ -16,7 +16,7 @@
 class Port : public blockfs::BlockDevice {
 public:
 	Port(int64_t parentId, int index, size_t numCommandSlots, bool staggeredSpinUp,
-			arch::mem_space regs);
+			bool hbaSupportsNcq, arch::mem_space regs);
 
 public:
 	async::result<bool> init();
@@ -26,13 +26,18 @@ public:
 	async::result<void> readSectors(uint64_t sector, void *buf, size_t numSectors) override;
 	async::result<void> writeSectors(uint64_t sector, const void *buf, size_t numSectors) override;
 	async::result<size_t> getSize() override;
+	size_t maxTransferSize() override;
 
 	int getIndex() const { return portIndex_; }
 
 private:
 	async::result<size_t> findFreeSlot_();
 	async::detached submitPendingLoop_();
+	async::result<void> transfer_(uint64_t sector, void *buffer, size_t numSectors,
+			CommandType type);
 	async::result<void> submitCommand_(Command *cmd);
+	void issueCommand_(size_t slot, Command *cmd);
+	async::detached recoverFromError_();
 	void start_();
 	void stop_();
 
@@ -60,7 +65,13 @@ private:
 	async::recurring_event freeSlotDoorbell_;
 
 	size_t numCommandSlots_;
+	// Number of slots that we actually use; limited by the device's NCQ queue depth.
+	size_t queueDepth_;
 	size_t commandsInFlight_;
 	int portIndex_;
 	bool staggeredSpinUp_;
+	bool hbaSupportsNcq_;
+	bool useNcq_ = false;
+	// Set while the port is stopped to recover from an NCQ error.
+	bool recovering_ = false;
 };
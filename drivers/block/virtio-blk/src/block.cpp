@@ -55,9 +55,7 @@ async::result<void> Device::readSectors(uint64_t sector,
 	assert(!((uintptr_t)buffer % 512));
 //	printf("readSectors(%lu, %lu)\n", sector, num_sectors);
 
-	// Limit to ensure that we don't monopolize the device.
-	auto max_sectors = _requestQueue->numDescriptors() / 4;
-	assert(max_sectors >= 1);
+	auto max_sectors = _maxSectorsPerRequest();
 
 	for(size_t progress = 0; progress < num_sectors; progress += max_sectors) {
 		auto request = new UserRequest(false, sector + progress,
@@ -76,9 +74,7 @@ async::result<void> Device::writeSectors(uint64_t sector,
 	assert(!((uintptr_t)buffer % 512));
 //	printf("writeSectors(%lu, %lu)\n", sector, num_sectors);
 
-	// Limit to ensure that we don't monopolize the device.
-	auto max_sectors = _requestQueue->numDescriptors() / 4;
-	assert(max_sectors >= 1);
+	auto max_sectors = _maxSectorsPerRequest();
 
 	for(size_t progress = 0; progress < num_sectors; progress += max_sectors) {
 		auto request = new UserRequest(true, sector + progress,
@@ -106,6 +102,11 @@ async::detached Device::_processRequests() {
 		_pendingQueue.pop();
 		assert(request->numSectors);
 
+		if(_requestQueue->supportsIndirect()) {
+			co_await _submitIndirect(request);
+			continue;
+		}
+
 		// Setup the descriptor for the request header.
 		virtio_core::Chain chain;
 		chain.append(co_await _requestQueue->obtainDescriptor());
@@ -156,4 +157,65 @@ async::detached Device::_processRequests() {
 	}
 }
 
+size_t Device::_maxSectorsPerRequest() {
+	if(_requestQueue->supportsIndirect()) {
+		// Besides the data, the chain contains the header and the status byte.
+		// Data that is not page-aligned needs one more descriptor.
+		return (_requestQueue->maxIndirectDescriptors() - 3) * (0x1000 / 512);
+	}
+
+	// Limit to ensure that we don't monopolize the device.
+	auto max_sectors = _requestQueue->numDescriptors() / 4;
+	assert(max_sectors >= 1);
+	return max_sectors;
+}
+
+// Puts the whole chain into an indirect table such that it occupies a single virtq slot.
+async::result<void> Device::_submitIndirect(UserRequest *request) {
+	auto head = co_await _requestQueue->obtainDescriptor();
+	auto table = _requestQueue->obtainIndirectTable();
+
+	VirtRequest *header = &virtRequestBuffer[head.tableIndex()];
+	if(request->write) {
+		header->type = VIRTIO_BLK_T_OUT;
+	}else{
+		header->type = VIRTIO_BLK_T_IN;
+	}
+	header->reserved = 0;
+	header->sector = request->sector;
+
+	virtio_core::Chain chain;
+	chain.append(table->obtainDescriptor());
+	chain.setupBuffer(virtio_core::hostToDevice, arch::dma_buffer_view{nullptr,
+			header, sizeof(VirtRequest)});
+
+	// Physically contiguous sectors within a page share a descriptor.
+	arch::dma_buffer_view data{nullptr, request->buffer, request->numSectors * 512};
+	if(request->write) {
+		virtio_core::scatterGather(virtio_core::hostToDevice, chain, table, data);
+	}else{
+		virtio_core::scatterGather(virtio_core::deviceToHost, chain, table, data);
+	}
+
+	if(logInitiateRetire)
+		std::cout << "Submitting " << request->numSectors
+				<< " sectors in " << (table->numDescriptors() - 1)
+				<< " indirect descriptors" << std::endl;
+
+	chain.append(table->obtainDescriptor());
+	chain.setupBuffer(virtio_core::deviceToHost, arch::dma_buffer_view{nullptr,
+			&statusBuffer[head.tableIndex()], 1});
+
+	_requestQueue->setupIndirect(head, table);
+	_requestQueue->postDescriptor(head, request,
+			[] (virtio_core::Request *base_request) {
+		auto request = static_cast<UserRequest *>(base_request);
+		if(logInitiateRetire)
+			std::cout << "Retiring " << request->numSectors
+					<< " sectors" << std::endl;
+		request->event.raise();
+	});
+	_requestQueue->notify();
+}
+
 } } // namespace block::virtio
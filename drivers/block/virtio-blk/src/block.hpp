@@ -68,6 +68,11 @@ private:
 	// Submits requests from _pendingQueue to the device.
 	async::detached _processRequests();
 
+	async::result<void> _submitIndirect(UserRequest *request);
+
+	// Maximal size of UserRequests that are passed to the device.
+	size_t _maxSectorsPerRequest();
+
 	std::unique_ptr<virtio_core::Transport> _transport;
 
 	// The single virtq of this device.
@@ -346,7 +346,7 @@ uint32_t GfxDevice::FrameBuffer::getPixelPitch() {
 	return _pixelPitch;
 }
 
-void GfxDevice::FrameBuffer::notifyDirty() {
+void GfxDevice::FrameBuffer::notifyDirty(std::vector<drm_mode_rect>) {
 
 }
 
@@ -1,4 +1,5 @@
 
+#include <algorithm>
 #include <assert.h>
 #include <stdio.h>
 #include <deque>
@@ -140,6 +141,38 @@ std::tuple<std::string, std::string, std::string> GfxDevice::driverInfo() {
 	return {"plainfb_gpu", "plainfb gpu", "0"};
 }
 
+void GfxDevice::_blit(FrameBuffer *fb, const std::vector<drm_mode_rect> &clips) {
+	auto bo = fb->getBufferObject();
+
+	for(auto clip : clips) {
+		if(fb->fastScanout()) {
+			// fastCopy16() operates on 16-byte units, i.e., on groups of 4 pixels.
+			clip.x1 &= ~3;
+			clip.x2 = std::min((clip.x2 + 3) & ~3, static_cast<int32_t>(bo->getWidth()));
+		}
+
+		auto dest = reinterpret_cast<char *>(_fbMapping.get())
+				+ clip.y1 * _screenPitch + clip.x1 * 4;
+		auto src = reinterpret_cast<char *>(bo->accessMapping())
+				+ clip.y1 * fb->getPitch() + clip.x1 * 4;
+		size_t length = (clip.x2 - clip.x1) * 4;
+
+		if(fb->fastScanout()) {
+			for(int32_t k = clip.y1; k < clip.y2; k++) {
+				drm_core::fastCopy16(dest, src, length);
+				dest += _screenPitch;
+				src += fb->getPitch();
+			}
+		}else{
+			for(int32_t k = clip.y1; k < clip.y2; k++) {
+				memcpy(dest, src, length);
+				dest += _screenPitch;
+				src += fb->getPitch();
+			}
+		}
+	}
+}
+
 std::pair<std::shared_ptr<drm_core::BufferObject>, uint32_t>
 GfxDevice::createDumb(uint32_t width, uint32_t height, uint32_t bpp) {
 	HelHandle handle;
@@ -190,13 +223,22 @@ void GfxDevice::Configuration::dispose() {
 }
 
 void GfxDevice::Configuration::commit(std::unique_ptr<drm_core::AtomicState> &state) {
-	_dispatch(state);
+	// Damage clips are only meaningful if we scan out the same FrameBuffer as before.
+	std::vector<drm_mode_rect> clips;
+	auto plane_state = state->plane(_device->_plane->id());
+	auto crtc_state = state->crtc(_device->_theCrtc->id());
+	if(plane_state->fb && plane_state->fb == _device->_plane->drmState()->fb
+			&& crtc_state->mode && _device->_theCrtc->drmState()->mode)
+		clips = drm_core::getDamageClips(plane_state.get());
+
+	_dispatch(state, std::move(clips));
 
 	_device->_theCrtc->setDrmState(state->crtc(_device->_theCrtc->id()));
 	_device->_plane->setDrmState(state->plane(_device->_plane->id()));
 }
 
-async::detached GfxDevice::Configuration::_dispatch(std::unique_ptr<drm_core::AtomicState> &state) {
+async::detached GfxDevice::Configuration::_dispatch(std::unique_ptr<drm_core::AtomicState> &state,
+		std::vector<drm_mode_rect> clips) {
 	auto crtc_state = state->crtc(_device->_theCrtc->id());
 
 	if(crtc_state->mode != nullptr) {
@@ -213,22 +255,8 @@ async::detached GfxDevice::Configuration::_dispatch(std::unique_ptr<drm_core::At
 			auto bo = fb->getBufferObject();
 			assert(bo->getWidth() == _device->_screenWidth);
 			assert(bo->getHeight() == _device->_screenHeight);
-			auto dest = reinterpret_cast<char *>(_device->_fbMapping.get());
-			auto src = reinterpret_cast<char *>(bo->accessMapping());
-
-			if(fb->fastScanout()) {
-				for(unsigned int k = 0; k < bo->getHeight(); k++) {
-					drm_core::fastCopy16(dest, src, bo->getWidth() * 4);
-					dest += _device->_screenPitch;
-					src += fb->getPitch();
-				}
-			}else{
-				for(unsigned int k = 0; k < bo->getHeight(); k++) {
-					memcpy(dest, src, bo->getWidth() * 4);
-					dest += _device->_screenPitch;
-					src += fb->getPitch();
-				}
-			}
+			_device->_blit(fb.get(), drm_core::mergeDamageClips(std::move(clips),
+					bo->getWidth(), bo->getHeight()));
 		}
 	} else {
 		std::cout << "gfx/plainfb: Disable scanout" << std::endl;
@@ -292,9 +320,14 @@ GfxDevice::BufferObject *GfxDevice::FrameBuffer::getBufferObject() {
 	return _bo.get();
 }
 
-void GfxDevice::FrameBuffer::notifyDirty() {
-	// TODO: Re-blit the FrameBuffer if it is currently displayed.
-	std::cout << "gfx/plainfb: notifyDirty() is not implemented correctly" << std::endl;
+void GfxDevice::FrameBuffer::notifyDirty(std::vector<drm_mode_rect> clips) {
+	auto plane_state = _device->_plane->drmState();
+	auto crtc_state = _device->_theCrtc->drmState();
+	if(plane_state->fb.get() != this || !crtc_state->mode)
+		return;
+
+	_device->_blit(this, drm_core::mergeDamageClips(std::move(clips),
+			_bo->getWidth(), _bo->getHeight()));
 }
 
 // ----------------------------------------------------------------
@@ -24,7 +24,8 @@ struct GfxDevice final : drm_core::Device, std::enable_shared_from_this<GfxDevic
 		void commit(std::unique_ptr<drm_core::AtomicState> &state) override;
 
 	private:
-		async::detached _dispatch(std::unique_ptr<drm_core::AtomicState> &state);
+		async::detached _dispatch(std::unique_ptr<drm_core::AtomicState> &state,
+				std::vector<drm_mode_rect> clips);
 
 		GfxDevice *_device;
 	};
@@ -78,7 +79,7 @@ struct GfxDevice final : drm_core::Device, std::enable_shared_from_this<GfxDevic
 		bool fastScanout() { return _fastScanout; }
 
 		GfxDevice::BufferObject *getBufferObject();
-		void notifyDirty() override;
+		void notifyDirty(std::vector<drm_mode_rect> clips) override;
 
 	private:
 		GfxDevice *_device;
@@ -103,6 +104,9 @@ struct GfxDevice final : drm_core::Device, std::enable_shared_from_this<GfxDevic
 	std::tuple<std::string, std::string, std::string> driverInfo() override;
 
 private:
+	// Copies the given (merged) regions of a FrameBuffer to the hardware framebuffer.
+	void _blit(FrameBuffer *fb, const std::vector<drm_mode_rect> &clips);
+
 	protocols::hw::Device _hwDevice;
 	unsigned int _screenWidth;
 	unsigned int _screenHeight;
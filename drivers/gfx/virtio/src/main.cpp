@@ -269,6 +269,8 @@ async::detached GfxDevice::Configuration::_dispatch(std::unique_ptr<drm_core::At
 
 		if(cs->mode == nullptr) {
 			std::cout << "gfx/virtio: Disable scanout" << std::endl;
+			static_pointer_cast<GfxDevice::Plane>(pps->plane)->scanoutFb = nullptr;
+
 			spec::SetScanout scanout;
 			memset(&scanout, 0, sizeof(spec::SetScanout));
 			scanout.header.type = spec::cmd::setScanout;
@@ -288,9 +290,17 @@ async::detached GfxDevice::Configuration::_dispatch(std::unique_ptr<drm_core::At
 
 		if(pps->fb != nullptr) {
 			auto fb = static_pointer_cast<GfxDevice::FrameBuffer>(pps->fb);
+			auto plane = static_pointer_cast<GfxDevice::Plane>(pps->plane);
 
 			co_await fb->getBufferObject()->wait();
 
+			if(plane->scanoutFb == pps->fb && plane->scanoutWidth == pps->src_w
+					&& plane->scanoutHeight == pps->src_h) {
+				co_await fb->_xferAndFlush(drm_core::mergeDamageClips(
+						drm_core::getDamageClips(pps.get()), pps->src_w, pps->src_h));
+				continue;
+			}
+
 			spec::XferToHost2d xfer;
 			memset(&xfer, 0, sizeof(spec::XferToHost2d));
 			xfer.header.type = spec::cmd::xferToHost2d;
@@ -351,6 +361,10 @@ async::detached GfxDevice::Configuration::_dispatch(std::unique_ptr<drm_core::At
 					arch::dma_buffer_view{nullptr, &flush_result, sizeof(spec::Header)});
 			co_await AwaitableRequest{_device->_controlQ, flush_chain.front()};
 			assert(flush_result.type == spec::resp::noData);
+
+			plane->scanoutFb = pps->fb;
+			plane->scanoutWidth = pps->src_w;
+			plane->scanoutHeight = pps->src_h;
 		}
 	}
 
@@ -408,44 +422,49 @@ GfxDevice::BufferObject *GfxDevice::FrameBuffer::getBufferObject() {
 	return _bo.get();
 }
 
-void GfxDevice::FrameBuffer::notifyDirty() {
-	_xferAndFlush();
-}
-
-async::detached GfxDevice::FrameBuffer::_xferAndFlush() {
-	spec::XferToHost2d xfer;
-	memset(&xfer, 0, sizeof(spec::XferToHost2d));
-	xfer.header.type = spec::cmd::xferToHost2d;
-	xfer.rect.x = 0;
-	xfer.rect.y = 0;
-	xfer.rect.width = _bo->getWidth();
-	xfer.rect.height = _bo->getHeight();
-	xfer.resourceId = _bo->hardwareId();
-
-	spec::Header xfer_result;
-	virtio_core::Chain xfer_chain;
-	co_await virtio_core::scatterGather(virtio_core::hostToDevice, xfer_chain, _device->_controlQ,
-		arch::dma_buffer_view{nullptr, &xfer, sizeof(spec::XferToHost2d)});
-	co_await virtio_core::scatterGather(virtio_core::deviceToHost, xfer_chain, _device->_controlQ,
-		arch::dma_buffer_view{nullptr, &xfer_result, sizeof(spec::Header)});
-	co_await AwaitableRequest{_device->_controlQ, xfer_chain.front()};
-
-	spec::ResourceFlush flush;
-	memset(&flush, 0, sizeof(spec::ResourceFlush));
-	flush.header.type = spec::cmd::resourceFlush;
-	flush.rect.x = 0;
-	flush.rect.y = 0;
-	flush.rect.width = _bo->getWidth();
-	flush.rect.height = _bo->getHeight();
-	flush.resourceId = _bo->hardwareId();
-
-	spec::Header flush_result;
-	virtio_core::Chain flush_chain;
-	co_await virtio_core::scatterGather(virtio_core::hostToDevice, flush_chain, _device->_controlQ,
-		arch::dma_buffer_view{nullptr, &flush, sizeof(spec::ResourceFlush)});
-	co_await virtio_core::scatterGather(virtio_core::deviceToHost, flush_chain, _device->_controlQ,
-		arch::dma_buffer_view{nullptr, &flush_result, sizeof(spec::Header)});
-	co_await AwaitableRequest{_device->_controlQ, flush_chain.front()};
+void GfxDevice::FrameBuffer::notifyDirty(std::vector<drm_mode_rect> clips) {
+	async::detach(_xferAndFlush(drm_core::mergeDamageClips(std::move(clips),
+			_bo->getWidth(), _bo->getHeight())));
+}
+
+async::result<void> GfxDevice::FrameBuffer::_xferAndFlush(std::vector<drm_mode_rect> clips) {
+	for(auto &clip : clips) {
+		spec::XferToHost2d xfer;
+		memset(&xfer, 0, sizeof(spec::XferToHost2d));
+		xfer.header.type = spec::cmd::xferToHost2d;
+		xfer.rect.x = clip.x1;
+		xfer.rect.y = clip.y1;
+		xfer.rect.width = clip.x2 - clip.x1;
+		xfer.rect.height = clip.y2 - clip.y1;
+		// Offset into the backing store; the host derives the stride from the resource width.
+		xfer.offset = (uint64_t(clip.y1) * _bo->getWidth() + clip.x1) * 4;
+		xfer.resourceId = _bo->hardwareId();
+
+		spec::Header xfer_result;
+		virtio_core::Chain xfer_chain;
+		co_await virtio_core::scatterGather(virtio_core::hostToDevice, xfer_chain, _device->_controlQ,
+			arch::dma_buffer_view{nullptr, &xfer, sizeof(spec::XferToHost2d)});
+		co_await virtio_core::scatterGather(virtio_core::deviceToHost, xfer_chain, _device->_controlQ,
+			arch::dma_buffer_view{nullptr, &xfer_result, sizeof(spec::Header)});
+		co_await AwaitableRequest{_device->_controlQ, xfer_chain.front()};
+
+		spec::ResourceFlush flush;
+		memset(&flush, 0, sizeof(spec::ResourceFlush));
+		flush.header.type = spec::cmd::resourceFlush;
+		flush.rect.x = clip.x1;
+		flush.rect.y = clip.y1;
+		flush.rect.width = clip.x2 - clip.x1;
+		flush.rect.height = clip.y2 - clip.y1;
+		flush.resourceId = _bo->hardwareId();
+
+		spec::Header flush_result;
+		virtio_core::Chain flush_chain;
+		co_await virtio_core::scatterGather(virtio_core::hostToDevice, flush_chain, _device->_controlQ,
+			arch::dma_buffer_view{nullptr, &flush, sizeof(spec::ResourceFlush)});
+		co_await virtio_core::scatterGather(virtio_core::deviceToHost, flush_chain, _device->_controlQ,
+			arch::dma_buffer_view{nullptr, &flush_result, sizeof(spec::Header)});
+		co_await AwaitableRequest{_device->_controlQ, flush_chain.front()};
+	}
 }
 
 // ----------------------------------------------------------------
@@ -46,6 +46,12 @@ struct GfxDevice final : drm_core::Device, std::enable_shared_from_this<GfxDevic
 
 		int scanoutId();
 
+		// FrameBuffer and size that the scanout was last set up with.
+		// Atomic commits that keep them only need to transfer damaged regions.
+		std::shared_ptr<drm_core::FrameBuffer> scanoutFb;
+		uint32_t scanoutWidth = 0;
+		uint32_t scanoutHeight = 0;
+
 	private:
 		int _scanoutId;
 	};
@@ -100,8 +106,8 @@ struct GfxDevice final : drm_core::Device, std::enable_shared_from_this<GfxDevic
 		FrameBuffer(GfxDevice *device, std::shared_ptr<GfxDevice::BufferObject> bo);
 
 		GfxDevice::BufferObject *getBufferObject();
-		void notifyDirty() override;
-		async::detached _xferAndFlush();
+		void notifyDirty(std::vector<drm_mode_rect> clips) override;
+		async::result<void> _xferAndFlush(std::vector<drm_mode_rect> clips);
 
 	private:
 		std::shared_ptr<GfxDevice::BufferObject> _bo;
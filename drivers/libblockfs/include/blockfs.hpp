@@ -19,6 +19,12 @@ struct BlockDevice {
 
 	virtual async::result<size_t> getSize() = 0;
 
+	// Maximal number of bytes that a single readSectors() or writeSectors() call should transfer.
+	// RequestQueue does not merge requests beyond this size.
+	virtual size_t maxTransferSize() {
+		return SIZE_MAX;
+	}
+
 	size_t size;
 	const size_t sectorSize;
 	const int64_t parentId;
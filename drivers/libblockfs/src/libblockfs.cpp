@@ -14,6 +14,7 @@
 #include <blockfs.hpp>
 #include "gpt.hpp"
 #include "ext2fs.hpp"
+#include "queue.hpp"
 #include "raw.hpp"
 #include "fs.bragi.hpp"
 #include <bragi/helpers-std.hpp>
@@ -157,6 +158,46 @@ async::result<protocols::fs::ReadResult> pread(void *object, int64_t offset, con
 	co_return chunk_size;
 }
 
+// Large reads are sent directly from the page cache (without copying into a buffer first).
+async::result<protocols::fs::ReadViewResult> readView(void *object, const char *,
+		size_t length) {
+	uint64_t start;
+	HEL_CHECK(helGetClock(&start));
+
+	auto self = static_cast<ext2fs::OpenFile *>(object);
+	co_await self->inode->readyJump.wait();
+
+	size_t chunkSize = 0;
+	auto chunkOffset = self->offset;
+	if(self->offset < self->inode->fileSize())
+		chunkSize = std::min(length, self->inode->fileSize() - self->offset);
+	self->offset += chunkSize;
+
+	uint64_t end;
+	HEL_CHECK(helGetClock(&end));
+
+	protocols::ostrace::Event oste{&ostContext, ostReadEvent};
+	oste.withCounter(ostByteCounter, static_cast<int64_t>(length));
+	oste.withCounter(ostTimeCounter, static_cast<int64_t>(end - start));
+	co_await oste.emit();
+
+	co_return protocols::fs::ReadView{helix::BorrowedDescriptor{self->inode->frontalMemory},
+			chunkOffset, chunkSize};
+}
+
+async::result<protocols::fs::ReadViewResult> preadView(void *object, int64_t offset,
+		const char *, size_t length) {
+	auto self = static_cast<ext2fs::OpenFile *>(object);
+	co_await self->inode->readyJump.wait();
+
+	size_t chunkSize = 0;
+	if(static_cast<uint64_t>(offset) < self->inode->fileSize())
+		chunkSize = std::min(length, self->inode->fileSize() - offset);
+
+	co_return protocols::fs::ReadView{helix::BorrowedDescriptor{self->inode->frontalMemory},
+			static_cast<uint64_t>(offset), chunkSize};
+}
+
 async::result<frg::expected<protocols::fs::Error, size_t>> write(void *object, const char *,
 		const void *buffer, size_t length) {
 	if(!length) {
@@ -220,6 +261,8 @@ constexpr protocols::fs::FileOperations fileOperations {
 	.seekEof      = &seekEof,
 	.read         = &read,
 	.pread        = &pread,
+	.readView     = &readView,
+	.preadView    = &preadView,
 	.write        = &write,
 	.pwrite       = &pwrite,
 	.readEntries  = &readEntries,
@@ -757,7 +800,11 @@ async::detached runDevice(BlockDevice *device) {
 	ostByteCounter = co_await ostContext.announceItem("numBytes");
 	ostTimeCounter = co_await ostContext.announceItem("time");
 
-	table = new gpt::Table(device);
+	// All I/O goes through the request queue such that adjacent requests are merged.
+	auto queue = new RequestQueue(device);
+	co_await queue->setupTracing(&ostContext);
+
+	table = new gpt::Table(queue);
 	co_await table->parse();
 
 	int64_t diskId = 0;
@@ -0,0 +1,182 @@
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+#include <helix/ipc.hpp>
+
+#include "queue.hpp"
+
+namespace blockfs {
+
+RequestQueue::RequestQueue(BlockDevice *device)
+: BlockDevice{device->sectorSize, device->parentId}, _device{device} {
+	_run();
+}
+
+async::result<void> RequestQueue::setupTracing(protocols::ostrace::Context *context) {
+	_ostCommandEvent = co_await context->announceEvent("libblockfs.command");
+	_ostByteCounter = co_await context->announceItem("numBytes");
+	_ostTimeCounter = co_await context->announceItem("time");
+	_ostMergeCounter = co_await context->announceItem("numRequests");
+	_ostDepthCounter = co_await context->announceItem("queueDepth");
+	_ostContext = context;
+}
+
+async::result<void> RequestQueue::readSectors(uint64_t sector, void *buffer,
+		size_t num_sectors) {
+	Request req{false, sector, num_sectors, buffer};
+	co_await _submit(&req);
+}
+
+async::result<void> RequestQueue::writeSectors(uint64_t sector, const void *buffer,
+		size_t num_sectors) {
+	Request req{true, sector, num_sectors, const_cast<void *>(buffer)};
+	co_await _submit(&req);
+}
+
+async::result<size_t> RequestQueue::getSize() {
+	return _device->getSize();
+}
+
+size_t RequestQueue::maxTransferSize() {
+	return _device->maxTransferSize();
+}
+
+async::result<void> RequestQueue::_submit(Request *req) {
+	HEL_CHECK(helGetClock(&req->submitTime));
+	_pending.push_back(req);
+
+	_stats.numRequests++;
+	_stats.queueDepth = _pending.size();
+	_stats.maxQueueDepth = std::max(_stats.maxQueueDepth, _stats.queueDepth);
+	_doorbell.raise();
+
+	co_await req->done.wait();
+}
+
+std::vector<RequestQueue::Request *> RequestQueue::_takeBatch() {
+	assert(!_pending.empty());
+	std::stable_sort(_pending.begin(), _pending.end(), [] (Request *a, Request *b) {
+		return a->sector < b->sector;
+	});
+
+	// Continue in ascending order from the previous batch; wrap around at the end.
+	auto first = std::find_if(_pending.begin(), _pending.end(), [&] (Request *req) {
+		return req->sector >= _headSector;
+	});
+	if(first == _pending.end())
+		first = _pending.begin();
+
+	// Merge subsequent requests of the same direction that start where the batch ends.
+	auto maxBytes = std::min(maxMergeBytes, _device->maxTransferSize());
+	auto maxSectors = std::max(maxBytes / sectorSize, (*first)->numSectors);
+	auto end = (*first)->sector + (*first)->numSectors;
+	auto numSectors = (*first)->numSectors;
+	auto last = first + 1;
+	while(last != _pending.end()
+			&& (*last)->isWrite == (*first)->isWrite
+			&& (*last)->sector == end
+			&& numSectors + (*last)->numSectors <= maxSectors) {
+		end += (*last)->numSectors;
+		numSectors += (*last)->numSectors;
+		++last;
+	}
+
+	std::vector<Request *> batch{first, last};
+	_pending.erase(first, last);
+	_headSector = end;
+	_stats.queueDepth = _pending.size();
+	return batch;
+}
+
+async::detached RequestQueue::_run() {
+	while(true) {
+		if(_pending.empty()) {
+			co_await _doorbell.async_wait();
+			continue;
+		}
+
+		// Plug the queue for one round of the dispatcher. This allows coroutines that
+		// become ready at the same time (e.g., read-ahead) to submit adjacent requests.
+		auto nop = co_await helix_ng::asyncNop();
+		HEL_CHECK(nop.error());
+
+		while(!_pending.empty()) {
+			if(_stats.inFlight >= maxInFlight) {
+				co_await _doorbell.async_wait();
+				continue;
+			}
+			_stats.inFlight++;
+			_issue(_takeBatch());
+		}
+	}
+}
+
+async::detached RequestQueue::_issue(std::vector<Request *> batch) {
+	auto head = batch.front();
+	size_t numSectors = 0;
+	for(auto req : batch)
+		numSectors += req->numSectors;
+	auto depth = _stats.queueDepth + _stats.inFlight;
+
+	uint64_t start;
+	HEL_CHECK(helGetClock(&start));
+
+	if(batch.size() == 1) {
+		if(head->isWrite) {
+			co_await _device->writeSectors(head->sector, head->buffer, numSectors);
+		}else{
+			co_await _device->readSectors(head->sector, head->buffer, numSectors);
+		}
+	}else{
+		// Drivers require sector-aligned buffers.
+		auto length = numSectors * sectorSize;
+		auto bounce = static_cast<char *>(aligned_alloc(0x1000, (length + 0xFFF) & ~size_t(0xFFF)));
+		assert(bounce);
+
+		if(head->isWrite) {
+			size_t offset = 0;
+			for(auto req : batch) {
+				memcpy(bounce + offset, req->buffer, req->numSectors * sectorSize);
+				offset += req->numSectors * sectorSize;
+			}
+			co_await _device->writeSectors(head->sector, bounce, numSectors);
+		}else{
+			co_await _device->readSectors(head->sector, bounce, numSectors);
+			size_t offset = 0;
+			for(auto req : batch) {
+				memcpy(req->buffer, bounce + offset, req->numSectors * sectorSize);
+				offset += req->numSectors * sectorSize;
+			}
+		}
+
+		free(bounce);
+		_stats.numMerges += batch.size() - 1;
+	}
+
+	uint64_t end;
+	HEL_CHECK(helGetClock(&end));
+
+	_stats.numCommands++;
+	for(auto req : batch) {
+		auto latency = end - req->submitTime;
+		_stats.totalLatency += latency;
+		_stats.maxLatency = std::max(_stats.maxLatency, latency);
+		// Requests live on the stack of their submitter. Do not touch them after this.
+		req->done.raise();
+	}
+
+	_stats.inFlight--;
+	_doorbell.raise();
+
+	if(_ostContext) {
+		protocols::ostrace::Event oste{_ostContext, _ostCommandEvent};
+		oste.withCounter(_ostByteCounter, static_cast<int64_t>(numSectors * sectorSize));
+		oste.withCounter(_ostTimeCounter, static_cast<int64_t>(end - start));
+		oste.withCounter(_ostMergeCounter, static_cast<int64_t>(batch.size()));
+		oste.withCounter(_ostDepthCounter, static_cast<int64_t>(depth));
+		co_await oste.emit();
+	}
+}
+
+} // namespace blockfs
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <vector>
+
+#include <async/oneshot-event.hpp>
+#include <async/recurring-event.hpp>
+#include <async/result.hpp>
+#include <protocols/ostrace/ostrace.hpp>
+#include <blockfs.hpp>
+
+namespace blockfs {
+
+// Queues requests to a BlockDevice, merges requests to adjacent sectors into
+// single device commands and bounds the number of commands in flight.
+// The RequestQueue itself is a BlockDevice that forwards to the driver's device.
+//
+// As before, there is no ordering guarantee between concurrent requests.
+struct RequestQueue final : BlockDevice {
+	// Maximal number of device commands that are issued concurrently.
+	static constexpr unsigned int maxInFlight = 16;
+	// Merged commands do not grow beyond this size.
+	static constexpr size_t maxMergeBytes = 256 * 1024;
+
+	struct Stats {
+		uint64_t numRequests = 0;
+		// Number of requests that were merged into the command of another request.
+		uint64_t numMerges = 0;
+		uint64_t numCommands = 0;
+		// Requests that are queued but not yet issued.
+		unsigned int queueDepth = 0;
+		unsigned int maxQueueDepth = 0;
+		unsigned int inFlight = 0;
+		// Time from submission to completion of requests, in nanoseconds.
+		uint64_t totalLatency = 0;
+		uint64_t maxLatency = 0;
+	};
+
+	RequestQueue(BlockDevice *device);
+
+	// Announces the ostrace event that is emitted for each device command.
+	async::result<void> setupTracing(protocols::ostrace::Context *context);
+
+	async::result<void> readSectors(uint64_t sector, void *buffer,
+			size_t num_sectors) override;
+
+	async::result<void> writeSectors(uint64_t sector, const void *buffer,
+			size_t num_sectors) override;
+
+	async::result<size_t> getSize() override;
+
+	size_t maxTransferSize() override;
+
+	const Stats &stats() {
+		return _stats;
+	}
+
+private:
+	struct Request {
+		bool isWrite;
+		uint64_t sector;
+		size_t numSectors;
+		void *buffer;
+		uint64_t submitTime = 0;
+		async::oneshot_event done;
+	};
+
+	async::result<void> _submit(Request *req);
+
+	std::vector<Request *> _takeBatch();
+
+	async::detached _run();
+	async::detached _issue(std::vector<Request *> batch);
+
+	BlockDevice *_device;
+
+	// Requests that are not yet issued. Sorted by sector when a batch is taken.
+	std::vector<Request *> _pending;
+	// Raised when requests are queued or when a command completes.
+	async::recurring_event _doorbell;
+	// Position of the previous batch. Batches are taken in ascending sector order.
+	uint64_t _headSector = 0;
+
+	Stats _stats;
+
+	protocols::ostrace::Context *_ostContext = nullptr;
+	protocols::ostrace::EventId _ostCommandEvent;
+	protocols::ostrace::ItemId _ostByteCounter;
+	protocols::ostrace::ItemId _ostTimeCounter;
+	protocols::ostrace::ItemId _ostMergeCounter;
+	protocols::ostrace::ItemId _ostDepthCounter;
+};
+
+} // namespace blockfs
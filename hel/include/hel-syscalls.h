@@ -85,6 +85,11 @@ extern inline __attribute__ (( always_inline )) HelError helResizeMemory(HelHand
 	return error;
 };
 
+extern inline __attribute__ (( always_inline )) HelError helDecommitMemory(HelHandle handle,
+		uintptr_t offset, size_t size) {
+	return helSyscall3(kHelCallDecommitMemory, (HelWord)handle, (HelWord)offset, (HelWord)size);
+};
+
 extern inline __attribute__ (( always_inline )) HelError helCreateManagedMemory(size_t size,
 		uint32_t flags, HelHandle *backing_handle, HelHandle *frontal_handle) {
 	HelWord back_handle;
@@ -214,6 +219,11 @@ extern inline __attribute__ (( always_inline )) HelError helSubmitSynchronizeSpa
 			(HelWord)queue, (HelWord)context);
 };
 
+extern inline __attribute__ (( always_inline )) HelError helSetSpaceName(HelHandle space,
+		const char *name, size_t length) {
+	return helSyscall3(kHelCallSetSpaceName, (HelWord)space, (HelWord)name, (HelWord)length);
+};
+
 extern inline __attribute__ (( always_inline )) HelError helPointerPhysical(const void *pointer, 
 		uintptr_t *physical) {
 	HelWord handle_word;
@@ -283,6 +293,16 @@ extern inline __attribute__ (( always_inline )) HelError helQueryThreadStats(Hel
 	return helSyscall2(kHelCallQueryThreadStats, (HelWord)handle, (HelWord)stats);
 };
 
+extern inline __attribute__ (( always_inline )) HelError helQueryCpuStats(int cpu,
+		struct HelCpuStats *stats) {
+	return helSyscall2(kHelCallQueryCpuStats, (HelWord)cpu, (HelWord)stats);
+};
+
+extern inline __attribute__ (( always_inline )) HelError helQueryNumaNodeStats(int node,
+		struct HelNumaNodeStats *stats) {
+	return helSyscall2(kHelCallQueryNumaNodeStats, (HelWord)node, (HelWord)stats);
+};
+
 extern inline __attribute__ (( always_inline )) HelError helYield() {
 	return helSyscall0(kHelCallYield);
 };
@@ -292,6 +312,16 @@ extern inline __attribute__ (( always_inline )) HelError helSetPriority(HelHandl
 	return helSyscall2(kHelCallSetPriority, (HelWord)handle, (HelWord)priority);
 };
 
+extern inline __attribute__ (( always_inline )) HelError helSetSchedParams(HelHandle handle,
+		const struct HelSchedParams *params) {
+	return helSyscall2(kHelCallSetSchedParams, (HelWord)handle, (HelWord)params);
+};
+
+extern inline __attribute__ (( always_inline )) HelError helGetSchedParams(HelHandle handle,
+		struct HelSchedParams *params) {
+	return helSyscall2(kHelCallGetSchedParams, (HelWord)handle, (HelWord)params);
+};
+
 extern inline __attribute__ (( always_inline )) HelError helSubmitObserve(HelHandle handle,
 		uint64_t in_seq, HelHandle queue, uintptr_t context) {
 	return helSyscall4(kHelCallSubmitObserve, (HelWord)handle, (HelWord)in_seq,
@@ -361,6 +391,26 @@ extern inline __attribute__ (( always_inline )) HelError helShutdownLane(HelHand
 	return helSyscall1(kHelCallShutdownLane, (HelWord)handle);
 };
 
+extern inline __attribute__ (( always_inline )) HelError helSyncCall(HelHandle handle,
+		const void *request, size_t requestLength, void *reply, size_t maxReplyLength,
+		size_t *replyLength) {
+	HelWord length;
+	HelError error = helSyscall5_1(kHelCallSyncCall, (HelWord)handle, (HelWord)request,
+			(HelWord)requestLength, (HelWord)reply, (HelWord)maxReplyLength, &length);
+	*replyLength = (size_t)length;
+	return error;
+};
+
+extern inline __attribute__ (( always_inline )) HelError helSyncReplyAndWait(HelHandle handle,
+		const void *reply, size_t replyLength, void *request, size_t maxRequestLength,
+		size_t *requestLength) {
+	HelWord length;
+	HelError error = helSyscall5_1(kHelCallSyncReplyAndWait, (HelWord)handle, (HelWord)reply,
+			(HelWord)replyLength, (HelWord)request, (HelWord)maxRequestLength, &length);
+	*requestLength = (size_t)length;
+	return error;
+};
+
 extern inline __attribute__ (( always_inline )) HelError helFutexWait(int *pointer,
 		int expected, int64_t deadline) {
 	return helSyscall3(kHelCallFutexWait, (HelWord)pointer, (HelWord)expected,
@@ -16,7 +16,7 @@
 
 enum {
 	// largest system call number plus 1
-	kHelNumCalls = 103,
+	kHelNumCalls = 111,
 
 	kHelCallLog = 1,
 	kHelCallPanic = 10,
@@ -35,6 +35,7 @@ enum {
 
 	kHelCallAllocateMemory = 51,
 	kHelCallResizeMemory = 83,
+	kHelCallDecommitMemory = 110,
 	kHelCallCreateManagedMemory = 64,
 	kHelCallCopyOnWrite = 39,
 	kHelCallAccessPhysical = 30,
@@ -56,10 +57,15 @@ enum {
 	kHelCallSubmitLockMemoryView = 48,
 	kHelCallLoadahead = 49,
 	kHelCallCreateVirtualizedSpace = 50,
+	kHelCallSetSpaceName = 109,
 
 	kHelCallCreateThread = 67,
 	kHelCallQueryThreadStats = 95,
+	kHelCallQueryCpuStats = 103,
+	kHelCallQueryNumaNodeStats = 108,
 	kHelCallSetPriority = 85,
+	kHelCallSetSchedParams = 104,
+	kHelCallGetSchedParams = 105,
 	kHelCallYield = 34,
 	kHelCallSubmitObserve = 74,
 	kHelCallKillThread = 87,
@@ -78,6 +84,8 @@ enum {
 	kHelCallCreateStream = 68,
 	kHelCallSubmitAsync = 79,
 	kHelCallShutdownLane = 91,
+	kHelCallSyncCall = 106,
+	kHelCallSyncReplyAndWait = 107,
 
 	kHelCallFutexWait = 73,
 	kHelCallFutexWake = 71,
@@ -122,6 +130,7 @@ enum {
 	kHelErrRemoteFault = 21,
 	kHelErrNoHardwareSupport = 16,
 	kHelErrNoMemory = 17,
+	kHelErrNoBandwidth = 22,
 };
 
 struct HelX86SegmentRegister {
@@ -242,6 +251,7 @@ struct HelDescriptorInfo {
 enum HelAllocFlags {
 	kHelAllocContinuous = 4,
 	kHelAllocOnDemand = 1,
+	kHelAllocDecommittable = 8,
 };
 
 struct HelAllocRestrictions {
@@ -530,6 +540,32 @@ struct HelThreadStats {
 	uint64_t userTime;
 };
 
+enum HelSchedPolicy {
+	kHelSchedFair = 0,
+	kHelSchedFifo = 1,
+	kHelSchedRoundRobin = 2,
+	kHelSchedDeadline = 3
+};
+
+struct HelSchedParams {
+	int policy;
+	int priority;
+	uint64_t runtime;
+	uint64_t deadline;
+	uint64_t period;
+};
+
+struct HelCpuStats {
+	uint64_t timerIrqs;
+	uint64_t neededTimerIrqs;
+	int numaNode;
+};
+
+struct HelNumaNodeStats {
+	uint64_t freeMemory;
+	uint64_t usedMemory;
+};
+
 enum {
   khelVmexitHlt = 0,
   khelVmexitTranslationFault = 1,
@@ -647,6 +683,20 @@ HEL_C_LINKAGE HelError helAllocateMemory(size_t size, uint32_t flags,
 //!    	New size in bytes.
 HEL_C_LINKAGE HelError helResizeMemory(HelHandle handle, size_t newSize);
 
+//! Releases the physical memory that backs a range of a memory object.
+//!
+//!    Afterwards, the range reads back as zeros.
+//!    The memory object must have been allocated with ::kHelAllocDecommittable.
+//! @param[in] handle
+//!    	Handle to the memory object.
+//! @param[in] offset
+//!    	Offset of the range in bytes.
+//!    	Must be aligned to the system's page size.
+//! @param[in] size
+//!    	Size of the range in bytes.
+//!    	Must be aligned to the system's page size.
+HEL_C_LINKAGE HelError helDecommitMemory(HelHandle handle, uintptr_t offset, size_t size);
+
 //! Creates a memory object that is managed by userspace.
 //!
 //!    The @p backingHandle is used to manage the memory object, while
@@ -786,6 +836,20 @@ HEL_C_LINKAGE HelError helSubmitSynchronizeSpace(HelHandle spaceHandle,
 //!    	Must be aligned to the system's page size.
 HEL_C_LINKAGE HelError helUnmapMemory(HelHandle spaceHandle, void *pointer, size_t size);
 
+//! Names an address space in kernel profiles.
+//!
+//! Analysis tools use the name to find the binary that user space samples
+//! in @p spaceHandle belong to. Spaces that are not named are only identified
+//! by a number. Only the first 64 bytes of the name are retained.
+//! This is a no-op if kernel profiling is disabled.
+//! @param[in] spaceHandle
+//!     Handle to the address space that is named.
+//! @param[in] name
+//!     Name of the space, usually the path of the executable.
+//! @param[in] length
+//!     Length of @p name in bytes.
+HEL_C_LINKAGE HelError helSetSpaceName(HelHandle spaceHandle, const char *name, size_t length);
+
 HEL_C_LINKAGE HelError helPointerPhysical(const void *pointer, uintptr_t *physical);
 
 //! Load memory (i.e., bytes) from a descriptor.
@@ -870,6 +934,25 @@ HEL_C_LINKAGE HelError helCreateThread(HelHandle universe, HelHandle spaceHandle
 //!     Statistics related to the thread.
 HEL_C_LINKAGE HelError helQueryThreadStats(HelHandle handle, struct HelThreadStats *stats);
 
+//! Query run-time statistics of a CPU.
+//!
+//! The statistics include the number of timer IRQs that the CPU took
+//! and the number of those IRQs that actually expired a deadline.
+//! @param[in] cpu
+//!     Index of the CPU.
+//! @param[out] stats
+//!     Statistics related to the CPU.
+HEL_C_LINKAGE HelError helQueryCpuStats(int cpu, struct HelCpuStats *stats);
+
+//! Query the physical memory usage of a NUMA node.
+//!
+//! Systems without NUMA information have a single node (node 0).
+//! @param[in] node
+//!     Index of the NUMA node.
+//! @param[out] stats
+//!     Free and used physical memory (in bytes) of the node.
+HEL_C_LINKAGE HelError helQueryNumaNodeStats(int node, struct HelNumaNodeStats *stats);
+
 //! Set the priority of a thread.
 //!
 //! Managarm always runs the runnable thread with highest priority.
@@ -880,6 +963,31 @@ HEL_C_LINKAGE HelError helQueryThreadStats(HelHandle handle, struct HelThreadSta
 //!     New priority value of the thread.
 HEL_C_LINKAGE HelError helSetPriority(HelHandle handle, int priority);
 
+//! Set the scheduling policy and parameters of a thread.
+//!
+//! Threads of the deadline policy preempt threads of the real-time policies
+//! (FIFO and round-robin), which in turn preempt threads of the fair policy.
+//! Real-time threads use priorities between 1 and 99.
+//! Deadline threads receive @p runtime ns of CPU time in each @p period ns,
+//! available before @p deadline ns after the start of the period;
+//! they are subject to admission control.
+//! In contrast to ::helSetPriority, this can be used on threads that are not running.
+//! @param[in] handle
+//!     Handle to the thread.
+//! @param[in] params
+//!     New scheduling parameters of the thread.
+//! @return
+//!     ::kHelErrNoBandwidth if the deadline policy is requested but
+//!     the system does not have enough CPU bandwidth left.
+HEL_C_LINKAGE HelError helSetSchedParams(HelHandle handle, const struct HelSchedParams *params);
+
+//! Query the scheduling policy and parameters of a thread.
+//! @param[in] handle
+//!     Handle to the thread.
+//! @param[out] params
+//!     Scheduling parameters of the thread.
+HEL_C_LINKAGE HelError helGetSchedParams(HelHandle handle, struct HelSchedParams *params);
+
 //! Yields the current thread.
 HEL_C_LINKAGE HelError helYield();
 
@@ -996,6 +1104,48 @@ HEL_C_LINKAGE HelError helSubmitAsync(HelHandle handle, const struct HelAction *
 
 HEL_C_LINKAGE HelError helShutdownLane(HelHandle handle);
 
+//! Maximal size of messages passed by ::helSyncCall and ::helSyncReplyAndWait.
+#define kHelSyncMessageSize 128
+
+//! Synchronously sends a request on a lane and waits for the reply.
+//!
+//! The request is delivered to the thread that waits in ::helSyncReplyAndWait
+//! on the other lane of the stream. If that thread is blocked on the same CPU,
+//! the kernel switches to it directly.
+//! @param[in] handle
+//!     Handle to the lane that the request is sent to.
+//! @param[in] request
+//!     Pointer to the request.
+//! @param[in] requestLength
+//!     Length of the request (at most ::kHelSyncMessageSize).
+//! @param[out] reply
+//!     Buffer that receives the reply.
+//! @param[in] maxReplyLength
+//!     Size of @p reply.
+//! @param[out] replyLength
+//!     Length of the reply.
+HEL_C_LINKAGE HelError helSyncCall(HelHandle handle, const void *request, size_t requestLength,
+		void *reply, size_t maxReplyLength, size_t *replyLength);
+
+//! Replies to the last request received on a lane and waits for the next request.
+//!
+//! At most one thread can wait on each lane.
+//! @param[in] handle
+//!     Handle to the lane that requests are received from.
+//! @param[in] reply
+//!     Pointer to the reply. If this is NULL, no reply is sent
+//!     (e.g., when waiting for the first request).
+//! @param[in] replyLength
+//!     Length of the reply (at most ::kHelSyncMessageSize).
+//! @param[out] request
+//!     Buffer that receives the next request.
+//! @param[in] maxRequestLength
+//!     Size of @p request.
+//! @param[out] requestLength
+//!     Length of the request.
+HEL_C_LINKAGE HelError helSyncReplyAndWait(HelHandle handle, const void *reply, size_t replyLength,
+		void *request, size_t maxRequestLength, size_t *requestLength);
+
 //! @}
 //! @name Inter-Thread Synchronization
 //! @{
@@ -1116,6 +1266,8 @@ extern inline __attribute__ (( always_inline )) const char *_helErrorString(HelE
 		return "Missing hardware support for this feature";
 	case kHelErrNoMemory:
 		return "Out of memory";
+	case kHelErrNoBandwidth:
+		return "Insufficient CPU bandwidth";
 	case kHelErrTransmissionMismatch:
 		return "Transmission mismatch";
 	case kHelErrCancelled:
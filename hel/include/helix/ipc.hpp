@@ -1,6 +1,7 @@
 #pragma once
 
 #include <assert.h>
+#include <algorithm>
 #include <atomic>
 #include <initializer_list>
 #include <list>
@@ -154,6 +155,15 @@ struct CurrentDispatcherToken {
 
 inline constexpr CurrentDispatcherToken currentDispatcher;
 
+// Hint to the CPU that we are busy-waiting.
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#elif defined(__aarch64__)
+	asm volatile ("yield");
+#endif
+}
+
 struct Dispatcher {
 	friend struct ElementHandle;
 
@@ -174,11 +184,15 @@ private:
 public:
 	static constexpr int sizeShift = 9;
 
+	// Lower bound of the adaptive spin budget (if spinning is enabled at all).
+	static constexpr unsigned int minSpinBudget = 16;
+
 	static Dispatcher &global();
 
 	Dispatcher()
 	: _handle{kHelNullHandle}, _queue{nullptr},
-			_activeChunks{0}, _retrieveIndex{0}, _nextIndex{0}, _lastProgress{0} { }
+			_activeChunks{0}, _retrieveIndex{0}, _nextIndex{0}, _lastProgress{0},
+			_spinLimit{0}, _spinBudget{0} { }
 
 	Dispatcher(const Dispatcher &) = delete;
 
@@ -211,6 +225,15 @@ public:
 		return _handle;
 	}
 
+	// Before blocking in the kernel, wait() polls the queue for up to limit iterations.
+	// The actual number of iterations adapts to how often polling succeeds.
+	// A limit of zero (the default) disables polling. Spinning only pays off if
+	// completions arrive at a high rate, e.g., on busy servers with multiple workers.
+	void setSpinLimit(unsigned int limit) {
+		_spinLimit = limit;
+		_spinBudget = limit;
+	}
+
 	void wait() {
 		while(true) {
 			// TODO: Initialize all chunks when setting up the queue.
@@ -307,6 +330,10 @@ private:
 		while(true) {
 			auto futex = __atomic_load_n(&_retrieveChunk()->progressFutex, __ATOMIC_ACQUIRE);
 			assert(!(futex & ~(kHelProgressMask | kHelProgressWaiters | kHelProgressDone)));
+			if(_spinBudget && !_hasProgress(futex)) {
+				_spin();
+				futex = __atomic_load_n(&_retrieveChunk()->progressFutex, __ATOMIC_ACQUIRE);
+			}
 			do {
 				if(_lastProgress != (futex & kHelProgressMask)) {
 					*done = false;
@@ -327,6 +354,25 @@ private:
 		}
 	}
 
+	bool _hasProgress(int futex) {
+		return _lastProgress != (futex & kHelProgressMask) || (futex & kHelProgressDone);
+	}
+
+	// Polls the current chunk until it makes progress or until the spin budget is exhausted.
+	// The budget grows if polling is successful and shrinks otherwise.
+	// Only touches state that ElementHandles of other threads do not modify.
+	void _spin() {
+		for(unsigned int i = 0; i < _spinBudget; ++i) {
+			auto futex = __atomic_load_n(&_retrieveChunk()->progressFutex, __ATOMIC_ACQUIRE);
+			if(_hasProgress(futex)) {
+				_spinBudget = std::min(_spinBudget * 2, _spinLimit);
+				return;
+			}
+			cpuRelax();
+		}
+		_spinBudget = std::min(std::max(_spinBudget / 2, minSpinBudget), _spinLimit);
+	}
+
 private:
 	HelHandle _handle;
 	HelQueue *_queue;
@@ -344,6 +390,10 @@ private:
 
 	// Per-chunk reference counts.
 	int _refCounts[16];
+
+	// Maximal and current number of polling iterations before blocking.
+	unsigned int _spinLimit;
+	unsigned int _spinBudget;
 };
 
 inline void CurrentDispatcherToken::wait() {
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include <helix/ipc.hpp>
+
+namespace helix {
+
+// Runs completions on multiple worker threads. Each worker owns its (thread-local)
+// Dispatcher, i.e., its own kernel queue and its own chunks. Operations are
+// completed on the worker that submitted them, hence completions do not bounce
+// between CPUs. Coroutines can move to a different worker via switchTo().
+//
+// ElementHandles (and thus results that refer to queue elements) must be
+// released on the worker that received them.
+struct DispatcherPool {
+	// Spin limit that is used by the workers unless specified otherwise.
+	static constexpr unsigned int defaultSpinLimit = 4096;
+
+	// Index of the worker that runs the calling thread or -1 if the calling
+	// thread is not a worker of any pool.
+	static int currentWorker();
+
+	explicit DispatcherPool(unsigned int numWorkers,
+			unsigned int spinLimit = defaultSpinLimit);
+
+	DispatcherPool(const DispatcherPool &) = delete;
+
+	DispatcherPool &operator= (const DispatcherPool &) = delete;
+
+	// Stops all workers and waits until they have exited.
+	// Operations that are still pending on the workers' queues are lost.
+	~DispatcherPool();
+
+	unsigned int numWorkers() {
+		return _workers.size();
+	}
+
+	// Runs a function on the given worker.
+	void post(unsigned int index, std::function<void()> function);
+
+	struct [[nodiscard]] SwitchToWorker : private Context {
+		SwitchToWorker(DispatcherPool *pool, unsigned int index)
+		: _pool{pool}, _index{index} { }
+
+		bool await_ready();
+		void await_suspend(std::coroutine_handle<> handle);
+		void await_resume() { }
+
+	private:
+		void complete(ElementHandle element) override;
+
+		DispatcherPool *_pool;
+		unsigned int _index;
+		std::coroutine_handle<> _handle;
+	};
+
+	// Awaitable that continues the calling coroutine on the given worker.
+	SwitchToWorker switchTo(unsigned int index) {
+		return SwitchToWorker{this, index};
+	}
+
+private:
+	struct Worker {
+		std::thread thread;
+		// Queue of the worker's Dispatcher. Set before the constructor returns.
+		HelHandle queue = kHelNullHandle;
+		// Only accessed by the worker itself.
+		bool stop = false;
+	};
+
+	void _serve(unsigned int index, unsigned int spinLimit);
+
+	// std::deque keeps pointers to workers stable.
+	std::deque<Worker> _workers;
+
+	// Protects Worker::queue during startup.
+	std::mutex _startupMutex;
+	std::condition_variable _startupCv;
+};
+
+} // namespace helix
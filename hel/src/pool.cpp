@@ -0,0 +1,105 @@
+#include <condition_variable>
+#include <mutex>
+
+#include <helix/pool.hpp>
+
+namespace helix {
+
+namespace {
+
+thread_local DispatcherPool *currentPool = nullptr;
+thread_local int currentIndex = -1;
+
+// Context that runs a function and then deletes itself.
+struct PostedFunction final : Context {
+	PostedFunction(std::function<void()> function)
+	: function{std::move(function)} { }
+
+	void complete(ElementHandle) override {
+		auto f = std::move(function);
+		delete this;
+		f();
+	}
+
+	std::function<void()> function;
+};
+
+} // anonymous namespace
+
+int DispatcherPool::currentWorker() {
+	return currentIndex;
+}
+
+DispatcherPool::DispatcherPool(unsigned int numWorkers, unsigned int spinLimit) {
+	assert(numWorkers);
+	for(unsigned int i = 0; i < numWorkers; ++i)
+		_workers.emplace_back();
+
+	for(unsigned int i = 0; i < numWorkers; ++i)
+		_workers[i].thread = std::thread{[this, i, spinLimit] {
+			_serve(i, spinLimit);
+		}};
+
+	// Wait until all workers have published their queues.
+	std::unique_lock lock{_startupMutex};
+	_startupCv.wait(lock, [&] {
+		for(auto &worker : _workers) {
+			if(worker.queue == kHelNullHandle)
+				return false;
+		}
+		return true;
+	});
+}
+
+DispatcherPool::~DispatcherPool() {
+	for(unsigned int i = 0; i < _workers.size(); ++i) {
+		auto worker = &_workers[i];
+		post(i, [worker] {
+			worker->stop = true;
+		});
+	}
+	for(auto &worker : _workers)
+		worker.thread.join();
+}
+
+void DispatcherPool::post(unsigned int index, std::function<void()> function) {
+	assert(index < _workers.size());
+	auto context = new PostedFunction{std::move(function)};
+	HEL_CHECK(helSubmitAsyncNop(_workers[index].queue,
+			reinterpret_cast<uintptr_t>(static_cast<Context *>(context))));
+}
+
+void DispatcherPool::_serve(unsigned int index, unsigned int spinLimit) {
+	auto worker = &_workers[index];
+	currentPool = this;
+	currentIndex = index;
+
+	auto &dispatcher = Dispatcher::global();
+	dispatcher.setSpinLimit(spinLimit);
+	{
+		std::lock_guard lock{_startupMutex};
+		worker->queue = dispatcher.acquire();
+	}
+	_startupCv.notify_all();
+
+	while(!worker->stop)
+		dispatcher.wait();
+}
+
+bool DispatcherPool::SwitchToWorker::await_ready() {
+	return currentPool == _pool && currentIndex == static_cast<int>(_index);
+}
+
+void DispatcherPool::SwitchToWorker::await_suspend(std::coroutine_handle<> handle) {
+	assert(_index < _pool->_workers.size());
+	_handle = handle;
+	auto context = static_cast<Context *>(this);
+	HEL_CHECK(helSubmitAsyncNop(_pool->_workers[_index].queue,
+			reinterpret_cast<uintptr_t>(context)));
+}
+
+void DispatcherPool::SwitchToWorker::complete(ElementHandle) {
+	_handle.resume();
+}
+
+} // namespace helix
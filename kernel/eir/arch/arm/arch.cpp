@@ -20,6 +20,8 @@ void setupPaging() {
 static inline constexpr uint64_t kPageValid = 1;
 static inline constexpr uint64_t kPageTable = (1 << 1);
 static inline constexpr uint64_t kPageL3Page = (1 << 1);
+// Block descriptors (L1 and L2) have kPageValid set but kPageTable clear.
+static inline constexpr uint64_t kPageBlock = 0;
 static inline constexpr uint64_t kPageXN = (uint64_t(1) << 54);
 static inline constexpr uint64_t kPagePXN = (uint64_t(1) << 53);
 static inline constexpr uint64_t kPageNotGlobal = (1 << 11);
@@ -55,6 +57,9 @@ void mapSingle4kPage(address_t address, address_t physical, uint32_t flags,
 
 	auto l1_ent = ((uint64_t *)l1_ptr)[l1];
 	auto l2_ptr = l1_ent & 0xFFFFFFFFF000;
+	if ((l1_ent & kPageValid) && !(l1_ent & kPageTable))
+		eir::panicLogger() << "eir: Trying to map 0x" << frg::hex_fmt{address}
+				<< " inside a 1 GiB block!" << frg::endlog;
 	if (!(l1_ent & kPageValid)) {
 		uint64_t addr = allocPage();
 
@@ -69,6 +74,9 @@ void mapSingle4kPage(address_t address, address_t physical, uint32_t flags,
 
 	auto l2_ent = ((uint64_t *)l2_ptr)[l2];
 	auto l3_ptr = l2_ent & 0xFFFFFFFFF000;
+	if ((l2_ent & kPageValid) && !(l2_ent & kPageTable))
+		eir::panicLogger() << "eir: Trying to map 0x" << frg::hex_fmt{address}
+				<< " inside a 2 MiB block!" << frg::endlog;
 	if (!(l2_ent & kPageValid)) {
 		uint64_t addr = allocPage();
 
@@ -116,6 +124,75 @@ void mapSingle4kPage(address_t address, address_t physical, uint32_t flags,
 	((uint64_t *)l3_ptr)[l3] = new_entry;
 }
 
+bool supportsLargePages(size_t size) {
+	// With the 4K granule, L1 and L2 block descriptors are always available.
+	return size == largePageSize || size == hugePageSize;
+}
+
+void mapSingleLargePage(address_t address, address_t physical, size_t size, uint32_t flags) {
+	assert(supportsLargePages(size));
+	assert(!(address & (size - 1)));
+	assert(!(physical & (size - 1)));
+
+	auto ttbr = (address >> 63) & 1;
+	auto l0 = (address >> 39) & 0x1FF;
+	auto l1 = (address >> 30) & 0x1FF;
+	auto l2 = (address >> 21) & 0x1FF;
+
+	auto l0_ent = ((uint64_t *)eirTTBR[ttbr])[l0];
+	auto l1_ptr = l0_ent & 0xFFFFFFFFF000;
+	if (!(l0_ent & kPageValid)) {
+		uint64_t addr = allocPage();
+
+		for(int i = 0; i < 512; i++)
+			((uint64_t *)addr)[i] = 0;
+
+		((uint64_t *)eirTTBR[ttbr])[l0] =
+			addr | kPageValid | kPageTable;
+
+		l1_ptr = addr;
+	}
+
+	uint64_t new_entry = physical | kPageValid | kPageBlock | kPageAccess
+			| kPageWb | kPageInnerSh;
+	if (!(flags & PageFlags::write))
+		new_entry |= kPageRO;
+	if (!(flags & PageFlags::execute))
+		new_entry |= kPageXN | kPagePXN;
+	if (!(flags & PageFlags::global))
+		new_entry |= kPageNotGlobal;
+
+	auto l1_ent = ((uint64_t *)l1_ptr)[l1];
+	if (size == hugePageSize) {
+		if (l1_ent & kPageValid)
+			eir::panicLogger() << "eir: Trying to map 0x" << frg::hex_fmt{address}
+					<< " twice!" << frg::endlog;
+		((uint64_t *)l1_ptr)[l1] = new_entry;
+		return;
+	}
+
+	auto l2_ptr = l1_ent & 0xFFFFFFFFF000;
+	if ((l1_ent & kPageValid) && !(l1_ent & kPageTable))
+		eir::panicLogger() << "eir: Trying to map 0x" << frg::hex_fmt{address}
+				<< " inside a 1 GiB block!" << frg::endlog;
+	if (!(l1_ent & kPageValid)) {
+		uint64_t addr = allocPage();
+
+		for(int i = 0; i < 512; i++)
+			((uint64_t *)addr)[i] = 0;
+
+		((uint64_t *)l1_ptr)[l1] =
+			addr | kPageValid | kPageTable;
+
+		l2_ptr = addr;
+	}
+
+	if (((uint64_t *)l2_ptr)[l2] & kPageValid)
+		eir::panicLogger() << "eir: Trying to map 0x" << frg::hex_fmt{address}
+				<< " twice!" << frg::endlog;
+	((uint64_t *)l2_ptr)[l2] = new_entry;
+}
+
 address_t getSingle4kPage(address_t address) {
 	auto ttbr = (address >> 63) & 1;
 	auto l0 = (address >> 39) & 0x1FF;
@@ -132,11 +209,15 @@ address_t getSingle4kPage(address_t address) {
 	auto l2_ptr = l1_ent & 0xFFFFFFFFF000;
 	if (!(l1_ent & kPageValid))
 		return -1;
+	if (!(l1_ent & kPageTable))
+		return (l1_ent & 0xFFFFC0000000) + (address & (hugePageSize - 1));
 
 	auto l2_ent = ((uint64_t *)l2_ptr)[l2];
 	auto l3_ptr = l2_ent & 0xFFFFFFFFF000;
 	if (!(l2_ent & kPageValid))
 		return -1;
+	if (!(l2_ent & kPageTable))
+		return (l2_ent & 0xFFFFFFE00000) + (address & (largePageSize - 1));
 
 	auto l3_ent = ((uint64_t *)l3_ptr)[l3];
 	auto page_ptr = l3_ent & 0xFFFFFFFFF000;
@@ -20,12 +20,16 @@ enum X86PageFlags {
 	kPageUser = 4,
 	kPagePwt = 0x8,
 	kPagePat = 0x80,
+	// Same bit as kPagePat, but in PDPT and PD entries.
+	kPageHuge = 0x80,
 	kPageGlobal = 0x100,
 	kPageXd = 0x8000000000000000
 };
 
 uintptr_t eirPml4Pointer = 0;
 
+bool have1GiBPages = false;
+
 void setupPaging() {
 	eirPml4Pointer = allocPage();
 
@@ -65,6 +69,9 @@ void mapSingle4kPage(address_t address, address_t physical, uint32_t flags,
 		((uint64_t *)pml4)[pml4_index] = pdpt | kPagePresent | kPageWrite;
 	}
 	uint64_t pdpt_entry = ((uint64_t *)pdpt)[pdpt_index];
+	if((pdpt_entry & kPagePresent) && (pdpt_entry & kPageHuge))
+		eir::panicLogger() << "eir: Trying to map 0x" << frg::hex_fmt{address}
+				<< " inside a 1 GiB page!" << frg::endlog;
 
 	// find the pd entry; create pd if necessary
 	uintptr_t pd = (uintptr_t)(pdpt_entry & 0xFFFFF000);
@@ -75,6 +82,9 @@ void mapSingle4kPage(address_t address, address_t physical, uint32_t flags,
 		((uint64_t *)pdpt)[pdpt_index] = pd | kPagePresent | kPageWrite;
 	}
 	uint64_t pd_entry = ((uint64_t *)pd)[pd_index];
+	if((pd_entry & kPagePresent) && (pd_entry & kPageHuge))
+		eir::panicLogger() << "eir: Trying to map 0x" << frg::hex_fmt{address}
+				<< " inside a 2 MiB page!" << frg::endlog;
 
 	// find the pt entry; create pt if necessary
 	uintptr_t pt = (uintptr_t)(pd_entry & 0xFFFFF000);
@@ -106,6 +116,71 @@ void mapSingle4kPage(address_t address, address_t physical, uint32_t flags,
 	((uint64_t*)pt)[pt_index] = new_entry;
 }
 
+bool supportsLargePages(size_t size) {
+	if(size == largePageSize)
+		return true;
+	if(size == hugePageSize)
+		return have1GiBPages;
+	return false;
+}
+
+void mapSingleLargePage(address_t address, address_t physical, size_t size, uint32_t flags) {
+	assert(supportsLargePages(size));
+	assert(!(address & (size - 1)));
+	assert(!(physical & (size - 1)));
+
+	int pml4_index = (int)((address >> 39) & 0x1FF);
+	int pdpt_index = (int)((address >> 30) & 0x1FF);
+	int pd_index = (int)((address >> 21) & 0x1FF);
+
+	// find the pml4_entry. the pml4 is always present
+	uintptr_t pml4 = eirPml4Pointer;
+	uint64_t pml4_entry = ((uint64_t *)pml4)[pml4_index];
+
+	// find the pdpt entry; create pdpt if necessary
+	uintptr_t pdpt = (uintptr_t)(pml4_entry & 0xFFFFF000);
+	if(!(pml4_entry & kPagePresent)) {
+		pdpt = allocPage();
+		for(int i = 0; i < 512; i++)
+			((uint64_t *)pdpt)[i] = 0;
+		((uint64_t *)pml4)[pml4_index] = pdpt | kPagePresent | kPageWrite;
+	}
+	uint64_t pdpt_entry = ((uint64_t *)pdpt)[pdpt_index];
+
+	uint64_t new_entry = physical | kPagePresent | kPageHuge;
+	if (flags & PageFlags::write)
+		new_entry |= kPageWrite;
+	if (!(flags & PageFlags::execute))
+		new_entry |= kPageXd;
+	if (flags & PageFlags::global)
+		new_entry |= kPageGlobal;
+
+	if(size == hugePageSize) {
+		if(pdpt_entry & kPagePresent)
+			eir::panicLogger() << "eir: Trying to map 0x" << frg::hex_fmt{address}
+					<< " twice!" << frg::endlog;
+		((uint64_t *)pdpt)[pdpt_index] = new_entry;
+		return;
+	}
+
+	// find the pd entry; create pd if necessary
+	if((pdpt_entry & kPagePresent) && (pdpt_entry & kPageHuge))
+		eir::panicLogger() << "eir: Trying to map 0x" << frg::hex_fmt{address}
+				<< " inside a 1 GiB page!" << frg::endlog;
+	uintptr_t pd = (uintptr_t)(pdpt_entry & 0xFFFFF000);
+	if(!(pdpt_entry & kPagePresent)) {
+		pd = allocPage();
+		for(int i = 0; i < 512; i++)
+			((uint64_t *)pd)[i] = 0;
+		((uint64_t *)pdpt)[pdpt_index] = pd | kPagePresent | kPageWrite;
+	}
+
+	if(((uint64_t *)pd)[pd_index] & kPagePresent)
+		eir::panicLogger() << "eir: Trying to map 0x" << frg::hex_fmt{address}
+				<< " twice!" << frg::endlog;
+	((uint64_t *)pd)[pd_index] = new_entry;
+}
+
 address_t getSingle4kPage(address_t address) {
 	assert(address % pageSize == 0);
 
@@ -128,12 +203,16 @@ address_t getSingle4kPage(address_t address) {
 	uintptr_t pd = (uintptr_t)(pdpt_entry & 0xFFFFF000);
 	if(!(pdpt_entry & kPagePresent))
 		return -1;
+	if(pdpt_entry & kPageHuge)
+		return (pdpt_entry & 0xF'FFFF'C000'0000) + (address & (hugePageSize - 1));
 	uint64_t pd_entry = ((uint64_t *)pd)[pd_index];
 
 	// find the pt entry; create pt if necessary
 	uintptr_t pt = (uintptr_t)(pd_entry & 0xFFFFF000);
 	if(!(pd_entry & kPagePresent))
 		return -1;
+	if(pd_entry & kPageHuge)
+		return (pd_entry & 0xF'FFFF'FFE0'0000) + (address & (largePageSize - 1));
 	uint64_t pt_entry = ((uint64_t *)pt)[pt_index];
 
 	// setup the new pt entry
@@ -168,6 +247,10 @@ void initProcessorEarly() {
 	if((normal[3] & arch::kCpuFlagPat) == 0)
 		eir::panicLogger() << "PAT is not supported on this CPU" << frg::endlog;
 
+	// Used to build the direct physical map.
+	if(extended[3] & (1 << 26))
+		have1GiBPages = true;
+
 	initArchCpu();
 
 	// Program the PAT. Each byte configures a single entry.
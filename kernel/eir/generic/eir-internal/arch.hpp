@@ -23,11 +23,18 @@ enum class CachingMode {
 
 static constexpr int pageShift = 12;
 static constexpr size_t pageSize = size_t(1) << pageShift;
+static constexpr size_t largePageSize = size_t(1) << 21;
+static constexpr size_t hugePageSize = size_t(1) << 30;
 
 void setupPaging();
 void mapSingle4kPage(address_t address, address_t physical, uint32_t flags,
 		CachingMode caching_mode = CachingMode::null);
 address_t getSingle4kPage(address_t address);
+// Returns true if pages of the given size (largePageSize or hugePageSize) can be mapped.
+bool supportsLargePages(size_t size);
+// Maps a naturally aligned page of size largePageSize or hugePageSize.
+// Such pages are always mapped with CachingMode::null.
+void mapSingleLargePage(address_t address, address_t physical, size_t size, uint32_t flags);
 
 void initProcessorEarly();
 void initProcessorPaging(void *kernel_start, uint64_t &kernel_entry);
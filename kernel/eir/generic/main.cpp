@@ -274,6 +274,39 @@ void unpoisonKasanShadow(address_t base, size_t size) {
 
 // ----------------------------------------------------------------------------
 
+// Maps [physical, physical + size) into the direct physical map. Uses the largest pages
+// that alignment permits and falls back to 4 KiB pages at the edges.
+static void mapDirectPhysical(address_t physical, size_t size,
+		size_t &numHuge, size_t &numLarge, size_t &numSmall) {
+	constexpr address_t directBase = 0xFFFF'8000'0000'0000;
+	static_assert(!(directBase & (hugePageSize - 1)));
+
+	address_t offset = 0;
+	while(offset < size) {
+		auto address = physical + offset;
+		auto remaining = size - offset;
+
+		if(supportsLargePages(hugePageSize) && !(address & (hugePageSize - 1))
+				&& remaining >= hugePageSize) {
+			mapSingleLargePage(directBase + address, address, hugePageSize,
+					PageFlags::write | PageFlags::global);
+			offset += hugePageSize;
+			numHuge++;
+		}else if(supportsLargePages(largePageSize) && !(address & (largePageSize - 1))
+				&& remaining >= largePageSize) {
+			mapSingleLargePage(directBase + address, address, largePageSize,
+					PageFlags::write | PageFlags::global);
+			offset += largePageSize;
+			numLarge++;
+		}else{
+			mapSingle4kPage(directBase + address, address,
+					PageFlags::write | PageFlags::global);
+			offset += pageSize;
+			numSmall++;
+		}
+	}
+}
+
 void mapRegionsAndStructs() {
 	// This region should be available RAM on every PC.
 	for(size_t page = 0x8000; page < 0x80000; page += pageSize)
@@ -282,15 +315,15 @@ void mapRegionsAndStructs() {
 	mapKasanShadow(0xFFFF'8000'0000'8000, 0x80000);
 	unpoisonKasanShadow(0xFFFF'8000'0000'8000, 0x80000);
 
+	size_t numHuge = 0, numLarge = 0, numSmall = 0;
 	address_t treeMapping = 0xFFFF'C080'0000'0000;
 	for(size_t i = 0; i < numRegions; ++i) {
 		if(regions[i].regionType != RegionType::allocatable)
 			continue;
 
 		// Map the region itself.
-		for(address_t page = 0; page < regions[i].size; page += pageSize)
-			mapSingle4kPage(0xFFFF'8000'0000'0000 + regions[i].address + page,
-					regions[i].address + page, PageFlags::write | PageFlags::global);
+		mapDirectPhysical(regions[i].address, regions[i].size,
+				numHuge, numLarge, numSmall);
 		mapKasanShadow(0xFFFF'8000'0000'0000 + regions[i].address, regions[i].size);
 		unpoisonKasanShadow(0xFFFF'8000'0000'0000 + regions[i].address, regions[i].size);
 
@@ -306,6 +339,9 @@ void mapRegionsAndStructs() {
 		unpoisonKasanShadow(buddyMapping, regions[i].buddyOverhead);
 		regions[i].buddyMap = buddyMapping;
 	}
+
+	eir::infoLogger() << "eir: Direct physical map uses " << numHuge << " 1 GiB pages, "
+			<< numLarge << " 2 MiB pages and " << numSmall << " 4 KiB pages" << frg::endlog;
 }
 
 void allocLogRingBuffer() {
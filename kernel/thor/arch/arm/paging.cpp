@@ -45,9 +45,6 @@ void invalidateFullTlb() {
 			::: "memory");
 }
 
-void poisonPhysicalAccess(PhysicalAddr physical) { assert(!"Not implemented"); }
-void poisonPhysicalWriteAccess(PhysicalAddr physical) { assert(!"Not implemented"); }
-
 PageContext::PageContext()
 : _nextStamp{1}, _primaryBinding{nullptr} { }
 
@@ -25,6 +25,14 @@ uint64_t getVirtualTimestampCounter() {
 	return cntvct;
 }
 
+namespace {
+	void countTimerIrq() {
+		auto cpuData = getCpuData();
+		cpuData->numTimerIrqs.fetch_add(1, std::memory_order_relaxed);
+		cpuData->numNeededTimerIrqs.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
 struct PhysicalGenericTimer : IrqSink, ClockSource {
 	PhysicalGenericTimer()
 	: IrqSink{frg::string<KernelAlloc>{*kernelAlloc, "physical-generic-timer-irq"}} { }
@@ -32,6 +40,8 @@ struct PhysicalGenericTimer : IrqSink, ClockSource {
 	virtual ~PhysicalGenericTimer() = default;
 
 	IrqStatus raise() override {
+		// The comparator only fires once the deadline passed.
+		countTimerIrq();
 		disarmPreemption();
 		return IrqStatus::acked;
 	}
@@ -53,6 +63,7 @@ struct VirtualGenericTimer : IrqSink, AlarmTracker {
 	using AlarmTracker::fireAlarm;
 
 	IrqStatus raise() override {
+		countTimerIrq();
 		disarm();
 		fireAlarm();
 		return IrqStatus::acked;
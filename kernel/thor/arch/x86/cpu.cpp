@@ -46,6 +46,9 @@ static constexpr uint16_t fcwInitializer =
 
 static constexpr uint32_t mxcsrInitializer = 0b1111110000000;
 
+// Zero is reserved for executors without SIMD state.
+static std::atomic<uint64_t> nextSimdId{1};
+
 
 size_t Executor::determineSimdSize() {
 	assert(cpuFeaturesKnown);
@@ -83,6 +86,7 @@ Executor::Executor(UserContext *context, AbiParameters abi) {
 
 	_tss = &context->tss;
 	_syscallStack = context->kernelStack.basePtr();
+	_simdId = nextSimdId.fetch_add(1, std::memory_order_relaxed);
 }
 
 Executor::Executor(FiberContext *context, AbiParameters abi)
@@ -135,11 +139,7 @@ void saveExecutor(Executor *executor, FaultImageAccessor accessor) {
 	executor->general()->clientFs = common::x86::rdmsr(common::x86::kMsrIndexFsBase);
 	executor->general()->clientGs = common::x86::rdmsr(common::x86::kMsrIndexKernelGsBase);
 
-	if(getGlobalCpuFeatures()->haveXsave){
-		common::x86::xsave((uint8_t*)executor->_fxState(), ~0);
-	} else {
-		asm volatile ("fxsaveq %0" : : "m" (*executor->_fxState()));
-	}
+	saveSimdState(executor);
 }
 
 void saveExecutor(Executor *executor, IrqImageAccessor accessor) {
@@ -168,12 +168,7 @@ void saveExecutor(Executor *executor, IrqImageAccessor accessor) {
 	executor->general()->clientFs = common::x86::rdmsr(common::x86::kMsrIndexFsBase);
 	executor->general()->clientGs = common::x86::rdmsr(common::x86::kMsrIndexKernelGsBase);
 
-
-	if(getGlobalCpuFeatures()->haveXsave){
-		common::x86::xsave((uint8_t*)executor->_fxState(), ~0);
-	}else{
-		asm volatile ("fxsaveq %0" : : "m" (*executor->_fxState()));
-	}
+	saveSimdState(executor);
 }
 
 void saveExecutor(Executor *executor, SyscallImageAccessor accessor) {
@@ -202,7 +197,18 @@ void saveExecutor(Executor *executor, SyscallImageAccessor accessor) {
 	executor->general()->clientFs = common::x86::rdmsr(common::x86::kMsrIndexFsBase);
 	executor->general()->clientGs = common::x86::rdmsr(common::x86::kMsrIndexKernelGsBase);
 
-	if(getGlobalCpuFeatures()->haveXsave){
+	saveSimdState(executor);
+}
+
+void saveSimdState(Executor *executor) {
+	if(!executor->_hasSimdState())
+		return;
+
+	// The SIMD registers always belong to the current executor (if it has SIMD state):
+	// restoreExecutor() loads them and kernel code does not modify them.
+	if(getGlobalCpuFeatures()->haveXsaveopt){
+		common::x86::xsaveopt((uint8_t*)executor->_fxState(), ~0);
+	}else if(getGlobalCpuFeatures()->haveXsave){
 		common::x86::xsave((uint8_t*)executor->_fxState(), ~0);
 	}else{
 		asm volatile ("fxsaveq %0" : : "m" (*executor->_fxState()));
@@ -254,10 +260,19 @@ extern "C" [[ noreturn ]] void _restoreExecutorRegisters(void *pointer);
 	common::x86::wrmsr(common::x86::kMsrIndexFsBase, executor->general()->clientFs);
 	common::x86::wrmsr(common::x86::kMsrIndexKernelGsBase, executor->general()->clientGs);
 
-	if(getGlobalCpuFeatures()->haveXsave){
-		common::x86::xrstor((uint8_t*)executor->_fxState(), ~0);
-	}else{
-		asm volatile ("fxrstorq %0" : : "m" (*executor->_fxState()));
+	// Skip reloading the SIMD registers if they still hold the executor's state,
+	// e.g., if we only ran kernel fibers since the executor was saved.
+	if(executor->_hasSimdState()) {
+		auto cpuData = getPlatformCpuData();
+		if(cpuData->simdOwner != executor->_simdId || executor->_simdCpu != cpuData) {
+			if(getGlobalCpuFeatures()->haveXsave){
+				common::x86::xrstor((uint8_t*)executor->_fxState(), ~0);
+			}else{
+				asm volatile ("fxrstorq %0" : : "m" (*executor->_fxState()));
+			}
+			cpuData->simdOwner = executor->_simdId;
+			executor->_simdCpu = cpuData;
+		}
 	}
 
 	uint16_t cs = executor->general()->cs;
@@ -414,6 +429,11 @@ static initgraph::Task enumerateCpuFeaturesTask{&globalInitEngine, "x86.enumerat
 
 			auto xsaveCpuid = common::x86::cpuid(0xD);
 			globalCpuFeatures.xsaveRegionSize = xsaveCpuid[2];
+
+			if(common::x86::cpuid(0xD, 1)[0] & 1) {
+				infoLogger() << "\e[37mthor: CPUs support XSAVEOPT\e[39m" << frg::endlog;
+				globalCpuFeatures.haveXsaveopt = true;
+			}
 		}else{
 			infoLogger() << "\e[37mthor: CPUs do not support XSAVE!\e[39m" << frg::endlog;
 		}
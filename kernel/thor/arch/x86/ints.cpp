@@ -497,6 +497,126 @@ extern "C" void onPlatformWork() {
 	disableInts();
 }
 
+namespace {
+	// The NMI handler must not fault, hence call chains are read by walking the active
+	// page tables and accessing memory through the physical window.
+	// We do not take any locks, so the data may be stale; this is fine for profiling.
+	bool peekStackWord(uintptr_t address, bool user, uint64_t &out) {
+		constexpr uint64_t entryPresent = 0x1;
+		constexpr uint64_t entryUser = 0x4;
+		constexpr uint64_t entryHuge = 0x80;
+		constexpr uint64_t entryAddress = 0x000FFFFFFFFFF000;
+		constexpr PhysicalAddr physicalLimit = 0x4000'0000'0000;
+
+		if(address & (sizeof(uint64_t) - 1))
+			return false;
+		if(inHigherHalf(address) == user)
+			return false;
+
+		uintptr_t cr3;
+		asm volatile ("mov %%cr3, %0" : "=r"(cr3));
+		PhysicalAddr table = cr3 & entryAddress;
+		for(int level = 3; level >= 0; level--) {
+			auto shift = kPageShift + 9 * level;
+			auto index = (address >> shift) & 0x1FF;
+
+			PageAccessor accessor{table};
+			auto entry = __atomic_load_n(
+					reinterpret_cast<uint64_t *>(accessor.get()) + index, __ATOMIC_RELAXED);
+			if(!(entry & entryPresent))
+				return false;
+			if(user && !(entry & entryUser))
+				return false;
+
+			// Huge pages are only possible for PDPT and PD entries.
+			if(level && !((level < 3) && (entry & entryHuge))) {
+				table = entry & entryAddress;
+				if(table >= physicalLimit)
+					return false;
+				continue;
+			}
+
+			auto pageMask = (uintptr_t{1} << shift) - 1;
+			PhysicalAddr physical = (entry & entryAddress & ~pageMask) + (address & pageMask);
+			if(physical >= physicalLimit)
+				return false;
+			PageAccessor wordAccessor{physical & ~PhysicalAddr{kPageSize - 1}};
+			out = *reinterpret_cast<uint64_t *>(reinterpret_cast<uintptr_t>(wordAccessor.get())
+					+ (physical & (kPageSize - 1)));
+			return true;
+		}
+		__builtin_unreachable();
+	}
+
+	// Stores ip and the return addresses of the frame pointer chain that starts at bp.
+	int walkProfileFrames(uintptr_t ip, uintptr_t bp, bool user, uint64_t *frames) {
+		int n = 0;
+		frames[n++] = ip;
+
+		uintptr_t previousBp = 0;
+		while(n < maxProfileFrames && bp) {
+			// Stacks grow down, hence callers' frames are at higher addresses.
+			if(bp <= previousBp)
+				break;
+			uint64_t nextBp, returnIp;
+			if(!peekStackWord(bp, user, nextBp) || !peekStackWord(bp + 8, user, returnIp))
+				break;
+			if(!returnIp)
+				break;
+			frames[n++] = returnIp;
+			previousBp = bp;
+			bp = nextBp;
+		}
+		return n;
+	}
+
+	void captureProfileSample(NmiImageAccessor image, CpuData *cpuData) {
+		struct {
+			ProfileSampleHeader header;
+			uint64_t frames[2 * maxProfileFrames];
+		} record;
+		record.header = {};
+		record.header.kind = ProfileRecordKind::sample;
+		record.header.cpu = cpuData->cpuIndex;
+
+		uint16_t cs = *image.cs();
+		bool fromUser = (cs == kSelClientUserCode);
+		if(fromUser || cs == kSelExecutorSyscallCode || cs == kSelExecutorFaultCode) {
+			auto thread = cpuData->activeExecutor.get();
+			memcpy(&record.header.threadId, thread->credentials() + 8, sizeof(uint64_t));
+			record.header.spaceId = profileSpaceId(thread->getAddressSpace().get());
+		}
+
+		int numFrames;
+		if(fromUser) {
+			numFrames = walkProfileFrames(*image.ip(), *image.bp(), true, record.frames);
+			record.header.numUserFrames = numFrames;
+		}else{
+#ifdef THOR_HAS_FRAME_POINTERS
+			numFrames = walkProfileFrames(*image.ip(), *image.bp(), false, record.frames);
+#else
+			record.frames[0] = *image.ip();
+			numFrames = 1;
+#endif
+			record.header.numKernelFrames = numFrames;
+
+			// Inside syscalls, the user chain starts at the registers that syscallStub saved.
+			// Within the stub itself, that frame is incomplete.
+			if(cs == kSelExecutorSyscallCode && !inStub(*image.ip())) {
+				auto syscallImage = SyscallImageAccessor::fromSyscallStack(
+						cpuData->syscallStack);
+				int numUserFrames = walkProfileFrames(*syscallImage.userIp(),
+						*syscallImage.userBp(), true, record.frames + numFrames);
+				record.header.numUserFrames = numUserFrames;
+				numFrames += numUserFrames;
+			}
+		}
+
+		cpuData->localProfileRing->enqueue(&record,
+				sizeof(ProfileSampleHeader) + numFrames * sizeof(uint64_t));
+	}
+} // anonymous namespace
+
 extern "C" void onPlatformNmi(NmiImageAccessor image) {
 	// If we interrupted user space or a kernel stub, we might need to update GS.
 	auto gs = common::x86::rdmsr(common::x86::kMsrIndexGsBase);
@@ -508,13 +628,11 @@ extern "C" void onPlatformNmi(NmiImageAccessor image) {
 	bool explained = false;
 	auto pmcMechanism = cpuData->profileMechanism.load(std::memory_order_acquire);
 	if(pmcMechanism == ProfileMechanism::intelPmc && checkIntelPmcOverflow()) {
-		uintptr_t ip = *image.ip();
-		cpuData->localProfileRing->enqueue(&ip, sizeof(uintptr_t));
+		captureProfileSample(image, cpuData);
 		setIntelPmc();
 		explained = true;
 	}else if(pmcMechanism == ProfileMechanism::amdPmc && checkAmdPmcOverflow()) {
-		uintptr_t ip = *image.ip();
-		cpuData->localProfileRing->enqueue(&ip, sizeof(uintptr_t));
+		captureProfileSample(image, cpuData);
 		setAmdPmc();
 		explained = true;
 	}
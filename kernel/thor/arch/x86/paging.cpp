@@ -49,19 +49,6 @@ void invalidateFullTlb() {
 	asm volatile ("mov %0, %%cr3" : : "r"(pml4) : "memory");
 }
 
-void poisonPhysicalAccess(PhysicalAddr physical) {
-	auto address = 0xFFFF'8000'0000'0000 + physical;
-	KernelPageSpace::global().unmapSingle4k(address);
-	invalidatePage(reinterpret_cast<void *>(address));
-}
-
-void poisonPhysicalWriteAccess(PhysicalAddr physical) {
-	auto address = 0xFFFF'8000'0000'0000 + physical;
-	KernelPageSpace::global().unmapSingle4k(address);
-	KernelPageSpace::global().mapSingle4k(address, physical, 0, CachingMode::null);
-	invalidatePage(reinterpret_cast<void *>(address));
-}
-
 } // namespace thor
 
 // --------------------------------------------------------
@@ -74,6 +61,8 @@ enum {
 	kPagePcd = 0x10,
 	kPageDirty = 0x40,
 	kPagePat = 0x80,
+	// Same bit as kPagePat, but in PDPT and PD entries.
+	kPageHuge = 0x80,
 	kPageGlobal = 0x100,
 	kPageXd = 0x8000000000000000,
 	kPageAddress = 0x000FFFFFFFFFF000
@@ -656,12 +645,15 @@ PhysicalAddr KernelPageSpace::unmapSingle4k(VirtualAddr pointer) {
 	uint64_t pdpt_entry = pdpt_pointer[pdpt_index];
 
 	// find the pd entry
+	// Note that eir maps the direct physical map using large pages.
 	assert((pdpt_entry & kPagePresent) != 0);
+	assert(!(pdpt_entry & kPageHuge));
 	uint64_t *pd_pointer = (uint64_t *)region.access(pdpt_entry & 0x000FFFFFFFFFF000);
 	uint64_t pd_entry = pd_pointer[pd_index];
 
 	// find the pt entry
 	assert((pd_entry & kPagePresent) != 0);
+	assert(!(pd_entry & kPageHuge));
 	uint64_t *pt_pointer = (uint64_t *)region.access(pd_entry & 0x000FFFFFFFFFF000);
 
 	// change the pt entry
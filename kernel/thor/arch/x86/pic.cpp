@@ -122,12 +122,30 @@ void GlobalApicContext::GlobalAlarmSlot::arm(uint64_t nanos) {
 		auto irq_lock = frg::guard(&irqMutex());
 		auto lock = frg::guard(&globalApicContext()->_mutex);
 		globalApicContext()->_globalDeadline = nanos;
+		globalApicContext()->_globalOwner = getCpuData()->cpuIndex;
 	}
 	LocalApicContext::_updateLocalTimer();
 }
 
+// Only the CPU that armed the global alarm services it; this avoids waking up
+// other (potentially idle) CPUs. Must be called with _mutex held.
+uint64_t GlobalApicContext::_ownDeadline() {
+	if(_globalOwner != getCpuData()->cpuIndex)
+		return 0;
+	return _globalDeadline;
+}
+
+void LocalApicContext::LocalAlarmSlot::arm(uint64_t nanos) {
+	assert(localApicContext()->timersAreCalibrated);
+	// The alarm can only be armed from its own CPU.
+	assert(this == &localApicContext()->_localAlarmInstance);
+
+	localApicContext()->_localDeadline = nanos;
+	LocalApicContext::_updateLocalTimer();
+}
+
 LocalApicContext::LocalApicContext()
-: _preemptionDeadline{0}, _globalDeadline{0} { }
+: _preemptionDeadline{0}, _globalDeadline{0}, _localDeadline{0} { }
 
 void LocalApicContext::setPreemption(uint64_t nanos) {
 	assert(localApicContext()->timersAreCalibrated);
@@ -148,22 +166,37 @@ void LocalApicContext::handleTimerIrq() {
 				<< frg::endlog;
 	auto self = localApicContext();
 	auto now = systemClockSource()->currentNanos();
+	bool needed = false;
 
-	if(self->_preemptionDeadline && now > self->_preemptionDeadline)
+	if(self->_preemptionDeadline && now > self->_preemptionDeadline) {
 		self->_preemptionDeadline = 0;
+		needed = true;
+	}
+
+	if(self->_localDeadline && now >= self->_localDeadline) {
+		self->_localDeadline = 0;
+		self->_localAlarmInstance.fireAlarm();
+		needed = true;
+	}
 
 	if(self->_globalDeadline && now > self->_globalDeadline) {
 		self->_globalDeadline = 0;
+		needed = true;
 		globalApicContext()->_globalAlarmInstance.fireAlarm();
 
 		// Update the global deadline to avoid calling fireAlarm() on the next IRQ.
 		{
 			auto irq_lock = frg::guard(&irqMutex());
 			auto lock = frg::guard(&globalApicContext()->_mutex);
-			localApicContext()->_globalDeadline = globalApicContext()->_globalDeadline;
+			localApicContext()->_globalDeadline = globalApicContext()->_ownDeadline();
 		}
 	}
 
+	auto cpuData = getCpuData();
+	cpuData->numTimerIrqs.fetch_add(1, std::memory_order_relaxed);
+	if(needed)
+		cpuData->numNeededTimerIrqs.fetch_add(1, std::memory_order_relaxed);
+
 	localApicContext()->_updateLocalTimer();
 }
 
@@ -180,11 +213,12 @@ void LocalApicContext::_updateLocalTimer() {
 	{
 		auto irq_lock = frg::guard(&irqMutex());
 		auto lock = frg::guard(&globalApicContext()->_mutex);
-		localApicContext()->_globalDeadline = globalApicContext()->_globalDeadline;
+		localApicContext()->_globalDeadline = globalApicContext()->_ownDeadline();
 	}
 
 	consider(localApicContext()->_preemptionDeadline);
 	consider(localApicContext()->_globalDeadline);
+	consider(localApicContext()->_localDeadline);
 
 	if(localApicContext()->useTscMode) {
 		if(!deadline) {
@@ -322,6 +356,9 @@ void initLocalApicPerCpu() {
 	picBase.store(lApicLvtPerfCount, apicLvtMode(4));
 
 	calibrateApicTimer();
+
+	if(systemClockSource())
+		initializeLocalTimerEngine();
 }
 
 uint32_t getLocalApicId() {
@@ -400,9 +437,22 @@ static initgraph::Task assessTimersTask{&globalInitEngine, "x86.assess-timers",
 		globalTimerEngine = frg::construct<PrecisionTimerEngine>(*kernelAlloc,
 				globalClockSource, globalApicContext()->globalAlarm());
 	//			globalClockSource, hpetAlarmTracker);
+
+		// Depending on the order of initialization, the BSP might have calibrated
+		// its timer before the system clock source was known.
+		// Otherwise (and on APs), this is done by initLocalApicPerCpu().
+		if(localApicContext()->timersAreCalibrated && !getCpuData()->localTimerEngine)
+			initializeLocalTimerEngine();
 	}
 };
 
+void initializeLocalTimerEngine() {
+	assert(localApicContext()->timersAreCalibrated);
+	assert(!getCpuData()->localTimerEngine);
+	getCpuData()->localTimerEngine = frg::construct<PrecisionTimerEngine>(*kernelAlloc,
+			globalClockSource, localApicContext()->localAlarm(), getCpuData());
+}
+
 void acknowledgeIpi() {
 	picBase.store(lApicEoi, 0);
 }
@@ -245,8 +245,19 @@ struct SyscallImageAccessor {
 	Word *out0() { return &_frame()->rsi; }
 	Word *out1() { return &_frame()->rdx; }
 
+	// User space registers at the time of the syscall.
+	Word *userIp() { return &_frame()->rip; }
+	Word *userBp() { return &_frame()->rbp; }
+
 	void *frameBase() { return _pointer + sizeof(Frame); }
 
+	// Returns the frame that syscallStub pushes to the given syscall stack.
+	static SyscallImageAccessor fromSyscallStack(void *stack) {
+		SyscallImageAccessor accessor;
+		accessor._pointer = reinterpret_cast<char *>(stack) - sizeof(Frame);
+		return accessor;
+	}
+
 private:
 	// this struct is accessed from assembly.
 	// do not randomly change its contents.
@@ -283,6 +294,8 @@ struct NmiImageAccessor {
 	Word *ip() { return &_frame()->rip; }
 	Word *cs() { return &_frame()->cs; }
 	Word *rflags() { return &_frame()->rflags; }
+	Word *sp() { return &_frame()->rsp; }
+	Word *bp() { return &_frame()->rbp; }
 
 private:
 	// note: this struct is accessed from assembly.
@@ -361,6 +374,7 @@ struct FiberContext {
 };
 
 struct Executor;
+struct PlatformCpuData;
 
 // Restores the current executor from its saved image.
 // This is functions does the heavy lifting during task switch.
@@ -373,6 +387,7 @@ struct Executor {
 	friend void saveExecutor(Executor *executor, SyscallImageAccessor accessor);
 	friend void workOnExecutor(Executor *executor);
 	friend void restoreExecutor(Executor *executor);
+	friend void saveSimdState(Executor *executor);
 
 	static size_t determineSize();
 	static size_t determineSimdSize();
@@ -493,16 +508,34 @@ public:
 		return reinterpret_cast<FxState *>(_pointer + sizeof(General) + 0x10);
 	}
 
+	// Must be called after the SIMD state in _fxState() was modified externally.
+	void _invalidateSimdState() {
+		_simdCpu = nullptr;
+	}
+
 private:
+	// Only user executors have SIMD state. Kernel code does not touch SIMD registers.
+	bool _hasSimdState() {
+		return _simdId;
+	}
+
 	char *_pointer;
 	void *_syscallStack;
 	common::x86::Tss64 *_tss;
+
+	// Unique ID of this executor's SIMD state (zero if there is none).
+	uint64_t _simdId = 0;
+	// CPU whose SIMD registers were last loaded from this executor.
+	PlatformCpuData *_simdCpu = nullptr;
 };
 
 void saveExecutor(Executor *executor, FaultImageAccessor accessor);
 void saveExecutor(Executor *executor, IrqImageAccessor accessor);
 void saveExecutor(Executor *executor, SyscallImageAccessor accessor);
 
+// Saves the SIMD registers of the current CPU to the executor (if it has SIMD state).
+void saveSimdState(Executor *executor);
+
 // Copies the current state into the executor and calls the supplied function.
 extern "C" void doForkExecutor(Executor *executor, void (*functor)(void *), void *context);
 
@@ -518,6 +551,7 @@ struct CpuFeatures {
 	static constexpr uint32_t profileAmdSupported = 2;
 
 	bool haveXsave;
+	bool haveXsaveopt;
 	bool haveAvx;
 	bool haveZmm;
 	bool haveInvariantTsc;
@@ -590,6 +624,10 @@ struct PlatformCpuData : public AssemblyCpuData {
 
 	LocalApicContext apicContext;
 
+	// SIMD ID of the executor whose state is loaded into the SIMD registers.
+	// Restoring the same executor on this CPU again does not need to reload them.
+	uint64_t simdOwner = 0;
+
 	// TODO: This is not really arch-specific!
 	smarter::borrowed_ptr<Thread> activeExecutor;
 };
@@ -641,11 +679,7 @@ void forkExecutor(F functor, Executor *executor) {
 		(*fp)();
 	};
 
-	if(getGlobalCpuFeatures()->haveXsave) {
-		common::x86::xsave((uint8_t*)executor->_fxState(), ~0);
-	} else {
-		asm volatile ("fxsaveq %0" : : "m" (*executor->_fxState()));
-	}
+	saveSimdState(executor);
 
 	doForkExecutor(executor, delegate, &functor);
 }
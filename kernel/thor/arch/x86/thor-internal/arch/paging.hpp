@@ -100,12 +100,6 @@ private:
 	frg::default_list_hook<ShootNode> _queueNode;
 };
 
-// Functions for debugging kernel page access:
-// Deny all access to the physical mapping.
-void poisonPhysicalAccess(PhysicalAddr physical);
-// Deny write access to the physical mapping.
-void poisonPhysicalWriteAccess(PhysicalAddr physical);
-
 struct PageSpace;
 struct PageBinding;
 
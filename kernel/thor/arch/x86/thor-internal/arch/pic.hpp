@@ -71,16 +71,31 @@ private:
 	GlobalAlarmSlot _globalAlarmInstance;
 
 private:
+	uint64_t _ownDeadline();
+
 	frg::ticket_spinlock _mutex;
 
 	uint64_t _globalDeadline;
+	// CPU that last armed the global alarm.
+	int _globalOwner = -1;
 };
 
 struct LocalApicContext {
 	friend struct GlobalApicContext;
 
+	struct LocalAlarmSlot final : AlarmTracker {
+		using AlarmTracker::fireAlarm;
+
+		void arm(uint64_t nanos) override;
+	};
+
 	LocalApicContext();
 
+	// Alarm that only fires on this CPU. Used by the per-CPU timer engine.
+	AlarmTracker *localAlarm() {
+		return &_localAlarmInstance;
+	}
+
 	static void setPreemption(uint64_t nanos);
 	static bool checkPreemption();
 
@@ -95,8 +110,11 @@ private:
 	static void _updateLocalTimer();
 
 private:
+	LocalAlarmSlot _localAlarmInstance;
+
 	uint64_t _preemptionDeadline;
 	uint64_t _globalDeadline;
+	uint64_t _localDeadline;
 };
 
 GlobalApicContext *globalApicContext();
@@ -111,6 +129,9 @@ uint64_t localTicks();
 
 void calibrateApicTimer();
 
+// Sets up the timer engine of the current CPU. Requires a calibrated timer.
+void initializeLocalTimerEngine();
+
 void acknowledgeIpi();
 
 void raiseInitAssertIpi(uint32_t dest_apic_id);
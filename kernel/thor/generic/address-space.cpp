@@ -1,8 +1,10 @@
+#include <atomic>
 #include <cstddef>
 #include <type_traits>
 #include <thor-internal/address-space.hpp>
 #include <thor-internal/coroutine.hpp>
 #include <thor-internal/physical.hpp>
+#include <thor-internal/profile.hpp>
 #include <thor-internal/fiber.hpp>
 #include <frg/container_of.hpp>
 #include <thor-internal/types.hpp>
@@ -1055,7 +1057,7 @@ coroutine<size_t> VirtualSpace::readPartialSpace(uintptr_t address,
 			auto irqLock = frg::guard(&irqMutex());
 			auto spaceGuard = frg::guard(&_snapshotMutex);
 
-			mapping = _findMapping(address);
+			mapping = _findMapping(address + progress);
 		}
 		if(!mapping)
 			co_return progress;
@@ -1120,6 +1122,12 @@ coroutine<size_t> VirtualSpace::readPartialSpace(uintptr_t address,
 
 coroutine<size_t> VirtualSpace::writePartialSpace(uintptr_t address,
 		const void *buffer, size_t size, smarter::shared_ptr<WorkQueue> wq) {
+	return _writePartialSpace(address, buffer, size, MappingFlags::null, std::move(wq));
+}
+
+coroutine<size_t> VirtualSpace::_writePartialSpace(uintptr_t address,
+		const void *buffer, size_t size, MappingFlags requiredFlags,
+		smarter::shared_ptr<WorkQueue> wq) {
 	// We do not take _consistencyMutex here since we are only interested in a snapshot.
 
 	size_t progress = 0;
@@ -1129,10 +1137,12 @@ coroutine<size_t> VirtualSpace::writePartialSpace(uintptr_t address,
 			auto irqLock = frg::guard(&irqMutex());
 			auto spaceGuard = frg::guard(&_snapshotMutex);
 
-			mapping = _findMapping(address);
+			mapping = _findMapping(address + progress);
 		}
 		if(!mapping)
 			co_return progress;
+		if((mapping->flags & requiredFlags) != requiredFlags)
+			co_return progress;
 
 		auto startInMapping = address + progress - mapping->address;
 		auto limitInMapping = frg::min(size - progress, mapping->length - startInMapping);
@@ -1180,6 +1190,9 @@ coroutine<size_t> VirtualSpace::writePartialSpace(uintptr_t address,
 			memcpy(reinterpret_cast<std::byte *>(accessor.get()) + misalign,
 					reinterpret_cast<const std::byte *>(buffer) + progress,
 					chunk);
+			// We bypass the page tables, so the dirty bits do not track this write.
+			mapping->view->markDirty((mapping->viewOffset + offsetInMapping) & ~(kPageSize - 1),
+					kPageSize);
 			progress += chunk;
 		}
 
@@ -1192,6 +1205,81 @@ coroutine<size_t> VirtualSpace::writePartialSpace(uintptr_t address,
 	co_return progress;
 }
 
+coroutine<frg::expected<Error>> VirtualSpace::copyFromSpace(uintptr_t address,
+		VirtualSpace *source, uintptr_t sourceAddress, size_t size,
+		smarter::shared_ptr<WorkQueue> wq) {
+	// We do not take _consistencyMutex of either space since we are only interested in a snapshot.
+
+	size_t progress = 0;
+	while(progress < size) {
+		smarter::shared_ptr<Mapping> mapping;
+		{
+			auto irqLock = frg::guard(&irqMutex());
+			auto spaceGuard = frg::guard(&source->_snapshotMutex);
+
+			mapping = source->_findMapping(sourceAddress + progress);
+		}
+		if(!mapping || !(mapping->flags & MappingFlags::protRead))
+			co_return Error::remoteFault;
+
+		auto startInMapping = sourceAddress + progress - mapping->address;
+		auto limitInMapping = frg::min(size - progress, mapping->length - startInMapping);
+		// Otherwise, _findMapping() would have returned garbage.
+		assert(limitInMapping);
+
+		auto lockOutcome = co_await mapping->lockVirtualRange(startInMapping, limitInMapping, wq);
+		if(!lockOutcome)
+			co_return Error::remoteFault;
+
+		FetchFlags fetchFlags = 0;
+		if(mapping->flags & MappingFlags::dontRequireBacking)
+			fetchFlags |= fetchDisallowBacking;
+
+		// This loop iterates until we hit the end of the mapping.
+		Error error = Error::success;
+		while(progress < size) {
+			auto offsetInMapping = sourceAddress + progress - mapping->address;
+			if(offsetInMapping == mapping->length)
+				break;
+			assert(offsetInMapping < mapping->length);
+
+			auto touchOutcome = co_await mapping->view->fetchRange(
+					(mapping->viewOffset + offsetInMapping) & ~(kPageSize - 1), fetchFlags, wq);
+			if(!touchOutcome) {
+				error = Error::remoteFault;
+				break;
+			}
+
+			auto [physical, cacheMode] = mapping->resolveRange(
+					offsetInMapping & ~(kPageSize - 1));
+			// Since we have locked the MemoryView, the physical address remains valid here.
+			assert(physical != PhysicalAddr(-1));
+
+			// Copy straight from the source page to the destination pages;
+			// the source page stays locked until the copy completes.
+			PageAccessor accessor{physical};
+			auto misalign = offsetInMapping & (kPageSize - 1);
+			auto chunk = frg::min(size - progress, kPageSize - misalign);
+			assert(chunk); // Otherwise, we would have finished already.
+			auto written = co_await _writePartialSpace(address + progress,
+					reinterpret_cast<const std::byte *>(accessor.get()) + misalign,
+					chunk, MappingFlags::protWrite, wq);
+			if(written != chunk) {
+				error = Error::fault;
+				break;
+			}
+			progress += chunk;
+		}
+
+		mapping->unlockVirtualRange(startInMapping, limitInMapping);
+
+		if(error != Error::success)
+			co_return error;
+	}
+
+	co_return {};
+}
+
 // --------------------------------------------------------
 // AddressSpace
 // --------------------------------------------------------
@@ -1201,12 +1289,19 @@ void AddressSpace::activate(smarter::shared_ptr<AddressSpace, BindableHandle> sp
 	PageSpace::activate(smarter::shared_ptr<PageSpace>{space->selfPtr.lock(), pageSpace});
 }
 
+namespace {
+	std::atomic<uint64_t> nextProfileId{1};
+}
+
 AddressSpace::AddressSpace()
-: VirtualSpace{&ops_}, ops_{this} { }
+: VirtualSpace{&ops_},
+		profileId{nextProfileId.fetch_add(1, std::memory_order_relaxed)},
+		ops_{this} { }
 
 AddressSpace::~AddressSpace() { }
 
 void AddressSpace::dispose(BindableHandle) {
+	retireProfileSpace(this);
 	retire();
 }
 
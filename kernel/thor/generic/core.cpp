@@ -35,6 +35,107 @@ void IrqSpinlock::unlock() {
 // Memory management
 // --------------------------------------------------------
 
+void KernelHeapLock::lock() {
+	irqMutex().lock();
+	void *self = getCpuData();
+	auto owner = _owner.load(std::memory_order_relaxed);
+	if(owner == self) {
+		_depth++;
+		return;
+	}
+	if(owner)
+		_numContended.fetch_add(1, std::memory_order_relaxed);
+	_spinlock.lock();
+	_owner.store(self, std::memory_order_relaxed);
+	_depth = 1;
+}
+
+void KernelHeapLock::unlock() {
+	assert(_owner.load(std::memory_order_relaxed) == getCpuData());
+	if(!--_depth) {
+		_owner.store(nullptr, std::memory_order_relaxed);
+		_spinlock.unlock();
+	}
+	irqMutex().unlock();
+}
+
+void KernelHeapMutex::lock() {
+	kernelHeapLock.lock();
+}
+
+void KernelHeapMutex::unlock() {
+	kernelHeapLock.unlock();
+}
+
+namespace {
+	// KASAN and allocation tracing need to observe every allocation,
+	// hence the per-CPU caches are bypassed.
+#if defined(THOR_KASAN) || defined(KERNEL_LOG_ALLOCATIONS)
+	constexpr bool useHeapCaches = false;
+#else
+	constexpr bool useHeapCaches = true;
+#endif
+
+	// Non-atomic increment; statistics are only written by the owning CPU.
+	void bumpStatistic(std::atomic<uint64_t> &counter) {
+		counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	}
+}
+
+void *KernelAlloc::allocate(size_t size) {
+	auto k = KernelHeapCache::sizeClassOf(size);
+	if(!useHeapCaches || k < 0)
+		return _pool->allocate(size);
+
+	auto irqLock = frg::guard(&irqMutex());
+	auto &sc = getCpuData()->heapCache.classes[k];
+	bumpStatistic(sc.numAllocations);
+	if(!sc.numObjects)
+		_refill(sc, k);
+	return sc.objects[--sc.numObjects];
+}
+
+void KernelAlloc::deallocate(void *pointer, size_t size) {
+	auto k = KernelHeapCache::sizeClassOf(size);
+	if(!useHeapCaches || k < 0 || !pointer) {
+		_pool->deallocate(pointer, size);
+		return;
+	}
+
+	auto irqLock = frg::guard(&irqMutex());
+	auto &sc = getCpuData()->heapCache.classes[k];
+	bumpStatistic(sc.numDeallocations);
+	if(sc.numObjects == KernelHeapCache::magazineSize)
+		_flush(sc, k);
+	sc.objects[sc.numObjects++] = pointer;
+}
+
+void *KernelAlloc::reallocate(void *pointer, size_t size) {
+	// Round up such that the object can later be deallocated into the cache of its class.
+	auto k = KernelHeapCache::sizeClassOf(size);
+	if(useHeapCaches && k >= 0)
+		size = KernelHeapCache::sizeOfClass(k);
+	return _pool->realloc(pointer, size);
+}
+
+void KernelAlloc::free(void *pointer) {
+	_pool->free(pointer);
+}
+
+void KernelAlloc::_refill(KernelHeapCache::SizeClass &sc, int k) {
+	bumpStatistic(sc.numRefills);
+	auto lock = frg::guard(&kernelHeapLock);
+	while(sc.numObjects < KernelHeapCache::batchSize)
+		sc.objects[sc.numObjects++] = _pool->allocate(KernelHeapCache::sizeOfClass(k));
+}
+
+void KernelAlloc::_flush(KernelHeapCache::SizeClass &sc, int k) {
+	bumpStatistic(sc.numFlushes);
+	auto lock = frg::guard(&kernelHeapLock);
+	while(sc.numObjects > KernelHeapCache::magazineSize - KernelHeapCache::batchSize)
+		_pool->deallocate(sc.objects[--sc.numObjects], KernelHeapCache::sizeOfClass(k));
+}
+
 KernelVirtualMemory::KernelVirtualMemory() {
 	// The size is chosen arbitrarily here; 2 GiB of kernel heap is sufficient for now.
 	uintptr_t vmBase = 0xFFFF'E000'0000'0000;
@@ -226,12 +327,9 @@ constinit frg::manual_box<PhysicalChunkAllocator> physicalAllocator = {};
 
 constinit frg::manual_box<KernelVirtualAlloc> kernelVirtualAlloc = {};
 
-constinit frg::manual_box<
-	frg::slab_pool<
-		KernelVirtualAlloc,
-		IrqSpinlock
-	>
-> kernelHeap = {};
+constinit KernelHeapLock kernelHeapLock;
+
+constinit frg::manual_box<KernelSlabPool> kernelHeap = {};
 
 constinit frg::manual_box<KernelAlloc> kernelAlloc = {};
 
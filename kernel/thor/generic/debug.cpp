@@ -1,5 +1,10 @@
+#include <async/algorithm.hpp>
 #include <thor-internal/cpu-data.hpp>
 #include <thor-internal/debug.hpp>
+#include <thor-internal/fiber.hpp>
+#include <thor-internal/main.hpp>
+#include <thor-internal/ring-buffer.hpp>
+#include <thor-internal/timer.hpp>
 #include <thor-internal/arch/stack.hpp>
 
 namespace thor {
@@ -142,8 +147,157 @@ namespace {
 	};
 
 	constinit LogProcessor logProcessor;
+
+	// Ring that backs the kernel-log kerncfg object. Allocated by initLogDrain.
+	constinit LogRingBuffer *kernelLogRing = nullptr;
+
+	void printMessage(const char *text, size_t length, bool toKernelLog) {
+		for(size_t i = 0; i < length; i++)
+			logProcessor.print(text[i]);
+		logProcessor.print('\n');
+
+		// LogRingBuffer::enqueue() takes irqMutex(), hence urgent messages skip the ring.
+		// Consumers are woken up by the drain fiber.
+		if(toKernelLog && kernelLogRing)
+			kernelLogRing->enqueue(text, length, true);
+	}
+} // anonymous namespace
+
+// --------------------------------------------------------
+// Deferred log output.
+// --------------------------------------------------------
+
+// InfoSink appends messages to a per-CPU SingleContextRecordRing without taking logMutex.
+// A fiber merges the records of all CPUs by timestamp and feeds them to the (slow)
+// LogHandlers. Until the rings are allocated, and for messages that do not fit into
+// a record, InfoSink prints synchronously instead.
+
+namespace {
+	constexpr size_t maxRecordText = 256;
+
+	// Bounds the time that records stay in the rings if they were emitted
+	// with IRQs disabled (in which case no wakeup is sent).
+	constexpr uint64_t logPollInterval = 50'000'000;
+
+	struct LogRecordHeader {
+		uint64_t timestamp;
+	};
+
+	struct LogRecord {
+		LogRecordHeader header;
+		char text[maxRecordText];
+	};
+
+	// Set if a wakeup of the drain fiber is already pending.
+	constinit std::atomic<bool> logDrainRequested{false};
+	async::recurring_event logDrainEvent;
+
+	void requestLogDrain() {
+		if(logDrainRequested.load(std::memory_order_relaxed))
+			return;
+		if(!intsAreEnabled())
+			return;
+		if(!logDrainRequested.exchange(true, std::memory_order_relaxed))
+			logDrainEvent.raise();
+	}
+
+	// Prints up to limit records, oldest first. Returns true if records may remain.
+	// Must be called with logMutex held and IRQs disabled.
+	bool drainLogRings(size_t limit) {
+		for(size_t n = 0; n < limit; n++) {
+			// Each ring is ordered by itself; find the ring with the oldest head.
+			CpuData *oldest = nullptr;
+			uint64_t oldestTimestamp = 0;
+			for(int i = 0; i < getCpuCount(); i++) {
+				auto cpuData = getCpuData(i);
+				auto ring = cpuData->localLogRing.load(std::memory_order_acquire);
+				if(!ring)
+					continue;
+
+				LogRecordHeader header;
+				auto [success, recordPtr, newPtr, size] = ring->dequeueAt(cpuData->logDeqPtr,
+						&header, sizeof(LogRecordHeader));
+				if(!success)
+					continue;
+				assert(size == sizeof(LogRecordHeader));
+				if(!oldest || header.timestamp < oldestTimestamp) {
+					oldest = cpuData;
+					oldestTimestamp = header.timestamp;
+				}
+			}
+			if(!oldest)
+				return false;
+
+			LogRecord record;
+			auto ring = oldest->localLogRing.load(std::memory_order_relaxed);
+			auto [success, recordPtr, newPtr, size] = ring->dequeueAt(oldest->logDeqPtr,
+					&record, sizeof(LogRecord));
+			// Only the drain consumes records, hence the ring cannot have become empty.
+			assert(success);
+			assert(size >= sizeof(LogRecordHeader));
+			if(recordPtr != oldest->logDeqPtr) {
+				const char lostMsg[] = "thor: Log records were lost due to ring overflow";
+				printMessage(lostMsg, sizeof(lostMsg) - 1, true);
+			}
+			oldest->logDeqPtr = newPtr;
+
+			printMessage(record.text, size - sizeof(LogRecordHeader), true);
+		}
+		return true;
+	}
+
+	initgraph::Task initLogDrain{&globalInitEngine, "generic.init-log-drain",
+		initgraph::Requires{getTaskingAvailableStage()},
+		[] {
+			void *kernelLogMemory = kernelAlloc->allocate(1 << 18);
+			kernelLogRing = frg::construct<LogRingBuffer>(*kernelAlloc,
+					reinterpret_cast<uintptr_t>(kernelLogMemory), 1 << 18);
+
+			KernelFiber::run([=] {
+				while(true) {
+					// Allocate rings for CPUs that were booted since the last iteration.
+					for(int i = 0; i < getCpuCount(); i++) {
+						auto cpuData = getCpuData(i);
+						if(cpuData->localLogRing.load(std::memory_order_relaxed))
+							continue;
+						cpuData->localLogRing.store(
+								frg::construct<SingleContextRecordRing>(*kernelAlloc),
+								std::memory_order_release);
+					}
+
+					// Printing a record to a slow (e.g., serial) console takes a while;
+					// print one record at a time to re-enable IRQs in between.
+					logDrainRequested.store(false, std::memory_order_relaxed);
+					while(true) {
+						StatelessIrqLock irqLock;
+						auto lock = frg::guard(&logMutex);
+
+						if(!drainLogRings(1))
+							break;
+					}
+					kernelLogRing->wakeup();
+
+					KernelFiber::asyncBlockCurrent(async::race_and_cancel(
+						[] (async::cancellation_token cancellation) {
+							return logDrainEvent.async_wait_if([] () -> bool {
+								return !logDrainRequested.load(std::memory_order_relaxed);
+							}, cancellation);
+						},
+						[] (async::cancellation_token cancellation) {
+							return generalTimerEngine()->sleepFor(logPollInterval,
+									cancellation, logPollInterval);
+						}
+					));
+				}
+			});
+		}
+	};
 } // anonymous namespace
 
+LogRingBuffer *getKernelLogRing() {
+	return kernelLogRing;
+}
+
 void panic() {
 	disableInts();
 	while(true)
@@ -155,19 +309,39 @@ constinit frg::stack_buffer_logger<UrgentSink> urgentLogger;
 constinit frg::stack_buffer_logger<PanicSink> panicLogger;
 
 void InfoSink::operator() (const char *msg) {
+	auto length = strlen(msg);
+
+	if(length <= maxRecordText) {
+		// Disable IRQs such that this CPU is the only producer of its ring.
+		StatelessIrqLock irqLock;
+
+		auto ring = getCpuData()->localLogRing.load(std::memory_order_acquire);
+		if(ring) {
+			LogRecord record;
+			record.header.timestamp = systemClockSource()->currentNanos();
+			memcpy(record.text, msg, length);
+			ring->enqueue(&record, sizeof(LogRecordHeader) + length);
+
+			irqLock.unlock();
+			requestLogDrain();
+			return;
+		}
+	}
+
 	auto irqLock = frg::guard(&irqMutex());
 	auto lock = frg::guard(&logMutex);
 
-	logProcessor.print(msg);
-	logProcessor.print('\n');
+	// Preserve the order of messages that are still buffered.
+	drainLogRings(SIZE_MAX);
+	printMessage(msg, length, true);
 }
 
 void UrgentSink::operator() (const char *msg) {
 	StatelessIrqLock irqLock;
 	auto lock = frg::guard(&logMutex);
 
-	logProcessor.print(msg);
-	logProcessor.print('\n');
+	drainLogRings(SIZE_MAX);
+	printMessage(msg, strlen(msg), false);
 }
 
 void PanicSink::operator() (const char *msg) {
@@ -176,8 +350,9 @@ void PanicSink::operator() (const char *msg) {
 	{
 		auto lock = frg::guard(&logMutex);
 
-		logProcessor.print(msg);
-		logProcessor.print('\n');
+		// Flush buffered messages; they likely explain the panic.
+		drainLogRings(SIZE_MAX);
+		printMessage(msg, strlen(msg), false);
 	}
 
 #ifdef THOR_HAS_FRAME_POINTERS
@@ -13,6 +13,7 @@
 #include <thor-internal/irq.hpp>
 #include <thor-internal/kernlet.hpp>
 #include <thor-internal/physical.hpp>
+#include <thor-internal/profile.hpp>
 #include <thor-internal/random.hpp>
 #include <thor-internal/stream.hpp>
 #include <thor-internal/thread.hpp>
@@ -108,6 +109,9 @@ HelError translateError(Error error) {
 	case Error::bufferTooSmall: return kHelErrBufferTooSmall;
 	case Error::fault: return kHelErrFault;
 	case Error::remoteFault: return kHelErrRemoteFault;
+	case Error::illegalArgs: return kHelErrIllegalArgs;
+	case Error::illegalState: return kHelErrIllegalState;
+	case Error::noBandwidth: return kHelErrNoBandwidth;
 	default:
 		assert(!"Unexpected error");
 		__builtin_unreachable();
@@ -369,15 +373,19 @@ HelError helAllocateMemory(size_t size, uint32_t flags,
 		if(!readUserMemory(&effective, restrictions, sizeof(HelAllocRestrictions)))
 			return kHelErrFault;
 
+	bool decommittable = flags & kHelAllocDecommittable;
+
 	smarter::shared_ptr<AllocatedMemory> memory;
 	if(flags & kHelAllocContinuous) {
 		memory = smarter::allocate_shared<AllocatedMemory>(*kernelAlloc, size, effective.addressBits,
-				size, kPageSize);
+				size, kPageSize, decommittable);
 	}else if(flags & kHelAllocOnDemand) {
-		memory = smarter::allocate_shared<AllocatedMemory>(*kernelAlloc, size, effective.addressBits);
+		memory = smarter::allocate_shared<AllocatedMemory>(*kernelAlloc, size, effective.addressBits,
+				kPageSize, kPageSize, decommittable);
 	}else{
 		// TODO: 
-		memory = smarter::allocate_shared<AllocatedMemory>(*kernelAlloc, size, effective.addressBits);
+		memory = smarter::allocate_shared<AllocatedMemory>(*kernelAlloc, size, effective.addressBits,
+				kPageSize, kPageSize, decommittable);
 	}
 	memory->selfPtr = memory;
 
@@ -417,6 +425,34 @@ HelError helResizeMemory(HelHandle handle, size_t newSize) {
 	return kHelErrNone;
 }
 
+HelError helDecommitMemory(HelHandle handle, uintptr_t offset, size_t size) {
+	auto this_thread = getCurrentThread();
+	auto this_universe = this_thread->getUniverse();
+
+	smarter::shared_ptr<MemoryView> memory;
+	{
+		auto irq_lock = frg::guard(&irqMutex());
+		Universe::Guard universe_guard(this_universe->lock);
+
+		auto wrapper = this_universe->getDescriptor(universe_guard, handle);
+		if(!wrapper)
+			return kHelErrNoDescriptor;
+		if(!wrapper->is<MemoryViewDescriptor>())
+			return kHelErrBadDescriptor;
+		memory = wrapper->get<MemoryViewDescriptor>().memory;
+	}
+
+	auto outcome = Thread::asyncBlockCurrent(memory->decommitRange(offset, size));
+	if(!outcome) {
+		if(outcome.error() == Error::illegalObject)
+			return kHelErrUnsupportedOperation;
+		assert(outcome.error() == Error::illegalArgs);
+		return kHelErrIllegalArgs;
+	}
+
+	return kHelErrNone;
+}
+
 HelError helCreateManagedMemory(size_t size, uint32_t flags,
 		HelHandle *backing_handle, HelHandle *frontal_handle) {
 	if(flags & ~uint32_t{kHelManagedReadahead})
@@ -962,6 +998,37 @@ HelError helSubmitSynchronizeSpace(HelHandle spaceHandle, void *pointer, size_t
 	return kHelErrNone;
 }
 
+HelError helSetSpaceName(HelHandle spaceHandle, const char *name, size_t length) {
+	auto thisThread = getCurrentThread();
+	auto thisUniverse = thisThread->getUniverse();
+
+	// nameProfileSpace() truncates longer names anyway.
+	char buffer[64];
+	auto chunk = frg::min(length, sizeof(buffer));
+	if(!readUserArray(name, buffer, chunk))
+		return kHelErrFault;
+
+	smarter::shared_ptr<AddressSpace, BindableHandle> space;
+	{
+		auto irqLock = frg::guard(&irqMutex());
+		Universe::Guard universeGuard(thisUniverse->lock);
+
+		if(spaceHandle == kHelNullHandle) {
+			space = thisThread->getAddressSpace().lock();
+		}else{
+			auto spaceWrapper = thisUniverse->getDescriptor(universeGuard, spaceHandle);
+			if(!spaceWrapper)
+				return kHelErrNoDescriptor;
+			if(!spaceWrapper->is<AddressSpaceDescriptor>())
+				return kHelErrBadDescriptor;
+			space = spaceWrapper->get<AddressSpaceDescriptor>().space;
+		}
+	}
+
+	nameProfileSpace(space.get(), frg::string_view{buffer, chunk});
+	return kHelErrNone;
+}
+
 HelError helPointerPhysical(const void *pointer, uintptr_t *physical) {
 	auto thisThread = getCurrentThread();
 	auto space = thisThread->getAddressSpace().lock();
@@ -1608,6 +1675,38 @@ HelError helQueryThreadStats(HelHandle handle, HelThreadStats *user_stats) {
 	return kHelErrNone;
 }
 
+HelError helQueryCpuStats(int cpu, HelCpuStats *user_stats) {
+	if(cpu < 0 || cpu >= getCpuCount())
+		return kHelErrIllegalArgs;
+	auto cpuData = getCpuData(cpu);
+
+	HelCpuStats stats;
+	memset(&stats, 0, sizeof(HelCpuStats));
+	stats.timerIrqs = cpuData->numTimerIrqs.load(std::memory_order_relaxed);
+	stats.neededTimerIrqs = cpuData->numNeededTimerIrqs.load(std::memory_order_relaxed);
+	stats.numaNode = cpuData->numaNode;
+
+	if(!writeUserObject(user_stats, stats))
+		return kHelErrFault;
+
+	return kHelErrNone;
+}
+
+HelError helQueryNumaNodeStats(int node, HelNumaNodeStats *user_stats) {
+	if(node < 0 || node >= physicalAllocator->numNumaNodes())
+		return kHelErrIllegalArgs;
+
+	HelNumaNodeStats stats;
+	memset(&stats, 0, sizeof(HelNumaNodeStats));
+	stats.freeMemory = physicalAllocator->numFreePagesOfNode(node) * kPageSize;
+	stats.usedMemory = physicalAllocator->numUsedPagesOfNode(node) * kPageSize;
+
+	if(!writeUserObject(user_stats, stats))
+		return kHelErrFault;
+
+	return kHelErrNone;
+}
+
 HelError helSetPriority(HelHandle handle, int priority) {
 	auto this_thread = getCurrentThread();
 	auto this_universe = this_thread->getUniverse();
@@ -1627,7 +1726,91 @@ HelError helSetPriority(HelHandle handle, int priority) {
 		thread = remove_tag_cast(thread_wrapper->get<ThreadDescriptor>().thread);
 	}
 
-	Scheduler::setPriority(thread.get(), priority);
+	if(auto error = Scheduler::setPriority(thread.get(), priority); error != Error::success)
+		return translateError(error);
+
+	return kHelErrNone;
+}
+
+HelError helSetSchedParams(HelHandle handle, const HelSchedParams *paramsPtr) {
+	HelSchedParams userParams;
+	if(!readUserObject(paramsPtr, userParams))
+		return kHelErrFault;
+
+	ScheduleParams params;
+	switch(userParams.policy) {
+	case kHelSchedFair: params.policy = SchedulePolicy::fair; break;
+	case kHelSchedFifo: params.policy = SchedulePolicy::fifo; break;
+	case kHelSchedRoundRobin: params.policy = SchedulePolicy::roundRobin; break;
+	case kHelSchedDeadline: params.policy = SchedulePolicy::deadline; break;
+	default:
+		return kHelErrIllegalArgs;
+	}
+	params.priority = userParams.priority;
+	params.runtime = userParams.runtime;
+	params.deadline = userParams.deadline;
+	params.period = userParams.period;
+
+	auto this_thread = getCurrentThread();
+	auto this_universe = this_thread->getUniverse();
+
+	smarter::shared_ptr<Thread> thread;
+	if(handle == kHelThisThread) {
+		thread = this_thread.lock();
+	}else{
+		auto irq_lock = frg::guard(&irqMutex());
+		Universe::Guard universe_guard(this_universe->lock);
+
+		auto thread_wrapper = this_universe->getDescriptor(universe_guard, handle);
+		if(!thread_wrapper)
+			return kHelErrNoDescriptor;
+		if(!thread_wrapper->is<ThreadDescriptor>())
+			return kHelErrBadDescriptor;
+		thread = remove_tag_cast(thread_wrapper->get<ThreadDescriptor>().thread);
+	}
+
+	if(auto error = Scheduler::setParams(thread.get(), params); error != Error::success)
+		return translateError(error);
+
+	return kHelErrNone;
+}
+
+HelError helGetSchedParams(HelHandle handle, HelSchedParams *paramsPtr) {
+	auto this_thread = getCurrentThread();
+	auto this_universe = this_thread->getUniverse();
+
+	smarter::shared_ptr<Thread> thread;
+	if(handle == kHelThisThread) {
+		thread = this_thread.lock();
+	}else{
+		auto irq_lock = frg::guard(&irqMutex());
+		Universe::Guard universe_guard(this_universe->lock);
+
+		auto thread_wrapper = this_universe->getDescriptor(universe_guard, handle);
+		if(!thread_wrapper)
+			return kHelErrNoDescriptor;
+		if(!thread_wrapper->is<ThreadDescriptor>())
+			return kHelErrBadDescriptor;
+		thread = remove_tag_cast(thread_wrapper->get<ThreadDescriptor>().thread);
+	}
+
+	auto params = Scheduler::getParams(thread.get());
+
+	HelSchedParams userParams;
+	memset(&userParams, 0, sizeof(HelSchedParams));
+	switch(params.policy) {
+	case SchedulePolicy::fair: userParams.policy = kHelSchedFair; break;
+	case SchedulePolicy::fifo: userParams.policy = kHelSchedFifo; break;
+	case SchedulePolicy::roundRobin: userParams.policy = kHelSchedRoundRobin; break;
+	case SchedulePolicy::deadline: userParams.policy = kHelSchedDeadline; break;
+	}
+	userParams.priority = params.priority;
+	userParams.runtime = params.runtime;
+	userParams.deadline = params.deadline;
+	userParams.period = params.period;
+
+	if(!writeUserObject(paramsPtr, userParams))
+		return kHelErrFault;
 
 	return kHelErrNone;
 }
@@ -1985,6 +2168,7 @@ HelError helStoreRegisters(HelHandle handle, int set, const void *image) {
 #endif
 	}else if(set == kHelRegsSimd) {
 #if defined(__x86_64__)
+		thread->_executor._invalidateSimdState();
 		if(!readUserMemory(thread->_executor._fxState(), image, Executor::determineSimdSize()))
 			return kHelErrFault;
 #elif defined(__aarch64__)
@@ -2042,6 +2226,7 @@ HelError helSubmitAwaitClock(uint64_t counter, HelHandle queue_handle, uintptr_t
 
 			worklet.setup(&Closure::elapsed, getCurrentThread()->mainWorkQueue());
 			PrecisionTimerNode::setup(nanos, cancelEvent, &worklet);
+			PrecisionTimerNode::setSlack(defaultUserTimerSlack);
 		}
 
 		void handleCancellation() override {
@@ -2140,6 +2325,8 @@ HelError helSubmitAsync(HelHandle handle, const HelAction *actions, size_t count
 		StreamNode transmit;
 		QueueSource mainSource;
 		QueueSource dataSource;
+		// Kernel copy of the HelSgItems of kHelActionSendFromBufferSg flows.
+		frg::unique_memory<KernelAlloc> sgList;
 		union {
 			HelSimpleResult helSimpleResult;
 			HelHandleResult helHandleResult;
@@ -2207,27 +2394,41 @@ HelError helSubmitAsync(HelHandle handle, const HelAction *actions, size_t count
 				ipcSize += ipcSourceSize(sizeof(HelSimpleResult));
 				break;
 			case kHelActionSendFromBufferSg: {
-				size_t length = 0;
-				auto sglist = reinterpret_cast<HelSgItem *>(recipe->buffer);
-				for(size_t j = 0; j < recipe->length; j++) {
-					HelSgItem item;
-					readUserObject(sglist + j, item);
-					length += item.length;
-				}
+				// Bound the kernel allocation below by the size of a page.
+				if(recipe->length > kPageSize / sizeof(HelSgItem))
+					return kHelErrIllegalArgs;
 
-				frg::unique_memory<KernelAlloc> buffer(*kernelAlloc, length);
-				size_t offset = 0;
+				// Take a snapshot of the list such that its length cannot change later on.
+				auto sglist = reinterpret_cast<HelSgItem *>(recipe->buffer);
+				frg::unique_memory<KernelAlloc> sgCopy(*kernelAlloc,
+						recipe->length * sizeof(HelSgItem));
+				auto sg = reinterpret_cast<HelSgItem *>(sgCopy.data());
+				size_t length = 0;
 				for(size_t j = 0; j < recipe->length; j++) {
-					HelSgItem item;
-					readUserObject(sglist + j, item);
-					if(!readUserMemory(reinterpret_cast<char *>(buffer.data()) + offset,
-							reinterpret_cast<char *>(item.buffer), item.length))
+					if(!readUserObject(sglist + j, sg[j]))
 						return kHelErrFault;
-					offset += item.length;
+					length += sg[j].length;
 				}
 
-				node->_tag = kTagSendKernelBuffer;
-				node->_inBuffer = std::move(buffer);
+				if(length <= kPageSize) {
+					frg::unique_memory<KernelAlloc> buffer(*kernelAlloc, length);
+					size_t offset = 0;
+					for(size_t j = 0; j < recipe->length; j++) {
+						if(!readUserMemory(reinterpret_cast<char *>(buffer.data()) + offset,
+								reinterpret_cast<char *>(sg[j].buffer), sg[j].length))
+							return kHelErrFault;
+						offset += sg[j].length;
+					}
+
+					node->_tag = kTagSendKernelBuffer;
+					node->_inBuffer = std::move(buffer);
+				}else{
+					// Large lists are not gathered into a kernel buffer; they use the flow protocol.
+					node->_tag = kTagSendFlow;
+					node->_maxLength = length;
+					items[i].sgList = std::move(sgCopy);
+					++numFlows;
+				}
 				ipcSize += ipcSourceSize(sizeof(HelSimpleResult));
 				break;
 			}
@@ -2451,9 +2652,6 @@ HelError helSubmitAsync(HelHandle handle, const HelAction *actions, size_t count
 		// Below, we need to ensure that we always complete our own nodes
 		// before completing peer nodes.
 
-		// The size of this array must be a power of two.
-		frg::array<frg::unique_memory<KernelAlloc>, 2> xferBuffers;
-
 		size_t i = 0;
 		size_t seenFlows = 0; // Iterates through flows.
 		while(seenFlows < numFlows) {
@@ -2475,13 +2673,30 @@ HelError helSubmitAsync(HelHandle handle, const HelAction *actions, size_t count
 				continue;
 			}
 
-			if(recipe->type == kHelActionSendFromBuffer
-					&& node->tag() == kTagSendFlow
+			// Senders transmit one or more segments of their address space.
+			HelSgItem singleSegment{recipe->buffer, recipe->length};
+			const HelSgItem *segments = &singleSegment;
+			size_t numSegments = 1;
+			if(recipe->type == kHelActionSendFromBufferSg) {
+				segments = reinterpret_cast<const HelSgItem *>(item->sgList.data());
+				numSegments = recipe->length;
+			}
+
+			if(node->tag() == kTagSendFlow
 					&& peer->tag() == kTagRecvKernelBuffer) {
-				frg::unique_memory<KernelAlloc> buffer(*kernelAlloc, recipe->length);
+				frg::unique_memory<KernelAlloc> buffer(*kernelAlloc, node->_maxLength);
 
 				co_await thread->mainWorkQueue()->enter();
-				auto outcome = readUserMemory(buffer.data(), recipe->buffer, recipe->length);
+				bool outcome = true;
+				size_t offset = 0;
+				for(size_t j = 0; j < numSegments; j++) {
+					if(!readUserMemory(reinterpret_cast<std::byte *>(buffer.data()) + offset,
+							segments[j].buffer, segments[j].length)) {
+						outcome = false;
+						break;
+					}
+					offset += segments[j].length;
+				}
 				if(!outcome) {
 					// We complete with fault; the remote with success.
 					// TODO: it probably makes sense to introduce a "remote fault" error.
@@ -2496,98 +2711,59 @@ HelError helSubmitAsync(HelHandle handle, const HelAction *actions, size_t count
 				peer->_transmitBuffer = std::move(buffer);
 				peer->complete();
 				node->complete();
-			}else if(recipe->type == kHelActionSendFromBuffer
-					&& node->tag() == kTagSendFlow
+			}else if(node->tag() == kTagSendFlow
 					&& peer->tag() == kTagRecvFlow) {
 				// Empty packets are handled by the generic stream code.
-				assert(recipe->length);
+				assert(node->_maxLength);
 
+				// The receiver copies each segment directly from our address space
+				// into its own, hence there is no need to buffer data in the kernel.
+				auto space = thread->getAddressSpace().get();
 				size_t progress = 0;
-				size_t numSent = 0;
-				size_t numAcked = 0;
-				bool lastTransferSent = false;
-				// Each iteration of this loop sends one transfer packet (or terminates).
-				while(true) {
-					bool anyRemoteFault = false;
-					while(numSent != numAcked) {
-						// If there is anything more to send, we only need to wait until
-						// at least one buffer is not in-flight (otherwise, we wait for all).
-						if(!lastTransferSent && numSent - numAcked < xferBuffers.size())
-							break;
-						auto ackPacket = co_await node->flowQueue.async_get();
-						assert(ackPacket);
-						if(ackPacket->fault)
-							anyRemoteFault = true;
-						++numAcked;
-					}
-
-					if(lastTransferSent) {
-						if(anyRemoteFault) {
-							node->_error = Error::remoteFault;
-						}else{
-							node->_error = Error::success;
-						}
-						break;
-					}
+				bool anyFault = false;
+				bool anyRemoteFault = false;
+				for(size_t j = 0; j < numSegments; j++) {
+					if(!segments[j].length)
+						continue;
+					progress += segments[j].length;
 
-					// If we encounter remote faults, we terminate.
-					if(anyRemoteFault) {
-						// Send the packet (may deallocate the peer!).
-						peer->flowQueue.put({ .terminate = true });
-						++numSent;
-
-						// Retrieve but ignore all acks.
-						assert(numSent > numAcked);
-						while(numSent != numAcked) {
-							auto ackPacket = co_await node->flowQueue.async_get();
-							assert(ackPacket);
-							++numAcked;
-						}
+					// Send the packet (may deallocate the peer!).
+					bool lastTransfer = (progress == node->_maxLength);
+					peer->flowQueue.put({
+						.space = space,
+						.address = reinterpret_cast<uintptr_t>(segments[j].buffer),
+						.size = segments[j].length,
+						.terminate = lastTransfer
+					});
 
-						node->_error = Error::remoteFault;
+					auto ackPacket = co_await node->flowQueue.async_get();
+					assert(ackPacket);
+					if(ackPacket->fault)
+						anyRemoteFault = true;
+					if(ackPacket->remoteFault)
+						anyFault = true;
+					if(lastTransfer)
 						break;
-					}
 
-					// Prepare a buffer an send it.
-					assert(numSent - numAcked < xferBuffers.size());
-					auto &xb = xferBuffers[numSent & (xferBuffers.size() - 1)];
-					if(!xb.size())
-						xb = frg::unique_memory<KernelAlloc>{*kernelAlloc, 4096};
-
-					auto chunkSize = frg::min(recipe->length - progress, xb.size());
-					assert(chunkSize);
-
-					co_await thread->mainWorkQueue()->enter();
-					auto outcome = readUserMemory(xb.data(),
-							reinterpret_cast<std::byte *>(recipe->buffer) + progress, chunkSize);
-					if(!outcome) {
+					// If we encounter faults, we terminate.
+					if(anyFault || anyRemoteFault) {
 						// Send the packet (may deallocate the peer!).
-						peer->flowQueue.put({ .terminate = true, .fault = true });
-						++numSent;
-
-						// Retrieve but ignore all acks.
-						assert(numSent > numAcked);
-						while(numSent != numAcked) {
-							auto ackPacket = co_await node->flowQueue.async_get();
-							assert(ackPacket);
-							++numAcked;
-						}
+						peer->flowQueue.put({ .terminate = true });
 
-						node->_error = Error::fault;
+						// Retrieve but ignore the ack.
+						auto ackPacket = co_await node->flowQueue.async_get();
+						assert(ackPacket);
 						break;
 					}
-
-					lastTransferSent = (progress + chunkSize == recipe->length);
-					// Send the packet (may deallocate the peer!).
-					peer->flowQueue.put({
-						.data = xb.data(),
-						.size = chunkSize,
-						.terminate = lastTransferSent
-					});
-					++numSent;
-					progress += chunkSize;
 				}
 
+				if(anyFault) {
+					node->_error = Error::fault;
+				}else if(anyRemoteFault) {
+					node->_error = Error::remoteFault;
+				}else{
+					node->_error = Error::success;
+				}
 				node->complete();
 			}else if(recipe->type == kHelActionRecvToBuffer
 					&& peer->tag() == kTagSendKernelBuffer) {
@@ -2614,22 +2790,28 @@ HelError helSubmitAsync(HelHandle handle, const HelAction *actions, size_t count
 
 				size_t progress = 0;
 				bool didFault = false;
+				bool didRemoteFault = false;
 				// Each iteration of this loop sends one ack packet.
 				while(true) {
 					auto xferPacket = co_await node->flowQueue.async_get();
 					assert(xferPacket);
 
-					if(xferPacket->data && !didFault) {
+					bool sourceFault = false;
+					if(xferPacket->space && !didFault && !didRemoteFault) {
 						// Otherwise, there would have been a transmission error.
 						assert(progress + xferPacket->size <= recipe->length);
 
-						co_await thread->mainWorkQueue()->enter();
-						auto outcome = writeUserMemory(
-								reinterpret_cast<std::byte *>(recipe->buffer) + progress,
-								xferPacket->data, xferPacket->size);
+						auto outcome = co_await thread->getAddressSpace()->copyFromSpace(
+								reinterpret_cast<uintptr_t>(recipe->buffer) + progress,
+								xferPacket->space, xferPacket->address, xferPacket->size,
+								thread->mainWorkQueue());
 						if(outcome) {
 							progress += xferPacket->size;
+						}else if(outcome.error() == Error::remoteFault) {
+							sourceFault = true;
+							didRemoteFault = true;
 						}else{
+							assert(outcome.error() == Error::fault);
 							didFault = true;
 						}
 					}
@@ -2641,8 +2823,8 @@ HelError helSubmitAsync(HelHandle handle, const HelAction *actions, size_t count
 							node->_error = Error::fault;
 						}else{
 							// Ack the packet (may deallocate the peer!).
-							peer->flowQueue.put({ .terminate = true });
-							if(xferPacket->fault) {
+							peer->flowQueue.put({ .terminate = true, .remoteFault = sourceFault });
+							if(xferPacket->fault || didRemoteFault) {
 								node->_error = Error::remoteFault;
 							}else{
 								node->_actualLength = progress;
@@ -2658,11 +2840,7 @@ HelError helSubmitAsync(HelHandle handle, const HelAction *actions, size_t count
 					assert(!xferPacket->fault);
 
 					// Ack the packet (may deallocate the peer!).
-					if(didFault) {
-						peer->flowQueue.put({ .fault = true });
-					}else{
-						peer->flowQueue.put({});
-					}
+					peer->flowQueue.put({ .fault = didFault, .remoteFault = sourceFault });
 				}
 
 				node->complete();
@@ -2700,6 +2878,108 @@ HelError helShutdownLane(HelHandle handle) {
 	return kHelErrNone;
 }
 
+namespace {
+	// SyncNode that blocks the current thread until the node completes.
+	struct SyncBlockNode final : SyncNode {
+		SyncBlockNode()
+		: thread{getCurrentThread().lock()} { }
+
+		void complete(bool handoff) override {
+			// This object may become invalid as soon as we set done.
+			auto t = std::move(thread);
+			done.store(true, std::memory_order_release);
+			if(handoff) {
+				Thread::handoffOther(t);
+			}else{
+				Thread::unblockOther(t);
+			}
+		}
+
+		void wait() {
+			auto wq = getCurrentThread()->mainWorkQueue();
+			while(true) {
+				if(done.load(std::memory_order_acquire))
+					break;
+				if(wq->check()) {
+					wq->run();
+					continue;
+				}
+				Thread::blockCurrent();
+			}
+		}
+
+		smarter::shared_ptr<Thread> thread;
+		std::atomic<bool> done{false};
+	};
+
+	HelError lookupSyncLane(HelHandle handle, LaneHandle &lane) {
+		auto this_universe = getCurrentThread()->getUniverse();
+		auto irq_lock = frg::guard(&irqMutex());
+		Universe::Guard universe_guard(this_universe->lock);
+
+		auto wrapper = this_universe->getDescriptor(universe_guard, handle);
+		if(!wrapper)
+			return kHelErrNoDescriptor;
+		if(!wrapper->is<LaneDescriptor>())
+			return kHelErrBadDescriptor;
+		lane = wrapper->get<LaneDescriptor>().handle;
+		return kHelErrNone;
+	}
+}
+
+HelError helSyncCall(HelHandle handle, const void *request, size_t requestLength,
+		void *reply, size_t maxReplyLength, size_t *replyLength) {
+	if(requestLength > syncMessageSize)
+		return kHelErrIllegalArgs;
+
+	LaneHandle lane;
+	if(auto error = lookupSyncLane(handle, lane); error)
+		return error;
+
+	SyncBlockNode node;
+	if(!readUserMemory(node.buffer.data(), request, requestLength))
+		return kHelErrFault;
+	node.length = requestLength;
+	node.maxLength = frg::min(maxReplyLength, syncMessageSize);
+
+	Stream::syncCall(lane, &node);
+	node.wait();
+
+	if(node.error != Error::success)
+		return translateError(node.error);
+	if(!writeUserMemory(reply, node.buffer.data(), node.length))
+		return kHelErrFault;
+	*replyLength = node.length;
+	return kHelErrNone;
+}
+
+HelError helSyncReplyAndWait(HelHandle handle, const void *reply, size_t replyLength,
+		void *request, size_t maxRequestLength, size_t *requestLength) {
+	if(replyLength > syncMessageSize)
+		return kHelErrIllegalArgs;
+
+	LaneHandle lane;
+	if(auto error = lookupSyncLane(handle, lane); error)
+		return error;
+
+	frg::array<std::byte, syncMessageSize> replyBuffer;
+	if(reply && !readUserMemory(replyBuffer.data(), reply, replyLength))
+		return kHelErrFault;
+
+	SyncBlockNode node;
+	node.maxLength = frg::min(maxRequestLength, syncMessageSize);
+
+	Stream::syncReplyAndWait(lane, reply ? replyBuffer.data() : nullptr, replyLength, &node);
+	node.wait();
+
+	if(node.error != Error::success)
+		return translateError(node.error);
+	if(!writeUserMemory(request, node.buffer.data(), node.length))
+		return kHelErrFault;
+	*requestLength = node.length;
+	return kHelErrNone;
+}
+
 HelError helFutexWait(int *pointer, int expected, int64_t deadline) {
 	auto thisThread = getCurrentThread();
 	auto space = thisThread->getAddressSpace();
@@ -2726,7 +3006,8 @@ HelError helFutexWait(int *pointer, int expected, int64_t deadline) {
 							cancellation);
 				},
 				[&] (async::cancellation_token cancellation) {
-					return generalTimerEngine()->sleep(deadline, cancellation);
+					return generalTimerEngine()->sleep(deadline, cancellation,
+							defaultUserTimerSlack);
 				}
 			)
 		);
@@ -320,15 +320,20 @@ void initializeKerncfg() {
 	// Create a fiber to manage requests to the kerncfg mbus object.
 	KernelFiber::run([=] {
 		async::detach_with_allocator(*kernelAlloc, createObject(*mbusClient));
+		async::detach_with_allocator(*kernelAlloc,
+				createByteRingObject(getKernelLogRing(), *mbusClient, "kernel-log"));
 
 #ifdef KERNEL_LOG_ALLOCATIONS
 		async::detach_with_allocator(*kernelAlloc,
 				createByteRingObject(allocLog.get(), *mbusClient, "heap-trace"));
 #endif
 
-		if(wantKernelProfile)
+		if(wantKernelProfile) {
 			async::detach_with_allocator(*kernelAlloc,
 					createByteRingObject(getGlobalProfileRing(), *mbusClient, "kernel-profile"));
+			async::detach_with_allocator(*kernelAlloc,
+					createByteRingObject(getHeapProfileRing(), *mbusClient, "kernel-heap-profile"));
+		}
 		if(wantOsTrace)
 			async::detach_with_allocator(*kernelAlloc,
 					createByteRingObject(getGlobalOsTraceRing(), *mbusClient, "os-trace"));
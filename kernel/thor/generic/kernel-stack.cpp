@@ -10,8 +10,9 @@ UniqueKernelStack UniqueKernelStack::make() {
 	size_t guardedSize = kSize + kPageSize;
 	auto pointer = KernelVirtualMemory::global().allocate(guardedSize);
 
+	// Stacks are usually allocated on the CPU that first runs them.
 	for(size_t offset = 0; offset < kSize; offset += kPageSize) {
-		PhysicalAddr physical = physicalAllocator->allocate(kPageSize);
+		PhysicalAddr physical = physicalAllocator->allocate(kPageSize, 64, currentNumaNode());
 		assert(physical != static_cast<PhysicalAddr>(-1) && "OOM");
 		KernelPageSpace::global().mapSingle4k(
 				reinterpret_cast<VirtualAddr>(pointer) + guardedSize - kSize + offset,
@@ -619,6 +619,9 @@ void handleSyscall(SyscallImageAccessor image) {
 	case kHelCallResizeMemory: {
 		*image.error() = helResizeMemory((HelHandle)arg0, (size_t)arg1);
 	} break;
+	case kHelCallDecommitMemory: {
+		*image.error() = helDecommitMemory((HelHandle)arg0, (uintptr_t)arg1, (size_t)arg2);
+	} break;
 	case kHelCallCreateManagedMemory: {
 		HelHandle backing_handle, frontal_handle;
 		*image.error() = helCreateManagedMemory((size_t)arg0, (uint32_t)arg1,
@@ -678,6 +681,9 @@ void handleSyscall(SyscallImageAccessor image) {
 		*image.error() = helSubmitSynchronizeSpace((HelHandle)arg0, (void *)arg1, (size_t)arg2,
 				(HelHandle)arg3, (uintptr_t)arg4);
 	} break;
+	case kHelCallSetSpaceName: {
+		*image.error() = helSetSpaceName((HelHandle)arg0, (const char *)arg1, (size_t)arg2);
+	} break;
 	case kHelCallPointerPhysical: {
 		uintptr_t physical;
 		*image.error() = helPointerPhysical((void *)arg0, &physical);
@@ -745,9 +751,21 @@ void handleSyscall(SyscallImageAccessor image) {
 	case kHelCallQueryThreadStats: {
 		*image.error() = helQueryThreadStats((HelHandle)arg0, (HelThreadStats *)arg1);
 	} break;
+	case kHelCallQueryCpuStats: {
+		*image.error() = helQueryCpuStats((int)arg0, (HelCpuStats *)arg1);
+	} break;
+	case kHelCallQueryNumaNodeStats: {
+		*image.error() = helQueryNumaNodeStats((int)arg0, (HelNumaNodeStats *)arg1);
+	} break;
 	case kHelCallSetPriority: {
 		*image.error() = helSetPriority((HelHandle)arg0, (int)arg1);
 	} break;
+	case kHelCallSetSchedParams: {
+		*image.error() = helSetSchedParams((HelHandle)arg0, (const HelSchedParams *)arg1);
+	} break;
+	case kHelCallGetSchedParams: {
+		*image.error() = helGetSchedParams((HelHandle)arg0, (HelSchedParams *)arg1);
+	} break;
 	case kHelCallYield: {
 		*image.error() = helYield();
 	} break;
@@ -799,6 +817,18 @@ void handleSyscall(SyscallImageAccessor image) {
 	case kHelCallShutdownLane: {
 		*image.error() = helShutdownLane((HelHandle)arg0);
 	} break;
+	case kHelCallSyncCall: {
+		size_t length;
+		*image.error() = helSyncCall((HelHandle)arg0, (const void *)arg1,
+				(size_t)arg2, (void *)arg3, (size_t)arg4, &length);
+		*image.out0() = length;
+	} break;
+	case kHelCallSyncReplyAndWait: {
+		size_t length;
+		*image.error() = helSyncReplyAndWait((HelHandle)arg0, (const void *)arg1,
+				(size_t)arg2, (void *)arg3, (size_t)arg4, &length);
+		*image.out0() = length;
+	} break;
 
 	case kHelCallFutexWait: {
 		*image.error() = helFutexWait((int *)arg0, (int)arg1, (int64_t)arg2);
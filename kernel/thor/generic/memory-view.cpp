@@ -157,7 +157,8 @@ struct MemoryReclaimer {
 				if(tortureUncaching) {
 					KernelFiber::asyncBlockCurrent(generalTimerEngine()->sleepFor(10'000'000));
 				}else{
-					KernelFiber::asyncBlockCurrent(generalTimerEngine()->sleepFor(1'000'000'000));
+					KernelFiber::asyncBlockCurrent(generalTimerEngine()->sleepFor(1'000'000'000,
+							{}, 100'000'000));
 				}
 			}
 		});
@@ -198,6 +199,10 @@ void MemoryView::resize(size_t newSize, async::any_receiver<void> receiver) {
 	panicLogger() << "MemoryView does not support resize!" << frg::endlog;
 }
 
+coroutine<frg::expected<Error>> MemoryView::decommitRange(uintptr_t, size_t) {
+	co_return Error::illegalObject;
+}
+
 void MemoryView::fork(async::any_receiver<frg::tuple<Error, smarter::shared_ptr<MemoryView>>> receiver) {
 	receiver.set_value({Error::illegalObject, nullptr});
 }
@@ -595,8 +600,9 @@ size_t HardwareMemory::getLength() {
 // --------------------------------------------------------
 
 AllocatedMemory::AllocatedMemory(size_t desiredLngth,
-		int addressBits, size_t desiredChunkSize, size_t chunkAlign)
-: _physicalChunks{*kernelAlloc},
+		int addressBits, size_t desiredChunkSize, size_t chunkAlign, bool decommittable)
+: MemoryView{decommittable ? &_evictQueue : nullptr},
+		_physicalChunks{*kernelAlloc}, _lockCounts{*kernelAlloc},
 		_addressBits{addressBits}, _chunkAlign{chunkAlign} {
 	static_assert(sizeof(unsigned long) == sizeof(uint64_t), "Fix use of __builtin_clzl");
 	_chunkSize = size_t(1) << (64 - __builtin_clzl(desiredChunkSize - 1));
@@ -614,6 +620,7 @@ AllocatedMemory::AllocatedMemory(size_t desiredLngth,
 	assert(_chunkAlign % kPageSize == 0);
 	assert(_chunkSize % _chunkAlign == 0);
 	_physicalChunks.resize(length / _chunkSize, PhysicalAddr(-1));
+	_lockCounts.resize(length / _chunkSize, 0);
 }
 
 AllocatedMemory::~AllocatedMemory() {
@@ -640,23 +647,81 @@ void AllocatedMemory::resize(size_t newSize, async::any_receiver<void> receiver)
 		size_t num_chunks = newSize / _chunkSize;
 		assert(num_chunks >= _physicalChunks.size());
 		_physicalChunks.resize(num_chunks, PhysicalAddr(-1));
+		_lockCounts.resize(num_chunks, 0);
 	}
 	receiver.set_value();
 }
 
+coroutine<frg::expected<Error>> AllocatedMemory::decommitRange(uintptr_t offset, size_t size) {
+	if(!canEvictMemory())
+		co_return Error::illegalObject;
+	if((offset & (_chunkSize - 1)) || (size & (_chunkSize - 1)))
+		co_return Error::illegalArgs;
+
+	frg::vector<PhysicalAddr, KernelAlloc> released{*kernelAlloc};
+	{
+		auto irq_lock = frg::guard(&irqMutex());
+		auto lock = frg::guard(&_mutex);
+
+		if(offset + size < offset || offset + size > _physicalChunks.size() * _chunkSize)
+			co_return Error::illegalArgs;
+
+		for(size_t i = offset / _chunkSize; i < (offset + size) / _chunkSize; ++i) {
+			if(_physicalChunks[i] == PhysicalAddr(-1))
+				continue;
+
+			// Locked chunks must stay in place; clear them instead.
+			if(_lockCounts[i]) {
+				for(size_t pg_progress = 0; pg_progress < _chunkSize; pg_progress += kPageSize) {
+					PageAccessor accessor{_physicalChunks[i] + pg_progress};
+					memset(accessor.get(), 0, kPageSize);
+				}
+				continue;
+			}
+
+			// From now on, fetchRange() allocates a fresh (zeroed) chunk.
+			released.push_back(_physicalChunks[i]);
+			_physicalChunks[i] = PhysicalAddr(-1);
+		}
+	}
+
+	if(released.empty())
+		co_return {};
+
+	// Mappings may still map the released chunks. Wait until all of them are unmapped.
+	co_await _evictQueue.evictRange(offset, size);
+
+	for(auto physical : released)
+		physicalAllocator->free(physical, _chunkSize);
+	co_return {};
+}
+
 frg::expected<Error, frg::tuple<smarter::shared_ptr<GlobalFutexSpace>, uintptr_t>>
 AllocatedMemory::resolveGlobalFutex(uintptr_t offset) {
 	smarter::shared_ptr<GlobalFutexSpace> futexSpace{selfPtr.lock()};
 	return frg::make_tuple(std::move(futexSpace), offset);
 }
 
-Error AllocatedMemory::lockRange(uintptr_t, size_t) {
-	// For now, we do not evict "anonymous" memory. TODO: Implement eviction here.
+Error AllocatedMemory::lockRange(uintptr_t offset, size_t size) {
+	// We never evict "anonymous" memory but decommitRange() must not release locked chunks.
+	auto irq_lock = frg::guard(&irqMutex());
+	auto lock = frg::guard(&_mutex);
+
+	assert(offset + size <= _physicalChunks.size() * _chunkSize);
+	for(size_t i = offset / _chunkSize; i * _chunkSize < offset + size; ++i)
+		_lockCounts[i]++;
 	return Error::success;
 }
 
-void AllocatedMemory::unlockRange(uintptr_t, size_t) {
-	// For now, we do not evict "anonymous" memory. TODO: Implement eviction here.
+void AllocatedMemory::unlockRange(uintptr_t offset, size_t size) {
+	auto irq_lock = frg::guard(&irqMutex());
+	auto lock = frg::guard(&_mutex);
+
+	assert(offset + size <= _physicalChunks.size() * _chunkSize);
+	for(size_t i = offset / _chunkSize; i * _chunkSize < offset + size; ++i) {
+		assert(_lockCounts[i]);
+		_lockCounts[i]--;
+	}
 }
 
 frg::tuple<PhysicalAddr, CachingMode> AllocatedMemory::peekRange(uintptr_t offset) {
@@ -685,7 +750,8 @@ AllocatedMemory::fetchRange(uintptr_t offset, FetchFlags, smarter::shared_ptr<Wo
 	assert(index < _physicalChunks.size());
 
 	if(_physicalChunks[index] == PhysicalAddr(-1)) {
-		auto physical = physicalAllocator->allocate(_chunkSize, _addressBits);
+		auto physical = physicalAllocator->allocate(_chunkSize, _addressBits,
+				currentNumaNode());
 		assert(physical != PhysicalAddr(-1) && "OOM");
 		assert(!(physical & (_chunkAlign - 1)));
 
@@ -713,13 +779,20 @@ size_t AllocatedMemory::getLength() {
 
 coroutine<frg::expected<Error, PhysicalAddr>> AllocatedMemory::takeGlobalFutex(uintptr_t offset,
 		smarter::shared_ptr<WorkQueue> wq) {
+	// Lock the page such that decommitRange() cannot release it while the futex is in use.
+	lockRange(offset & ~(kPageSize - 1), kPageSize);
 	// TODO: This could be optimized further (by avoiding the coroutine call).
-	auto range = FRG_CO_TRY(co_await fetchRange(offset & ~(kPageSize - 1), 0, wq));
-	assert(range.get<0>() != PhysicalAddr(-1));
-	co_return range.get<0>();
+	auto range = co_await fetchRange(offset & ~(kPageSize - 1), 0, wq);
+	if(!range) {
+		unlockRange(offset & ~(kPageSize - 1), kPageSize);
+		co_return range.error();
+	}
+	assert(range.value().get<0>() != PhysicalAddr(-1));
+	co_return range.value().get<0>();
 }
 
-void AllocatedMemory::retireGlobalFutex(uintptr_t) {
+void AllocatedMemory::retireGlobalFutex(uintptr_t offset) {
+	unlockRange(offset & ~(kPageSize - 1), kPageSize);
 }
 
 // --------------------------------------------------------
@@ -1030,7 +1103,7 @@ BackingMemory::fetchRange(uintptr_t offset, FetchFlags, smarter::shared_ptr<Work
 	assert(pit);
 
 	if(pit->physical == PhysicalAddr(-1)) {
-		PhysicalAddr physical = physicalAllocator->allocate(kPageSize);
+		PhysicalAddr physical = physicalAllocator->allocate(kPageSize, 64, currentNumaNode());
 		assert(physical != PhysicalAddr(-1) && "OOM");
 
 		PageAccessor accessor{physical};
@@ -1615,7 +1688,7 @@ bool CopyOnWriteMemory::asyncLockRange(uintptr_t offset, size_t size,
 				continue;
 			}
 
-			PhysicalAddr physical = physicalAllocator->allocate(kPageSize);
+			PhysicalAddr physical = physicalAllocator->allocate(kPageSize, 64, currentNumaNode());
 			assert(physical != PhysicalAddr(-1) && "OOM");
 			PageAccessor accessor{physical};
 
@@ -1745,7 +1818,7 @@ CopyOnWriteMemory::fetchRange(uintptr_t offset, FetchFlags, smarter::shared_ptr<
 		co_return PhysicalRange{cowIt->physical, kPageSize, CachingMode::null};
 	}
 
-	PhysicalAddr physical = physicalAllocator->allocate(kPageSize);
+	PhysicalAddr physical = physicalAllocator->allocate(kPageSize, 64, currentNumaNode());
 	assert(physical != PhysicalAddr(-1) && "OOM");
 	PageAccessor accessor{physical};
 
@@ -2,12 +2,15 @@
 #include <bragi/helpers-frigg.hpp>
 #include <frg/small_vector.hpp>
 #include <frg/span.hpp>
+#include <frg/vector.hpp>
 #include <thor-internal/fiber.hpp>
 #include <thor-internal/kernel-io.hpp>
 #include <thor-internal/main.hpp>
+#include <thor-internal/memory-view.hpp>
 #include <thor-internal/ostrace.hpp>
 #include <thor-internal/stream.hpp>
 #include <thor-internal/timer.hpp>
+#include <protocols/ostrace/ring.hpp>
 #include <mbus.frigg_pb.hpp>
 
 // --------------------------------------------------------------------------------------
@@ -40,6 +43,7 @@ initgraph::Task initOsTraceCore{&globalInitEngine, "generic.init-ostrace-core",
 
 		void *osTraceMemory = kernelAlloc->allocate(1 << 20);
 		globalOsTraceRing.initialize(reinterpret_cast<uintptr_t>(osTraceMemory), 1 << 20);
+		userRings.initialize(*kernelAlloc);
 
 		osTraceInUse.store(true);
 	}
@@ -86,6 +90,146 @@ LogRingBuffer *getGlobalOsTraceRing() {
 	return globalOsTraceRing.get();
 }
 
+// --------------------------------------------------------------------------------------
+// Shared-memory rings of userspace emitters.
+// --------------------------------------------------------------------------------------
+
+namespace {
+
+struct UserRing {
+	// The ring lives as long as its emitter holds a handle or mapping of the memory.
+	// Records that are still in the ring when it is released are lost.
+	smarter::weak_ptr<ImmediateMemory> memory;
+	// Value of RingHeader::numDropped that we last reported.
+	uint64_t numReportedDrops = 0;
+};
+
+frg::ticket_spinlock userRingsMutex;
+// Rings are only removed by the drain fiber, hence pointers to them stay valid there.
+frg::manual_box<frg::vector<UserRing *, KernelAlloc>> userRings;
+
+// Reads from the data area of a ring, taking wrap-around into account.
+void readFromRing(ImmediateMemory *memory, uint64_t ptr, void *buffer, size_t size) {
+	using protocols::ostrace::ringDataSize;
+	using protocols::ostrace::ringHeaderSize;
+
+	auto offset = ptr & (ringDataSize - 1);
+	auto chunk = frg::min(size, ringDataSize - offset);
+	memory->readImmediate(ringHeaderSize + offset, buffer, chunk);
+	if(chunk < size)
+		memory->readImmediate(ringHeaderSize,
+				reinterpret_cast<char *>(buffer) + chunk, size - chunk);
+}
+
+// Moves all records from a ring into the global ostrace ring.
+// The ring is written by userspace, hence we validate everything that we read.
+void drainUserRing(UserRing &ring, ImmediateMemory *memory) {
+	using protocols::ostrace::RingHeader;
+	using protocols::ostrace::maxRingEntrySize;
+	using protocols::ostrace::ringDataSize;
+
+	auto header = memory->accessImmediate<RingHeader>(0);
+	auto writePtr = __atomic_load_n(&header->writePtr, __ATOMIC_ACQUIRE);
+	auto readPtr = __atomic_load_n(&header->readPtr, __ATOMIC_RELAXED);
+
+	char buffer[maxRingEntrySize];
+	bool corrupted = writePtr - readPtr > ringDataSize;
+	while(!corrupted && readPtr != writePtr) {
+		uint32_t length;
+		if(writePtr - readPtr < sizeof(uint32_t)) {
+			corrupted = true;
+			break;
+		}
+		readFromRing(memory, readPtr, &length, sizeof(uint32_t));
+		if(length < 8 || length > maxRingEntrySize - sizeof(uint32_t)
+				|| sizeof(uint32_t) + length > writePtr - readPtr) {
+			corrupted = true;
+			break;
+		}
+		readFromRing(memory, readPtr + sizeof(uint32_t), buffer, length);
+
+		// Only accept EventRecords; announcements must go through IPC.
+		auto preamble = bragi::read_preamble(frg::span<const char>{buffer, length});
+		if(preamble.error()
+				|| preamble.id() != bragi::message_id<managarm::ostrace::EventRecord>
+				|| 8 + preamble.tail_size() != length) {
+			corrupted = true;
+			break;
+		}
+
+		globalOsTraceRing->enqueue(buffer, length);
+		readPtr += sizeof(uint32_t) + length;
+	}
+
+	if(corrupted) {
+		infoLogger() << "\e[31m" "thor: Discarding corrupted ostrace ring" "\e[39m"
+				<< frg::endlog;
+		readPtr = writePtr;
+	}
+	__atomic_store_n(&header->readPtr, readPtr, __ATOMIC_RELEASE);
+
+	auto numDropped = __atomic_load_n(&header->numDropped, __ATOMIC_RELAXED);
+	if(numDropped != ring.numReportedDrops) {
+		infoLogger() << "thor: ostrace ring overrun, "
+				<< (numDropped - ring.numReportedDrops) << " records were dropped"
+				<< frg::endlog;
+		ring.numReportedDrops = numDropped;
+	}
+}
+
+smarter::shared_ptr<ImmediateMemory> createUserRing() {
+	auto memory = smarter::allocate_shared<ImmediateMemory>(*kernelAlloc,
+			protocols::ostrace::ringHeaderSize + protocols::ostrace::ringDataSize);
+	memory->selfPtr = memory;
+
+	auto ring = frg::construct<UserRing>(*kernelAlloc);
+	ring->memory = memory;
+
+	auto irqLock = frg::guard(&irqMutex());
+	auto lock = frg::guard(&userRingsMutex);
+	userRings->push_back(ring);
+	return memory;
+}
+
+void runUserRingDrain() {
+	KernelFiber::run([=] {
+		while(true) {
+			KernelFiber::asyncBlockCurrent(generalTimerEngine()->sleepFor(10'000'000,
+					{}, 1'000'000));
+
+			// Drain without holding the lock such that we can wake up readers of the global ring.
+			size_t i = 0;
+			while(true) {
+				UserRing *ring;
+				smarter::shared_ptr<ImmediateMemory> memory;
+				{
+					auto irqLock = frg::guard(&irqMutex());
+					auto lock = frg::guard(&userRingsMutex);
+					if(i == userRings->size())
+						break;
+					ring = (*userRings)[i];
+					memory = ring->memory.lock();
+
+					// Forget about rings that were released by their emitters.
+					if(!memory) {
+						(*userRings)[i] = (*userRings)[userRings->size() - 1];
+						userRings->resize(userRings->size() - 1);
+					}
+				}
+
+				if(!memory) {
+					frg::destruct(*kernelAlloc, ring);
+					continue;
+				}
+				drainUserRing(*ring, memory.get());
+				i++;
+			}
+		}
+	});
+}
+
+} // anonymous namespace
+
 // --------------------------------------------------------------------------------------
 // mbus object handling.
 // --------------------------------------------------------------------------------------
@@ -245,6 +389,38 @@ coroutine<Error> handleReq(LaneHandle boundLane) {
 			co_return Error::protocolViolation;
 		}
 	} break;
+	case bragi::message_id<managarm::ostrace::CreateRingReq>: {
+		auto maybeReq = bragi::parse_head_tail<managarm::ostrace::CreateRingReq>(
+				headSpan, tailSpan, *kernelAlloc);
+		if(!maybeReq)
+			co_return Error::protocolViolation;
+
+		managarm::ostrace::Response<KernelAlloc> resp(*kernelAlloc);
+		if(wantOsTrace) {
+			resp.set_error(managarm::ostrace::Error::SUCCESS);
+		}else{
+			resp.set_error(managarm::ostrace::Error::OSTRACE_GLOBALLY_DISABLED);
+		}
+
+		frg::string<KernelAlloc> ser(*kernelAlloc);
+		resp.SerializeToString(&ser);
+		frg::unique_memory<KernelAlloc> respBuffer{*kernelAlloc, ser.size()};
+		memcpy(respBuffer.data(), ser.data(), ser.size());
+		auto respError = co_await SendBufferSender{lane, std::move(respBuffer)};
+		if(respError != Error::success) {
+			assert(isRemoteIpcError(respError));
+			co_return Error::protocolViolation;
+		}
+
+		if(wantOsTrace) {
+			auto memoryError = co_await PushDescriptorSender{lane,
+					MemoryViewDescriptor{createUserRing()}};
+			if(memoryError != Error::success) {
+				assert(isRemoteIpcError(memoryError));
+				co_return Error::protocolViolation;
+			}
+		}
+	} break;
 	case bragi::message_id<managarm::ostrace::AnnounceEventReq>: {
 		auto maybeReq = bragi::parse_head_tail<managarm::ostrace::AnnounceEventReq>(
 				headSpan, tailSpan, *kernelAlloc);
@@ -332,6 +508,8 @@ initgraph::Task initOsTraceMbus{&globalInitEngine, "generic.init-ostrace-sinks",
 			// Only dump to an I/O channel if ostrace is supported (otherwise, the ring buffer
 			// does not even exist).
 			if(wantOsTrace) {
+				runUserRingDrain();
+
 				auto channel = solicitIoChannel("ostrace");
 				if(channel) {
 					infoLogger() << "thor: Connecting ostrace to I/O channel" << frg::endlog;
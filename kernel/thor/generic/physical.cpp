@@ -31,14 +31,21 @@ void *SkeletalRegion::access(PhysicalAddr physical) {
 // PhysicalChunkAllocator
 // --------------------------------------------------------
 
+int currentNumaNode() {
+	return getCpuData()->numaNode;
+}
+
 PhysicalChunkAllocator::PhysicalChunkAllocator() {
+	for(int i = 0; i < maxNumaNodes; i++)
+		for(int j = 0; j < maxNumaNodes; j++)
+			_distances[i][j] = (i == j) ? localNumaDistance : remoteNumaDistance;
 }
 
 void PhysicalChunkAllocator::bootstrapRegion(PhysicalAddr address,
 		int order, size_t numRoots, int8_t *buddyTree) {
-	if(_numRegions >= 8) {
-		infoLogger() << "thor: Ignoring memory region (can only handle 8 regions)"
-				<< frg::endlog;
+	if(_numRegions >= maxRegions) {
+		infoLogger() << "thor: Ignoring memory region (can only handle "
+				<< maxRegions << " regions)" << frg::endlog;
 		return;
 	}
 
@@ -47,6 +54,7 @@ void PhysicalChunkAllocator::bootstrapRegion(PhysicalAddr address,
 	_allRegions[n].regionSize = numRoots << (order + kPageShift);
 	_allRegions[n].buddyAccessor = BuddyAccessor{address, kPageShift,
 			buddyTree, numRoots, order};
+	_allRegions[n].numPages = numRoots << order;
 
 	auto currentTotal = _totalPages.load(std::memory_order_relaxed);
 	auto currentFree = _freePages.load(std::memory_order_relaxed);
@@ -54,7 +62,75 @@ void PhysicalChunkAllocator::bootstrapRegion(PhysicalAddr address,
 	_freePages.store(currentFree + (numRoots << order), std::memory_order_relaxed);
 }
 
-PhysicalAddr PhysicalChunkAllocator::allocate(size_t size, int addressBits) {
+void PhysicalChunkAllocator::setNumaNode(PhysicalAddr address, size_t size, int node) {
+	assert(node >= 0 && node < maxNumaNodes);
+
+	auto irq_lock = frg::guard(&irqMutex());
+	auto lock = frg::guard(&_mutex);
+
+	if(node >= _numNodes)
+		_numNodes = node + 1;
+
+	// Regions are not split; a region that spans multiple nodes belongs to the node
+	// that contains its start.
+	for(int i = 0; i < _numRegions; i++) {
+		auto base = _allRegions[i].physicalBase;
+		if(base < address || base - address >= size)
+			continue;
+		_allRegions[i].numaNode = node;
+		infoLogger() << "thor: Memory region at 0x" << frg::hex_fmt(base)
+				<< " belongs to NUMA node " << node << frg::endlog;
+	}
+}
+
+void PhysicalChunkAllocator::setNumaDistance(int from, int to, uint8_t distance) {
+	assert(from >= 0 && from < maxNumaNodes);
+	assert(to >= 0 && to < maxNumaNodes);
+
+	auto irq_lock = frg::guard(&irqMutex());
+	auto lock = frg::guard(&_mutex);
+
+	_distances[from][to] = distance;
+}
+
+size_t PhysicalChunkAllocator::numFreePagesOfNode(int node) {
+	auto irq_lock = frg::guard(&irqMutex());
+	auto lock = frg::guard(&_mutex);
+
+	size_t n = 0;
+	for(int i = 0; i < _numRegions; i++) {
+		if(_allRegions[i].numaNode == node)
+			n += _allRegions[i].numPages - _allRegions[i].usedPages;
+	}
+	return n;
+}
+
+size_t PhysicalChunkAllocator::numUsedPagesOfNode(int node) {
+	auto irq_lock = frg::guard(&irqMutex());
+	auto lock = frg::guard(&_mutex);
+
+	size_t n = 0;
+	for(int i = 0; i < _numRegions; i++) {
+		if(_allRegions[i].numaNode == node)
+			n += _allRegions[i].usedPages;
+	}
+	return n;
+}
+
+PhysicalAddr PhysicalChunkAllocator::_allocateFrom(Region &region, int target, int addressBits) {
+	if(target > region.buddyAccessor.tableOrder())
+		return static_cast<PhysicalAddr>(-1);
+
+	auto physical = region.buddyAccessor.allocate(target, addressBits);
+	if(physical == BuddyAccessor::illegalAddress)
+		return static_cast<PhysicalAddr>(-1);
+//	infoLogger() << "Allocate " << (void *)physical << frg::endlog;
+	assert(!(physical % (size_t(kPageSize) << target)));
+	region.usedPages += size_t{1} << target;
+	return physical;
+}
+
+PhysicalAddr PhysicalChunkAllocator::allocate(size_t size, int addressBits, int node) {
 	auto irq_lock = frg::guard(&irqMutex());
 	auto lock = frg::guard(&_mutex);
 
@@ -73,16 +149,35 @@ PhysicalAddr PhysicalChunkAllocator::allocate(size_t size, int addressBits) {
 	if(logPhysicalAllocs)
 		infoLogger() << "thor: Allocating physical memory of order "
 					<< (target + kPageShift) << frg::endlog;
-	for(int i = 0; i < _numRegions; i++) {
-		if(target > _allRegions[i].buddyAccessor.tableOrder())
-			continue;
+	if(node == anyNumaNode || node >= _numNodes) {
+		for(int i = 0; i < _numRegions; i++) {
+			auto physical = _allocateFrom(_allRegions[i], target, addressBits);
+			if(physical != static_cast<PhysicalAddr>(-1))
+				return physical;
+		}
+		return static_cast<PhysicalAddr>(-1);
+	}
 
-		auto physical = _allRegions[i].buddyAccessor.allocate(target, addressBits);
-		if(physical == BuddyAccessor::illegalAddress)
-			continue;
-	//	infoLogger() << "Allocate " << (void *)physical << frg::endlog;
-		assert(!(physical % (size_t(kPageSize) << target)));
-		return physical;
+	// Visit nodes in order of increasing distance (starting with the node itself).
+	bool visited[maxNumaNodes]{};
+	for(int k = 0; k < _numNodes; k++) {
+		int best = -1;
+		for(int j = 0; j < _numNodes; j++) {
+			if(visited[j])
+				continue;
+			if(best < 0 || _distances[node][j] < _distances[node][best]
+					|| (j == node && _distances[node][j] == _distances[node][best]))
+				best = j;
+		}
+		visited[best] = true;
+
+		for(int i = 0; i < _numRegions; i++) {
+			if(_allRegions[i].numaNode != best)
+				continue;
+			auto physical = _allocateFrom(_allRegions[i], target, addressBits);
+			if(physical != static_cast<PhysicalAddr>(-1))
+				return physical;
+		}
 	}
 
 	return static_cast<PhysicalAddr>(-1);
@@ -103,6 +198,7 @@ void PhysicalChunkAllocator::free(PhysicalAddr address, size_t size) {
 			continue;
 
 		_allRegions[i].buddyAccessor.free(address, target);
+		_allRegions[i].usedPages -= size_t{1} << target;
 		auto currentFree = _freePages.load(std::memory_order_relaxed);
 		auto currentUsed = _usedPages.load(std::memory_order_relaxed);
 		assert(currentUsed > size / kPageSize);
@@ -2,6 +2,8 @@
 #include <thor-internal/arch/pmc-amd.hpp>
 #include <thor-internal/arch/pmc-intel.hpp>
 #endif
+#include <thor-internal/address-space.hpp>
+#include <thor-internal/cpu-data.hpp>
 #include <thor-internal/fiber.hpp>
 #include <thor-internal/kernel-io.hpp>
 #include <thor-internal/main.hpp>
@@ -14,6 +16,50 @@ bool wantKernelProfile = false;
 
 namespace {
 	frg::manual_box<LogRingBuffer> globalProfileRing;
+	// Set once globalProfileRing is initialized.
+	bool havePmcProfile = false;
+	frg::manual_box<LogRingBuffer> heapProfileRing;
+
+	// Record that is emitted to the kernel-heap-profile channel once per second.
+	// All counters are cumulative since boot and summed over all CPUs.
+	struct HeapProfileRecord {
+		// Acquisitions of the shared heap lock that had to wait for another CPU.
+		uint64_t numContended;
+		struct {
+			uint64_t objectSize;
+			uint64_t numAllocations;
+			uint64_t numDeallocations;
+			uint64_t numRefills;
+			uint64_t numFlushes;
+		} classes[KernelHeapCache::numClasses];
+	};
+
+	void runHeapProfile() {
+		void *heapProfileMemory = kernelAlloc->allocate(1 << 16);
+		heapProfileRing.initialize(reinterpret_cast<uintptr_t>(heapProfileMemory), 1 << 16);
+
+		KernelFiber::run([=] {
+			while(true) {
+				KernelFiber::asyncBlockCurrent(generalTimerEngine()->sleepFor(1'000'000'000,
+						{}, 100'000'000));
+
+				HeapProfileRecord record{};
+				record.numContended = kernelHeapLock.numContended();
+				for(int k = 0; k < KernelHeapCache::numClasses; k++) {
+					auto &out = record.classes[k];
+					out.objectSize = KernelHeapCache::sizeOfClass(k);
+					for(int i = 0; i < getCpuCount(); i++) {
+						auto &sc = getCpuData(i)->heapCache.classes[k];
+						out.numAllocations += sc.numAllocations.load(std::memory_order_relaxed);
+						out.numDeallocations += sc.numDeallocations.load(std::memory_order_relaxed);
+						out.numRefills += sc.numRefills.load(std::memory_order_relaxed);
+						out.numFlushes += sc.numFlushes.load(std::memory_order_relaxed);
+					}
+				}
+				heapProfileRing->enqueue(&record, sizeof(HeapProfileRecord));
+			}
+		});
+	}
 
 	initgraph::Task initProfilingSinks{&globalInitEngine, "generic.init-profiling-sinks",
 		initgraph::Requires{getFibersAvailableStage(),
@@ -28,15 +74,26 @@ namespace {
 				async::detach_with_allocator(*kernelAlloc,
 						dumpRingToChannel(globalProfileRing.get(), std::move(channel), 2048));
 			}
+
+			auto heapChannel = solicitIoChannel("kernel-heap-profile");
+			if(heapChannel) {
+				infoLogger() << "thor: Connecting heap profiling to I/O channel" << frg::endlog;
+				async::detach_with_allocator(*kernelAlloc,
+						dumpRingToChannel(heapProfileRing.get(), std::move(heapChannel), 2048));
+			}
 		}
 	};
 }
 
 void initializeProfile() {
-#ifdef __x86_64__
 	if(!wantKernelProfile)
 		return;
 
+	// Heap statistics do not depend on hardware support for profiling.
+	runHeapProfile();
+
+#ifdef __x86_64__
+
 	if(!(getGlobalCpuFeatures()->profileFlags & CpuFeatures::profileIntelSupported)
 			&& !(getGlobalCpuFeatures()->profileFlags & CpuFeatures::profileAmdSupported)) {
 		infoLogger() << "\e[31m" "thor: Kernel profiling was requested but"
@@ -46,6 +103,7 @@ void initializeProfile() {
 
 	void *profileMemory = kernelAlloc->allocate(1 << 20);
 	globalProfileRing.initialize(reinterpret_cast<uintptr_t>(profileMemory), 1 << 20);
+	havePmcProfile = true;
 
 	// Dump the per-CPU profiling data to the global ring buffer.
 	// TODO: Start one such fiber per CPU.
@@ -66,16 +124,17 @@ void initializeProfile() {
 
 		uint64_t deqPtr = 0;
 		while(true) {
-			char buffer[128];
+			char buffer[maxProfileRecordSize];
 			auto [success, recordPtr, newPtr, size] = getCpuData()->localProfileRing->dequeueAt(
-					deqPtr, buffer, 128);
+					deqPtr, buffer, maxProfileRecordSize);
 			deqPtr = newPtr;
 			if(!success) {
-				KernelFiber::asyncBlockCurrent(generalTimerEngine()->sleepFor(1'000'000));
+				KernelFiber::asyncBlockCurrent(generalTimerEngine()->sleepFor(1'000'000,
+						{}, 1'000'000));
 				continue;
 			}
-			assert(size);
-			assert(size < 128);
+			assert(size >= sizeof(ProfileSampleHeader));
+			assert(size <= maxProfileRecordSize);
 
 			globalProfileRing->enqueue(buffer, size);
 		}
@@ -87,4 +146,40 @@ LogRingBuffer *getGlobalProfileRing() {
 	return globalProfileRing.get();
 }
 
+LogRingBuffer *getHeapProfileRing() {
+	return heapProfileRing.get();
+}
+
+uint64_t profileSpaceId(AddressSpace *space) {
+	return space->profileId;
+}
+
+void nameProfileSpace(AddressSpace *space, frg::string_view name) {
+	if(!havePmcProfile)
+		return;
+
+	struct {
+		ProfileSpaceNameHeader header;
+		char name[64];
+	} record;
+	auto length = frg::min(name.size(), sizeof(record.name));
+	record.header.kind = ProfileRecordKind::spaceName;
+	record.header.nameLength = length;
+	record.header.spaceId = profileSpaceId(space);
+	memcpy(record.name, name.data(), length);
+	globalProfileRing->enqueue(&record, sizeof(ProfileSpaceNameHeader) + length,
+			!intsAreEnabled());
+}
+
+void retireProfileSpace(AddressSpace *space) {
+	if(!havePmcProfile)
+		return;
+
+	ProfileSpaceRetiredHeader record{};
+	record.kind = ProfileRecordKind::spaceRetired;
+	record.spaceId = profileSpaceId(space);
+	globalProfileRing->enqueue(&record, sizeof(ProfileSpaceRetiredHeader),
+			!intsAreEnabled());
+}
+
 } // namespace thor
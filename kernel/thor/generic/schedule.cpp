@@ -18,7 +18,39 @@ namespace {
 	constexpr bool disablePreemption = false;
 
 	// Minimum length of a preemption time slice in ns.
-	constexpr int64_t sliceGranularity = 10'000'000;
+	constexpr int64_t sliceGranularity = 2'000'000;
+
+	// Hysteresis (in ns) before a waiting fair entity preempts the current one.
+	// This is independent of the slice length to avoid ping-ponging between entities.
+	constexpr int64_t fairSwitchHysteresis = 10'000'000;
+
+	// Period in which each runnable entity should run once (in ns).
+	// The slice length is this period divided by the number of runnable entities.
+	constexpr int64_t schedulingLatency = 24'000'000;
+
+	// Maximum length of a preemption time slice in ns.
+	constexpr int64_t maxSliceLength = 40'000'000;
+
+	// Each priority level doubles (or halves) the slice length, up to this limit.
+	constexpr int maxPriorityShift = 2;
+
+	// Length of a time slice of the round-robin policy in ns.
+	constexpr uint64_t roundRobinSlice = 10'000'000;
+
+	// Limits for the parameters of the deadline policy (in ns).
+	constexpr uint64_t minDeadlineRuntime = 10'000;
+	constexpr uint64_t maxDeadlinePeriod = 4'000'000'000;
+
+	// Bandwidth of deadline entities is measured in units of 1 / bandwidthScale CPUs.
+	constexpr uint64_t bandwidthScale = uint64_t{1} << 20;
+
+	// Admission control: deadline entities may use at most this fraction
+	// (in percent) of the total CPU time. The rest is reserved for other policies.
+	constexpr uint64_t maxDeadlineUtilization = 95;
+
+	// Protects globalBandwidth and ScheduleEntity::_admittedBandwidth.
+	frg::ticket_spinlock globalBandwidthMutex;
+	uint64_t globalBandwidth = 0;
 
 	struct IdleTask final : ScheduleEntity {
 		IdleTask()
@@ -53,27 +85,63 @@ namespace {
 int ScheduleEntity::orderPriority(const ScheduleEntity *a, const ScheduleEntity *b) {
 	assert(a->type() == ScheduleType::regular);
 	assert(b->type() == ScheduleType::regular);
-	return b->priority - a->priority; // Prefer larger priority.
+
+	auto rank = [] (const ScheduleEntity *entity) -> int {
+		switch(entity->_params.policy) {
+		case SchedulePolicy::fair: return 0;
+		case SchedulePolicy::fifo: return 1;
+		case SchedulePolicy::roundRobin: return 1;
+		case SchedulePolicy::deadline: return 2;
+		}
+		__builtin_unreachable();
+	};
+
+	// Prefer deadline entities over real-time entities over fair entities.
+	if(auto ro = rank(b) - rank(a); ro)
+		return ro;
+
+	// Prefer the earliest deadline.
+	if(a->_params.policy == SchedulePolicy::deadline) {
+		if(a->_absoluteDeadline == b->_absoluteDeadline)
+			return 0;
+		return a->_absoluteDeadline > b->_absoluteDeadline ? 1 : -1;
+	}
+
+	return b->_params.priority - a->_params.priority; // Prefer larger priority.
 }
 
 bool ScheduleEntity::scheduleBefore(const ScheduleEntity *a, const ScheduleEntity *b) {
 	assert(a->type() == ScheduleType::regular);
 	assert(b->type() == ScheduleType::regular);
+
+	// Entities of the other policies are run in FIFO order.
+	if(a->_params.policy != SchedulePolicy::fair)
+		return a->_sequence < b->_sequence;
+
 	return a->baseUnfairness - a->refProgress
 			> b->baseUnfairness - b->refProgress; // Prefer greater unfairness.
 }
 
 ScheduleEntity::ScheduleEntity(ScheduleType type)
-: type_{type}, state{ScheduleState::null}, priority{0}, _refClock{0}, _runTime{0},
+: type_{type}, state{ScheduleState::null}, _refClock{0}, _runTime{0},
 		refProgress{0}, baseUnfairness{0} { }
 
 ScheduleEntity::~ScheduleEntity() {
 	assert(state == ScheduleState::null);
+
+	if(_admittedBandwidth) {
+		auto irqLock = frg::guard(&irqMutex());
+		auto lock = frg::guard(&globalBandwidthMutex);
+		globalBandwidth -= _admittedBandwidth;
+	}
 }
 
 void Scheduler::associate(ScheduleEntity *entity, Scheduler *scheduler) {
 	assert(entity->type() == ScheduleType::regular);
 
+	auto irqLock = frg::guard(&irqMutex());
+	auto lock = frg::guard(&entity->_associationMutex);
+
 //	infoLogger() << "associate " << entity << frg::endlog;
 	assert(entity->state == ScheduleState::null);
 	entity->_scheduler = scheduler;
@@ -85,28 +153,105 @@ void Scheduler::unassociate(ScheduleEntity *entity) {
 
 	// TODO: This is only really need to assert against _current.
 	auto irqLock = frg::guard(&irqMutex());
+	auto lock = frg::guard(&entity->_associationMutex);
 
 	auto self = entity->_scheduler;
 	assert(self);
 
 	assert(entity->state == ScheduleState::attached);
 	assert(entity != self->_current);
+
+	// Pending parameter changes are applied by the next scheduler.
+	{
+		auto scheduleLock = frg::guard(&self->_mutex);
+		if(entity->_onParamsList) {
+			self->_paramsList.erase(self->_paramsList.iterator_to(entity));
+			entity->_onParamsList = false;
+		}
+		if(self->_handoffEntity == entity)
+			self->_handoffEntity = nullptr;
+	}
+
 	entity->_scheduler = nullptr;
 	entity->state = ScheduleState::null;
 }
 
-void Scheduler::setPriority(ScheduleEntity *entity, int priority) {
+Error Scheduler::setParams(ScheduleEntity *entity, const ScheduleParams &params) {
 	assert(entity->type() == ScheduleType::regular);
 
-	auto scheduleLock = frg::guard(&irqMutex());
+	uint64_t bandwidth = 0;
+	switch(params.policy) {
+	case SchedulePolicy::fair:
+		break;
+	case SchedulePolicy::fifo:
+	case SchedulePolicy::roundRobin:
+		if(params.priority < minRealtimePriority || params.priority > maxRealtimePriority)
+			return Error::illegalArgs;
+		break;
+	case SchedulePolicy::deadline:
+		if(params.runtime < minDeadlineRuntime
+				|| params.runtime > params.deadline
+				|| params.deadline > params.period
+				|| params.period > maxDeadlinePeriod)
+			return Error::illegalArgs;
+		bandwidth = (params.runtime * bandwidthScale + params.period - 1) / params.period;
+		break;
+	default:
+		return Error::illegalArgs;
+	}
+
+	auto irqLock = frg::guard(&irqMutex());
+
+	// Admission control for the deadline policy. Note that this is done globally;
+	// the bandwidth of a single CPU can still be exceeded if deadline entities
+	// are pinned to the same CPU.
+	{
+		auto lock = frg::guard(&globalBandwidthMutex);
+		auto limit = getCpuCount() * bandwidthScale * maxDeadlineUtilization / 100;
+		auto total = globalBandwidth - entity->_admittedBandwidth + bandwidth;
+		if(bandwidth > entity->_admittedBandwidth && total > limit)
+			return Error::noBandwidth;
+		globalBandwidth = total;
+		entity->_admittedBandwidth = bandwidth;
+	}
+
+	auto lock = frg::guard(&entity->_associationMutex);
+
+	entity->_requestedParams = params;
 
 	auto self = entity->_scheduler;
-	assert(self);
+	if(!self) {
+		// No scheduler can access the entity; apply the parameters directly.
+		entity->_params = params;
+		entity->_paramsChanged = false;
+		return Error::success;
+	}
 
-	// Otherwise, we would have to remove-reinsert into the queue.
-	assert(entity == self->_current);
+	// Let the owning CPU apply the parameters.
+	entity->_paramsChanged = true;
+	{
+		auto scheduleLock = frg::guard(&self->_mutex);
+		if(!entity->_onParamsList) {
+			self->_paramsList.push_back(entity);
+			entity->_onParamsList = true;
+		}
+	}
+	sendPingIpi(self->_cpuContext->cpuIndex);
+	return Error::success;
+}
+
+ScheduleParams Scheduler::getParams(ScheduleEntity *entity) {
+	assert(entity->type() == ScheduleType::regular);
 
-	entity->priority = priority;
+	auto irqLock = frg::guard(&irqMutex());
+	auto lock = frg::guard(&entity->_associationMutex);
+	return entity->_requestedParams;
+}
+
+Error Scheduler::setPriority(ScheduleEntity *entity, int priority) {
+	auto params = getParams(entity);
+	params.priority = priority;
+	return setParams(entity, params);
 }
 
 void Scheduler::resume(ScheduleEntity *entity) {
@@ -138,6 +283,23 @@ void Scheduler::resume(ScheduleEntity *entity) {
 	}
 }
 
+void Scheduler::handoff(ScheduleEntity *entity) {
+	auto self = entity->_scheduler;
+	assert(self);
+	if(self != localScheduler()) {
+		resume(entity);
+		return;
+	}
+
+	{
+		auto irqLock = frg::guard(&irqMutex());
+		auto lock = frg::guard(&self->_mutex);
+
+		self->_handoffEntity = entity;
+	}
+	resume(entity);
+}
+
 void Scheduler::suspendCurrent() {
 	assert(!intsAreEnabled());
 
@@ -227,8 +389,78 @@ void Scheduler::update() {
 		entity->_refClock = _refClock;
 		entity->state = ScheduleState::active;
 
-		_waitQueue.push(entity);
-		_numWaiting++;
+		_applyParams(entity);
+
+		// Constant bandwidth server: the entity keeps its deadline and remaining budget
+		// unless that would exceed its bandwidth until the deadline.
+		if(entity->_params.policy == SchedulePolicy::deadline) {
+			auto &params = entity->_params;
+			if(entity->_absoluteDeadline <= _refClock
+					|| (entity->_budget > 0 && static_cast<uint64_t>(entity->_budget) * params.period
+						> (entity->_absoluteDeadline - _refClock) * params.runtime)) {
+				entity->_absoluteDeadline = _refClock + params.deadline;
+				entity->_budget = params.runtime;
+			}
+			entity->_throttled = entity->_budget <= 0;
+		}
+
+		entity->_sequence = _nextSequence++;
+		_enqueue(entity);
+	}
+
+	// Replenish throttled entities whose deadline has passed.
+	ScheduleList throttledSnapshot;
+	throttledSnapshot.splice(throttledSnapshot.end(), _throttledList);
+	while(!throttledSnapshot.empty()) {
+		auto entity = throttledSnapshot.pop_front();
+		if(entity->_absoluteDeadline > _refClock) {
+			_throttledList.push_back(entity);
+			continue;
+		}
+		_replenish(entity);
+		entity->_sequence = _nextSequence++;
+		_enqueue(entity);
+	}
+
+	// Apply parameter changes that were requested by other CPUs.
+	frg::intrusive_list<
+		ScheduleEntity,
+		frg::locate_member<
+			ScheduleEntity,
+			frg::default_list_hook<ScheduleEntity>,
+			&ScheduleEntity::paramsHook
+		>
+	> paramsSnapshot;
+	{
+		auto irqLock = frg::guard(&irqMutex());
+		auto lock = frg::guard(&_mutex);
+
+		while(!_paramsList.empty()) {
+			auto entity = _paramsList.pop_front();
+			entity->_onParamsList = false;
+			paramsSnapshot.push_back(entity);
+		}
+	}
+	while(!paramsSnapshot.empty()) {
+		auto entity = paramsSnapshot.pop_front();
+		// Inactive entities apply their parameters once they become active.
+		if(entity->state != ScheduleState::active)
+			continue;
+
+		if(entity == _current) {
+			_applyParams(entity);
+			continue;
+		}
+
+		// Re-insert the entity since its position in the queue changes.
+		if(entity->_throttled) {
+			_throttledList.erase(_throttledList.iterator_to(entity));
+		}else{
+			_waitQueue.remove(entity);
+			_numWaiting--;
+		}
+		_applyParams(entity);
+		_enqueue(entity);
 	}
 }
 
@@ -236,7 +468,15 @@ bool Scheduler::maybeReschedule() {
 	assert(!intsAreEnabled());
 	assert(_current);
 
-	auto wantToSchedule = [this] () -> bool {
+	// Real-time entities that are preempted by entities of higher priority
+	// keep their position in the queue.
+	bool rotate = true;
+
+	auto wantToSchedule = [&] () -> bool {
+		// Throttled entities are always switched out.
+		if(_current->type() == ScheduleType::regular && _current->_throttled)
+			return true;
+
 		// If there are no waiters, we keep the current entity.
 		// Otherwise, if the current entity is not active anymore, we always switch.
 		if(_waitQueue.empty())
@@ -249,21 +489,32 @@ bool Scheduler::maybeReschedule() {
 
 		// Switch based on entity priority.
 		if(auto po = ScheduleEntity::orderPriority(_current, _waitQueue.top()); po > 0) {
+			rotate = false;
 			return true;
 		}else if(po < 0) {
 			return false;
 		}
 
-		// Switch based on unfairness.
-		auto diff = _liveUnfairness(_current) + sliceGranularity * 256
-				- _liveUnfairness(_waitQueue.top());
-		return diff < 0;
+		switch(_current->_params.policy) {
+		case SchedulePolicy::fair: {
+			// Switch based on unfairness.
+			auto diff = _liveUnfairness(_current) + fairSwitchHysteresis * 256
+					- _liveUnfairness(_waitQueue.top());
+			return diff < 0;
+		}
+		case SchedulePolicy::roundRobin:
+			return _refClock - _sliceClock >= roundRobinSlice;
+		case SchedulePolicy::fifo:
+		case SchedulePolicy::deadline:
+			return false;
+		}
+		__builtin_unreachable();
 	};
 
 	if(!wantToSchedule())
 		return false;
 
-	_unschedule();
+	_unschedule(rotate);
 	_schedule();
 	return true;
 }
@@ -272,7 +523,7 @@ void Scheduler::forceReschedule() {
 	assert(!intsAreEnabled());
 
 	if(_current)
-		_unschedule();
+		_unschedule(true);
 	_schedule();
 }
 
@@ -284,15 +535,13 @@ void Scheduler::forceReschedule() {
 	_scheduled = nullptr;
 	_sliceClock = _refClock;
 
-	if(!preemptionIsArmed())
-		_updatePreemption();
+	_updatePreemption();
 
 	currentRunnable()->invoke();
 }
 
 void Scheduler::renewSchedule() {
-	if(!preemptionIsArmed())
-		_updatePreemption();
+	_updatePreemption();
 }
 
 ScheduleEntity *Scheduler::currentRunnable() {
@@ -300,7 +549,7 @@ ScheduleEntity *Scheduler::currentRunnable() {
 	return _current;
 }
 
-void Scheduler::_unschedule() {
+void Scheduler::_unschedule(bool rotate) {
 	assert(_current);
 
 	// Decrease the unfairness at the end of the time slice.
@@ -308,8 +557,9 @@ void Scheduler::_unschedule() {
 
 	if(_current->type() == ScheduleType::regular
 			|| _current->state == ScheduleState::active) {
-		_waitQueue.push(_current);
-		_numWaiting++;
+		if(rotate)
+			_current->_sequence = _nextSequence++;
+		_enqueue(_current);
 	}
 
 	_current = nullptr;
@@ -319,6 +569,12 @@ void Scheduler::_schedule() {
 	assert(!_current);
 	assert(!_scheduled);
 
+	ScheduleEntity *handoffEntity;
+	{
+		auto lock = frg::guard(&_mutex);
+		handoffEntity = std::exchange(_handoffEntity, nullptr);
+	}
+
 	if(_waitQueue.empty()) {
 		if(logScheduling)
 			infoLogger() << "No entities to schedule" << frg::endlog;
@@ -326,8 +582,18 @@ void Scheduler::_schedule() {
 		return;
 	}
 
+	// Run the entity that we handed off to unless the top entity takes priority over it.
+	// Since _current is null, active entities are on the wait queue unless they are throttled.
 	auto entity = _waitQueue.top();
-	_waitQueue.pop();
+	if(handoffEntity && handoffEntity != entity
+			&& handoffEntity->state == ScheduleState::active
+			&& !handoffEntity->_throttled
+			&& ScheduleEntity::orderPriority(handoffEntity, entity) <= 0) {
+		entity = handoffEntity;
+		_waitQueue.remove(entity);
+	}else{
+		_waitQueue.pop();
+	}
 	_numWaiting--;
 
 	// Increase the unfairness at the start of the time slice.
@@ -338,13 +604,13 @@ void Scheduler::_schedule() {
 	if(logScheduling) {
 //		infoLogger() << "System progress: " << (_systemProgress / 256) / (1000 * 1000)
 //				<< " ms" << frg::endlog;
-		infoLogger() << "Running entity with priority: " << entity->priority
+		infoLogger() << "Running entity with priority: " << entity->_params.priority
 				<< ", unfairness: " << (_liveUnfairness(entity) / 256) / (1000 * 1000)
 				<< " ms, runtime: " << _liveRuntime(entity) / (1000 * 1000)
 				<< " ms (" << (_numWaiting + 1) << " active threads)" << frg::endlog;
 	}
 	if(logNextBest && !_waitQueue.empty())
-		infoLogger() << "    Next entity has priority: " << _waitQueue.top()->priority
+		infoLogger() << "    Next entity has priority: " << _waitQueue.top()->_params.priority
 				<< ", unfairness: " << (_liveUnfairness(_waitQueue.top()) / 256) / (1000 * 1000)
 				<< " ms, runtime: " << _liveRuntime(_waitQueue.top()) / (1000 * 1000)
 				<< " ms" << frg::endlog;
@@ -352,29 +618,157 @@ void Scheduler::_schedule() {
 	_scheduled = entity;
 }
 
-// Returns true if preemption should be done immediately.
+uint64_t Scheduler::_sliceLength() {
+	assert(_current->type() == ScheduleType::regular);
+
+	// Number of waiting/running threads.
+	auto n = static_cast<int64_t>(_numWaiting) + 1;
+	auto length = schedulingLatency / n;
+
+	// Favor entities with high priority among entities of the same priority class.
+	auto shift = frg::min(frg::max(_current->_params.priority, -maxPriorityShift),
+			maxPriorityShift);
+	if(shift > 0) {
+		length <<= shift;
+	}else if(shift < 0) {
+		length >>= -shift;
+	}
+
+	return frg::min(frg::max(length, sliceGranularity), maxSliceLength);
+}
+
+void Scheduler::_applyParams(ScheduleEntity *entity) {
+	assert(entity->state == ScheduleState::active);
+
+	ScheduleParams params;
+	{
+		auto irqLock = frg::guard(&irqMutex());
+		auto lock = frg::guard(&entity->_associationMutex);
+
+		if(!entity->_paramsChanged)
+			return;
+		params = entity->_requestedParams;
+		entity->_paramsChanged = false;
+	}
+
+	// The unfairness is not meaningful across policies.
+	if(params.policy != entity->_params.policy) {
+		entity->baseUnfairness = 0;
+		entity->refProgress = _systemProgress;
+	}
+
+	entity->_params = params;
+	entity->_throttled = false;
+	if(params.policy == SchedulePolicy::deadline) {
+		entity->_absoluteDeadline = _refClock + params.deadline;
+		entity->_budget = params.runtime;
+	}
+}
+
+void Scheduler::_enqueue(ScheduleEntity *entity) {
+	assert(entity->state == ScheduleState::active);
+
+	if(entity->_throttled) {
+		assert(entity->_params.policy == SchedulePolicy::deadline);
+		_throttledList.push_back(entity);
+		return;
+	}
+
+	_waitQueue.push(entity);
+	_numWaiting++;
+}
+
+// Called at the deadline of a throttled entity. Starts a new period.
+void Scheduler::_replenish(ScheduleEntity *entity) {
+	assert(entity->_throttled);
+	auto &params = entity->_params;
+
+	entity->_throttled = false;
+	while(entity->_budget <= 0) {
+		entity->_absoluteDeadline += params.period;
+		entity->_budget += params.runtime;
+	}
+	if(entity->_absoluteDeadline <= _refClock) {
+		entity->_absoluteDeadline = _refClock + params.deadline;
+		entity->_budget = params.runtime;
+	}
+}
+
+void Scheduler::_chargeBudget(ScheduleEntity *entity, uint64_t delta) {
+	assert(entity == _current);
+
+	entity->_budget -= delta;
+	if(entity->_budget <= 0)
+		entity->_throttled = true;
+}
+
+// Arms the preemption timer if (and only if) the current entity has to be
+// preempted at some point. CPUs with zero or one runnable entity run tickless
+// (unless deadline entities need to be throttled or replenished).
 void Scheduler::_updatePreemption() {
 	if(disablePreemption)
 		return;
 
-	// Disable preemption if there are no other threads.
-	if(_waitQueue.empty())
-		return;
+	uint64_t deadline = 0;
+	auto consider = [&] (uint64_t dc) {
+		if(!deadline || dc < deadline)
+			deadline = dc;
+	};
+
+	// Throttled entities become runnable again at their deadline.
+	for(auto entity : _throttledList)
+		consider(entity->_absoluteDeadline);
 
-	// If there was no current entity, we would have rescheduled.
 	assert(_current);
-	assert(_current->type() == ScheduleType::regular);
-	assert(_current->state == ScheduleState::active);
+	if(_current->type() == ScheduleType::regular) {
+		assert(_current->state == ScheduleState::active);
 
-	if(auto po = ScheduleEntity::orderPriority(_current, _waitQueue.top()); po < 0) {
-		// Disable preemption if we have higher priority.
-		return;
-	}else{
 		// If there was an entity with higher priority, we would have rescheduled.
-		assert(!po);
+		// Entities with lower priority never preempt the current entity.
+		bool contended = false;
+		if(!_waitQueue.empty()) {
+			auto po = ScheduleEntity::orderPriority(_current, _waitQueue.top());
+			assert(po <= 0);
+			contended = !po;
+		}
+
+		switch(_current->_params.policy) {
+		case SchedulePolicy::fair:
+			// If the slice already elapsed, maybeReschedule() decided to keep the
+			// current entity; give it at least another granule.
+			if(contended)
+				consider(frg::max(_sliceClock + _sliceLength(),
+						_refClock + sliceGranularity));
+			break;
+		case SchedulePolicy::roundRobin:
+			if(contended)
+				consider(_sliceClock + roundRobinSlice);
+			break;
+		case SchedulePolicy::fifo:
+			break;
+		case SchedulePolicy::deadline:
+			// Throttle the entity once its budget is exhausted.
+			assert(_current->_budget > 0);
+			consider(_refClock + _current->_budget);
+			break;
+		}
+	}
+
+	if(!deadline) {
+		if(preemptionIsArmed())
+			disarmPreemption();
+		_preemptionDeadline = 0;
+		return;
 	}
 
-	armPreemption(sliceGranularity);
+	// The slice length depends on the number of waiters; it can shrink while the
+	// slice is running. Avoid reprogramming the timer if the deadline did not change.
+	if(preemptionIsArmed() && deadline == _preemptionDeadline)
+		return;
+
+	auto now = systemClockSource()->currentNanos();
+	armPreemption(deadline > now ? deadline - now : 0);
+	_preemptionDeadline = deadline;
 }
 
 void Scheduler::_updateCurrentEntity() {
@@ -390,6 +784,9 @@ void Scheduler::_updateCurrentEntity() {
 				<< " us (" << _numWaiting << " waiting threads)" << frg::endlog;
 	_current->baseUnfairness -= _numWaiting * delta_progress;
 	_current->refProgress = _systemProgress;
+
+	// Charge the run time (and the budget of deadline entities).
+	_updateEntityStats(_current);
 }
 
 void Scheduler::_updateWaitingEntity(ScheduleEntity *entity) {
@@ -412,8 +809,12 @@ void Scheduler::_updateEntityStats(ScheduleEntity *entity) {
 	assert(entity->state == ScheduleState::active
 			|| entity == _current);
 
-	if(entity == _current)
-		entity->_runTime += _refClock - entity->_refClock;
+	if(entity == _current) {
+		auto delta = _refClock - entity->_refClock;
+		entity->_runTime += delta;
+		if(entity->_params.policy == SchedulePolicy::deadline)
+			_chargeBudget(entity, delta);
+	}
 	entity->_refClock = _refClock;
 }
 
@@ -7,6 +7,7 @@
 #include <thor-internal/universe.hpp>
 #include <thor-internal/fiber.hpp>
 #include <thor-internal/module.hpp>
+#include <thor-internal/profile.hpp>
 #include <thor-internal/stream.hpp>
 #include <thor-internal/thread.hpp>
 #include "mbus.frigg_pb.hpp"
@@ -257,6 +258,7 @@ coroutine<void> executeModule(frg::string_view name, MfsRegular *module,
 		LaneHandle xpipe_lane,
 		Scheduler *scheduler) {
 	auto space = AddressSpace::create();
+	nameProfileSpace(space.get(), name);
 
 	ImageInfo exec_info = co_await loadModuleImage(space, 0, module->getMemory());
 
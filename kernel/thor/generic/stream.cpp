@@ -169,7 +169,7 @@ void Stream::Submitter::run() {
 		}else if(u->tag() == kTagSendKernelBuffer && v->tag() == kTagRecvKernelBuffer) {
 			transfer(SendRecvInline{}, u, v);
 		}else if(u->tag() == kTagSendFlow && v->tag() == kTagRecvKernelBuffer) {
-			if(u->_inBuffer.size() > v->_maxLength) {
+			if(u->_maxLength > v->_maxLength) {
 				// Both nodes complete with bufferTooSmall.
 				u->_error = Error::bufferTooSmall;
 				v->_error = Error::bufferTooSmall;
@@ -261,6 +261,7 @@ bool Stream::decrementPeers(Stream *stream, int lane) {
 			&StreamNode::processQueueItem
 		>
 	> pending;
+	SyncList pendingSync;
 
 	{
 		auto irq_lock = frg::guard(&irqMutex());
@@ -269,6 +270,8 @@ bool Stream::decrementPeers(Stream *stream, int lane) {
 
 		stream->_laneBroken[lane] = true;
 		pending.splice(pending.end(), stream->_processQueue[!lane]);
+		stream->_takeSync(lane, Error::endOfLane, Error::endOfLane, pendingSync);
+		stream->_takeSync(!lane, Error::endOfLane, Error::endOfLane, pendingSync);
 	}
 
 	while(!pending.empty()) {
@@ -276,11 +279,15 @@ bool Stream::decrementPeers(Stream *stream, int lane) {
 		_cancelItem(item, Error::endOfLane);
 	}
 
+	while(!pendingSync.empty())
+		pendingSync.pop_front()->complete(false);
+
 	return true;
 }
 
 Stream::Stream()
-: _laneBroken{false, false}, _laneShutDown{false, false} {
+: _laneBroken{false, false}, _laneShutDown{false, false},
+		_syncServer{nullptr, nullptr}, _syncReplyTo{nullptr, nullptr} {
 	_peerCount[0].store(1, std::memory_order_relaxed);
 	_peerCount[1].store(1, std::memory_order_relaxed);
 }
@@ -299,6 +306,7 @@ void Stream::shutdownLane(int lane) {
 			&StreamNode::processQueueItem
 		>
 	> pendingOnThisLane, pendingOnOtherLane;
+	SyncList pendingSync;
 
 	{
 		auto irq_lock = frg::guard(&irqMutex());
@@ -308,8 +316,13 @@ void Stream::shutdownLane(int lane) {
 		_laneShutDown[lane] = true;
 		pendingOnThisLane.splice(pendingOnThisLane.end(), _processQueue[lane]);
 		pendingOnOtherLane.splice(pendingOnOtherLane.end(), _processQueue[!lane]);
+		_takeSync(lane, Error::laneShutdown, Error::endOfLane, pendingSync);
+		_takeSync(!lane, Error::endOfLane, Error::laneShutdown, pendingSync);
 	}
 
+	while(!pendingSync.empty())
+		pendingSync.pop_front()->complete(false);
+
 	while(!pendingOnThisLane.empty()) {
 		auto item = pendingOnThisLane.pop_front();
 		_cancelItem(item, Error::laneShutdown);
@@ -343,6 +356,130 @@ void Stream::_cancelItem(StreamNode *item, Error error) {
 	}
 }
 
+// --------------------------------------------------------
+// Synchronous call/reply IPC.
+// --------------------------------------------------------
+
+static void transferSyncMessage(SyncNode *from, SyncNode *to) {
+	if(from->length > to->maxLength) {
+		to->error = Error::bufferTooSmall;
+		to->length = 0;
+		return;
+	}
+
+	memcpy(to->buffer.data(), from->buffer.data(), from->length);
+	to->error = Error::success;
+	to->length = from->length;
+}
+
+void Stream::syncCall(LaneHandle &lane, SyncNode *node) {
+	auto s = lane.getStream();
+	int p = lane.getLane();
+	int q = 1 - p;
+
+	SyncNode *server = nullptr;
+	{
+		auto irqLock = frg::guard(&irqMutex());
+		auto lock = frg::guard(&s->_mutex);
+		assert(!s->_laneBroken[p]);
+
+		if(s->_laneShutDown[p]) {
+			node->error = Error::laneShutdown;
+		}else if(s->_laneBroken[q] || s->_laneShutDown[q]) {
+			node->error = Error::endOfLane;
+		}else if(s->_syncServer[q]) {
+			server = std::exchange(s->_syncServer[q], nullptr);
+			assert(!s->_syncReplyTo[q]);
+			transferSyncMessage(node, server);
+			s->_syncReplyTo[q] = node;
+		}else{
+			// The server is busy; it picks up the call on its next syncReplyAndWait().
+			s->_syncCalls[q].push_back(node);
+			return;
+		}
+	}
+
+	if(!server) {
+		node->complete(false);
+		return;
+	}
+
+	// We block until the server replies, hence we hand off to the server.
+	server->complete(true);
+}
+
+void Stream::syncReplyAndWait(LaneHandle &lane,
+		const void *reply, size_t replyLength, SyncNode *node) {
+	auto s = lane.getStream();
+	int p = lane.getLane();
+	int q = 1 - p;
+
+	SyncNode *caller = nullptr;
+	bool received = true;
+	{
+		auto irqLock = frg::guard(&irqMutex());
+		auto lock = frg::guard(&s->_mutex);
+		assert(!s->_laneBroken[p]);
+
+		if(reply) {
+			caller = std::exchange(s->_syncReplyTo[p], nullptr);
+			if(caller) {
+				if(replyLength > caller->maxLength) {
+					caller->error = Error::bufferTooSmall;
+					caller->length = 0;
+				}else{
+					memcpy(caller->buffer.data(), reply, replyLength);
+					caller->error = Error::success;
+					caller->length = replyLength;
+				}
+			}
+		}
+
+		if(reply && !caller) {
+			// There is no call to reply to.
+			node->error = Error::illegalState;
+		}else if(s->_laneShutDown[p]) {
+			node->error = Error::laneShutdown;
+		}else if(s->_syncServer[p]) {
+			// Only one thread can wait on each lane.
+			node->error = Error::illegalState;
+		}else if(!s->_syncCalls[p].empty()) {
+			auto call = s->_syncCalls[p].pop_front();
+			transferSyncMessage(call, node);
+			s->_syncReplyTo[p] = call;
+		}else if(s->_laneBroken[q] || s->_laneShutDown[q]) {
+			node->error = Error::endOfLane;
+		}else{
+			s->_syncServer[p] = node;
+			received = false;
+		}
+	}
+
+	// If we block now, we hand off to the caller.
+	if(caller)
+		caller->complete(!received);
+	if(received)
+		node->complete(false);
+}
+
+void Stream::_takeSync(int lane, Error serverError, Error callError, SyncList &list) {
+	if(auto server = std::exchange(_syncServer[lane], nullptr); server) {
+		server->error = serverError;
+		list.push_back(server);
+	}
+
+	if(auto call = std::exchange(_syncReplyTo[lane], nullptr); call) {
+		call->error = callError;
+		list.push_back(call);
+	}
+
+	while(!_syncCalls[lane].empty()) {
+		auto call = _syncCalls[lane].pop_front();
+		call->error = callError;
+		list.push_back(call);
+	}
+}
+
 frg::tuple<LaneHandle, LaneHandle> createStream() {
 	auto stream = smarter::allocate_shared<Stream>(*kernelAlloc);
 	assert(stream.ctr()->check_count() == 1);
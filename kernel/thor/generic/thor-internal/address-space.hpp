@@ -435,6 +435,14 @@ public:
 		);
 	}
 
+	// Copies data from another space into this space. Pages of both spaces are accessed
+	// through the kernel's view of physical memory, i.e., without an intermediate buffer.
+	// In contrast to readSpace() / writeSpace(), this honors the protection of the mappings.
+	// Returns Error::fault if this space faults and Error::remoteFault if the source faults.
+	coroutine<frg::expected<Error>> copyFromSpace(uintptr_t address,
+			VirtualSpace *source, uintptr_t sourceAddress, size_t size,
+			smarter::shared_ptr<WorkQueue> wq);
+
 	// ----------------------------------------------------------------------------------
 	// GlobalFutex support.
 	// ----------------------------------------------------------------------------------
@@ -492,6 +500,10 @@ private:
 
 	smarter::shared_ptr<Mapping> _findMapping(VirtualAddr address);
 
+	// Implementation of writePartialSpace(). Stops at mappings that lack requiredFlags.
+	coroutine<size_t> _writePartialSpace(uintptr_t address, const void *buffer, size_t size,
+			MappingFlags requiredFlags, smarter::shared_ptr<WorkQueue> wq);
+
 	// Splits some memory range from a hole mapping.
 	void _splitHole(Hole *hole, VirtualAddr offset, VirtualAddr length);
 
@@ -584,6 +596,9 @@ public:
 
 	void dispose(BindableHandle);
 
+	// Identifies the space in kernel profiles; see profileSpaceId().
+	const uint64_t profileId;
+
 	FutexRealm localFutexRealm;
 
 	bool updatePageAccess(VirtualAddr address) {
@@ -3,12 +3,14 @@
 #include <thor-internal/arch/cpu.hpp>
 #include <thor-internal/executor-context.hpp>
 #include <thor-internal/kernel-locks.hpp>
+#include <thor-internal/kernel_heap.hpp>
 #include <thor-internal/schedule.hpp>
 
 namespace thor {
 
 // Forward defined for pointers that are part of CpuData.
 struct KernelFiber;
+struct PrecisionTimerEngine;
 struct SingleContextRecordRing;
 struct WorkQueue;
 
@@ -32,17 +34,32 @@ struct CpuData : public PlatformCpuData {
 	bool haveVirtualization;
 
 	int cpuIndex;
+	// Assigned from the ACPI SRAT (if available).
+	int numaNode = 0;
 
 	ExecutorContext *executorContext = nullptr;
 	KernelFiber *activeFiber;
 	KernelFiber *wqFiber = nullptr;
 	smarter::shared_ptr<WorkQueue> generalWorkQueue;
+	// Only set if the architecture supports per-CPU alarms.
+	PrecisionTimerEngine *localTimerEngine = nullptr;
 	std::atomic<uint64_t> heartbeat;
+	KernelHeapCache heapCache;
+
+	// Timer IRQs taken by this CPU and the number of those IRQs that actually
+	// expired a deadline (preemption or alarm). Used to verify tickless operation.
+	std::atomic<uint64_t> numTimerIrqs{0};
+	std::atomic<uint64_t> numNeededTimerIrqs{0};
 
 	unsigned int irqEntropySeq = 0;
 	std::atomic<ProfileMechanism> profileMechanism{};
 	// TODO: This should be a unique_ptr instead.
 	SingleContextRecordRing *localProfileRing = nullptr;
+
+	// InfoSink records emitted on this CPU; allocated by the log drain fiber.
+	std::atomic<SingleContextRecordRing *> localLogRing{nullptr};
+	// Position of the log drain in localLogRing. Protected by the global log mutex.
+	uint64_t logDeqPtr = 0;
 };
 
 CpuData *getCpuData(size_t k);
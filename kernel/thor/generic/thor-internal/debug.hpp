@@ -5,6 +5,8 @@
 
 namespace thor {
 
+struct LogRingBuffer;
+
 void panic();
 
 // --------------------------------------------------------
@@ -26,6 +28,9 @@ void disableLogHandler(LogHandler *sink);
 size_t currentLogSequence();
 void copyLogMessage(size_t sequence, char *text);
 
+// Ring that receives all messages printed through infoLogger().
+LogRingBuffer *getKernelLogRing();
+
 // --------------------------------------------------------
 // Loggers.
 // --------------------------------------------------------
@@ -20,6 +20,8 @@ enum class Error {
 	remoteFault,
 	noMemory,
 	noHardwareSupport,
+	// Admission control rejected a request for CPU bandwidth.
+	noBandwidth,
 	hardwareBroken,
 	// Internal error: the remote has violated the IPC protocol.
 	protocolViolation,
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <assert.h>
+#include <atomic>
 #include <frg/slab.hpp>
 #include <frg/spinlock.hpp>
 #include <frg/manual_box.hpp>
@@ -19,6 +20,35 @@ private:
 	frg::ticket_spinlock _spinlock;
 };
 
+// Lock of the shared kernel heap. Unlike IrqSpinlock, this lock is recursive on the
+// same CPU: this allows the per-CPU heap caches to refill or flush a whole batch of
+// objects while taking the lock only once.
+struct KernelHeapLock {
+	constexpr KernelHeapLock() = default;
+
+	void lock();
+	void unlock();
+
+	// Number of lock() calls that found the lock held by another CPU.
+	uint64_t numContended() {
+		return _numContended.load(std::memory_order_relaxed);
+	}
+
+private:
+	frg::ticket_spinlock _spinlock;
+	std::atomic<void *> _owner{nullptr};
+	unsigned int _depth = 0;
+	std::atomic<uint64_t> _numContended{0};
+};
+
+// Stateless handle to the global KernelHeapLock (frg::slab_pool owns its mutex by value).
+struct KernelHeapMutex {
+	constexpr KernelHeapMutex() = default;
+
+	void lock();
+	void unlock();
+};
+
 struct KernelVirtualMemory {
 	using Mutex = frg::ticket_spinlock;
 public:
@@ -66,16 +96,68 @@ public:
 	void output_trace(void *buffer, size_t size);
 };
 
-using KernelAlloc = frg::slab_allocator<KernelVirtualAlloc, IrqSpinlock>;
+using KernelSlabPool = frg::slab_pool<KernelVirtualAlloc, KernelHeapMutex>;
+
+// Per-CPU cache ("magazine") of free objects for each small size class.
+// Allocations and sized deallocations are served from the cache of the current CPU;
+// the shared KernelSlabPool is only accessed to refill or flush a batch of objects.
+struct KernelHeapCache {
+	static constexpr int minClassShift = 4;
+	static constexpr int maxClassShift = 12;
+	static constexpr int numClasses = maxClassShift - minClassShift + 1;
+	static constexpr size_t magazineSize = 32;
+	static constexpr size_t batchSize = magazineSize / 2;
+
+	// Returns -1 for sizes that are not cached.
+	static int sizeClassOf(size_t size) {
+		if(size > (size_t{1} << maxClassShift))
+			return -1;
+		if(size <= (size_t{1} << minClassShift))
+			return 0;
+		return (64 - __builtin_clzll(size - 1)) - minClassShift;
+	}
+
+	static size_t sizeOfClass(int k) {
+		return size_t{1} << (minClassShift + k);
+	}
+
+	struct SizeClass {
+		size_t numObjects = 0;
+		void *objects[magazineSize];
+
+		// Statistics. These are only written by the owning CPU.
+		std::atomic<uint64_t> numAllocations{0};
+		std::atomic<uint64_t> numDeallocations{0};
+		std::atomic<uint64_t> numRefills{0};
+		std::atomic<uint64_t> numFlushes{0};
+	};
+
+	SizeClass classes[numClasses];
+};
+
+struct KernelAlloc {
+	KernelAlloc(KernelSlabPool *pool)
+	: _pool{pool} { }
+
+	void *allocate(size_t size);
+	void deallocate(void *pointer, size_t size);
+	void *reallocate(void *pointer, size_t size);
+	// Objects that are freed without a size cannot be attributed to a size class,
+	// hence they are returned to the shared pool directly.
+	void free(void *pointer);
+
+private:
+	void _refill(KernelHeapCache::SizeClass &sc, int k);
+	void _flush(KernelHeapCache::SizeClass &sc, int k);
+
+	KernelSlabPool *_pool;
+};
+
+extern constinit KernelHeapLock kernelHeapLock;
 
 extern constinit frg::manual_box<KernelVirtualAlloc> kernelVirtualAlloc;
 
-extern constinit frg::manual_box<
-	frg::slab_pool<
-		KernelVirtualAlloc,
-		IrqSpinlock
-	>
-> kernelHeap;
+extern constinit frg::manual_box<KernelSlabPool> kernelHeap;
 
 extern constinit frg::manual_box<KernelAlloc> kernelAlloc;
 
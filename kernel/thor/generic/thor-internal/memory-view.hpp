@@ -275,6 +275,9 @@ public:
 
 	virtual void resize(size_t newLength, async::any_receiver<void> receiver);
 
+	// Releases the physical memory that backs a range. Afterwards, the range reads back as zeros.
+	virtual coroutine<frg::expected<Error>> decommitRange(uintptr_t offset, size_t size);
+
 	// Returns a unique identity for each memory address.
 	// This is used as a key to access futexes.
 	virtual frg::expected<Error, frg::tuple<smarter::shared_ptr<GlobalFutexSpace>, uintptr_t>>
@@ -757,6 +760,21 @@ struct ImmediateMemory final : MemoryView, GlobalFutexSpace {
 		}
 	}
 
+	void readImmediate(uintptr_t offset, void *pointer, size_t size) {
+		size_t progress = 0;
+		while(progress < size) {
+			auto misalign = (offset + progress) & (kPageSize - 1);
+			auto chunk = frg::min(size - progress, kPageSize - misalign);
+
+			auto index = (offset + progress) >> kPageShift;
+			assert(index < _physicalPages.size());
+			PageAccessor accessor{_physicalPages[index]};
+			memcpy(reinterpret_cast<std::byte *>(pointer) + progress,
+					reinterpret_cast<std::byte *>(accessor.get()) + misalign, chunk);
+			progress += chunk;
+		}
+	}
+
 public:
 	// Contract: set by the code that constructs this object.
 	smarter::borrowed_ptr<ImmediateMemory> selfPtr;
@@ -791,8 +809,10 @@ private:
 };
 
 struct AllocatedMemory final : MemoryView, GlobalFutexSpace {
+	// Mappings of decommittable memory observe evictions, which decommitRange() relies on.
 	AllocatedMemory(size_t length, int addressBits = 64,
-			size_t chunkSize = kPageSize, size_t chunkAlign = kPageSize);
+			size_t chunkSize = kPageSize, size_t chunkAlign = kPageSize,
+			bool decommittable = false);
 	AllocatedMemory(const AllocatedMemory &) = delete;
 	~AllocatedMemory();
 
@@ -800,6 +820,7 @@ struct AllocatedMemory final : MemoryView, GlobalFutexSpace {
 
 	size_t getLength() override;
 	void resize(size_t newLength, async::any_receiver<void> receiver) override;
+	coroutine<frg::expected<Error>> decommitRange(uintptr_t offset, size_t size) override;
 	frg::expected<Error, frg::tuple<smarter::shared_ptr<GlobalFutexSpace>, uintptr_t>>
 			resolveGlobalFutex(uintptr_t offset) override;
 	Error lockRange(uintptr_t offset, size_t size) override;
@@ -821,8 +842,12 @@ private:
 	frg::ticket_spinlock _mutex;
 
 	frg::vector<PhysicalAddr, KernelAlloc> _physicalChunks;
+	// Number of active locks on each chunk. decommitRange() does not release locked chunks.
+	frg::vector<unsigned int, KernelAlloc> _lockCounts;
 	int _addressBits;
 	size_t _chunkSize, _chunkAlign;
+
+	EvictionQueue _evictQueue;
 };
 
 struct ManagedSpace : CacheBundle {
@@ -25,17 +25,43 @@ public:
 	void *access(PhysicalAddr physical);
 };
 
+// Passed to PhysicalChunkAllocator::allocate() to allocate from any NUMA node.
+inline constexpr int anyNumaNode = -1;
+inline constexpr int maxNumaNodes = 16;
+
+// Distances as defined by the ACPI SLIT.
+inline constexpr uint8_t localNumaDistance = 10;
+inline constexpr uint8_t remoteNumaDistance = 20;
+
+// Returns the NUMA node of the current CPU.
+int currentNumaNode();
+
 class PhysicalChunkAllocator {
 	typedef frg::ticket_spinlock Mutex;
 public:
+	// Same as the maximal number of regions that eir passes to us.
+	static constexpr int maxRegions = 64;
+
 	PhysicalChunkAllocator();
 	
 	void bootstrapRegion(PhysicalAddr address,
 			int order, size_t numRoots, int8_t *buddyTree);
 
-	PhysicalAddr allocate(size_t size, int addressBits = 64);
+	// Assigns all regions that start within [address, address + size) to a NUMA node.
+	void setNumaNode(PhysicalAddr address, size_t size, int node);
+	void setNumaDistance(int from, int to, uint8_t distance);
+
+	// If node is not anyNumaNode, the allocator first tries regions on that node
+	// and then falls back to other nodes in order of increasing distance.
+	PhysicalAddr allocate(size_t size, int addressBits = 64, int node = anyNumaNode);
 	void free(PhysicalAddr address, size_t size);
 
+	int numNumaNodes() {
+		return _numNodes;
+	}
+	size_t numFreePagesOfNode(int node);
+	size_t numUsedPagesOfNode(int node);
+
 	size_t numTotalPages() {
 		return _totalPages.load(std::memory_order_relaxed);
 	}
@@ -53,11 +79,19 @@ private:
 		PhysicalAddr physicalBase;
 		PhysicalAddr regionSize;
 		BuddyAccessor buddyAccessor;
+		int numaNode = 0;
+		size_t numPages = 0;
+		size_t usedPages = 0;
 	};
 
-	Region _allRegions[8];
+	PhysicalAddr _allocateFrom(Region &region, int target, int addressBits);
+
+	Region _allRegions[maxRegions];
 	int _numRegions = 0;
 
+	int _numNodes = 1;
+	uint8_t _distances[maxNumaNodes][maxNumaNodes];
+
 	std::atomic<size_t> _totalPages{0};
 	std::atomic<size_t> _usedPages{0};
 	std::atomic<size_t> _freePages{0};
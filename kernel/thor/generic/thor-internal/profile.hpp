@@ -1,12 +1,67 @@
 #pragma once
 
+#include <frg/string.hpp>
 #include <thor-internal/ring-buffer.hpp>
 
 namespace thor {
 
+struct AddressSpace;
+
 extern bool wantKernelProfile;
 
+// Each record in the kernel-profile ring starts with one of these values.
+// The records do not carry their length; it follows from the header.
+enum class ProfileRecordKind : uint32_t {
+	sample = 1,
+	spaceName = 2,
+	spaceRetired = 3
+};
+
+// Maximal number of frames of each (i.e., kernel and user) call chain.
+inline constexpr int maxProfileFrames = 32;
+
+// Emitted for each PMC overflow. Followed by numKernelFrames kernel IPs and then
+// numUserFrames user IPs (as uint64_t, innermost frame first).
+// threadId and spaceId are zero if the sample did not hit a thread.
+struct ProfileSampleHeader {
+	ProfileRecordKind kind;
+	uint32_t cpu;
+	// Same value as the last 8 bytes of the thread's credentials.
+	uint64_t threadId;
+	uint64_t spaceId;
+	uint16_t numKernelFrames;
+	uint16_t numUserFrames;
+	uint32_t padding;
+};
+
+// Associates a spaceId with the name of a server. Followed by nameLength bytes.
+struct ProfileSpaceNameHeader {
+	ProfileRecordKind kind;
+	uint32_t nameLength;
+	uint64_t spaceId;
+};
+
+// Emitted once the last handle to an address space is gone.
+// Samples are delayed by the per-CPU rings, hence a few samples of the space
+// can still follow this record.
+struct ProfileSpaceRetiredHeader {
+	ProfileRecordKind kind;
+	uint32_t padding;
+	uint64_t spaceId;
+};
+
+inline constexpr size_t maxProfileRecordSize = sizeof(ProfileSampleHeader)
+		+ 2 * maxProfileFrames * sizeof(uint64_t);
+
+// Unlike the address of the space, this is never reused.
+uint64_t profileSpaceId(AddressSpace *space);
+
 void initializeProfile();
 LogRingBuffer *getGlobalProfileRing();
+LogRingBuffer *getHeapProfileRing();
+
+// Allows analysis tools to attribute samples in the given address space to a binary.
+void nameProfileSpace(AddressSpace *space, frg::string_view name);
+void retireProfileSpace(AddressSpace *space);
 
 } // namespace thor
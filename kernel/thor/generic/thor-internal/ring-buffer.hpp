@@ -75,6 +75,11 @@ struct LogRingBuffer {
 		enqueue(&c, 1);
 	}
 
+	// Wakes up consumers after enqueue() was called with suppressWakeup.
+	void wakeup() {
+		event_.raise();
+	}
+
 	frg::tuple<bool, uint64_t, uint64_t, size_t>
 	dequeueAt(uint64_t deqPtr, void *data, size_t maxSize) {
 		auto p = reinterpret_cast<char *>(data);
@@ -6,6 +6,7 @@
 #include <frg/list.hpp>
 #include <frg/pairing_heap.hpp>
 #include <frg/spinlock.hpp>
+#include <thor-internal/error.hpp>
 
 namespace thor {
 
@@ -25,6 +26,33 @@ enum class ScheduleState {
 	active
 };
 
+enum class SchedulePolicy {
+	// Fair-share scheduling among entities of the same priority.
+	fair,
+	// Real-time policies. These always preempt fair entities and are ordered
+	// strictly by priority. Round-robin entities of the same priority share the CPU.
+	fifo,
+	roundRobin,
+	// Earliest deadline first. Each entity is served by a constant bandwidth server
+	// that grants it `runtime` ns of CPU time in every `period`. Deadline entities
+	// preempt all other entities but are throttled once they exhaust their budget.
+	deadline
+};
+
+struct ScheduleParams {
+	SchedulePolicy policy = SchedulePolicy::fair;
+	// For the fair policy, this is a relative priority.
+	// For the real-time policies, this is between minRealtimePriority and maxRealtimePriority.
+	int priority = 0;
+	// Only used by the deadline policy (in ns).
+	uint64_t runtime = 0;
+	uint64_t deadline = 0;
+	uint64_t period = 0;
+};
+
+inline constexpr int minRealtimePriority = 1;
+inline constexpr int maxRealtimePriority = 99;
+
 // This needs to store a large timeframe.
 // For now, store it as 55.8 0 signed integer nanoseconds.
 using Progress = int64_t;
@@ -60,15 +88,37 @@ public:
 private:
 	const ScheduleType type_;
 
+	// Protects _scheduler and the requested scheduling parameters.
 	frg::ticket_spinlock _associationMutex;
 	Scheduler *_scheduler;
 
 	ScheduleState state;
-	int priority;
+
+	// Parameters that are currently in effect. Only accessed by the owning scheduler.
+	ScheduleParams _params;
+
+	// Parameters requested by Scheduler::setParams(). These are applied by
+	// the owning scheduler (see Scheduler::_applyParams()).
+	ScheduleParams _requestedParams;
+	bool _paramsChanged = false;
+	bool _onParamsList = false;
+
+	// Bandwidth (in units of 1 / bandwidthScale CPUs) that was admitted for the deadline policy.
+	uint64_t _admittedBandwidth = 0;
 
 	frg::default_list_hook<ScheduleEntity> listHook;
+	frg::default_list_hook<ScheduleEntity> paramsHook;
 	frg::pairing_heap_hook<ScheduleEntity> heapHook;
 
+	// Entities of the real-time and deadline policies with equal keys are run
+	// in the order in which they were enqueued.
+	uint64_t _sequence = 0;
+
+	// State of the constant bandwidth server (deadline policy only).
+	uint64_t _absoluteDeadline = 0;
+	int64_t _budget = 0;
+	bool _throttled = false;
+
 	uint64_t _refClock;
 	uint64_t _runTime;
 
@@ -96,11 +146,23 @@ struct Scheduler {
 	static void associate(ScheduleEntity *entity, Scheduler *scheduler);
 	static void unassociate(ScheduleEntity *entity);
 
-	static void setPriority(ScheduleEntity *entity, int priority);
+	// Changes the scheduling parameters of an entity. Unlike setPriority(), this can be
+	// called on entities that are not currently running (on any CPU). Entities that
+	// request the deadline policy are subject to admission control.
+	static Error setParams(ScheduleEntity *entity, const ScheduleParams &params);
+	static ScheduleParams getParams(ScheduleEntity *entity);
+
+	// Changes only the priority. Keeps the current policy.
+	static Error setPriority(ScheduleEntity *entity, int priority);
 
 	static void resume(ScheduleEntity *entity);
 	static void suspendCurrent();
 
+	// Like resume() but if the entity belongs to this CPU, it runs next once the current
+	// entity is switched out (unless that would violate priorities). Used to donate the
+	// rest of the time slice when the current entity blocks on the resumed entity.
+	static void handoff(ScheduleEntity *entity);
+
 	Scheduler(CpuData *cpu_context);
 
 	Scheduler(const Scheduler &) = delete;
@@ -123,10 +185,27 @@ public:
 	ScheduleEntity *currentRunnable();
 
 private:
-	void _unschedule();
+	// If rotate is false, real-time entities keep their position among
+	// entities of the same priority.
+	void _unschedule(bool rotate);
 	void _schedule();
 
 private:
+	using ScheduleList = frg::intrusive_list<
+		ScheduleEntity,
+		frg::locate_member<
+			ScheduleEntity,
+			frg::default_list_hook<ScheduleEntity>,
+			&ScheduleEntity::listHook
+		>
+	>;
+
+	void _applyParams(ScheduleEntity *entity);
+	void _enqueue(ScheduleEntity *entity);
+	void _replenish(ScheduleEntity *entity);
+	void _chargeBudget(ScheduleEntity *entity, uint64_t delta);
+
+	uint64_t _sliceLength();
 	void _updatePreemption();
 
 	void _updateCurrentEntity();
@@ -151,6 +230,12 @@ private:
 
 	size_t _numWaiting = 0;
 
+	// Deadline entities that exhausted their budget. They are put back into
+	// _waitQueue at their current deadline (the replenishment time).
+	ScheduleList _throttledList;
+
+	uint64_t _nextSequence = 0;
+
 	// The last tick at which the scheduler's state (i.e. progress) was updated.
 	// In our model this is the time point at which slice T started.
 	uint64_t _refClock = 0;
@@ -158,6 +243,9 @@ private:
 	// Start of the current timeslice.
 	uint64_t _sliceClock;
 
+	// Deadline that the preemption timer was last armed for (or zero).
+	uint64_t _preemptionDeadline = 0;
+
 	// This variables stores sum{t = 0, ... T} w(t)/n(t).
 	// This allows us to easily track u_p(T) for all waiting processes.
 	Progress _systemProgress = 0;
@@ -166,17 +254,24 @@ private:
 	// Management of pending entities.
 	// ----------------------------------------------------------------------------------
 
-	// Note that _mutex *only* protects _pendingList and nothing more!
+	// Note that _mutex *only* protects _pendingList, _paramsList and _handoffEntity
+	// and nothing more!
 	frg::ticket_spinlock _mutex;
 
+	ScheduleList _pendingList;
+
+	// Entity that is preferred by the next call to _schedule() (see handoff()).
+	ScheduleEntity *_handoffEntity = nullptr;
+
+	// Entities whose scheduling parameters were changed from outside of this CPU.
 	frg::intrusive_list<
 		ScheduleEntity,
 		frg::locate_member<
 			ScheduleEntity,
 			frg::default_list_hook<ScheduleEntity>,
-			&ScheduleEntity::listHook
+			&ScheduleEntity::paramsHook
 		>
-	> _pendingList;
+	> _paramsList;
 };
 
 Scheduler *localScheduler();
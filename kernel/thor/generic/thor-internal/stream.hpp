@@ -72,11 +72,19 @@ inline bool usesFlowProtocol(int tag) {
 	return tag == kTagSendFlow || tag == kTagRecvFlow;
 }
 
+struct VirtualSpace;
+
 struct FlowPacket {
-	void *data = nullptr;
+	// Memory in the sender's address space that the receiver copies from.
+	// The space remains valid until the packet is acked.
+	VirtualSpace *space = nullptr;
+	uintptr_t address = 0;
 	size_t size = 0;
 	bool terminate = false;
+	// The side that sends this packet encountered a fault.
 	bool fault = false;
+	// Only used in acks: the memory referenced by the acked packet could not be read.
+	bool remoteFault = false;
 };
 
 struct StreamNode {
@@ -188,6 +196,37 @@ using StreamList = frg::intrusive_list<
 	>
 >;
 
+// Maximal size of messages that are exchanged by synchronous calls.
+inline constexpr size_t syncMessageSize = 128;
+
+// Participant of a synchronous call/reply exchange on a lane (see Stream::syncCall()).
+// Callers transmit their request through buffer and receive the reply in the same buffer.
+struct SyncNode {
+	friend struct Stream;
+
+	SyncNode() = default;
+
+	SyncNode(const SyncNode &) = delete;
+
+	SyncNode &operator= (const SyncNode &) = delete;
+
+	// Called (without locks held) once a message was received or an error occurred.
+	// If handoff is true, the completing thread is about to block on this node's thread.
+	virtual void complete(bool handoff) = 0;
+
+	frg::array<std::byte, syncMessageSize> buffer;
+	size_t length = 0;
+	// Maximal length of the message that is received.
+	size_t maxLength = 0;
+	Error error = Error::success;
+
+private:
+	frg::default_list_hook<SyncNode> _hook;
+
+protected:
+	~SyncNode() = default;
+};
+
 struct Stream {
 	struct Submitter {
 		void enqueue(const LaneHandle &lane, StreamList &chain);
@@ -216,6 +255,19 @@ struct Stream {
 
 	void shutdownLane(int lane);
 
+	// Synchronous call/reply IPC. Messages are passed directly to the thread that waits
+	// on the other lane, bypassing the stream's process queues. Each lane has at most one
+	// waiting server thread; calls that arrive while the server is busy are queued.
+
+	// Transmits the request in node->buffer to the server on the other lane.
+	// node->complete() is called once the reply arrived.
+	static void syncCall(LaneHandle &lane, SyncNode *node);
+
+	// Replies to the call that was received last on this lane (unless reply is null)
+	// and waits for the next call. node->complete() is called once a call arrives.
+	static void syncReplyAndWait(LaneHandle &lane,
+			const void *reply, size_t replyLength, SyncNode *node);
+
 private:
 	static void _cancelItem(StreamNode *item, Error error);
 
@@ -240,6 +292,26 @@ private:
 	// Submissions are disallowed and return lane-shutdown errors.
 	// Submissions to the paired lane return end-of-lane errors.
 	bool _laneShutDown[2];
+
+	using SyncList = frg::intrusive_list<
+		SyncNode,
+		frg::locate_member<
+			SyncNode,
+			frg::default_list_hook<SyncNode>,
+			&SyncNode::_hook
+		>
+	>;
+
+	// Protected by _mutex. Indexed by the server's lane.
+	// Server thread that waits for calls.
+	SyncNode *_syncServer[2];
+	// Calls that were not yet received by the server.
+	SyncList _syncCalls[2];
+	// Call that was received by the server but not replied to yet.
+	SyncNode *_syncReplyTo[2];
+
+	// Moves the server of a lane and all calls to that server to the given list.
+	void _takeSync(int lane, Error serverError, Error callError, SyncList &list);
 };
 
 frg::tuple<LaneHandle, LaneHandle> createStream();
@@ -180,6 +180,9 @@ public:
 	// State transitions that apply to arbitrary threads.
 	// TODO: interruptOther() needs an Interrupt argument.
 	static void unblockOther(smarter::borrowed_ptr<Thread> thread);
+	// Like unblockOther() but lets the thread run next on this CPU once the current
+	// thread blocks (see Scheduler::handoff()).
+	static void handoffOther(smarter::borrowed_ptr<Thread> thread);
 	static void killOther(smarter::borrowed_ptr<Thread> thread);
 	static void interruptOther(smarter::borrowed_ptr<Thread> thread);
 	static Error resumeOther(smarter::borrowed_ptr<Thread> thread);
@@ -274,6 +277,8 @@ public:
 	void handlePreemption(IrqImageAccessor accessor) override;
 
 private:
+	static void _unblock(smarter::borrowed_ptr<Thread> thread, bool handoff);
+
 	void _uninvoke();
 	void _kill();
 
@@ -6,14 +6,18 @@
 #include <async/cancellation.hpp>
 #include <frg/container_of.hpp>
 #include <frg/intrusive.hpp>
+#include <frg/list.hpp>
 #include <frg/pairing_heap.hpp>
 #include <frg/spinlock.hpp>
+#include <frg/utility.hpp>
 #include <thor-internal/cancel.hpp>
 #include <thor-internal/work-queue.hpp>
 
 namespace thor {
 
 struct PrecisionTimerEngine;
+struct TimerWheel;
+struct CpuData;
 
 struct ClockSource {
 	virtual uint64_t currentNanos() = 0;
@@ -55,6 +59,9 @@ private:
 	std::atomic<AlarmSink *> _sink;
 };
 
+// Slack that is applied to timers that user space requests (same as Linux' default timer_slack_ns).
+inline constexpr uint64_t defaultUserTimerSlack = 50'000;
+
 enum class TimerState {
 	none,
 	queued,
@@ -75,6 +82,7 @@ struct PrecisionTimerNode {
 
 	friend struct CompareTimer;
 	friend struct PrecisionTimerEngine;
+	friend struct TimerWheel;
 
 	PrecisionTimerNode()
 	: _engine{nullptr}, _cancelCb{this} { }
@@ -90,14 +98,29 @@ struct PrecisionTimerNode {
 		_elapsed = elapsed;
 	}
 
+	// The timer may elapse up to slack nanoseconds after its deadline.
+	// This allows the engine to coalesce timers with nearby deadlines.
+	void setSlack(uint64_t slack) {
+		_slack = slack;
+	}
+
 	bool wasCancelled() {
 		return _wasCancelled;
 	}
 
 	frg::pairing_heap_hook<PrecisionTimerNode> hook;
+	frg::default_list_hook<PrecisionTimerNode> wheelHook;
 
 private:
+	uint64_t _hardDeadline() const {
+		// Saturate; timers that (effectively) never expire use huge deadlines.
+		if(_deadline > UINT64_MAX - _slack)
+			return UINT64_MAX;
+		return _deadline + _slack;
+	}
+
 	uint64_t _deadline;
+	uint64_t _slack = 0;
 	async::cancellation_token _cancelToken;
 	Worklet *_elapsed;
 
@@ -105,16 +128,73 @@ private:
 	PrecisionTimerEngine *_engine;
 
 	TimerState _state = TimerState::none;
+	// Whether the timer is queued in the engine's TimerWheel (instead of the heap).
+	bool _inWheel = false;
+	uint8_t _wheelLevel = 0;
+	uint8_t _wheelSlot = 0;
 	bool _wasCancelled = false;
 	async::cancellation_observer<CancelFunctor> _cancelCb;
 };
 
+// The heap is ordered by the latest time at which timers must elapse.
 struct CompareTimer {
 	bool operator() (const PrecisionTimerNode *a, const PrecisionTimerNode *b) const {
-		return a->_deadline > b->_deadline;
+		return a->_hardDeadline() > b->_hardDeadline();
 	}
 };
 
+// Hierarchical timer wheel for timers that tolerate at least one tick (~1ms) of slack.
+// Insertion and removal are O(1). Each level has numSlots slots; a slot of level k
+// covers numSlots^k ticks. Timers are cascaded to finer levels as their deadline approaches.
+struct TimerWheel {
+	static constexpr int tickShift = 20;
+	static constexpr uint64_t tickNanos = uint64_t{1} << tickShift;
+	static constexpr int slotShift = 6;
+	static constexpr size_t numSlots = size_t{1} << slotShift;
+	static constexpr int numLevels = 4;
+
+	using TimerList = frg::intrusive_list<
+		PrecisionTimerNode,
+		frg::locate_member<
+			PrecisionTimerNode,
+			frg::default_list_hook<PrecisionTimerNode>,
+			&PrecisionTimerNode::wheelHook
+		>
+	>;
+
+	TimerWheel(uint64_t now);
+
+	bool empty() {
+		return !_numTimers;
+	}
+
+	void insert(PrecisionTimerNode *timer);
+	void remove(PrecisionTimerNode *timer);
+
+	// Returns the time at which advance() needs to be called next (or zero if the wheel is empty).
+	uint64_t nextDeadline();
+
+	// Removes all timers that elapsed at time now from the wheel and appends them to the list.
+	void advance(uint64_t now, TimerList &elapsed);
+
+private:
+	static uint64_t _tickOf(PrecisionTimerNode *timer) {
+		// Round up without overflowing for huge deadlines.
+		return (timer->_deadline >> tickShift)
+				+ ((timer->_deadline & (tickNanos - 1)) ? 1 : 0);
+	}
+
+	void _insert(PrecisionTimerNode *timer, uint64_t tick);
+
+	// All ticks before _currentTick were already processed.
+	uint64_t _currentTick;
+	size_t _numTimers = 0;
+
+	TimerList _slots[numLevels][numSlots];
+	// Bitmap of non-empty slots per level.
+	uint64_t _pending[numLevels] = {};
+};
+
 struct PrecisionTimerEngine final : private AlarmSink {
 	friend struct PrecisionTimerNode;
 
@@ -122,8 +202,10 @@ private:
 	using Mutex = frg::ticket_spinlock;
 
 public:
-	PrecisionTimerEngine(ClockSource *clock, AlarmTracker *alarm);
-	
+	// Per-CPU engines pass the CpuData of the CPU whose alarm they use.
+	// Timers that are installed on other CPUs are redirected to those CPUs' engines.
+	PrecisionTimerEngine(ClockSource *clock, AlarmTracker *alarm, CpuData *cpu = nullptr);
+
 	void installTimer(PrecisionTimerNode *timer);
 
 	// ----------------------------------------------------------------------------------
@@ -145,14 +227,20 @@ public:
 		PrecisionTimerEngine *self;
 		uint64_t deadline;
 		async::cancellation_token cancellation;
+		uint64_t slack;
 	};
 
-	SleepSender sleep(uint64_t deadline, async::cancellation_token cancellation = {}) {
-		return {this, deadline, cancellation};
+	SleepSender sleep(uint64_t deadline, async::cancellation_token cancellation = {},
+			uint64_t slack = 0) {
+		return {this, deadline, cancellation, slack};
 	}
 
-	SleepSender sleepFor(uint64_t nanos, async::cancellation_token cancellation = {}) {
-		return {this, systemClockSource()->currentNanos() + nanos, cancellation};
+	// The slack is clamped to the duration of the sleep.
+	SleepSender sleepFor(uint64_t nanos, async::cancellation_token cancellation = {},
+			uint64_t slack = 0) {
+		auto now = systemClockSource()->currentNanos();
+		uint64_t deadline = (nanos > UINT64_MAX - now) ? UINT64_MAX : now + nanos;
+		return {this, deadline, cancellation, frg::min(slack, nanos)};
 	}
 
 	template<typename R>
@@ -169,7 +257,8 @@ public:
 				auto op = frg::container_of(base, &SleepOperation::worklet_);
 				async::execution::set_value(op->receiver_);
 			}, WorkQueue::generalQueue());
-			node_.setup(s_.deadline, &worklet_);
+			node_.setup(s_.deadline, s_.cancellation, &worklet_);
+			node_.setSlack(s_.slack);
 			s_.self->installTimer(&node_);
 		}
 
@@ -193,13 +282,20 @@ private:
 	void firedAlarm();
 
 private:
+	void _installTimer(PrecisionTimerNode *timer);
+
 	void _progress();
 
+	void _elapse(PrecisionTimerNode *timer);
+
 	ClockSource *_clock;
 	AlarmTracker *_alarm;
+	CpuData *_cpu;
 
 	Mutex _mutex;
 
+	TimerWheel _timerWheel;
+
 	frg::pairing_heap<
 		PrecisionTimerNode,
 		frg::locate_member<
@@ -210,13 +306,15 @@ private:
 		CompareTimer
 	> _timerQueue;
 	
-	size_t _activeTimers;
+	size_t _activeTimers = 0;
 };
 
 inline void PrecisionTimerNode::CancelFunctor::operator() () {
 	node_->_engine->cancelTimer(node_);
 }
 
+// Returns the timer engine of the current CPU (or the global engine if the
+// architecture does not provide per-CPU alarms).
 PrecisionTimerEngine *generalTimerEngine();
 
 bool haveTimer();
@@ -320,6 +320,14 @@ void Thread::raiseSignals(SyscallImageAccessor image) {
 }
 
 void Thread::unblockOther(smarter::borrowed_ptr<Thread> thread) {
+	_unblock(thread, false);
+}
+
+void Thread::handoffOther(smarter::borrowed_ptr<Thread> thread) {
+	_unblock(thread, true);
+}
+
+void Thread::_unblock(smarter::borrowed_ptr<Thread> thread, bool handoff) {
 	// Release semantics ensure that we synchronize with the thread when it flips the flag
 	// back to false. Acquire semantics are needed to synchronize with other threads
 	// that already set the flag to true in the meantime.
@@ -338,7 +346,11 @@ void Thread::unblockOther(smarter::borrowed_ptr<Thread> thread) {
 				<< " is deferred (via unblock)" << frg::endlog;
 
 	thread->_runState = kRunDeferred;
-	Scheduler::resume(thread.get());
+	if(handoff) {
+		Scheduler::handoff(thread.get());
+	}else{
+		Scheduler::resume(thread.get());
+	}
 }
 
 void Thread::killOther(smarter::borrowed_ptr<Thread> thread) {
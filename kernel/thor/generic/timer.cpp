@@ -10,16 +10,148 @@ static constexpr bool logProgress = false;
 ClockSource *globalClockSource;
 PrecisionTimerEngine *globalTimerEngine;
 
-PrecisionTimerEngine::PrecisionTimerEngine(ClockSource *clock, AlarmTracker *alarm)
-: _clock{clock}, _alarm{alarm} {
+// --------------------------------------------------------
+// TimerWheel
+// --------------------------------------------------------
+
+TimerWheel::TimerWheel(uint64_t now)
+: _currentTick{now >> tickShift} { }
+
+void TimerWheel::insert(PrecisionTimerNode *timer) {
+	assert(!timer->_inWheel);
+	timer->_inWheel = true;
+	_numTimers++;
+	_insert(timer, _tickOf(timer));
+}
+
+void TimerWheel::_insert(PrecisionTimerNode *timer, uint64_t tick) {
+	if(tick < _currentTick)
+		tick = _currentTick;
+
+	// Find the finest level that can hold the timer. Timers that are too far in
+	// the future are put into the last slot of the coarsest level; they are
+	// re-inserted when that slot is cascaded.
+	auto delta = tick - _currentTick;
+	int level = 0;
+	while(level < numLevels - 1 && (delta >> ((level + 1) * slotShift)))
+		level++;
+	if(delta >> (numLevels * slotShift))
+		tick = _currentTick + (uint64_t{1} << (numLevels * slotShift)) - 1;
+
+	auto slot = (tick >> (level * slotShift)) & (numSlots - 1);
+	_slots[level][slot].push_back(timer);
+	_pending[level] |= uint64_t{1} << slot;
+	timer->_wheelLevel = level;
+	timer->_wheelSlot = slot;
+}
+
+void TimerWheel::remove(PrecisionTimerNode *timer) {
+	assert(timer->_inWheel);
+	timer->_inWheel = false;
+	_numTimers--;
+
+	auto &list = _slots[timer->_wheelLevel][timer->_wheelSlot];
+	list.erase(list.iterator_to(timer));
+	if(list.empty())
+		_pending[timer->_wheelLevel] &= ~(uint64_t{1} << timer->_wheelSlot);
+}
+
+uint64_t TimerWheel::nextDeadline() {
+	if(!_numTimers)
+		return 0;
+
+	// For level 0, this is the tick of the next pending slot. For higher levels,
+	// this is the tick at which the next pending slot is cascaded.
+	uint64_t next = ~uint64_t{0};
+	for(int level = 0; level < numLevels; level++) {
+		if(!_pending[level])
+			continue;
+		auto shift = level * slotShift;
+		auto current = (_currentTick >> shift) & (numSlots - 1);
+		// Rotate the bitmap such that bit 0 corresponds to the current slot.
+		auto rotated = current ? ((_pending[level] >> current)
+					| (_pending[level] << (numSlots - current)))
+				: _pending[level];
+		// Unless we are at the start of its range, the current slot of a higher level
+		// was already cascaded; its timers belong to the next rotation.
+		if(level && (_currentTick & ((uint64_t{1} << shift) - 1)))
+			rotated &= ~uint64_t{1};
+		uint64_t distance = rotated ? __builtin_ctzll(rotated) : numSlots;
+		auto tick = ((_currentTick >> shift) + distance) << shift;
+		if(tick < next)
+			next = tick;
+	}
+	return next << tickShift;
+}
+
+void TimerWheel::advance(uint64_t now, TimerList &elapsed) {
+	auto targetTick = now >> tickShift;
+	while(_currentTick <= targetTick && _numTimers) {
+		// Skip ticks that do not have any work.
+		auto nextTick = nextDeadline() >> tickShift;
+		if(nextTick > targetTick) {
+			_currentTick = targetTick + 1;
+			return;
+		}
+		if(nextTick > _currentTick)
+			_currentTick = nextTick;
+
+		// Cascade slots of higher levels when we enter their ranges.
+		for(int level = 1; level < numLevels; level++) {
+			auto shift = level * slotShift;
+			if(_currentTick & ((uint64_t{1} << shift) - 1))
+				break;
+			// Timers never return to the slot that is being cascaded.
+			auto slot = (_currentTick >> shift) & (numSlots - 1);
+			auto &list = _slots[level][slot];
+			_pending[level] &= ~(uint64_t{1} << slot);
+			while(!list.empty()) {
+				auto timer = list.pop_front();
+				_insert(timer, _tickOf(timer));
+			}
+		}
+
+		auto slot = _currentTick & (numSlots - 1);
+		auto &list = _slots[0][slot];
+		_pending[0] &= ~(uint64_t{1} << slot);
+		while(!list.empty()) {
+			auto timer = list.pop_front();
+			assert(_tickOf(timer) <= _currentTick);
+			timer->_inWheel = false;
+			_numTimers--;
+			elapsed.push_back(timer);
+		}
+		_currentTick++;
+	}
+	if(_currentTick <= targetTick)
+		_currentTick = targetTick + 1;
+}
+
+// --------------------------------------------------------
+// PrecisionTimerEngine
+// --------------------------------------------------------
+
+PrecisionTimerEngine::PrecisionTimerEngine(ClockSource *clock, AlarmTracker *alarm, CpuData *cpu)
+: _clock{clock}, _alarm{alarm}, _cpu{cpu}, _timerWheel{clock->currentNanos()} {
 	_alarm->setSink(this);
 }
 
 void PrecisionTimerEngine::installTimer(PrecisionTimerNode *timer) {
+	auto irq_lock = frg::guard(&irqMutex());
+
+	// Per-CPU engines can only program the alarm of their own CPU.
+	auto self = this;
+	if(_cpu && _cpu != getCpuData()) {
+		self = getCpuData()->localTimerEngine;
+		assert(self);
+	}
+	self->_installTimer(timer);
+}
+
+void PrecisionTimerEngine::_installTimer(PrecisionTimerNode *timer) {
 	assert(!timer->_engine);
 	timer->_engine = this;
 
-	auto irq_lock = frg::guard(&irqMutex());
 	auto lock = frg::guard(&_mutex);
 	assert(timer->_state == TimerState::none);
 
@@ -38,7 +170,12 @@ void PrecisionTimerEngine::installTimer(PrecisionTimerNode *timer) {
 		return;
 	}
 
-	_timerQueue.push(timer);
+	// Timers that tolerate a full tick of slack go to the wheel.
+	if(timer->_slack >= TimerWheel::tickNanos) {
+		_timerWheel.insert(timer);
+	}else{
+		_timerQueue.push(timer);
+	}
 	_activeTimers++;
 	timer->_state = TimerState::queued;
 
@@ -50,7 +187,11 @@ void PrecisionTimerEngine::cancelTimer(PrecisionTimerNode *timer) {
 	auto lock = frg::guard(&_mutex);
 
 	if(timer->_state == TimerState::queued) {
-		_timerQueue.remove(timer);
+		if(timer->_inWheel) {
+			_timerWheel.remove(timer);
+		}else{
+			_timerQueue.remove(timer);
+		}
 		_activeTimers--;
 		timer->_wasCancelled = true;
 	}else{
@@ -68,43 +209,58 @@ void PrecisionTimerEngine::firedAlarm() {
 	_progress();
 }
 
+void PrecisionTimerEngine::_elapse(PrecisionTimerNode *timer) {
+	assert(timer->_state == TimerState::queued);
+	_activeTimers--;
+	if(logProgress)
+		infoLogger() << "thor: Timer completed" << frg::endlog;
+	if(timer->_cancelCb.try_reset()) {
+		timer->_state = TimerState::retired;
+		WorkQueue::post(timer->_elapsed);
+	}else{
+		// Let the cancellation handler invoke the continuation.
+		timer->_state = TimerState::elapsed;
+	}
+}
+
 // This function is somewhat complicated because we have to avoid a race between
 // the comparator setup and the main counter.
 void PrecisionTimerEngine::_progress() {
 	auto current = _clock->currentNanos();
-	do {
+	while(true) {
 		// Process all timers that elapsed in the past.
 		if(logProgress)
 			infoLogger() << "thor: Processing timers until " << current << frg::endlog;
-		while(true) {
-			if(_timerQueue.empty()) {
-				_alarm->arm(0);
-				return;
-			}
 
-			if(_timerQueue.top()->_deadline > current)
-				break;
+		TimerWheel::TimerList elapsed;
+		_timerWheel.advance(current, elapsed);
+		while(!elapsed.empty())
+			_elapse(elapsed.pop_front());
 
+		// The heap is ordered by hard deadlines (i.e., deadline + slack) and the alarm is
+		// programmed for the earliest one. Expire timers as long as their soft deadlines
+		// have passed; this coalesces timers whose slack windows overlap.
+		while(!_timerQueue.empty() && _timerQueue.top()->_deadline <= current) {
 			auto timer = _timerQueue.top();
-			assert(timer->_state == TimerState::queued);
 			_timerQueue.pop();
-			_activeTimers--;
-			if(logProgress)
-				infoLogger() << "thor: Timer completed" << frg::endlog;
-			if(timer->_cancelCb.try_reset()) {
-				timer->_state = TimerState::retired;
-				WorkQueue::post(timer->_elapsed);
-			}else{
-				// Let the cancellation handler invoke the continuation.
-				timer->_state = TimerState::elapsed;
-			}
+			_elapse(timer);
+		}
+
+		uint64_t deadline = _timerWheel.nextDeadline();
+		if(!_timerQueue.empty()) {
+			auto hard = _timerQueue.top()->_hardDeadline();
+			if(!deadline || hard < deadline)
+				deadline = hard;
 		}
 
 		// Setup the comparator and iterate if there was a race.
-		assert(!_timerQueue.empty());
-		_alarm->arm(_timerQueue.top()->_deadline);
+		_alarm->arm(deadline);
+		if(!deadline)
+			return;
 		current = _clock->currentNanos();
-	} while(_timerQueue.top()->_deadline <= current);
+		if(deadline > current)
+			return;
+	}
 }
 
 ClockSource *systemClockSource() {
@@ -112,6 +268,8 @@ ClockSource *systemClockSource() {
 }
 
 PrecisionTimerEngine *generalTimerEngine() {
+	if(auto engine = getCpuData()->localTimerEngine; engine)
+		return engine;
 	return globalTimerEngine;
 }
 
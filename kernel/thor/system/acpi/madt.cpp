@@ -400,9 +400,11 @@ static initgraph::Task enterAcpiModeTask{&globalInitEngine, "acpi.enter-acpi-mod
 };
 
 static initgraph::Task bootApsTask{&globalInitEngine, "acpi.boot-aps",
-	initgraph::Requires{&enterAcpiModeTask},
+	initgraph::Requires{&enterAcpiModeTask,
+		getNumaDiscoveredStage()},
 	[] {
 		bootOtherProcessors();
+		assignCpuNumaNodes();
 	}
 };
 
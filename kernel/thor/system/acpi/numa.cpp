@@ -0,0 +1,204 @@
+#include <thor-internal/cpu-data.hpp>
+#include <thor-internal/debug.hpp>
+#include <thor-internal/main.hpp>
+#include <thor-internal/physical.hpp>
+#include <thor-internal/acpi/acpi.hpp>
+
+#include <lai/core.h>
+
+namespace thor {
+namespace acpi {
+
+// Note: like the MADT, the SRAT and SLIT are not necessarily aligned.
+
+struct [[gnu::packed]] SratHeader {
+	uint32_t reserved1;
+	uint64_t reserved2;
+};
+
+struct [[gnu::packed]] SratGenericEntry {
+	uint8_t type;
+	uint8_t length;
+};
+
+struct [[gnu::packed]] SratLocalApicEntry {
+	SratGenericEntry generic;
+	uint8_t proximityLow;
+	uint8_t localApicId;
+	uint32_t flags;
+	uint8_t localSapicEid;
+	uint8_t proximityHigh[3];
+	uint32_t clockDomain;
+};
+
+struct [[gnu::packed]] SratMemoryEntry {
+	SratGenericEntry generic;
+	uint32_t proximity;
+	uint16_t reserved1;
+	uint64_t base;
+	uint64_t length;
+	uint32_t reserved2;
+	uint32_t flags;
+	uint64_t reserved3;
+};
+
+struct [[gnu::packed]] SratLocalX2ApicEntry {
+	SratGenericEntry generic;
+	uint16_t reserved1;
+	uint32_t proximity;
+	uint32_t x2ApicId;
+	uint32_t flags;
+	uint32_t clockDomain;
+	uint32_t reserved2;
+};
+
+namespace srat_flags {
+	static constexpr uint32_t enabled = 1;
+};
+
+struct [[gnu::packed]] SlitHeader {
+	uint64_t numLocalities;
+};
+
+namespace {
+	// Maps ACPI proximity domains to (dense) NUMA node numbers.
+	uint32_t proximityOfNode[maxNumaNodes];
+	int numNodes = 0;
+
+	// Maps APIC IDs to NUMA nodes.
+	struct ApicAffinity {
+		uint32_t apicId;
+		int node;
+	};
+	constexpr int maxApicAffinities = 256;
+	ApicAffinity apicAffinities[maxApicAffinities];
+	int numApicAffinities = 0;
+
+	int nodeOfProximity(uint32_t proximity, bool create) {
+		for(int i = 0; i < numNodes; i++) {
+			if(proximityOfNode[i] == proximity)
+				return i;
+		}
+		if(!create)
+			return -1;
+		if(numNodes == maxNumaNodes) {
+			infoLogger() << "thor: Too many NUMA nodes, proximity domain " << proximity
+					<< " is treated as node 0" << frg::endlog;
+			return 0;
+		}
+		proximityOfNode[numNodes] = proximity;
+		return numNodes++;
+	}
+
+	void addApicAffinity(uint32_t apicId, uint32_t proximity) {
+		if(numApicAffinities == maxApicAffinities) {
+			infoLogger() << "thor: Ignoring SRAT affinity of APIC " << apicId << frg::endlog;
+			return;
+		}
+		auto node = nodeOfProximity(proximity, true);
+		apicAffinities[numApicAffinities++] = {apicId, node};
+	}
+
+	void parseSrat() {
+		void *sratWindow = laihost_scan("SRAT", 0);
+		if(!sratWindow)
+			return;
+		auto srat = reinterpret_cast<acpi_header_t *>(sratWindow);
+
+		infoLogger() << "thor: Parsing SRAT" << frg::endlog;
+
+		size_t offset = sizeof(acpi_header_t) + sizeof(SratHeader);
+		while(offset < srat->length) {
+			auto generic = (SratGenericEntry *)((uint8_t *)srat + offset);
+			if(!generic->length)
+				break;
+			if(generic->type == 0) { // Local APIC affinity.
+				auto entry = (SratLocalApicEntry *)generic;
+				if(entry->flags & srat_flags::enabled) {
+					uint32_t proximity = entry->proximityLow
+							| (uint32_t(entry->proximityHigh[0]) << 8)
+							| (uint32_t(entry->proximityHigh[1]) << 16)
+							| (uint32_t(entry->proximityHigh[2]) << 24);
+					addApicAffinity(entry->localApicId, proximity);
+				}
+			}else if(generic->type == 1) { // Memory affinity.
+				auto entry = (SratMemoryEntry *)generic;
+				if((entry->flags & srat_flags::enabled) && entry->length) {
+					auto node = nodeOfProximity(entry->proximity, true);
+					infoLogger() << "    Memory 0x" << frg::hex_fmt(entry->base)
+							<< " (0x" << frg::hex_fmt(entry->length) << " bytes)"
+							<< " is on node " << node << frg::endlog;
+					physicalAllocator->setNumaNode(entry->base, entry->length, node);
+				}
+			}else if(generic->type == 2) { // Local x2APIC affinity.
+				auto entry = (SratLocalX2ApicEntry *)generic;
+				if(entry->flags & srat_flags::enabled)
+					addApicAffinity(entry->x2ApicId, entry->proximity);
+			}
+			offset += generic->length;
+		}
+	}
+
+	void parseSlit() {
+		void *slitWindow = laihost_scan("SLIT", 0);
+		if(!slitWindow)
+			return;
+		auto slit = reinterpret_cast<acpi_header_t *>(slitWindow);
+		auto header = (SlitHeader *)((uint8_t *)slit + sizeof(acpi_header_t));
+		auto matrix = (uint8_t *)header + sizeof(SlitHeader);
+		auto n = header->numLocalities;
+
+		if(sizeof(acpi_header_t) + sizeof(SlitHeader) + n * n > slit->length) {
+			infoLogger() << "thor: Ignoring truncated SLIT" << frg::endlog;
+			return;
+		}
+
+		// SLIT localities are proximity domains.
+		for(uint64_t i = 0; i < n; i++) {
+			auto from = nodeOfProximity(i, false);
+			if(from < 0)
+				continue;
+			for(uint64_t j = 0; j < n; j++) {
+				auto to = nodeOfProximity(j, false);
+				if(to < 0)
+					continue;
+				physicalAllocator->setNumaDistance(from, to, matrix[i * n + j]);
+			}
+		}
+	}
+}
+
+initgraph::Stage *getNumaDiscoveredStage() {
+	static initgraph::Stage s{&globalInitEngine, "acpi.numa-discovered"};
+	return &s;
+}
+
+static initgraph::Task discoverNumaTask{&globalInitEngine, "acpi.discover-numa",
+	initgraph::Requires{getTablesDiscoveredStage()},
+	initgraph::Entails{getNumaDiscoveredStage()},
+	[] {
+		parseSrat();
+		if(numNodes > 1)
+			parseSlit();
+		infoLogger() << "thor: Found " << frg::max(numNodes, 1) << " NUMA node(s)"
+				<< frg::endlog;
+	}
+};
+
+void assignCpuNumaNodes() {
+#ifdef __x86_64__
+	for(int k = 0; k < getCpuCount(); k++) {
+		auto cpuData = getCpuData(k);
+		for(int i = 0; i < numApicAffinities; i++) {
+			if(apicAffinities[i].apicId != static_cast<uint32_t>(cpuData->localApicId))
+				continue;
+			cpuData->numaNode = apicAffinities[i].node;
+			infoLogger() << "thor: CPU " << k << " is on NUMA node "
+					<< cpuData->numaNode << frg::endlog;
+			break;
+		}
+	}
+#endif
+}
+
+} } // namespace thor::acpi
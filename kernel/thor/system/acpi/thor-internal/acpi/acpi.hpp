@@ -23,5 +23,9 @@ namespace acpi {
 
 initgraph::Stage *getTablesDiscoveredStage();
 initgraph::Stage *getNsAvailableStage();
+initgraph::Stage *getNumaDiscoveredStage();
+
+// Assigns NUMA nodes (from the SRAT) to all CPUs that are currently known.
+void assignCpuNumaNodes();
 
 } } // namespace thor::acpi
@@ -5,6 +5,7 @@
 #include <string.h>
 #include <sys/auxv.h>
 #include <algorithm>
+#include <deque>
 #include <iostream>
 #include <memory>
 #include <unordered_map>
@@ -13,6 +14,7 @@
 #include <variant>
 #include <vector>
 
+#include <async/recurring-event.hpp>
 #include <async/result.hpp>
 #include <helix/ipc.hpp>
 
@@ -63,15 +65,20 @@ struct Group final : Entity {
 		return _children;
 	}
 
-	void linkObserver(std::shared_ptr<Observer> observer) {
-		_observers.insert(std::move(observer));
-	}
+	void linkObserver(std::shared_ptr<Observer> observer);
 
 	void processAttach(std::shared_ptr<Entity> entity);
 
 private:
 	std::unordered_set<std::shared_ptr<Entity>> _children;
-	std::unordered_set<std::shared_ptr<Observer>> _observers;
+
+	// Observers are indexed by one property/value pair that their filter requires.
+	// Maps property -> value -> observers.
+	std::unordered_map<std::string,
+			std::unordered_map<std::string, std::vector<std::shared_ptr<Observer>>>>
+			_indexedObservers;
+	// Observers whose filter does not require a fixed property value.
+	std::vector<std::shared_ptr<Observer>> _unindexedObservers;
 };
 
 struct Object final : Entity {
@@ -152,15 +159,29 @@ struct Observer {
 	explicit Observer(AnyFilter filter, helix::UniqueLane lane)
 	: _filter(std::move(filter)), _lane(std::move(lane)) { }
 
-	async::detached traverse(std::shared_ptr<Entity> root);
+	const AnyFilter &getFilter() const {
+		return _filter;
+	}
+
+	// Sends queued attach notifications to the client.
+	async::detached run();
+
+	void traverse(std::shared_ptr<Entity> root);
 
-	async::detached onAttach(std::shared_ptr<Entity> entity);
+	void onAttach(std::shared_ptr<Entity> entity);
 
 private:
 	AnyFilter _filter;
 	helix::UniqueLane _lane;
+
+	// Entities that we still need to notify the client about.
+	std::deque<std::shared_ptr<Entity>> _queue;
+	async::recurring_event _queueEvent;
 };
 
+// Upper bound on the size of ATTACH_BATCH messages; clients receive into 16 KiB buffers.
+constexpr size_t maxBatchSize = 8192;
+
 static bool matchesFilter(const Entity *entity, const AnyFilter &filter) {
 	if(auto real = std::get_if<EqualsFilter>(&filter); real) {
 		auto &properties = entity->getProperties();
@@ -178,12 +199,88 @@ static bool matchesFilter(const Entity *entity, const AnyFilter &filter) {
 	}
 }
 	
+// Returns an EqualsFilter that every entity matching the filter must satisfy, if any.
+static const EqualsFilter *findIndexKey(const AnyFilter &filter) {
+	if(auto real = std::get_if<EqualsFilter>(&filter); real) {
+		return real;
+	}else if(auto real = std::get_if<Conjunction>(&filter); real) {
+		for(auto &operand : real->getOperands()) {
+			if(auto key = findIndexKey(operand); key)
+				return key;
+		}
+		return nullptr;
+	}else{
+		throw std::runtime_error("Unexpected filter");
+	}
+}
+
+void Group::linkObserver(std::shared_ptr<Observer> observer) {
+	if(auto key = findIndexKey(observer->getFilter()); key) {
+		_indexedObservers[key->getProperty()][key->getValue()].push_back(std::move(observer));
+	}else{
+		_unindexedObservers.push_back(std::move(observer));
+	}
+}
+
 void Group::processAttach(std::shared_ptr<Entity> entity) {
-	for(auto &observer_ptr : _observers)
+	// Only consider observers whose index key matches one of the entity's properties.
+	for(auto &[name, value] : entity->getProperties()) {
+		auto property_it = _indexedObservers.find(name);
+		if(property_it == _indexedObservers.end())
+			continue;
+		auto value_it = property_it->second.find(value);
+		if(value_it == property_it->second.end())
+			continue;
+		for(auto &observer_ptr : value_it->second)
+			observer_ptr->onAttach(entity);
+	}
+
+	for(auto &observer_ptr : _unindexedObservers)
 		observer_ptr->onAttach(entity);
 }
 
-async::detached Observer::traverse(std::shared_ptr<Entity> root) {
+static void encodeEntity(const Entity *entity, managarm::mbus::EntityInfo *msg) {
+	msg->set_id(entity->getId());
+	for(auto kv : entity->getProperties()) {
+		auto entry = msg->add_properties();
+		entry->set_name(kv.first);
+		entry->mutable_item()->mutable_string_item()->set_value(kv.second);
+	}
+}
+
+async::detached Observer::run() {
+	while(true) {
+		while(_queue.empty())
+			co_await _queueEvent.async_wait();
+
+		// Send as many queued entities as fit into a single message.
+		managarm::mbus::SvrRequest req;
+		req.set_req_type(managarm::mbus::SvrReqType::ATTACH_BATCH);
+		size_t size = 0;
+		while(!_queue.empty()) {
+			managarm::mbus::EntityInfo info;
+			encodeEntity(_queue.front().get(), &info);
+
+			// Account for the field tag and length prefix.
+			auto info_size = info.ByteSizeLong() + 4;
+			if(req.entities_size() && size + info_size > maxBatchSize)
+				break;
+			*req.add_entities() = std::move(info);
+			size += info_size;
+			_queue.pop_front();
+		}
+
+		helix::SendBuffer send_req;
+
+		auto ser = req.SerializeAsString();
+		auto &&transmit = helix::submitAsync(_lane, helix::Dispatcher::global(),
+				helix::action(&send_req, ser.data(), ser.size()));
+		co_await transmit.async_wait();
+		HEL_CHECK(send_req.error());
+	}
+}
+
+void Observer::traverse(std::shared_ptr<Entity> root) {
 	std::queue<std::shared_ptr<Entity>> entities;
 	entities.push(root);
 	while(!entities.empty()) {
@@ -197,46 +294,20 @@ async::detached Observer::traverse(std::shared_ptr<Entity> root) {
 
 		if(!matchesFilter(entity.get(), _filter)) 
 			continue;
-		
-		helix::SendBuffer send_req;
 
-		managarm::mbus::SvrRequest req;
-		req.set_req_type(managarm::mbus::SvrReqType::ATTACH);
-		req.set_id(entity->getId());
-		for(auto kv : entity->getProperties()) {
-			auto entry = req.add_properties();
-			entry->set_name(kv.first);
-			entry->mutable_item()->mutable_string_item()->set_value(kv.second);
-		}
-
-		auto ser = req.SerializeAsString();
-		auto &&transmit = helix::submitAsync(_lane, helix::Dispatcher::global(),
-				helix::action(&send_req, ser.data(), ser.size()));
-		co_await transmit.async_wait();
-		HEL_CHECK(send_req.error());
+		_queue.push_back(std::move(entity));
 	}
+
+	if(!_queue.empty())
+		_queueEvent.raise();
 }
 
-async::detached Observer::onAttach(std::shared_ptr<Entity> entity) {
+void Observer::onAttach(std::shared_ptr<Entity> entity) {
 	if(!matchesFilter(entity.get(), _filter)) 
-		co_return;
-	
-	helix::SendBuffer send_req;
+		return;
 
-	managarm::mbus::SvrRequest req;
-	req.set_req_type(managarm::mbus::SvrReqType::ATTACH);
-	req.set_id(entity->getId());
-	for(auto kv : entity->getProperties()) {
-		auto entry = req.add_properties();
-		entry->set_name(kv.first);
-		entry->mutable_item()->mutable_string_item()->set_value(kv.second);
-	}
-
-	auto ser = req.SerializeAsString();
-	auto &&transmit = helix::submitAsync(_lane, helix::Dispatcher::global(),
-			helix::action(&send_req, ser.data(), ser.size()));
-	co_await transmit.async_wait();
-	HEL_CHECK(send_req.error());
+	_queue.push_back(std::move(entity));
+	_queueEvent.raise();
 }
 
 std::unordered_map<int64_t, std::shared_ptr<Entity>> allEntities;
@@ -402,6 +473,7 @@ async::detached serve(helix::UniqueLane lane) {
 			group->linkObserver(observer);
 
 			observer->traverse(parent);
+			observer->run();
 
 			managarm::mbus::SvrResponse resp;
 			resp.set_error(managarm::mbus::Error::SUCCESS);
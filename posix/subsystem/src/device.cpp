@@ -160,32 +160,32 @@ private:
 
 		auto page = reinterpret_cast<protocols::fs::StatusPage *>(_statusMapping.get());
 
-		// Start the seqlock read.
-		auto seqlock = __atomic_load_n(&page->seqlock, __ATOMIC_ACQUIRE);
-		if(seqlock & 1) {
+		uint64_t sequence;
+		int status;
+		if(!protocols::fs::readStatusPage(page, sequence, status)) {
 			if(logStatusSeqlock)
 				std::cout << "posix: Status page update in progess;"
 						" falling back to IPC request." << std::endl;
 			co_return co_await pollOverIpc();
 		}
 
-		// Perform the actual loads.
-		auto sequence = __atomic_load_n(&page->sequence, __ATOMIC_RELAXED);
-		auto status = __atomic_load_n(&page->status, __ATOMIC_RELAXED);
-
-		// Finish the seqlock read.
-		__atomic_thread_fence(__ATOMIC_ACQUIRE);
-		if(__atomic_load_n(&page->seqlock, __ATOMIC_RELAXED) != seqlock) {
-			if(logStatusSeqlock)
-				std::cout << "posix: Stale data from status page;"
-						" falling back to IPC request." << std::endl;
-			co_return co_await pollOverIpc();
-		}
-
 		// TODO: Return a full edge mask or edges since sequence zero.
 		co_return PollStatusResult{sequence, status};
 	}
 
+	protocols::fs::StatusPage *statusPage() override {
+		if(!_statusMapping)
+			return nullptr;
+		auto page = reinterpret_cast<protocols::fs::StatusPage *>(_statusMapping.get());
+		if(!__atomic_load_n(&page->watchId, __ATOMIC_RELAXED))
+			return nullptr;
+		return page;
+	}
+
+	StatusDomain *statusDomain() override {
+		return _statusDomain.get();
+	}
+
 	FutureMaybe<helix::UniqueDescriptor> accessMemory() override {
 		auto memory = co_await _file.accessMemory();
 		co_return std::move(memory);
@@ -198,10 +198,11 @@ private:
 public:
 	DeviceFile(helix::UniqueLane control, helix::UniqueLane lane,
 			std::shared_ptr<MountView> mount, std::shared_ptr<FsLink> link,
-			helix::Mapping status_mapping)
+			helix::Mapping status_mapping, std::shared_ptr<StatusDomain> status_domain)
 	: File{StructName::get("devicefile"), std::move(mount), std::move(link)},
 			_control{std::move(control)}, _file{std::move(lane)},
-			_statusMapping{std::move(status_mapping)} { }
+			_statusMapping{std::move(status_mapping)},
+			_statusDomain{std::move(status_domain)} { }
 
 	~DeviceFile() {
 		// It's not necessary to do any cleanup here.
@@ -216,6 +217,7 @@ private:
 	helix::UniqueLane _control;
 	protocols::fs::File _file;
 	helix::Mapping _statusMapping;
+	std::shared_ptr<StatusDomain> _statusDomain;
 };
 
 } // anonymous namespace
@@ -225,7 +227,7 @@ private:
 // --------------------------------------------------------
 
 async::result<frg::expected<Error, smarter::shared_ptr<File, FileHandle>>>
-openExternalDevice(helix::BorrowedLane lane,
+openExternalDevice(helix::BorrowedLane lane, std::shared_ptr<StatusDomain> status_domain,
 		std::shared_ptr<MountView> mount, std::shared_ptr<FsLink> link,
 		SemanticFlags semantic_flags) {
 	if(semantic_flags & ~(semanticNonBlock | semanticRead | semanticWrite)){
@@ -268,7 +270,8 @@ openExternalDevice(helix::BorrowedLane lane,
 	}
 
 	auto file = smarter::make_shared<DeviceFile>(helix::UniqueLane{},
-			pull_pt.descriptor(), std::move(mount), std::move(link), std::move(status_mapping));
+			pull_pt.descriptor(), std::move(mount), std::move(link), std::move(status_mapping),
+			std::move(status_domain));
 	file->setupWeakFile(file);
 	co_return File::constructHandle(std::move(file));
 }
@@ -88,8 +88,9 @@ async::result<void> createDeviceNode(std::string path, VfsType type, DeviceId id
 // External device helpers.
 // --------------------------------------------------------
 
+// Files that are opened with the same status_domain must be served by the same server.
 async::result<frg::expected<Error, smarter::shared_ptr<File, FileHandle>>>
-openExternalDevice(helix::BorrowedLane lane,
+openExternalDevice(helix::BorrowedLane lane, std::shared_ptr<StatusDomain> status_domain,
 		std::shared_ptr<MountView> mount, std::shared_ptr<FsLink> link,
 		SemanticFlags semantic_flags);
 
@@ -1,11 +1,15 @@
 
 #include <string.h>
 #include <iostream>
+#include <memory>
+#include <unordered_map>
 
 #include <async/recurring-event.hpp>
 #include <boost/intrusive/list.hpp>
 #include <frg/manual_box.hpp>
 #include <helix/ipc.hpp>
+#include <protocols/fs/client.hpp>
+#include <protocols/fs/defs.hpp>
 #include "common.hpp"
 #include "epoll.hpp"
 
@@ -13,6 +17,123 @@ namespace {
 
 bool logEpoll = false;
 
+} // anonymous namespace
+
+// A file that waits for status changes on a StatusWatcher.
+struct StatusWatch {
+	// Called once the status of the file changed; the watch is detached at this point.
+	virtual void statusChanged() = 0;
+	// Called if the server closed the file; the watch is detached at this point.
+	virtual void statusClosed() = 0;
+
+	virtual smarter::shared_ptr<File> watchedFile() = 0;
+
+	uint64_t watchId = 0;
+
+protected:
+	~StatusWatch() = default;
+};
+
+// Waits for status changes of all files of a StatusDomain. Instead of one pollWait() per file,
+// there is at most one outstanding FILE_POLL_STATUS_BATCH request per domain.
+struct StatusWatcher : std::enable_shared_from_this<StatusWatcher> {
+	static StatusWatcher *get(StatusDomain *domain) {
+		assert(domain);
+		if(!domain->watcher)
+			domain->watcher = std::make_shared<StatusWatcher>();
+		return domain->watcher.get();
+	}
+
+	void attach(StatusWatch *watch, uint64_t watchId) {
+		watch->watchId = watchId;
+		_watches.insert({watchId, watch});
+		if(!_running) {
+			_running = true;
+			_run(shared_from_this());
+		}
+	}
+
+	void detach(StatusWatch *watch) {
+		auto [begin, end] = _watches.equal_range(watch->watchId);
+		for(auto it = begin; it != end; ++it) {
+			if(it->second == watch) {
+				_watches.erase(it);
+				// Do not keep the file alive until the next status change.
+				if(watch == _laneWatch) {
+					_laneWatch = nullptr;
+					_cancelBatch.cancel();
+				}
+				return;
+			}
+		}
+		assert(!"StatusWatch is not attached");
+	}
+
+private:
+	async::detached _run(std::shared_ptr<StatusWatcher> self) {
+		// Note that the request stays valid for watches that are attached while we wait:
+		// it reports all changes since _sequence.
+		while(!_watches.empty()) {
+			// The request can be sent on the lane of any file of the domain.
+			// It is cancelled once the watch of that file detaches.
+			_laneWatch = _watches.begin()->second;
+			auto file = _laneWatch->watchedFile();
+			_cancelBatch.reset();
+			auto resultOrError = co_await protocols::fs::pollStatusBatch(
+					file->getPassthroughLane(), _sequence, _cancelBatch);
+			_laneWatch = nullptr;
+
+			std::vector<StatusWatch *> fired;
+			if(!resultOrError) {
+				assert(resultOrError.error() == protocols::fs::Error::brokenPipe);
+				for(auto &[watchId, watch] : _watches) {
+					if(watch->watchedFile().get() == file.get())
+						fired.push_back(watch);
+				}
+				for(auto watch : fired)
+					detach(watch);
+				for(auto watch : fired)
+					watch->statusClosed();
+				continue;
+			}
+
+			auto &result = resultOrError.value();
+			if(logEpoll)
+				std::cout << "posix.epoll: Status batch with "
+						<< result.changedWatches.size() << " changes"
+						<< (result.overflow ? " (overflow)" : "") << std::endl;
+			_sequence = result.sequence;
+			if(result.overflow) {
+				for(auto &[watchId, watch] : _watches)
+					fired.push_back(watch);
+			}else{
+				for(auto watchId : result.changedWatches) {
+					auto [begin, end] = _watches.equal_range(watchId);
+					for(auto it = begin; it != end; ++it)
+						fired.push_back(it->second);
+				}
+			}
+
+			// Callbacks may attach the watches again.
+			for(auto watch : fired)
+				detach(watch);
+			for(auto watch : fired)
+				watch->statusChanged();
+		}
+		_running = false;
+	}
+
+	std::unordered_multimap<uint64_t, StatusWatch *> _watches;
+	uint64_t _sequence = 0;
+	bool _running = false;
+
+	// Watch whose file carries the outstanding request.
+	StatusWatch *_laneWatch = nullptr;
+	async::cancellation_event _cancelBatch;
+};
+
+namespace {
+
 struct OpenFile : File {
 	// ------------------------------------------------------------------------
 	// Internal API.
@@ -42,12 +163,24 @@ private:
 		smarter::shared_ptr<Item> item;
 	};
 
-	struct Item : boost::intrusive::list_base_hook<> {
+	struct Item final : boost::intrusive::list_base_hook<>, StatusWatch {
 		Item(smarter::shared_ptr<OpenFile> epoll, Process *process,
 				smarter::shared_ptr<File> file, int mask, uint64_t cookie)
 		: epoll{epoll}, state{stateActive}, process{process},
 				file{std::move(file)}, eventMask{mask}, cookie{cookie} { }
 
+		void statusChanged() override {
+			_statusChanged(this);
+		}
+
+		void statusClosed() override {
+			_statusClosed(this);
+		}
+
+		smarter::shared_ptr<File> watchedFile() override {
+			return file;
+		}
+
 		smarter::shared_ptr<OpenFile> epoll;
 		State state;
 
@@ -68,16 +201,101 @@ private:
 
 		std::optional<frg::expected<Error, PollWaitResult>> pollOutcome;
 
+		// Set while the item is polling via a StatusWatcher instead of pollWait().
+		// watchRef keeps the item alive while it is attached to the watcher.
+		StatusWatcher *watcher = nullptr;
+		smarter::shared_ptr<Item> watchRef;
+
 		smarter::borrowed_ptr<Item> self;
 	};
 
+	static void _makePending(Item *item) {
+		auto self = item->epoll.get();
+
+		if(logEpoll)
+			std::cout << "posix.epoll \e[1;34m" << item->epoll->structName() << "\e[0m"
+					<< ": Item \e[1;34m" << item->file->structName()
+					<< "\e[0m becomes pending" << std::endl;
+
+		if(!(item->state & statePending)) {
+			item->state |= statePending;
+
+			item->self.lock().ctr()->increment();
+			self->_pendingQueue.push_back(*item);
+			self->_currentSeq++;
+			self->_statusBell.raise();
+		}
+	}
+
+	// Starts watching the status page of the item's file.
+	// sequence is the last sequence number that the caller observed.
+	static void _watchStatus(Item *item, uint64_t sequence) {
+		auto page = item->file->statusPage();
+		assert(page);
+		assert(!(item->state & statePolling));
+		assert(!item->watcher);
+
+		item->state |= statePolling;
+		item->watcher = StatusWatcher::get(item->file->statusDomain());
+		item->watchRef = item->self.lock();
+		item->watcher->attach(item, __atomic_load_n(&page->watchId, __ATOMIC_RELAXED));
+
+		// The watcher only reports changes that happen after its last batch.
+		// Catch changes that happened before we attached.
+		if(__atomic_load_n(&page->sequence, __ATOMIC_ACQUIRE) != sequence) {
+			item->watcher->detach(item);
+			_statusChanged(item);
+		}
+	}
+
+	static void _statusChanged(Item *item) {
+		auto ref = std::move(item->watchRef);
+		item->watcher = nullptr;
+
+		assert(item->state & statePolling);
+		item->state &= ~statePolling;
+		if(!(item->state & stateActive))
+			return;
+
+		// If the page is updated concurrently, waitForEvents() re-checks the item via pollStatus().
+		uint64_t sequence;
+		int status;
+		if(!protocols::fs::readStatusPage(item->file->statusPage(), sequence, status)
+				|| (status & (item->eventMask | EPOLLERR | EPOLLHUP))) {
+			// As for pollWait(), we stop watching once an item becomes pending.
+			_makePending(item);
+		}else{
+			_watchStatus(item, sequence);
+		}
+	}
+
+	static void _statusClosed(Item *item) {
+		auto ref = std::move(item->watchRef);
+		item->watcher = nullptr;
+
+		assert(item->state & statePolling);
+		item->state &= ~statePolling;
+	}
+
+	// Stops an ongoing pollWait() or detaches the item from its StatusWatcher.
+	// The caller needs to hold a reference to the item.
+	static void _cancelPolling(Item *item) {
+		if(item->watcher) {
+			item->watcher->detach(item);
+			item->watcher = nullptr;
+			item->state &= ~statePolling;
+			item->watchRef = nullptr;
+		}else{
+			item->cancelPoll.cancel();
+		}
+	}
+
 	static void _awaitPoll(Item *item) {
 	reRunImmediately:
 		// First, destruct the operation so that we can re-use it later.
 		item->pollOperation.destruct();
 
 		assert(item->state & statePolling);
-		auto self = item->epoll.get();
 
 		// Discard non-active and closed items.
 		if(!(item->state & stateActive)) {
@@ -100,22 +318,10 @@ private:
 		// Level-triggered items stay pending until the event disappears.
 		auto result = resultOrError.value();
 		if(std::get<1>(result) & (item->eventMask | EPOLLERR | EPOLLHUP)) {
-			if(logEpoll)
-				std::cout << "posix.epoll \e[1;34m" << item->epoll->structName() << "\e[0m"
-						<< ": Item \e[1;34m" << item->file->structName()
-						<< "\e[0m becomes pending" << std::endl;
-
 			// Note that we stop watching once an item becomes pending.
 			// We do this as we have to pollStatus() again anyway before we report the item.
 			item->state &= ~statePolling;
-			if(!(item->state & statePending)) {
-				item->state |= statePending;
-
-				item->self.lock().ctr()->increment();
-				self->_pendingQueue.push_back(*item);
-				self->_currentSeq++;
-				self->_statusBell.raise();
-			}
+			_makePending(item);
 		}else{
 			// Here, we assume that the lambda does not execute on the current stack.
 			// TODO: Use some callback queueing mechanism to ensure this.
@@ -183,7 +389,7 @@ public:
 
 		item->eventMask = mask;
 		item->cookie = cookie;
-		item->cancelPoll.cancel();
+		_cancelPolling(item.get());
 
 		// Mark the item as pending.
 		if(!(item->state & statePending)) {
@@ -208,7 +414,7 @@ public:
 		auto item = it->second;
 		assert(item->state & stateActive);
 
-		item->cancelPoll.cancel();
+		_cancelPolling(item.get());
 
 		_fileMap.erase(it);
 		item->state &= ~stateActive;
@@ -275,7 +481,10 @@ public:
 				auto status = std::get<1>(result) & (item->eventMask | EPOLLERR | EPOLLHUP);
 				if(!status) {
 					item->state &= ~statePending;
-					if(!(item->state & statePolling)) {
+					if(!(item->state & statePolling) && item->file->statusPage()) {
+						// Files with status pages are watched without any per-file IPC.
+						_watchStatus(item.get(), std::get<0>(result));
+					}else if(!(item->state & statePolling)) {
 						item->state |= statePolling;
 
 						// Once an item is not pending anymore, we continue watching it.
@@ -346,7 +555,7 @@ public:
 			item->state &= ~stateActive;
 
 			if(item->state & statePolling)
-				item->cancelPoll.cancel();
+				_cancelPolling(item.get());
 
 			if(item->state & statePending) {
 				auto qit = _pendingQueue.iterator_to(*item);
@@ -176,6 +176,18 @@ private:
 		co_return length;
 	}
 
+	async::result<frg::expected<Error, size_t>>
+	pread(Process *, int64_t offset, void *data, size_t max_length) override {
+		auto result = co_await _file.pread(offset, data, max_length);
+		if(!result) {
+			if(result.error() == protocols::fs::Error::illegalArguments)
+				co_return Error::illegalArguments;
+			assert(result.error() == protocols::fs::Error::illegalOperationTarget);
+			co_return Error::seekOnPipe;
+		}
+		co_return result.value();
+	}
+
 	async::result<frg::expected<Error, PollWaitResult>>
 	pollWait(Process *, uint64_t sequence, int mask,
 			async::cancellation_token cancellation) override {
@@ -448,6 +460,11 @@ private:
 		return true;
 	}
 
+	// All changes to the directory go through this class, hence it can invalidate the cache.
+	bool supportsDentryCache() override {
+		return true;
+	}
+
 	async::result<frg::expected<Error, std::pair<std::shared_ptr<FsLink>, size_t>>>
 	traverseLinks(std::deque<std::string> path) override {
 		managarm::fs::CntRequest req;
@@ -530,6 +547,7 @@ private:
 				helix_ng::pullDescriptor()
 			)
 		);
+		dentryCache().invalidate(this, name);
 		HEL_CHECK(offer.error());
 		HEL_CHECK(sendReq.error());
 		HEL_CHECK(recvResp.error());
@@ -565,6 +583,7 @@ private:
 				helix_ng::pullDescriptor()
 			)
 		);
+		dentryCache().invalidate(this, name);
 		HEL_CHECK(offer.error());
 		HEL_CHECK(sendReq.error());
 		HEL_CHECK(sendName.error());
@@ -655,6 +674,7 @@ private:
 				helix::action(&recv_resp, kHelItemChain),
 				helix::action(&pull_node));
 		co_await transmit.async_wait();
+		dentryCache().invalidate(this, name);
 		HEL_CHECK(offer.error());
 		HEL_CHECK(send_req.error());
 		HEL_CHECK(recv_resp.error());
@@ -693,6 +713,7 @@ private:
 				helix::action(&send_req, ser.data(), ser.size(), kHelItemChain),
 				helix::action(&recv_resp));
 		co_await transmit.async_wait();
+		dentryCache().invalidate(this, name);
 		HEL_CHECK(offer.error());
 		HEL_CHECK(send_req.error());
 		HEL_CHECK(recv_resp.error());
@@ -718,6 +739,7 @@ private:
 				helix_ng::recvInline()
 			)
 		);
+		dentryCache().invalidate(this, name);
 		HEL_CHECK(offer.error());
 		HEL_CHECK(send_req.error());
 		HEL_CHECK(recv_resp.error());
@@ -854,6 +876,9 @@ async::result<frg::expected<Error, std::shared_ptr<FsLink>>>
 		)
 	);
 
+	dentryCache().invalidate(source_node, source->getName());
+	dentryCache().invalidate(target_node, name);
+
 	HEL_CHECK(offer.error());
 	HEL_CHECK(send_head.error());
 	HEL_CHECK(send_tail.error());
@@ -1,13 +1,19 @@
 #include "extern_socket.hpp"
 
+#include <helix/memory.hpp>
+
 #include "fs.bragi.hpp"
 #include "protocols/fs/client.hpp"
+#include "protocols/fs/defs.hpp"
 
 namespace {
+// All sockets are served by the netserver.
+std::shared_ptr<StatusDomain> netserverDomain = std::make_shared<StatusDomain>();
+
 struct Socket : File {
-	Socket(helix::UniqueLane sockLane)
+	Socket(helix::UniqueLane sockLane, helix::Mapping statusMapping)
 	: File{StructName::get("extern-socket")},
-		_file{std::move(sockLane)} { }
+		_file{std::move(sockLane)}, _statusMapping{std::move(statusMapping)} { }
 
 	async::result<frg::expected<Error, PollWaitResult>>
 	pollWait(Process *, uint64_t sequence, int mask,
@@ -19,17 +25,38 @@ struct Socket : File {
 
 	async::result<frg::expected<Error, PollStatusResult>>
 	pollStatus(Process *) override {
+		if(auto page = statusPage(); page) {
+			uint64_t sequence;
+			int status;
+			if(protocols::fs::readStatusPage(page, sequence, status))
+				co_return PollStatusResult{sequence, status};
+		}
+
 		auto resultOrError = co_await _file.pollStatus();
 		assert(resultOrError);
 		co_return resultOrError.value();
 	}
 
+	protocols::fs::StatusPage *statusPage() override {
+		if(!_statusMapping)
+			return nullptr;
+		auto page = reinterpret_cast<protocols::fs::StatusPage *>(_statusMapping.get());
+		if(!__atomic_load_n(&page->watchId, __ATOMIC_RELAXED))
+			return nullptr;
+		return page;
+	}
+
+	StatusDomain *statusDomain() override {
+		return netserverDomain.get();
+	}
+
 	helix::BorrowedDescriptor getPassthroughLane() override {
 		return _file.getLane();
 	}
 
 private:
 	protocols::fs::File _file;
+	helix::Mapping _statusMapping;
 };
 }
 
@@ -47,11 +74,12 @@ async::result<smarter::shared_ptr<File, FileHandle>> createSocket(helix::Borrowe
 	auto req_data = req.SerializeAsString();
 	char buffer[128];
 
-	auto [offer, send_req, recv_resp, recv_lane] = co_await helix_ng::exchangeMsgs(
+	auto [offer, send_req, recv_resp, recv_lane, recv_page] = co_await helix_ng::exchangeMsgs(
 		lane,
 		helix_ng::offer(
 			helix_ng::sendBuffer(req_data.data(), req_data.size()),
 			helix_ng::recvBuffer(buffer, sizeof(buffer)),
+			helix_ng::pullDescriptor(),
 			helix_ng::pullDescriptor()
 		)
 	);
@@ -64,7 +92,13 @@ async::result<smarter::shared_ptr<File, FileHandle>> createSocket(helix::Borrowe
 	resp.ParseFromArray(buffer, recv_resp.actualLength());
 	assert(resp.error() == managarm::fs::Errors::SUCCESS);
 
-	auto file = smarter::make_shared<Socket>(recv_lane.descriptor());
+	helix::Mapping statusMapping;
+	if(resp.caps() & managarm::fs::FileCaps::FC_STATUS_PAGE) {
+		assert(!recv_page.error());
+		statusMapping = helix::Mapping{recv_page.descriptor(), 0, 0x1000};
+	}
+
+	auto file = smarter::make_shared<Socket>(recv_lane.descriptor(), std::move(statusMapping));
 	file->setupWeakFile(file);
 	co_return File::constructHandle(file);
 }
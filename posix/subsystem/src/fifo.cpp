@@ -1,4 +1,4 @@
-
+#include <limits.h>
 #include <string.h>
 #include <sys/epoll.h>
 #include <iostream>
@@ -8,43 +8,80 @@
 #include <async/recurring-event.hpp>
 #include <helix/ipc.hpp>
 #include "fifo.hpp"
+#include "pipe-buffer.hpp"
+#include "process.hpp"
 
 #include <experimental/coroutine>
 
 namespace fifo {
 
-namespace {
-
-constexpr bool logFifos = false;
-
-struct Packet {
-	// The actual octet data that the packet consists of.
-	std::vector<char> buffer;
-
-	size_t offset = 0;
-};
-
 struct Channel {
 	Channel()
 	: writerCount{0}, readerCount{0} { }
 
+	// Wakes up all waiters after data was added to the pipe.
+	void produced() {
+		inSeq = ++currentSeq;
+		statusBell.raise();
+	}
+
+	// Wakes up all waiters after data was removed from the pipe (or the capacity changed).
+	void consumed() {
+		outSeq = ++currentSeq;
+		statusBell.raise();
+	}
+
 	// Status management for poll().
 	async::recurring_event statusBell;
-	// Start at currentSeq = 1 since the pipe is always writable.
+	// Start at currentSeq = 1 since the pipe is initially writable.
 	uint64_t currentSeq = 1;
 	uint64_t noWriterSeq = 0;
 	uint64_t noReaderSeq = 0;
 	uint64_t inSeq = 0;
+	uint64_t outSeq = 1;
 	int writerCount;
 	int readerCount;
 
+	// Set while splice() writes data from the front of the ring to a file.
+	// Other consumers must wait until the data is either consumed or left in the ring.
+	bool draining = false;
+
 	async::recurring_event readerPresent;
 	async::recurring_event writerPresent;
 
-	// The actual queue of this pipe.
-	std::deque<Packet> packetQueue;
+	// The actual buffer of this pipe.
+	pipe_buffer::Ring ring;
 };
 
+namespace {
+
+constexpr bool logFifos = false;
+
+// Waits until the pipe contains data. Returns false on EOF.
+async::result<frg::expected<Error, bool>> waitForData(Channel *channel, bool nonBlock) {
+	while(channel->draining || (channel->ring.empty() && channel->writerCount)) {
+		if(nonBlock) {
+			if(logFifos)
+				std::cout << "posix: FIFO pipe would block" << std::endl;
+			co_return Error::wouldBlock;
+		}
+		co_await channel->statusBell.async_wait();
+	}
+	co_return !channel->ring.empty();
+}
+
+// Waits until a page can be added to the pipe.
+async::result<frg::expected<Error>> waitForSlot(Channel *channel, bool nonBlock) {
+	while(channel->readerCount && !channel->ring.hasFreeSlot()) {
+		if(nonBlock)
+			co_return Error::wouldBlock;
+		co_await channel->statusBell.async_wait();
+	}
+	if(!channel->readerCount)
+		co_return Error::brokenPipe;
+	co_return {};
+}
+
 struct ReaderFile : File {
 public:
 	static void serve(smarter::shared_ptr<ReaderFile> file) {
@@ -80,28 +117,15 @@ public:
 		if(!maxLength)
 			co_return 0;
 
-		while(_channel->packetQueue.empty() && _channel->writerCount) {
-			if(nonBlock_) {
-				if(logFifos)
-					std::cout << "posix: FIFO pipe would block" << std::endl;
-				co_return Error::wouldBlock;
-			}
-			co_await _channel->statusBell.async_wait();
-		}
-
-		if(_channel->packetQueue.empty()) {
-			assert(!_channel->writerCount);
+		auto hasData = co_await waitForData(_channel.get(), nonBlock_);
+		if(!hasData)
+			co_return hasData.error();
+		if(!hasData.value())
 			co_return 0;
-		}
 
-		// TODO: Truncate packets (for SOCK_DGRAM) here.
-		auto packet = &_channel->packetQueue.front();
-		size_t chunk = std::min(packet->buffer.size() - packet->offset, maxLength);
+		auto chunk = _channel->ring.read(data, maxLength);
 		assert(chunk); // Otherwise we return above since !maxLength.
-		memcpy(data, packet->buffer.data() + packet->offset, chunk);
-		packet->offset += chunk;
-		if(packet->offset == packet->buffer.size())
-			_channel->packetQueue.pop_front();
+		_channel->consumed();
 		co_return chunk;
 	}
 
@@ -132,7 +156,7 @@ public:
 		int events = 0;
 		if(!_channel->writerCount)
 			events |= EPOLLHUP;
-		if(!_channel->packetQueue.empty())
+		if(!_channel->ring.empty())
 			events |= EPOLLIN;
 
 		co_return PollStatusResult(_channel->currentSeq, events);
@@ -161,6 +185,10 @@ public:
 		co_return 0;
 	}
 
+	std::shared_ptr<Channel> pipeReadEnd() override {
+		return _channel;
+	}
+
 private:
 	helix::UniqueLane _passthrough;
 
@@ -180,8 +208,8 @@ public:
 				smarter::shared_ptr<File>{file}, &File::fileOperations));
 	}
 
-	WriterFile(std::shared_ptr<MountView> mount, std::shared_ptr<FsLink> link)
-	: File{StructName::get("fifo.write"), mount, link, File::defaultPipeLikeSeek} { }
+	WriterFile(std::shared_ptr<MountView> mount, std::shared_ptr<FsLink> link, bool nonBlock = false)
+	: File{StructName::get("fifo.write"), mount, link, File::defaultPipeLikeSeek}, nonBlock_{nonBlock} { }
 
 	void connectChannel(std::shared_ptr<Channel> channel) {
 		assert(!_channel);
@@ -201,14 +229,29 @@ public:
 
 	async::result<frg::expected<Error, size_t>>
 	writeAll(Process *process, const void *data, size_t maxLength) override {
-		Packet packet;
-		packet.buffer.resize(maxLength);
-		memcpy(packet.buffer.data(), data, maxLength);
-		packet.offset = 0;
-
-		_channel->packetQueue.push_back(std::move(packet));
-		_channel->inSeq = ++_channel->currentSeq;
-		_channel->statusBell.raise();
+		auto source = reinterpret_cast<const char *>(data);
+		size_t progress = 0;
+		while(progress < maxLength) {
+			// Writes of up to PIPE_BUF bytes must not be interleaved with other writes.
+			auto needed = maxLength <= PIPE_BUF ? maxLength : 1;
+			while(_channel->readerCount && _channel->ring.space() < needed) {
+				if(nonBlock_) {
+					if(progress)
+						co_return progress;
+					co_return Error::wouldBlock;
+				}
+				co_await _channel->statusBell.async_wait();
+			}
+
+			if(!_channel->readerCount) {
+				if(progress)
+					co_return progress;
+				co_return Error::brokenPipe;
+			}
+
+			progress += _channel->ring.write(source + progress, maxLength - progress);
+			_channel->produced();
+		}
 		co_return maxLength;
 	}
 
@@ -224,7 +267,9 @@ public:
 		if(cancellation.is_cancellation_requested())
 			std::cout << "\e[33mposix: fifo::poll() cancellation is untested\e[39m" << std::endl;
 
-		int edges = EPOLLOUT;
+		int edges = 0;
+		if(_channel->outSeq > pastSeq)
+			edges |= EPOLLOUT;
 		if(_channel->noReaderSeq > pastSeq)
 			edges |= EPOLLERR;
 
@@ -233,7 +278,9 @@ public:
 
 	async::result<frg::expected<Error, PollStatusResult>>
 	pollStatus(Process *) override {
-		int events = EPOLLOUT;
+		int events = 0;
+		if(_channel->ring.space() >= PIPE_BUF)
+			events |= EPOLLOUT;
 		if(!_channel->readerCount)
 			events |= EPOLLERR;
 
@@ -244,10 +291,31 @@ public:
 		return _passthrough;
 	}
 
+	async::result<void> setFileFlags(int flags) override {
+		if(flags & ~O_NONBLOCK) {
+			std::cout << "posix: setFileFlags on fifo \e[1;34m" << structName() << "\e[0m called with unknown flags" << std::endl;
+			co_return;
+		}
+		nonBlock_ = flags & O_NONBLOCK;
+		co_return;
+	}
+
+	async::result<int> getFileFlags() override {
+		if(nonBlock_)
+			co_return O_NONBLOCK;
+		co_return 0;
+	}
+
+	std::shared_ptr<Channel> pipeWriteEnd() override {
+		return _channel;
+	}
+
 private:
 	helix::UniqueLane _passthrough;
 
 	std::shared_ptr<Channel> _channel;
+
+	bool nonBlock_;
 };
 
 } // anonymous namespace
@@ -308,7 +376,7 @@ std::array<smarter::shared_ptr<File, FileHandle>, 2> createPair(bool nonBlock) {
 	auto link = SpecialLink::makeSpecialLink(VfsType::fifo, 0777);
 	auto channel = std::make_shared<Channel>();
 	auto r_file = smarter::make_shared<ReaderFile>(nullptr, link, nonBlock);
-	auto w_file = smarter::make_shared<WriterFile>(nullptr, link);
+	auto w_file = smarter::make_shared<WriterFile>(nullptr, link, nonBlock);
 	r_file->setupWeakFile(r_file);
 	w_file->setupWeakFile(w_file);
 	r_file->connectChannel(channel);
@@ -319,5 +387,221 @@ std::array<smarter::shared_ptr<File, FileHandle>, 2> createPair(bool nonBlock) {
 			File::constructHandle(std::move(w_file))};
 }
 
-} // namespace fifo
+size_t getCapacity(Channel *channel) {
+	return channel->ring.capacity();
+}
+
+frg::expected<protocols::fs::Error, size_t> setCapacity(Channel *channel, size_t capacity) {
+	if(capacity > pipe_buffer::maxCapacity)
+		return protocols::fs::Error::illegalArguments;
+	if(!channel->ring.setCapacity(capacity))
+		return protocols::fs::Error::resourceBusy;
+	channel->consumed();
+	return channel->ring.capacity();
+}
+
+async::result<frg::expected<Error, size_t>>
+splice(Process *process, SharedFilePtr in, std::optional<int64_t> inOffset,
+		SharedFilePtr out, std::optional<int64_t> outOffset, size_t length, bool nonBlock) {
+	// Both files stay open until we return; hence, the channels stay connected.
+	auto inPipe = in->pipeReadEnd();
+	auto outPipe = out->pipeWriteEnd();
+	if((!inPipe && in->pipeWriteEnd()) || (!outPipe && out->pipeReadEnd()))
+		co_return Error::badFd;
+	if(!inPipe && !outPipe)
+		co_return Error::illegalArguments;
+	if((inPipe && inOffset) || (outPipe && outOffset))
+		co_return Error::seekOnPipe;
+	if(inPipe == outPipe)
+		co_return Error::illegalArguments;
+	if(!length)
+		co_return 0;
+
+	if(inPipe && outPipe) {
+		while(true) {
+			auto hasData = co_await waitForData(inPipe.get(), nonBlock);
+			if(!hasData)
+				co_return hasData.error();
+			if(!hasData.value())
+				co_return 0;
+			if(auto waitResult = co_await waitForSlot(outPipe.get(), nonBlock); !waitResult)
+				co_return waitResult.error();
+
+			// Other readers may have drained the pipe while we were waiting for a slot.
+			if(!inPipe->draining && !inPipe->ring.empty() && outPipe->ring.hasFreeSlot())
+				break;
+		}
+
+		// Move page references; this does not copy any data.
+		size_t progress = 0;
+		while(progress < length && !inPipe->ring.empty() && outPipe->ring.hasFreeSlot()) {
+			auto segment = inPipe->ring.pop(length - progress);
+			progress += segment.length;
+			outPipe->ring.push(std::move(segment));
+		}
+		inPipe->consumed();
+		outPipe->produced();
+		co_return progress;
+	}else if(inPipe) {
+		auto hasData = co_await waitForData(inPipe.get(), nonBlock);
+		if(!hasData)
+			co_return hasData.error();
+		if(!hasData.value())
+			co_return 0;
+
+		// Write directly from the pipe's pages to the file. Data is only consumed
+		// after it was written, such that it stays in the pipe if the write fails.
+		size_t progress = 0;
+		frg::expected<Error, size_t> result = 0;
+		inPipe->draining = true;
+		while(progress < length && !inPipe->ring.empty()) {
+			auto segment = inPipe->ring.peek(0);
+			auto chunk = std::min(segment.length, length - progress);
+
+			if(outOffset) {
+				result = co_await out->pwrite(process, *outOffset + progress,
+						segment.data(), chunk);
+			}else{
+				result = co_await out->writeAll(process, segment.data(), chunk);
+			}
+			if(!result)
+				break;
+
+			inPipe->ring.pop(result.value());
+			progress += result.value();
+			if(result.value() < chunk)
+				break;
+		}
+		inPipe->draining = false;
+		// This also wakes up consumers that waited for us to finish.
+		inPipe->consumed();
+
+		if(!result && !progress)
+			co_return result.error();
+		co_return progress;
+	}else{
+		assert(outPipe);
+		if(auto waitResult = co_await waitForSlot(outPipe.get(), nonBlock); !waitResult)
+			co_return waitResult.error();
+
+		// Read from the file directly into fresh pages that are then added to the pipe.
+		// splice() with an offset must not change the file offset, hence we use pread().
+		size_t progress = 0;
+		frg::expected<Error, size_t> result = 0;
+		while(progress < length) {
+			auto page = pipe_buffer::PageRef::allocate();
+			auto chunk = std::min(pipe_buffer::pageSize, length - progress);
+			if(inOffset) {
+				result = co_await in->pread(process, *inOffset + progress, page.data(), chunk);
+			}else{
+				result = co_await in->readSome(process, page.data(), chunk);
+			}
+			if(!result || !result.value())
+				break;
+
+			// Other writers may have filled up the pipe while we were reading.
+			if(auto waitResult = co_await waitForSlot(outPipe.get(), false); !waitResult) {
+				result = waitResult.error();
+				break;
+			}
+			outPipe->ring.push(pipe_buffer::Segment{std::move(page), 0, result.value()});
+			outPipe->produced();
+			progress += result.value();
 
+			if(result.value() < chunk || !outPipe->ring.hasFreeSlot())
+				break;
+		}
+
+		if(!result && !progress)
+			co_return result.error();
+		co_return progress;
+	}
+}
+
+async::result<frg::expected<Error, size_t>>
+tee(SharedFilePtr in, SharedFilePtr out, size_t length, bool nonBlock) {
+	auto inPipe = in->pipeReadEnd();
+	auto outPipe = out->pipeWriteEnd();
+	if((!inPipe && in->pipeWriteEnd()) || (!outPipe && out->pipeReadEnd()))
+		co_return Error::badFd;
+	if(!inPipe || !outPipe || inPipe == outPipe)
+		co_return Error::illegalArguments;
+	if(!length)
+		co_return 0;
+
+	while(true) {
+		auto hasData = co_await waitForData(inPipe.get(), nonBlock);
+		if(!hasData)
+			co_return hasData.error();
+		if(!hasData.value())
+			co_return 0;
+		if(auto waitResult = co_await waitForSlot(outPipe.get(), nonBlock); !waitResult)
+			co_return waitResult.error();
+
+		// Readers may have drained the pipe while we were waiting for a slot.
+		if(!inPipe->draining && !inPipe->ring.empty() && outPipe->ring.hasFreeSlot())
+			break;
+	}
+
+	// Share page references between both pipes. Since the pages are no longer exclusive,
+	// neither pipe appends to them afterwards.
+	size_t progress = 0;
+	for(size_t n = 0; n < inPipe->ring.numSegments() && progress < length; n++) {
+		if(!outPipe->ring.hasFreeSlot())
+			break;
+		auto segment = inPipe->ring.peek(n);
+		segment.length = std::min(segment.length, length - progress);
+		progress += segment.length;
+		outPipe->ring.push(std::move(segment));
+	}
+	outPipe->produced();
+	co_return progress;
+}
+
+async::result<frg::expected<Error, size_t>>
+vmsplice(Process *process, SharedFilePtr out, std::vector<UserBuffer> buffers, bool nonBlock) {
+	auto outPipe = out->pipeWriteEnd();
+	if(!outPipe) {
+		if(out->pipeReadEnd())
+			co_return Error::badFd;
+		co_return Error::illegalArguments;
+	}
+
+	if(auto waitResult = co_await waitForSlot(outPipe.get(), nonBlock); !waitResult)
+		co_return waitResult.error();
+
+	// Load the user's memory directly into the pipe's pages.
+	size_t progress = 0;
+	for(auto &buffer : buffers) {
+		size_t offset = 0;
+		while(offset < buffer.length) {
+			if(!outPipe->ring.hasFreeSlot())
+				co_return progress;
+
+			auto page = pipe_buffer::PageRef::allocate();
+			auto chunk = std::min(pipe_buffer::pageSize, buffer.length - offset);
+			auto loadMemory = co_await helix_ng::readMemory(process->vmContext()->getSpace(),
+					buffer.address + offset, chunk, page.data());
+			if(loadMemory.error()) {
+				if(progress)
+					co_return progress;
+				co_return Error::illegalArguments;
+			}
+
+			// readMemory() might have blocked; re-check that the pipe is still usable.
+			if(!outPipe->readerCount) {
+				if(progress)
+					co_return progress;
+				co_return Error::brokenPipe;
+			}
+			if(!outPipe->ring.push(pipe_buffer::Segment{std::move(page), 0, chunk}))
+				co_return progress;
+			outPipe->produced();
+			offset += chunk;
+			progress += chunk;
+		}
+	}
+	co_return progress;
+}
+
+} // namespace fifo
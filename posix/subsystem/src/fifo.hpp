@@ -1,4 +1,6 @@
 
+#include <optional>
+
 #include "file.hpp"
 #include "fs.hpp"
 
@@ -11,5 +13,29 @@ openNamedChannel(std::shared_ptr<MountView> mount, std::shared_ptr<FsLink> link,
 
 std::array<smarter::shared_ptr<File, FileHandle>, 2> createPair(bool nonBlock);
 
-} // namespace fifo
+// Implementation of F_GETPIPE_SZ and F_SETPIPE_SZ.
+size_t getCapacity(Channel *channel);
+frg::expected<protocols::fs::Error, size_t> setCapacity(Channel *channel, size_t capacity);
+
+// Moves data between two files, at least one of which must be a pipe.
+// Data is moved between pipes by passing page references (i.e., without copying).
+// Offsets are only allowed for ends that are not pipes.
+// Returns Error::badFd if in is not readable or out is not writable.
+async::result<frg::expected<Error, size_t>>
+splice(Process *process, SharedFilePtr in, std::optional<int64_t> inOffset,
+		SharedFilePtr out, std::optional<int64_t> outOffset, size_t length, bool nonBlock);
+
+// Duplicates data from one pipe to another without consuming it.
+async::result<frg::expected<Error, size_t>>
+tee(SharedFilePtr in, SharedFilePtr out, size_t length, bool nonBlock);
 
+struct UserBuffer {
+	uintptr_t address;
+	size_t length;
+};
+
+// Copies data from the address space of the process into a pipe.
+async::result<frg::expected<Error, size_t>>
+vmsplice(Process *process, SharedFilePtr out, std::vector<UserBuffer> buffers, bool nonBlock);
+
+} // namespace fifo
@@ -4,7 +4,9 @@
 #include <future>
 
 #include <sys/socket.h>
+#include <linux/falloc.h>
 #include <helix/ipc.hpp>
+#include "fifo.hpp"
 #include "file.hpp"
 #include "process.hpp"
 #include "fs.bragi.hpp"
@@ -85,6 +87,10 @@ async::result<frg::expected<protocols::fs::Error, size_t>> File::ptWrite(void *o
 		switch(result.error()) {
 		case Error::noSpaceLeft:
 			co_return protocols::fs::Error::noSpaceLeft;
+		case Error::wouldBlock:
+			co_return protocols::fs::Error::wouldBlock;
+		case Error::brokenPipe:
+			co_return protocols::fs::Error::brokenPipe;
 		default:
 			assert(!"Unexpected error from writeAll()");
 			__builtin_unreachable();
@@ -121,9 +127,22 @@ async::result<frg::expected<protocols::fs::Error>> File::ptTruncate(void *object
 }
 
 async::result<frg::expected<protocols::fs::Error>> File::ptAllocate(void *object,
-		int64_t offset, size_t size) {
+		int mode, int64_t offset, size_t size) {
 	auto self = static_cast<File *>(object);
 
+	if(offset < 0 || !size)
+		co_return protocols::fs::Error::illegalArguments;
+
+	if(mode & FALLOC_FL_PUNCH_HOLE) {
+		// Linux requires FALLOC_FL_KEEP_SIZE to be passed together with FALLOC_FL_PUNCH_HOLE.
+		if(mode != (FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE))
+			co_return protocols::fs::Error::illegalArguments;
+		co_return co_await self->punchHole(offset, size);
+	}else if(mode) {
+		std::cout << "posix: Unsupported fallocate() mode " << mode << std::endl;
+		co_return protocols::fs::Error::illegalArguments;
+	}
+
 	co_return co_await self->allocate(offset, size);
 }
 
@@ -193,6 +212,23 @@ async::result<frg::expected<protocols::fs::Error, int>> File::ptAddSeals(void *o
 	co_return co_await self->addSeals(seals);
 }
 
+async::result<frg::expected<protocols::fs::Error, size_t>> File::ptGetPipeSize(void *object) {
+	auto self = static_cast<File *>(object);
+	auto pipe = self->getPipe();
+	if(!pipe)
+		co_return protocols::fs::Error::illegalOperationTarget;
+	co_return fifo::getCapacity(pipe.get());
+}
+
+async::result<frg::expected<protocols::fs::Error, size_t>> File::ptSetPipeSize(void *object,
+		size_t size) {
+	auto self = static_cast<File *>(object);
+	auto pipe = self->getPipe();
+	if(!pipe)
+		co_return protocols::fs::Error::illegalOperationTarget;
+	co_return fifo::setCapacity(pipe.get(), size);
+}
+
 async::result<protocols::fs::RecvResult>
 File::ptRecvMsg(void *object, const char *creds, uint32_t flags,
 		void *data, size_t len,
@@ -289,6 +325,12 @@ async::result<frg::expected<Error, ControllingTerminalState *>> File::getControl
 	co_return Error::notTerminal;
 }
 
+async::result<frg::expected<Error, size_t>> File::pread(Process *, int64_t, void *, size_t) {
+	std::cout << "posix \e[1;34m" << structName()
+			<< "\e[0m: Object does not implement pread()" << std::endl;
+	co_return Error::seekOnPipe;
+}
+
 async::result<frg::expected<Error, size_t>> File::pwrite(Process *, int64_t, const void *, size_t) {
 	std::cout << "posix \e[1;34m" << structName()
 			<< "\e[0m: Object does not implement pwrite()" << std::endl;
@@ -325,6 +367,10 @@ async::result<frg::expected<protocols::fs::Error>> File::allocate(int64_t, size_
 	throw std::runtime_error("posix: Object has no File::allocate()");
 }
 
+async::result<frg::expected<protocols::fs::Error>> File::punchHole(int64_t, size_t) {
+	co_return protocols::fs::Error::illegalOperationTarget;
+}
+
 async::result<frg::expected<Error, off_t>> File::seek(off_t, VfsSeek) {
 	if(_defaultOps & defaultPipeLikeSeek) {
 		co_return Error::seekOnPipe;
@@ -459,3 +505,25 @@ async::result<frg::expected<protocols::fs::Error, int>> File::getSeals() {
 async::result<frg::expected<protocols::fs::Error, int>> File::addSeals(int seals) {
 	co_return protocols::fs::Error::illegalOperationTarget;
 }
+
+protocols::fs::StatusPage *File::statusPage() {
+	return nullptr;
+}
+
+StatusDomain *File::statusDomain() {
+	return nullptr;
+}
+
+std::shared_ptr<fifo::Channel> File::pipeReadEnd() {
+	return nullptr;
+}
+
+std::shared_ptr<fifo::Channel> File::pipeWriteEnd() {
+	return nullptr;
+}
+
+std::shared_ptr<fifo::Channel> File::getPipe() {
+	if(auto pipe = pipeReadEnd(); pipe)
+		return pipe;
+	return pipeWriteEnd();
+}
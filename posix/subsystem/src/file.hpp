@@ -17,10 +17,24 @@ struct FsLink;
 struct Process;
 struct ControllingTerminalState;
 
+namespace fifo {
+	struct Channel;
+}
+
 struct FileHandle { };
 
 using SharedFilePtr = smarter::shared_ptr<File, FileHandle>;
 
+struct StatusWatcher;
+
+// Groups the files whose status pages are announced by the same server (see File::statusPage()).
+// Domains are created by posix (e.g., one per device), hence files of different servers
+// never end up in the same domain.
+struct StatusDomain {
+	// Created by epoll once it watches a file of this domain.
+	std::shared_ptr<StatusWatcher> watcher;
+};
+
 // TODO: Rename this enum as is not part of the VFS.
 enum class Error {
 	success,
@@ -61,7 +75,10 @@ enum class Error {
 	noSpaceLeft,
 
 	// Corresponds with EISDIR
-	isDirectory
+	isDirectory,
+
+	// Corresponds with EBADF
+	badFd
 };
 
 // TODO: Rename this enum as is not part of the VFS.
@@ -128,7 +145,7 @@ public:
 	ptTruncate(void *object, size_t size);
 
 	static async::result<frg::expected<protocols::fs::Error>>
-	ptAllocate(void *object, int64_t offset, size_t size);
+	ptAllocate(void *object, int mode, int64_t offset, size_t size);
 
 	static async::result<int>
 	ptGetOption(void *object, int option);
@@ -178,6 +195,10 @@ public:
 	static async::result<frg::expected<protocols::fs::Error, int>> ptGetSeals(void *object);
 	static async::result<frg::expected<protocols::fs::Error, int>> ptAddSeals(void *object, int seals);
 
+	static async::result<frg::expected<protocols::fs::Error, size_t>> ptGetPipeSize(void *object);
+	static async::result<frg::expected<protocols::fs::Error, size_t>> ptSetPipeSize(void *object,
+			size_t size);
+
 	static constexpr auto fileOperations = protocols::fs::FileOperations{
 		.seekAbs = &ptSeekAbs,
 		.seekRel = &ptSeekRel,
@@ -202,6 +223,8 @@ public:
 		.peername = &ptPeername,
 		.getSeals = &ptGetSeals,
 		.addSeals = &ptAddSeals,
+		.getPipeSize = &ptGetPipeSize,
+		.setPipeSize = &ptSetPipeSize,
 	};
 
 	// ------------------------------------------------------------------------
@@ -283,6 +306,9 @@ public:
 	virtual async::result<frg::expected<Error, ControllingTerminalState *>>
 	getControllingTerminal();
 
+	virtual async::result<frg::expected<Error, size_t>>
+	pread(Process *process, int64_t offset, void *data, size_t max_length);
+
 	virtual async::result<frg::expected<Error, size_t>>
 	pwrite(Process *process, int64_t offset, const void *data, size_t length);
 
@@ -303,6 +329,10 @@ public:
 
 	virtual async::result<frg::expected<protocols::fs::Error>> allocate(int64_t offset, size_t size);
 
+	// Implements fallocate(FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE):
+	// the range reads back as zeros afterwards and its backing memory may be released.
+	virtual async::result<frg::expected<protocols::fs::Error>> punchHole(int64_t offset, size_t size);
+
 	// poll() uses a sequence number mechansim for synchronization.
 	// Before returning, it waits until current-sequence > in-sequence.
 	// Returns (current-sequence, edges since in-sequence, current events).
@@ -321,6 +351,13 @@ public:
 	// Returns (current-sequence, active events).
 	virtual async::result<frg::expected<Error, PollStatusResult>> pollStatus(Process *);
 
+	// Returns the status page of files whose server announces status changes in batches
+	// (i.e., if protocols::fs::StatusPage::watchId is non-zero). Returns nullptr otherwise.
+	// epoll watches such files without issuing one pollWait() per file.
+	virtual protocols::fs::StatusPage *statusPage();
+	// Must be non-null if statusPage() is non-null.
+	virtual StatusDomain *statusDomain();
+
 	virtual async::result<int> getOption(int option);
 	virtual async::result<void> setOption(int option, int value);
 
@@ -351,6 +388,14 @@ public:
 	virtual async::result<frg::expected<protocols::fs::Error, int>> getSeals();
 	virtual async::result<frg::expected<protocols::fs::Error, int>> addSeals(int flags);
 
+	// Return the pipe if this file is its read end (or write end, respectively).
+	// Used by splice() and tee() to check the direction of the transfer.
+	virtual std::shared_ptr<fifo::Channel> pipeReadEnd();
+	virtual std::shared_ptr<fifo::Channel> pipeWriteEnd();
+
+	// Returns the pipe if this file is either of its ends.
+	std::shared_ptr<fifo::Channel> getPipe();
+
 	virtual async::result<frg::expected<Error, std::string>> ttyname();
 private:
 	smarter::weak_ptr<File> _weakPtr;
@@ -109,6 +109,10 @@ async::result<frg::expected<Error, std::pair<std::shared_ptr<FsLink>, size_t>>>
 	throw std::runtime_error("traverseLinks() is not implemented for this FsNode");
 }
 
+bool FsNode::supportsDentryCache() {
+	return false;
+}
+
 async::result<Error> FsNode::chmod(int mode) {
 	std::cout << "\e[31m" "posix: chmod() is not implemented for this FsNode" "\e[39m" << std::endl;
 	co_return Error::accessDenied;
@@ -174,6 +174,10 @@ public:
 	virtual bool hasTraverseLinks();
 	virtual async::result<frg::expected<Error, std::pair<std::shared_ptr<FsLink>, size_t>>> traverseLinks(std::deque<std::string> path);
 
+	// Whether the VFS may cache the results of getLink() and traverseLinks() (see DentryCache).
+	// File systems that return true must invalidate the cache when they add or remove links.
+	virtual bool supportsDentryCache();
+
 protected:
 	void notifyObservers(uint32_t inotifyEvents, const std::string &name, uint32_t cookie);
 
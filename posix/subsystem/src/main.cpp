@@ -13,6 +13,7 @@
 #include <sys/stat.h>
 #include <iomanip>
 #include <iostream>
+#include <sstream>
 
 #include <async/algorithm.hpp>
 #include <async/oneshot-event.hpp>
@@ -43,6 +44,7 @@
 #include "memfd.hpp"
 #include "procfs.hpp"
 #include "pts.hpp"
+#include "request-stats.hpp"
 #include "signalfd.hpp"
 #include "subsystem/block.hpp"
 #include "subsystem/drm.hpp"
@@ -54,6 +56,7 @@
 #include "timerfd.hpp"
 #include "eventfd.hpp"
 #include "tmp_fs.hpp"
+#include "workers.hpp"
 #include <kerncfg.pb.h>
 #include <bragi/helpers-std.hpp>
 #include <posix.bragi.hpp>
@@ -694,6 +697,23 @@ async::result<void> serveSignals(std::shared_ptr<Process> self,
 	generation->signalsDone.raise();
 }
 
+// Requests that only touch the file table or immutable process state.
+// Workers handle them without switching to the home thread (see workers.hpp).
+constexpr bool isLocalRequest(uint32_t requestKey) {
+	switch(requestKey) {
+	case request_stats::messageKey<managarm::posix::GetTidRequest>():
+	case request_stats::legacyKey(managarm::posix::CntReqType::GET_PID):
+	case request_stats::messageKey<managarm::posix::CloseRequest>():
+	case request_stats::legacyKey(managarm::posix::CntReqType::DUP):
+	case request_stats::legacyKey(managarm::posix::CntReqType::DUP2):
+	case request_stats::legacyKey(managarm::posix::CntReqType::FD_SET_FLAGS):
+	case request_stats::messageKey<managarm::posix::IoctlFioclexRequest>():
+		return true;
+	default:
+		return false;
+	}
+}
+
 async::result<void> serveRequests(std::shared_ptr<Process> self,
 		std::shared_ptr<Generation> generation) {
 	async::cancellation_token cancellation = generation->cancelServe;
@@ -703,7 +723,10 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 	}};
 
 	while(true) {
-		auto [accept, recv_head] = co_await helix_ng::exchangeMsgs(
+		// Handlers of non-local requests continue on the home thread; return to our worker.
+		co_await workers::switchTo(generation->worker);
+
+		auto [accept, recv_inline] = co_await helix_ng::exchangeMsgs(
 				self->posixLane(),
 				helix_ng::accept(
 					helix_ng::recvInline()
@@ -714,11 +737,11 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 			break;
 		HEL_CHECK(accept.error());
 
-		if(recv_head.error() == kHelErrBufferTooSmall) {
+		if(recv_inline.error() == kHelErrBufferTooSmall) {
 			std::cout << "posix: Rejecting request due to RecvInline overflow" << std::endl;
 			continue;
 		}
-		HEL_CHECK(recv_head.error());
+		HEL_CHECK(recv_inline.error());
 
 		auto conversation = accept.descriptor();
 
@@ -734,9 +757,13 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 			HEL_CHECK(send_resp.error());
 		};
 
+		// Copy the head since the queue chunk must not be accessed once we leave this worker.
+		auto headData = static_cast<const std::byte *>(recv_inline.data());
+		std::vector<std::byte> recv_head(headData, headData + recv_inline.length());
+		recv_inline.reset();
+
 		auto preamble = bragi::read_preamble(recv_head);
 		assert(!preamble.error());
-		recv_head.reset();
 
 		managarm::posix::CntRequest req;
 		if (preamble.id() == managarm::posix::CntRequest::message_id) {
@@ -749,10 +776,29 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 			req = *o;
 		}
 
-		if(preamble.id() == bragi::message_id<managarm::posix::GetTidRequest>) {
+		// CntRequests are dispatched on their request type, all other requests on their
+		// message ID. The keys are dense such that the switch below compiles to a jump table.
+		uint32_t requestKey = preamble.id();
+		if(preamble.id() == managarm::posix::CntRequest::message_id) {
+			requestKey = request_stats::legacyKey(req.request_type());
+		}else if(preamble.id() >= request_stats::legacyKeyBase) {
+			// Unknown message; do not let it alias a legacy request.
+			requestKey = request_stats::numKeys;
+		}
+		request_stats::Timer requestTimer{requestKey};
+		bool decodingFailed = false;
+
+		bool local = isLocalRequest(requestKey);
+		workers::countRequest(local);
+		if(!local)
+			co_await workers::switchToHome();
+
+		switch(requestKey) {
+		case request_stats::messageKey<managarm::posix::GetTidRequest>(): {
 			auto req = bragi::parse_head_only<managarm::posix::GetTidRequest>(recv_head);
 			if (!req) {
 				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+				decodingFailed = true;
 				break;
 			}
 			if(logRequests)
@@ -767,7 +813,9 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 				helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
 			);
 			HEL_CHECK(sendResp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::GET_PID) {
+			break;
+		}
+		case request_stats::legacyKey(managarm::posix::CntReqType::GET_PID): {
 			if(logRequests)
 				std::cout << "posix: GET_PID" << std::endl;
 
@@ -782,11 +830,14 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 					helix::action(&send_resp, ser.data(), ser.size()));
 			co_await transmit.async_wait();
 			HEL_CHECK(send_resp.error());
-		}else if(preamble.id() == managarm::posix::GetPpidRequest::message_id) {
+			break;
+		}
+		case request_stats::messageKey<managarm::posix::GetPpidRequest>(): {
 			auto req = bragi::parse_head_only<managarm::posix::GetPpidRequest>(recv_head);
 
 			if (!req) {
 				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+				decodingFailed = true;
 				break;
 			}
 
@@ -803,11 +854,14 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 				);
 
 			HEL_CHECK(send_resp.error());
-		}else if(preamble.id() == managarm::posix::GetUidRequest::message_id) {
+			break;
+		}
+		case request_stats::messageKey<managarm::posix::GetUidRequest>(): {
 			auto req = bragi::parse_head_only<managarm::posix::GetUidRequest>(recv_head);
 
 			if (!req) {
 				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+				decodingFailed = true;
 				break;
 			}
 
@@ -824,11 +878,14 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 				);
 
 			HEL_CHECK(send_resp.error());
-		}else if(preamble.id() == managarm::posix::SetUidRequest::message_id) {
+			break;
+		}
+		case request_stats::messageKey<managarm::posix::SetUidRequest>(): {
 			auto req = bragi::parse_head_only<managarm::posix::SetUidRequest>(recv_head);
 
 			if (!req) {
 				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+				decodingFailed = true;
 				break;
 			}
 
@@ -843,11 +900,14 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 			} else {
 				co_await sendErrorResponse(managarm::posix::Errors::SUCCESS);
 			}
-		}else if(preamble.id() == managarm::posix::GetEuidRequest::message_id) {
+			break;
+		}
+		case request_stats::messageKey<managarm::posix::GetEuidRequest>(): {
 			auto req = bragi::parse_head_only<managarm::posix::GetEuidRequest>(recv_head);
 
 			if (!req) {
 				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+				decodingFailed = true;
 				break;
 			}
 
@@ -864,11 +924,14 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 				);
 
 			HEL_CHECK(send_resp.error());
-		}else if(preamble.id() == managarm::posix::SetEuidRequest::message_id) {
+			break;
+		}
+		case request_stats::messageKey<managarm::posix::SetEuidRequest>(): {
 			auto req = bragi::parse_head_only<managarm::posix::SetEuidRequest>(recv_head);
 
 			if (!req) {
 				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+				decodingFailed = true;
 				break;
 			}
 
@@ -883,11 +946,14 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 			} else {
 				co_await sendErrorResponse(managarm::posix::Errors::SUCCESS);
 			}
-		}else if(preamble.id() == managarm::posix::GetGidRequest::message_id) {
+			break;
+		}
+		case request_stats::messageKey<managarm::posix::GetGidRequest>(): {
 			auto req = bragi::parse_head_only<managarm::posix::GetGidRequest>(recv_head);
 
 			if (!req) {
 				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+				decodingFailed = true;
 				break;
 			}
 
@@ -904,11 +970,14 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 				);
 
 			HEL_CHECK(send_resp.error());
-		}else if(preamble.id() == managarm::posix::GetEgidRequest::message_id) {
+			break;
+		}
+		case request_stats::messageKey<managarm::posix::GetEgidRequest>(): {
 			auto req = bragi::parse_head_only<managarm::posix::GetEgidRequest>(recv_head);
 
 			if (!req) {
 				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+				decodingFailed = true;
 				break;
 			}
 
@@ -925,11 +994,14 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 				);
 
 			HEL_CHECK(send_resp.error());
-		}else if(preamble.id() == managarm::posix::SetGidRequest::message_id) {
+			break;
+		}
+		case request_stats::messageKey<managarm::posix::SetGidRequest>(): {
 			auto req = bragi::parse_head_only<managarm::posix::SetGidRequest>(recv_head);
 
 			if (!req) {
 				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+				decodingFailed = true;
 				break;
 			}
 
@@ -944,11 +1016,14 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 			} else {
 				co_await sendErrorResponse(managarm::posix::Errors::SUCCESS);
 			}
-		}else if(preamble.id() == managarm::posix::SetEgidRequest::message_id) {
+			break;
+		}
+		case request_stats::messageKey<managarm::posix::SetEgidRequest>(): {
 			auto req = bragi::parse_head_only<managarm::posix::SetEgidRequest>(recv_head);
 
 			if (!req) {
 				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+				decodingFailed = true;
 				break;
 			}
 
@@ -963,7 +1038,9 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 			} else {
 				co_await sendErrorResponse(managarm::posix::Errors::SUCCESS);
 			}
-		}else if(req.request_type() == managarm::posix::CntReqType::WAIT) {
+			break;
+		}
+		case request_stats::legacyKey(managarm::posix::CntReqType::WAIT): {
 			if(logRequests)
 				std::cout << "posix: WAIT" << std::endl;
 
@@ -1003,7 +1080,9 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 					helix::action(&send_resp, ser.data(), ser.size()));
 			co_await transmit.async_wait();
 			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::GET_RESOURCE_USAGE) {
+			break;
+		}
+		case request_stats::legacyKey(managarm::posix::CntReqType::GET_RESOURCE_USAGE): {
 			if(logRequests)
 				std::cout << "posix: GET_RESOURCE_USAGE" << std::endl;
 
@@ -1032,10 +1111,13 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 					helix::action(&send_resp, ser.data(), ser.size()));
 			co_await transmit.async_wait();
 			HEL_CHECK(send_resp.error());
-		}else if(preamble.id() == bragi::message_id<managarm::posix::VmMapRequest>) {
+			break;
+		}
+		case request_stats::messageKey<managarm::posix::VmMapRequest>(): {
 			auto req = bragi::parse_head_only<managarm::posix::VmMapRequest>(recv_head);
 			if (!req) {
 				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+				decodingFailed = true;
 				break;
 			}
 			if(logRequests)
@@ -1106,7 +1188,9 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 				helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
 			);
 			HEL_CHECK(sendResp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::VM_REMAP) {
+			break;
+		}
+		case request_stats::legacyKey(managarm::posix::CntReqType::VM_REMAP): {
 			if(logRequests)
 				std::cout << "posix: VM_REMAP" << std::endl;
 
@@ -1124,7 +1208,9 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 					helix::action(&send_resp, ser.data(), ser.size()));
 			co_await transmit.async_wait();
 			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::VM_PROTECT) {
+			break;
+		}
+		case request_stats::legacyKey(managarm::posix::CntReqType::VM_PROTECT): {
 			if(logRequests)
 				std::cout << "posix: VM_PROTECT" << std::endl;
 			helix::SendBuffer send_resp;
@@ -1157,7 +1243,9 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 					helix::action(&send_resp, ser.data(), ser.size()));
 			co_await transmit.async_wait();
 			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::VM_UNMAP) {
+			break;
+		}
+		case request_stats::legacyKey(managarm::posix::CntReqType::VM_UNMAP): {
 			if(logRequests)
 				std::cout << "posix: VM_UNMAP address: " << (void *)req.address()
 						<< ", size: " << (void *)(size_t)req.size() << std::endl;
@@ -1174,7 +1262,9 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 					helix::action(&send_resp, ser.data(), ser.size()));
 			co_await transmit.async_wait();
 			HEL_CHECK(send_resp.error());
-		}else if(preamble.id() == managarm::posix::MountRequest::message_id) {
+			break;
+		}
+		case request_stats::messageKey<managarm::posix::MountRequest>(): {
 			std::vector<std::byte> tail(preamble.tail_size());
 			auto [recv_tail] = co_await helix_ng::exchangeMsgs(
 					conversation,
@@ -1186,6 +1276,7 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 
 			if (!req) {
 				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+				decodingFailed = true;
 				break;
 			}
 
@@ -1255,7 +1346,9 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 					);
 
 			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::CHROOT) {
+			break;
+		}
+		case request_stats::legacyKey(managarm::posix::CntReqType::CHROOT): {
 			if(logRequests)
 				std::cout << "posix: CHROOT" << std::endl;
 
@@ -1286,7 +1379,9 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 					helix::action(&send_resp, ser.data(), ser.size()));
 			co_await transmit.async_wait();
 			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::CHDIR) {
+			break;
+		}
+		case request_stats::legacyKey(managarm::posix::CntReqType::CHDIR): {
 			if(logRequests)
 				std::cout << "posix: CHDIR" << std::endl;
 
@@ -1317,7 +1412,9 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 					helix::action(&send_resp, ser.data(), ser.size()));
 			co_await transmit.async_wait();
 			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::FCHDIR) {
+			break;
+		}
+		case request_stats::legacyKey(managarm::posix::CntReqType::FCHDIR): {
 			if(logRequests)
 				std::cout << "posix: CHDIR" << std::endl;
 
@@ -1347,7 +1444,9 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 					helix::action(&send_resp, ser.data(), ser.size()));
 			co_await transmit.async_wait();
 			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::ACCESSAT) {
+			break;
+		}
+		case request_stats::legacyKey(managarm::posix::CntReqType::ACCESSAT): {
 			if(logRequests || logPaths)
 				std::cout << "posix: ACCESSAT " << req.path() << std::endl;
 
@@ -1402,7 +1501,9 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 			auto [send_resp] = co_await helix_ng::exchangeMsgs(conversation,
 				helix_ng::sendBuffer(ser.data(), ser.size()));
 			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::MKDIRAT) {
+			break;
+		}
+		case request_stats::legacyKey(managarm::posix::CntReqType::MKDIRAT): {
 			if(logRequests || logPaths)
 				std::cout << "posix: MKDIRAT " << req.path() << std::endl;
 
@@ -1487,7 +1588,9 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 				co_await transmit.async_wait();
 				HEL_CHECK(send_resp.error());
 			}
-		}else if(preamble.id() == managarm::posix::MkfifoAtRequest::message_id) {
+			break;
+		}
+		case request_stats::messageKey<managarm::posix::MkfifoAtRequest>(): {
 			std::vector<std::byte> tail(preamble.tail_size());
 			auto [recv_tail] = co_await helix_ng::exchangeMsgs(
 					conversation,
@@ -1499,6 +1602,7 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 
 			if (!req) {
 				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+				decodingFailed = true;
 				break;
 			}
 
@@ -1557,7 +1661,9 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 			}
 
 			co_await sendErrorResponse(managarm::posix::Errors::SUCCESS);
-		}else if(preamble.id() == managarm::posix::LinkAtRequest::message_id) {
+			break;
+		}
+		case request_stats::messageKey<managarm::posix::LinkAtRequest>(): {
 			std::vector<std::byte> tail(preamble.tail_size());
 			auto [recv_tail] = co_await helix_ng::exchangeMsgs(
 					conversation,
@@ -1660,7 +1766,9 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 			}
 
 			co_await sendErrorResponse(managarm::posix::Errors::SUCCESS);
-		}else if(preamble.id() == managarm::posix::SymlinkAtRequest::message_id) {
+			break;
+		}
+		case request_stats::messageKey<managarm::posix::SymlinkAtRequest>(): {
 			std::vector<std::byte> tail(preamble.tail_size());
 			auto [recv_tail] = co_await helix_ng::exchangeMsgs(
 					conversation,
@@ -1672,6 +1780,7 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 
 			if (!req) {
 				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+				decodingFailed = true;
 				break;
 			}
 
@@ -1732,7 +1841,9 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 				helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
 			);
 			HEL_CHECK(sendResp.error());
-		}else if(preamble.id() == managarm::posix::RenameAtRequest::message_id) {
+			break;
+		}
+		case request_stats::messageKey<managarm::posix::RenameAtRequest>(): {
 			std::vector<std::byte> tail(preamble.tail_size());
 			auto [recv_tail] = co_await helix_ng::exchangeMsgs(
 					conversation,
@@ -1744,6 +1855,7 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 
 			if (!req) {
 				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+				decodingFailed = true;
 				break;
 			}
 
@@ -1833,7 +1945,9 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 			}
 
 			co_await sendErrorResponse(managarm::posix::Errors::SUCCESS);
-		}else if(preamble.id() == managarm::posix::FstatAtRequest::message_id) {
+			break;
+		}
+		case request_stats::messageKey<managarm::posix::FstatAtRequest>(): {
 			std::vector<std::byte> tail(preamble.tail_size());
 			auto [recv_tail] = co_await helix_ng::exchangeMsgs(
 					conversation,
@@ -1845,6 +1959,7 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 
 			if (!req) {
 				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+				decodingFailed = true;
 				break;
 			}
 
@@ -1957,7 +2072,9 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 				);
 
 			HEL_CHECK(send_resp.error());
-		}else if(preamble.id() == managarm::posix::FchmodAtRequest::message_id) {
+			break;
+		}
+		case request_stats::messageKey<managarm::posix::FchmodAtRequest>(): {
 			std::vector<std::byte> tail(preamble.tail_size());
 			auto [recv_tail] = co_await helix_ng::exchangeMsgs(
 					conversation,
@@ -2027,7 +2144,9 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 			co_await target_link->getTarget()->chmod(req->mode());
 
 			co_await sendErrorResponse(managarm::posix::Errors::SUCCESS);
-		}else if(preamble.id() == managarm::posix::UtimensAtRequest::message_id) {
+			break;
+		}
+		case request_stats::messageKey<managarm::posix::UtimensAtRequest>(): {
 			std::vector<std::byte> tail(preamble.tail_size());
 			auto [recv_tail] = co_await helix_ng::exchangeMsgs(
 					conversation,
@@ -2039,6 +2158,7 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 
 			if (!req) {
 				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+				decodingFailed = true;
 				break;
 			}
 
@@ -2096,7 +2216,9 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 			co_await target->utimensat(req->atimeSec(), req->atimeNsec(), req->mtimeSec(), req->mtimeNsec());
 
 			co_await sendErrorResponse(managarm::posix::Errors::SUCCESS);
-		}else if(req.request_type() == managarm::posix::CntReqType::READLINK) {
+			break;
+		}
+		case request_stats::legacyKey(managarm::posix::CntReqType::READLINK): {
 			if(logRequests || logPaths)
 				std::cout << "posix: READLINK path: " << req.path() << std::endl;
 
@@ -2161,7 +2283,9 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 				co_await transmit.async_wait();
 				HEL_CHECK(send_resp.error());
 			}
-		}else if(preamble.id() == bragi::message_id<managarm::posix::OpenAtRequest>) {
+			break;
+		}
+		case request_stats::messageKey<managarm::posix::OpenAtRequest>(): {
 			std::vector<std::byte> tail(preamble.tail_size());
 			auto [recvTail] = co_await helix_ng::exchangeMsgs(
 					conversation,
@@ -2172,6 +2296,7 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 			auto req = bragi::parse_head_tail<managarm::posix::OpenAtRequest>(recv_head, tail);
 			if (!req) {
 				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+				decodingFailed = true;
 				break;
 			}
 			if(logRequests || logPaths)
@@ -2361,16 +2486,19 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 					helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
 				);
 			HEL_CHECK(sendResp.error());
-		}else if(preamble.id() == bragi::message_id<managarm::posix::CloseRequest>) {
+			break;
+		}
+		case request_stats::messageKey<managarm::posix::CloseRequest>(): {
 			auto req = bragi::parse_head_only<managarm::posix::CloseRequest>(recv_head);
 			if (!req) {
 				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+				decodingFailed = true;
 				break;
 			}
 			if(logRequests)
 				std::cout << "posix: CLOSE file descriptor " << req->fd() << std::endl;
 
-			self->fileContext()->closeFile(req->fd());
+			workers::releaseOnHome(self->fileContext()->closeFile(req->fd()));
 
 			managarm::posix::SvrResponse resp;
 			resp.set_error(managarm::posix::Errors::SUCCESS);
@@ -2380,17 +2508,17 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 					helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
 				);
 			HEL_CHECK(sendResp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::DUP) {
+			break;
+		}
+		case request_stats::legacyKey(managarm::posix::CntReqType::DUP): {
 			if(logRequests)
 				std::cout << "posix: DUP" << std::endl;
 
-			auto file = self->fileContext()->getFile(req.fd());
-
-			if (!file) {
+			if(req.flags() & ~(managarm::posix::OpenFlags::OF_CLOEXEC)) {
 				helix::SendBuffer send_resp;
 
 				managarm::posix::SvrResponse resp;
-				resp.set_error(managarm::posix::Errors::BAD_FD);
+				resp.set_error(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
 
 				auto ser = resp.SerializeAsString();
 				auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
@@ -2400,11 +2528,14 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 				continue;
 			}
 
-			if(req.flags() & ~(managarm::posix::OpenFlags::OF_CLOEXEC)) {
+			auto newfd = self->fileContext()->duplicateFile(req.fd(),
+					req.flags() & managarm::posix::OpenFlags::OF_CLOEXEC);
+
+			if (!newfd) {
 				helix::SendBuffer send_resp;
 
 				managarm::posix::SvrResponse resp;
-				resp.set_error(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+				resp.set_error(managarm::posix::Errors::BAD_FD);
 
 				auto ser = resp.SerializeAsString();
 				auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
@@ -2414,31 +2545,28 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 				continue;
 			}
 
-			int newfd = self->fileContext()->attachFile(file,
-					req.flags() & managarm::posix::OpenFlags::OF_CLOEXEC);
-
 			helix::SendBuffer send_resp;
 
 			managarm::posix::SvrResponse resp;
 			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_fd(newfd);
+			resp.set_fd(newfd.value());
 
 			auto ser = resp.SerializeAsString();
 			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
 					helix::action(&send_resp, ser.data(), ser.size()));
 			co_await transmit.async_wait();
 			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::DUP2) {
+			break;
+		}
+		case request_stats::legacyKey(managarm::posix::CntReqType::DUP2): {
 			if(logRequests)
 				std::cout << "posix: DUP2" << std::endl;
 
-			auto file = self->fileContext()->getFile(req.fd());
-
-			if (!file || req.newfd() < 0) {
+			if(req.flags()) {
 				helix::SendBuffer send_resp;
 
 				managarm::posix::SvrResponse resp;
-				resp.set_error(managarm::posix::Errors::BAD_FD);
+				resp.set_error(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
 
 				auto ser = resp.SerializeAsString();
 				auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
@@ -2448,11 +2576,13 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 				continue;
 			}
 
-			if(req.flags()) {
+			auto previous = self->fileContext()->duplicateFileTo(req.fd(), req.newfd());
+
+			if (!previous) {
 				helix::SendBuffer send_resp;
 
 				managarm::posix::SvrResponse resp;
-				resp.set_error(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+				resp.set_error(managarm::posix::Errors::BAD_FD);
 
 				auto ser = resp.SerializeAsString();
 				auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
@@ -2461,8 +2591,7 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 				HEL_CHECK(send_resp.error());
 				continue;
 			}
-
-			self->fileContext()->attachFile(req.newfd(), file);
+			workers::releaseOnHome(std::move(previous.value()));
 
 			helix::SendBuffer send_resp;
 
@@ -2474,10 +2603,13 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 					helix::action(&send_resp, ser.data(), ser.size()));
 			co_await transmit.async_wait();
 			HEL_CHECK(send_resp.error());
-		}else if(preamble.id() == bragi::message_id<managarm::posix::IsTtyRequest>) {
+			break;
+		}
+		case request_stats::messageKey<managarm::posix::IsTtyRequest>(): {
 			auto req = bragi::parse_head_only<managarm::posix::IsTtyRequest>(recv_head);
 			if (!req) {
 				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+				decodingFailed = true;
 				break;
 			}
 			if(logRequests)
@@ -2500,7 +2632,9 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 					helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
 				);
 			HEL_CHECK(sendResp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::TTY_NAME) {
+			break;
+		}
+		case request_stats::legacyKey(managarm::posix::CntReqType::TTY_NAME): {
 			if(logRequests)
 				std::cout << "posix: TTY_NAME" << std::endl;
 
@@ -2530,7 +2664,9 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 					helix::action(&send_resp, ser.data(), ser.size()));
 			co_await transmit.async_wait();
 			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::GETCWD) {
+			break;
+		}
+		case request_stats::legacyKey(managarm::posix::CntReqType::GETCWD): {
 			if(logRequests)
 				std::cout << "posix: GETCWD" << std::endl;
 
@@ -2552,7 +2688,9 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 			co_await transmit.async_wait();
 			HEL_CHECK(send_resp.error());
 			HEL_CHECK(send_path.error());
-		}else if(preamble.id() == managarm::posix::UnlinkAtRequest::message_id) {
+			break;
+		}
+		case request_stats::messageKey<managarm::posix::UnlinkAtRequest>(): {
 			std::vector<std::byte> tail(preamble.tail_size());
 			auto [recv_tail] = co_await helix_ng::exchangeMsgs(
 					conversation,
@@ -2564,6 +2702,7 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 
 			if (!req) {
 				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+				decodingFailed = true;
 				break;
 			}
 
@@ -2637,7 +2776,9 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 			}
 
 			co_await sendErrorResponse(managarm::posix::Errors::SUCCESS);
-		}else if(preamble.id() == managarm::posix::RmdirRequest::message_id) {
+			break;
+		}
+		case request_stats::messageKey<managarm::posix::RmdirRequest>(): {
 			std::vector<std::byte> tail(preamble.tail_size());
 			auto [recv_tail] = co_await helix_ng::exchangeMsgs(
 					conversation,
@@ -2649,6 +2790,7 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 
 			if (!req) {
 				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+				decodingFailed = true;
 				break;
 			}
 
@@ -2686,7 +2828,9 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 			}
 
 			co_await sendErrorResponse(managarm::posix::Errors::SUCCESS);
-		}else if(req.request_type() == managarm::posix::CntReqType::FD_GET_FLAGS) {
+			break;
+		}
+		case request_stats::legacyKey(managarm::posix::CntReqType::FD_GET_FLAGS): {
 			if(logRequests)
 				std::cout << "posix: FD_GET_FLAGS" << std::endl;
 
@@ -2718,7 +2862,9 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 					helix::action(&send_resp, ser.data(), ser.size()));
 			co_await transmit.async_wait();
 			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::FD_SET_FLAGS) {
+			break;
+		}
+		case request_stats::legacyKey(managarm::posix::CntReqType::FD_SET_FLAGS): {
 			if(logRequests)
 				std::cout << "posix: FD_SET_FLAGS" << std::endl;
 
@@ -2740,10 +2886,13 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 			auto [send_resp] = co_await helix_ng::exchangeMsgs(conversation,
 					helix_ng::sendBuffer(ser.data(), ser.size()));
 			HEL_CHECK(send_resp.error());
-		}else if(preamble.id() == bragi::message_id<managarm::posix::IoctlFioclexRequest>) {
+			break;
+		}
+		case request_stats::messageKey<managarm::posix::IoctlFioclexRequest>(): {
 			auto req = bragi::parse_head_only<managarm::posix::IoctlFioclexRequest>(recv_head);
 			if (!req) {
 				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+				decodingFailed = true;
 				break;
 			}
 
@@ -2762,7 +2911,9 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 			auto [send_resp] = co_await helix_ng::exchangeMsgs(conversation,
 					helix_ng::sendBuffer(ser.data(), ser.size()));
 			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::SIG_ACTION) {
+			break;
+		}
+		case request_stats::legacyKey(managarm::posix::CntReqType::SIG_ACTION): {
 			if(logRequests)
 				std::cout << "posix: SIG_ACTION" << std::endl;
 
@@ -2849,7 +3000,9 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 					helix::action(&send_resp, ser.data(), ser.size()));
 			co_await transmit.async_wait();
 			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::PIPE_CREATE) {
+			break;
+		}
+		case request_stats::legacyKey(managarm::posix::CntReqType::PIPE_CREATE): {
 			if(logRequests)
 				std::cout << "posix: PIPE_CREATE" << std::endl;
 
@@ -2878,7 +3031,9 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 					helix::action(&send_resp, ser.data(), ser.size()));
 			co_await transmit.async_wait();
 			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::SETSID) {
+			break;
+		}
+		case request_stats::legacyKey(managarm::posix::CntReqType::SETSID): {
 			if(logRequests)
 				std::cout << "posix: SETSID" << std::endl;
 
@@ -2898,11 +3053,14 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 			auto [send_resp] = co_await helix_ng::exchangeMsgs(conversation,
 					helix_ng::sendBuffer(ser.data(), ser.size()));
 			HEL_CHECK(send_resp.error());
-		}else if(preamble.id() == managarm::posix::SocketRequest::message_id) {
+			break;
+		}
+		case request_stats::messageKey<managarm::posix::SocketRequest>(): {
 			auto req = bragi::parse_head_only<managarm::posix::SocketRequest>(recv_head);
 
 			if (!req) {
 				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+				decodingFailed = true;
 				break;
 			}
 
@@ -2920,7 +3078,7 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 						|| req->socktype() == SOCK_SEQPACKET);
 				assert(!req->protocol());
 
-				file = un_socket::createSocketFile(req->flags() & SOCK_NONBLOCK);
+				file = un_socket::createSocketFile(req->socktype(), req->flags() & SOCK_NONBLOCK);
 			}else if(req->domain() == AF_NETLINK) {
 				assert(req->socktype() == SOCK_RAW || req->socktype() == SOCK_DGRAM);
 				file = nl_socket::createSocketFile(req->protocol(), req->flags() & SOCK_NONBLOCK);
@@ -2945,11 +3103,14 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 				);
 
 			HEL_CHECK(send_resp.error());
-		}else if(preamble.id() == managarm::posix::SockpairRequest::message_id) {
+			break;
+		}
+		case request_stats::messageKey<managarm::posix::SockpairRequest>(): {
 			auto req = bragi::parse_head_only<managarm::posix::SockpairRequest>(recv_head);
 
 			if (!req) {
 				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+				decodingFailed = true;
 				break;
 			}
 
@@ -2967,7 +3128,7 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 					|| req->socktype() == SOCK_SEQPACKET);
 			assert(!req->protocol());
 
-			auto pair = un_socket::createSocketPair(self.get());
+			auto pair = un_socket::createSocketPair(self.get(), req->socktype());
 			auto fd0 = self->fileContext()->attachFile(std::get<0>(pair),
 					req->flags() & SOCK_CLOEXEC);
 			auto fd1 = self->fileContext()->attachFile(std::get<1>(pair),
@@ -2984,11 +3145,14 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 				);
 
 			HEL_CHECK(send_resp.error());
-		}else if(preamble.id() == managarm::posix::AcceptRequest::message_id) {
+			break;
+		}
+		case request_stats::messageKey<managarm::posix::AcceptRequest>(): {
 			auto req = bragi::parse_head_only<managarm::posix::AcceptRequest>(recv_head);
 
 			if (!req) {
 				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+				decodingFailed = true;
 				break;
 			}
 
@@ -3020,7 +3184,9 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 				);
 
 			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::EPOLL_CALL) {
+			break;
+		}
+		case request_stats::legacyKey(managarm::posix::CntReqType::EPOLL_CALL): {
 			if(logRequests)
 				std::cout << "posix: EPOLL_CALL" << std::endl;
 
@@ -3120,7 +3286,9 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 					helix::action(&send_resp, ser.data(), ser.size()));
 			co_await transmit.async_wait();
 			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::EPOLL_CREATE) {
+			break;
+		}
+		case request_stats::legacyKey(managarm::posix::CntReqType::EPOLL_CREATE): {
 			if(logRequests)
 				std::cout << "posix: EPOLL_CREATE" << std::endl;
 
@@ -3141,7 +3309,9 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 					helix::action(&send_resp, ser.data(), ser.size()));
 			co_await transmit.async_wait();
 			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::EPOLL_ADD) {
+			break;
+		}
+		case request_stats::legacyKey(managarm::posix::CntReqType::EPOLL_ADD): {
 			if(logRequests)
 				std::cout << "posix: EPOLL_ADD" << std::endl;
 
@@ -3172,7 +3342,9 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 					helix::action(&send_resp, ser.data(), ser.size()));
 			co_await transmit.async_wait();
 			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::EPOLL_MODIFY) {
+			break;
+		}
+		case request_stats::legacyKey(managarm::posix::CntReqType::EPOLL_MODIFY): {
 			if(logRequests)
 				std::cout << "posix: EPOLL_MODIFY" << std::endl;
 
@@ -3199,7 +3371,9 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 					helix::action(&send_resp, ser.data(), ser.size()));
 			co_await transmit.async_wait();
 			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::EPOLL_DELETE) {
+			break;
+		}
+		case request_stats::legacyKey(managarm::posix::CntReqType::EPOLL_DELETE): {
 			if(logRequests)
 				std::cout << "posix: EPOLL_DELETE" << std::endl;
 
@@ -3228,7 +3402,9 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 					helix::action(&send_resp, ser.data(), ser.size()));
 			co_await transmit.async_wait();
 			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::EPOLL_WAIT) {
+			break;
+		}
+		case request_stats::legacyKey(managarm::posix::CntReqType::EPOLL_WAIT): {
 			if(logRequests)
 				std::cout << "posix: EPOLL_WAIT request" << std::endl;
 
@@ -3276,7 +3452,9 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 					helix::action(&send_data, events, k * sizeof(struct epoll_event)));
 			co_await transmit.async_wait();
 			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::TIMERFD_CREATE) {
+			break;
+		}
+		case request_stats::legacyKey(managarm::posix::CntReqType::TIMERFD_CREATE): {
 			if(logRequests)
 				std::cout << "posix: TIMERFD_CREATE" << std::endl;
 
@@ -3296,7 +3474,9 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 					helix::action(&send_resp, ser.data(), ser.size()));
 			co_await transmit.async_wait();
 			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::TIMERFD_SETTIME) {
+			break;
+		}
+		case request_stats::legacyKey(managarm::posix::CntReqType::TIMERFD_SETTIME): {
 			if(logRequests)
 				std::cout << "posix: TIMERFD_SETTIME" << std::endl;
 
@@ -3316,7 +3496,9 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 					helix::action(&send_resp, ser.data(), ser.size()));
 			co_await transmit.async_wait();
 			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::SIGNALFD_CREATE) {
+			break;
+		}
+		case request_stats::legacyKey(managarm::posix::CntReqType::SIGNALFD_CREATE): {
 			if(logRequests)
 				std::cout << "posix: SIGNALFD_CREATE" << std::endl;
 
@@ -3342,11 +3524,14 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 					helix::action(&send_resp, ser.data(), ser.size()));
 			co_await transmit.async_wait();
 			HEL_CHECK(send_resp.error());
-		}else if(preamble.id() == managarm::posix::InotifyCreateRequest::message_id) {
+			break;
+		}
+		case request_stats::messageKey<managarm::posix::InotifyCreateRequest>(): {
 			auto req = bragi::parse_head_only<managarm::posix::InotifyCreateRequest>(recv_head);
 
 			if (!req) {
 				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+				decodingFailed = true;
 				break;
 			}
 
@@ -3369,7 +3554,9 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 				);
 
 			HEL_CHECK(send_resp.error());
-		}else if(preamble.id() == managarm::posix::InotifyAddRequest::message_id) {
+			break;
+		}
+		case request_stats::messageKey<managarm::posix::InotifyAddRequest>(): {
 			std::vector<std::byte> tail(preamble.tail_size());
 			auto [recv_tail] = co_await helix_ng::exchangeMsgs(
 					conversation,
@@ -3381,6 +3568,7 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 
 			if (!req) {
 				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+				decodingFailed = true;
 				break;
 			}
 
@@ -3424,11 +3612,14 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 				);
 
 			HEL_CHECK(send_resp.error());
-		}else if(preamble.id() == managarm::posix::EventfdCreateRequest::message_id) {
+			break;
+		}
+		case request_stats::messageKey<managarm::posix::EventfdCreateRequest>(): {
 			auto req = bragi::parse_head_only<managarm::posix::EventfdCreateRequest>(recv_head);
 
 			if (!req) {
 				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+				decodingFailed = true;
 				break;
 			}
 
@@ -3457,7 +3648,9 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 				);
 
 			HEL_CHECK(send_resp.error());
-		}else if(preamble.id() == managarm::posix::MknodAtRequest::message_id) {
+			break;
+		}
+		case request_stats::messageKey<managarm::posix::MknodAtRequest>(): {
 			std::vector<std::byte> tail(preamble.tail_size());
 			auto [recv_tail] = co_await helix_ng::exchangeMsgs(
 					conversation,
@@ -3469,6 +3662,7 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 
 			if(!req) {
 				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+				decodingFailed = true;
 				break;
 			}
 
@@ -3596,11 +3790,14 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 				);
 
 			HEL_CHECK(send_resp.error());
-		}else if(preamble.id() == managarm::posix::GetPgidRequest::message_id) {
+			break;
+		}
+		case request_stats::messageKey<managarm::posix::GetPgidRequest>(): {
 			auto req = bragi::parse_head_only<managarm::posix::GetPgidRequest>(recv_head);
 
 			if (!req) {
 				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+				decodingFailed = true;
 				break;
 			}
 
@@ -3628,11 +3825,14 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 				);
 
 			HEL_CHECK(send_resp.error());
-		}else if(preamble.id() == managarm::posix::SetPgidRequest::message_id) {
+			break;
+		}
+		case request_stats::messageKey<managarm::posix::SetPgidRequest>(): {
 			auto req = bragi::parse_head_only<managarm::posix::SetPgidRequest>(recv_head);
 
 			if (!req) {
 				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+				decodingFailed = true;
 				break;
 			}
 
@@ -3699,11 +3899,14 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 				);
 
 			HEL_CHECK(send_resp.error());
-		}else if(preamble.id() == managarm::posix::GetSidRequest::message_id) {
+			break;
+		}
+		case request_stats::messageKey<managarm::posix::GetSidRequest>(): {
 			auto req = bragi::parse_head_only<managarm::posix::GetSidRequest>(recv_head);
 
 			if (!req) {
 				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+				decodingFailed = true;
 				break;
 			}
 
@@ -3730,7 +3933,9 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 				);
 
 			HEL_CHECK(send_resp.error());
-		}else if(preamble.id() == managarm::posix::MemFdCreateRequest::message_id) {
+			break;
+		}
+		case request_stats::messageKey<managarm::posix::MemFdCreateRequest>(): {
 			managarm::posix::SvrResponse resp;
 			std::vector<std::byte> tail(preamble.tail_size());
 			auto [recv_tail] = co_await helix_ng::exchangeMsgs(
@@ -3743,6 +3948,7 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 
 			if (!req) {
 				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+				decodingFailed = true;
 				break;
 			}
 
@@ -3775,7 +3981,264 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 					helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
 				);
 			HEL_CHECK(sendResp.error());
-		}else{
+			break;
+		}
+		case request_stats::messageKey<managarm::posix::SetSchedulerRequest>(): {
+			auto req = bragi::parse_head_only<managarm::posix::SetSchedulerRequest>(recv_head);
+			if(!req) {
+				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+				decodingFailed = true;
+				break;
+			}
+			if(logRequests)
+				std::cout << "posix: SET_SCHEDULER " << req->pid()
+						<< ", policy: " << req->policy() << std::endl;
+
+			std::shared_ptr<Process> target;
+			if(req->pid()) {
+				target = Process::findProcess(req->pid());
+				if(!target) {
+					co_await sendErrorResponse(managarm::posix::Errors::NO_SUCH_RESOURCE);
+					continue;
+				}
+			}else{
+				target = self;
+			}
+
+			HelSchedParams params{};
+			switch(req->policy()) {
+			case managarm::posix::SchedPolicy::SCHED_OTHER:
+			case managarm::posix::SchedPolicy::SCHED_BATCH:
+			case managarm::posix::SchedPolicy::SCHED_IDLE:
+				params.policy = kHelSchedFair;
+				break;
+			case managarm::posix::SchedPolicy::SCHED_FIFO:
+				params.policy = kHelSchedFifo;
+				params.priority = req->priority();
+				break;
+			case managarm::posix::SchedPolicy::SCHED_RR:
+				params.policy = kHelSchedRoundRobin;
+				params.priority = req->priority();
+				break;
+			case managarm::posix::SchedPolicy::SCHED_DEADLINE:
+				params.policy = kHelSchedDeadline;
+				params.runtime = req->runtime();
+				params.deadline = req->deadline();
+				// As on Linux, the period defaults to the deadline.
+				params.period = req->period() ? req->period() : req->deadline();
+				break;
+			default:
+				co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+				continue;
+			}
+			if(params.policy == kHelSchedFair && req->priority()) {
+				co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+				continue;
+			}
+
+			// Only privileged processes may use the real-time and deadline policies
+			// or change the policy of processes of other users.
+			if(self->euid() != 0
+					&& (params.policy != kHelSchedFair || self->euid() != target->uid())) {
+				co_await sendErrorResponse(managarm::posix::Errors::INSUFFICIENT_PERMISSION);
+				continue;
+			}
+
+			auto error = helSetSchedParams(target->threadDescriptor().getHandle(), &params);
+			if(error == kHelErrIllegalArgs) {
+				co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+				continue;
+			}else if(error == kHelErrNoBandwidth) {
+				co_await sendErrorResponse(managarm::posix::Errors::RESOURCE_IN_USE);
+				continue;
+			}
+			HEL_CHECK(error);
+			if(params.policy == kHelSchedFair)
+				target->setFairSchedPolicy(req->policy());
+
+			managarm::posix::SvrResponse resp;
+			resp.set_error(managarm::posix::Errors::SUCCESS);
+
+			auto [sendResp] = co_await helix_ng::exchangeMsgs(
+					conversation,
+					helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
+				);
+			HEL_CHECK(sendResp.error());
+			break;
+		}
+		case request_stats::messageKey<managarm::posix::GetSchedulerRequest>(): {
+			auto req = bragi::parse_head_only<managarm::posix::GetSchedulerRequest>(recv_head);
+			if(!req) {
+				std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+				decodingFailed = true;
+				break;
+			}
+			if(logRequests)
+				std::cout << "posix: GET_SCHEDULER " << req->pid() << std::endl;
+
+			std::shared_ptr<Process> target;
+			if(req->pid()) {
+				target = Process::findProcess(req->pid());
+				if(!target) {
+					co_await sendErrorResponse(managarm::posix::Errors::NO_SUCH_RESOURCE);
+					continue;
+				}
+			}else{
+				target = self;
+			}
+
+			HelSchedParams params;
+			HEL_CHECK(helGetSchedParams(target->threadDescriptor().getHandle(), &params));
+
+			managarm::posix::SvrResponse resp;
+			resp.set_error(managarm::posix::Errors::SUCCESS);
+			switch(params.policy) {
+			case kHelSchedFifo:
+				resp.set_sched_policy(managarm::posix::SchedPolicy::SCHED_FIFO);
+				resp.set_sched_priority(params.priority);
+				break;
+			case kHelSchedRoundRobin:
+				resp.set_sched_policy(managarm::posix::SchedPolicy::SCHED_RR);
+				resp.set_sched_priority(params.priority);
+				break;
+			case kHelSchedDeadline:
+				resp.set_sched_policy(managarm::posix::SchedPolicy::SCHED_DEADLINE);
+				resp.set_sched_runtime(params.runtime);
+				resp.set_sched_deadline(params.deadline);
+				resp.set_sched_period(params.period);
+				break;
+			default:
+				resp.set_sched_policy(target->fairSchedPolicy());
+				break;
+			}
+
+			auto [sendResp] = co_await helix_ng::exchangeMsgs(
+					conversation,
+					helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
+				);
+			HEL_CHECK(sendResp.error());
+			break;
+		}
+		case request_stats::messageKey<managarm::posix::SpliceRequest>():
+		case request_stats::messageKey<managarm::posix::TeeRequest>():
+		case request_stats::messageKey<managarm::posix::VmspliceRequest>(): {
+			frg::expected<Error, size_t> result = 0;
+			if(requestKey == request_stats::messageKey<managarm::posix::SpliceRequest>()) {
+				auto req = bragi::parse_head_only<managarm::posix::SpliceRequest>(recv_head);
+				if(!req) {
+					std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+					decodingFailed = true;
+					break;
+				}
+				if(logRequests)
+					std::cout << "posix: SPLICE " << req->fd_in() << " -> " << req->fd_out() << std::endl;
+
+				auto in = self->fileContext()->getFile(req->fd_in());
+				auto out = self->fileContext()->getFile(req->fd_out());
+				if(!in || !out) {
+					co_await sendErrorResponse(managarm::posix::Errors::NO_SUCH_FD);
+					continue;
+				}
+
+				std::optional<int64_t> inOffset, outOffset;
+				if(req->off_in() != -1)
+					inOffset = req->off_in();
+				if(req->off_out() != -1)
+					outOffset = req->off_out();
+				if((inOffset && *inOffset < 0) || (outOffset && *outOffset < 0)) {
+					co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+					continue;
+				}
+
+				result = co_await fifo::splice(self.get(), std::move(in), inOffset, std::move(out), outOffset,
+						req->size(), req->flags() & managarm::posix::SpliceFlags::SF_NONBLOCK);
+			}else if(requestKey == request_stats::messageKey<managarm::posix::TeeRequest>()) {
+				auto req = bragi::parse_head_only<managarm::posix::TeeRequest>(recv_head);
+				if(!req) {
+					std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+					decodingFailed = true;
+					break;
+				}
+				if(logRequests)
+					std::cout << "posix: TEE " << req->fd_in() << " -> " << req->fd_out() << std::endl;
+
+				auto in = self->fileContext()->getFile(req->fd_in());
+				auto out = self->fileContext()->getFile(req->fd_out());
+				if(!in || !out) {
+					co_await sendErrorResponse(managarm::posix::Errors::NO_SUCH_FD);
+					continue;
+				}
+
+				result = co_await fifo::tee(std::move(in), std::move(out), req->size(),
+						req->flags() & managarm::posix::SpliceFlags::SF_NONBLOCK);
+			}else{
+				std::vector<std::byte> tail(preamble.tail_size());
+				auto [recv_tail] = co_await helix_ng::exchangeMsgs(
+						conversation,
+						helix_ng::recvBuffer(tail.data(), tail.size())
+					);
+				HEL_CHECK(recv_tail.error());
+
+				auto req = bragi::parse_head_tail<managarm::posix::VmspliceRequest>(recv_head, tail);
+				if(!req) {
+					std::cout << "posix: Rejecting request due to decoding failure" << std::endl;
+					decodingFailed = true;
+					break;
+				}
+				if(logRequests)
+					std::cout << "posix: VMSPLICE " << req->fd() << std::endl;
+
+				auto out = self->fileContext()->getFile(req->fd());
+				if(!out) {
+					co_await sendErrorResponse(managarm::posix::Errors::NO_SUCH_FD);
+					continue;
+				}
+				if(req->iov_bases().size() != req->iov_lengths().size()) {
+					co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+					continue;
+				}
+
+				std::vector<fifo::UserBuffer> buffers;
+				for(size_t i = 0; i < req->iov_bases().size(); i++)
+					buffers.push_back({req->iov_bases()[i], req->iov_lengths()[i]});
+
+				result = co_await fifo::vmsplice(self.get(), std::move(out), std::move(buffers),
+						req->flags() & managarm::posix::SpliceFlags::SF_NONBLOCK);
+			}
+
+			if(!result) {
+				switch(result.error()) {
+				case Error::wouldBlock:
+					co_await sendErrorResponse(managarm::posix::Errors::WOULD_BLOCK);
+					break;
+				case Error::brokenPipe:
+					co_await sendErrorResponse(managarm::posix::Errors::BROKEN_PIPE);
+					break;
+				case Error::seekOnPipe:
+					co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_OPERATION_TARGET);
+					break;
+				case Error::badFd:
+					co_await sendErrorResponse(managarm::posix::Errors::BAD_FD);
+					break;
+				default:
+					co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+					break;
+				}
+				continue;
+			}
+
+			managarm::posix::SvrResponse resp;
+			resp.set_error(managarm::posix::Errors::SUCCESS);
+			resp.set_size(result.value());
+
+			auto [sendResp] = co_await helix_ng::exchangeMsgs(
+					conversation,
+					helix_ng::sendBragiHeadOnly(resp, frg::stl_allocator{})
+				);
+			HEL_CHECK(sendResp.error());
+			break;
+		}
+		default: {
 			std::cout << "posix: Illegal request" << std::endl;
 			helix::SendBuffer send_resp;
 
@@ -3788,8 +4251,14 @@ async::result<void> serveRequests(std::shared_ptr<Process> self,
 			co_await transmit.async_wait();
 			HEL_CHECK(send_resp.error());
 		}
+		}
+
+		if(decodingFailed)
+			break;
 	}
 
+	co_await workers::switchToHome();
+
 	if(logCleanup)
 		std::cout << "\e[33mposix: Exiting serveRequests()\e[39m" << std::endl;
 	generation->requestsDone.raise();
@@ -3803,6 +4272,8 @@ async::result<void> serve(std::shared_ptr<Process> self, std::shared_ptr<Generat
 	auto res = globalCredentialsMap.insert({creds, self});
 	assert(res.second);
 
+	generation->worker = workers::pick();
+
 	co_await async::when_all(
 		observeThread(self, generation),
 		serveSignals(self, generation),
@@ -3817,32 +4288,36 @@ namespace {
 	helix::UniqueLane kerncfgLane;
 };
 
+async::result<std::string> fetchCmdline() {
+	helix::Offer offer;
+	helix::SendBuffer send_req;
+	helix::RecvInline recv_resp;
+	helix::RecvInline recv_cmdline;
+
+	managarm::kerncfg::CntRequest req;
+	req.set_req_type(managarm::kerncfg::CntReqType::GET_CMDLINE);
+
+	auto ser = req.SerializeAsString();
+	auto &&transmit = helix::submitAsync(kerncfgLane, helix::Dispatcher::global(),
+			helix::action(&offer, kHelItemAncillary),
+			helix::action(&send_req, ser.data(), ser.size(), kHelItemChain),
+			helix::action(&recv_resp, kHelItemChain),
+			helix::action(&recv_cmdline));
+	co_await transmit.async_wait();
+	HEL_CHECK(offer.error());
+	HEL_CHECK(send_req.error());
+	HEL_CHECK(recv_resp.error());
+	HEL_CHECK(recv_cmdline.error());
+
+	managarm::kerncfg::SvrResponse resp;
+	resp.ParseFromArray(recv_resp.data(), recv_resp.length());
+	assert(resp.error() == managarm::kerncfg::Error::SUCCESS);
+	co_return std::string{(const char *)recv_cmdline.data(), recv_cmdline.length()};
+}
+
 struct CmdlineNode final : public procfs::RegularNode {
 	async::result<std::string> show() override {
-		helix::Offer offer;
-		helix::SendBuffer send_req;
-		helix::RecvInline recv_resp;
-		helix::RecvInline recv_cmdline;
-
-		managarm::kerncfg::CntRequest req;
-		req.set_req_type(managarm::kerncfg::CntReqType::GET_CMDLINE);
-
-		auto ser = req.SerializeAsString();
-		auto &&transmit = helix::submitAsync(kerncfgLane, helix::Dispatcher::global(),
-				helix::action(&offer, kHelItemAncillary),
-				helix::action(&send_req, ser.data(), ser.size(), kHelItemChain),
-				helix::action(&recv_resp, kHelItemChain),
-				helix::action(&recv_cmdline));
-		co_await transmit.async_wait();
-		HEL_CHECK(offer.error());
-		HEL_CHECK(send_req.error());
-		HEL_CHECK(recv_resp.error());
-		HEL_CHECK(recv_cmdline.error());
-
-		managarm::kerncfg::SvrResponse resp;
-		resp.ParseFromArray(recv_resp.data(), recv_resp.length());
-		assert(resp.error() == managarm::kerncfg::Error::SUCCESS);
-		co_return std::string{(const char *)recv_cmdline.data(), recv_cmdline.length()} + '\n';
+		co_return (co_await fetchCmdline()) + '\n';
 	}
 
 	async::result<void> store(std::string) override {
@@ -3850,6 +4325,24 @@ struct CmdlineNode final : public procfs::RegularNode {
 	}
 };
 
+struct DentryCacheNode final : public procfs::RegularNode {
+	async::result<std::string> show() override {
+		auto &stats = dentryCache().statistics();
+		std::stringstream stream;
+		stream << "hits " << stats.hits << "\n";
+		stream << "negative_hits " << stats.negativeHits << "\n";
+		stream << "misses " << stats.misses << "\n";
+		stream << "invalidations " << stats.invalidations << "\n";
+		stream << "evictions " << stats.evictions << "\n";
+		stream << "stale_inserts " << stats.staleInserts << "\n";
+		co_return stream.str();
+	}
+
+	async::result<void> store(std::string) override {
+		throw std::runtime_error("Cannot store to /proc/posix-dentries");
+	}
+};
+
 async::result<void> enumerateKerncfg() {
 	auto root = co_await mbus::Instance::global().getRoot();
 
@@ -3872,12 +4365,31 @@ async::result<void> enumerateKerncfg() {
 	procfs_root->directMkregular("cmdline", std::make_shared<CmdlineNode>());
 }
 
+// Starts the number of workers requested by "posix.workers=N" on the kernel command line.
+async::result<void> startWorkers() {
+	unsigned int count = 0;
+
+	auto cmdline = co_await fetchCmdline();
+	std::istringstream stream{cmdline};
+	std::string option;
+	while(stream >> option) {
+		if(option.starts_with("posix.workers="))
+			count = std::max(0, atoi(option.c_str() + strlen("posix.workers=")));
+	}
+
+	workers::start(count);
+
+	auto procfs_root = std::static_pointer_cast<procfs::DirectoryNode>(getProcfs()->getTarget());
+	procfs_root->directMkregular("posix-workers", workers::createStatsNode());
+}
+
 // --------------------------------------------------------
 // main() function
 // --------------------------------------------------------
 
 async::detached runInit() {
 	co_await enumerateKerncfg();
+	co_await startWorkers();
 	co_await clk::enumerateTracker();
 	async::detach(net::enumerateNetserver());
 	co_await populateRootView();
@@ -3904,6 +4416,10 @@ int main() {
 	input_subsystem::run();
 	pci_subsystem::run();
 
+	auto procfs_root = std::static_pointer_cast<procfs::DirectoryNode>(getProcfs()->getTarget());
+	procfs_root->directMkregular("posix-requests", request_stats::createStatsNode());
+	procfs_root->directMkregular("posix-dentries", std::make_shared<DentryCacheNode>());
+
 	runInit();
 
 	async::run_forever(helix::currentDispatcher);
@@ -0,0 +1,156 @@
+#include <string.h>
+#include <algorithm>
+#include <bit>
+
+#include "pipe-buffer.hpp"
+
+namespace pipe_buffer {
+
+namespace {
+
+// Keep freed pages around such that pipes do not hit malloc() on every write.
+constexpr size_t maxCachedPages = 256;
+
+std::vector<Page *> freePages;
+
+} // anonymous namespace
+
+// ----------------------------------------------------------------------------
+// PageRef.
+// ----------------------------------------------------------------------------
+
+PageRef PageRef::allocate() {
+	Page *page;
+	if(!freePages.empty()) {
+		page = freePages.back();
+		freePages.pop_back();
+	}else{
+		page = new Page;
+	}
+	page->refCount = 1;
+	return PageRef{page};
+}
+
+void PageRef::_release() {
+	assert(_page->refCount);
+	if(--_page->refCount)
+		return;
+
+	if(freePages.size() < maxCachedPages) {
+		freePages.push_back(_page);
+	}else{
+		delete _page;
+	}
+}
+
+// ----------------------------------------------------------------------------
+// Ring.
+// ----------------------------------------------------------------------------
+
+Ring::Ring(size_t capacity) {
+	auto success = setCapacity(capacity);
+	assert(success);
+}
+
+size_t Ring::space() const {
+	size_t space = (_slots.size() - _count) * pageSize;
+	if(_count) {
+		auto &tail = peek(_count - 1);
+		if(tail.page.isExclusive())
+			space += pageSize - (tail.offset + tail.length);
+	}
+	return space;
+}
+
+bool Ring::setCapacity(size_t capacity) {
+	size_t numSlots = std::bit_ceil(std::max((capacity + pageSize - 1) / pageSize, size_t{1}));
+	if(numSlots < _count)
+		return false;
+
+	std::vector<Segment> slots(numSlots);
+	for(size_t i = 0; i < _count; i++)
+		slots[i] = std::move(_at(i));
+	_slots = std::move(slots);
+	_head = 0;
+	return true;
+}
+
+size_t Ring::write(const void *data, size_t length) {
+	auto source = reinterpret_cast<const char *>(data);
+	size_t progress = 0;
+
+	if(_count) {
+		auto &tail = _at(_count - 1);
+		if(tail.page.isExclusive()) {
+			auto end = tail.offset + tail.length;
+			auto chunk = std::min(pageSize - end, length);
+			memcpy(tail.page.data() + end, source, chunk);
+			tail.length += chunk;
+			progress += chunk;
+		}
+	}
+
+	while(progress < length && _count < _slots.size()) {
+		auto chunk = std::min(pageSize, length - progress);
+		auto page = PageRef::allocate();
+		memcpy(page.data(), source + progress, chunk);
+		_at(_count) = Segment{std::move(page), 0, chunk};
+		_count++;
+		progress += chunk;
+	}
+
+	_size += progress;
+	return progress;
+}
+
+size_t Ring::read(void *data, size_t length) {
+	auto dest = reinterpret_cast<char *>(data);
+	size_t progress = 0;
+	while(progress < length && _count) {
+		auto &front = _at(0);
+		auto chunk = std::min(front.length, length - progress);
+		memcpy(dest + progress, front.data(), chunk);
+		progress += chunk;
+		pop(chunk);
+	}
+	return progress;
+}
+
+bool Ring::push(Segment segment) {
+	assert(segment.length);
+	if(_count == _slots.size())
+		return false;
+
+	_size += segment.length;
+	_at(_count) = std::move(segment);
+	_count++;
+	return true;
+}
+
+Segment Ring::pop(size_t length) {
+	assert(_count);
+	auto &front = _at(0);
+
+	Segment result;
+	if(length >= front.length) {
+		result = std::move(front);
+		front = Segment{};
+		_head = (_head + 1) & (_slots.size() - 1);
+		_count--;
+	}else{
+		// Split the segment; both parts share the page.
+		result = Segment{front.page, front.offset, length};
+		front.offset += length;
+		front.length -= length;
+	}
+
+	_size -= result.length;
+	return result;
+}
+
+void Ring::clear() {
+	while(_count)
+		pop(_at(0).length);
+}
+
+} // namespace pipe_buffer
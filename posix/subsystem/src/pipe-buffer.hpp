@@ -0,0 +1,154 @@
+#pragma once
+
+#include <assert.h>
+#include <stddef.h>
+#include <utility>
+#include <vector>
+
+// Page-based buffers for pipes and UNIX sockets.
+// Data is stored in reference counted pages; splice() and tee() move or share
+// page references between buffers instead of copying the data.
+namespace pipe_buffer {
+
+inline constexpr size_t pageSize = 0x1000;
+
+// Linux defaults to 16 pages per pipe.
+inline constexpr size_t defaultCapacity = 16 * pageSize;
+
+// Upper bound for F_SETPIPE_SZ (matches Linux' default /proc/sys/fs/pipe-max-size).
+inline constexpr size_t maxCapacity = 0x100000;
+
+struct Page {
+	unsigned int refCount;
+	char data[pageSize];
+};
+
+// Owning reference to a Page. Pages are returned to a free list once
+// the last reference is dropped.
+struct PageRef {
+	static PageRef allocate();
+
+	PageRef()
+	: _page{nullptr} { }
+
+	PageRef(const PageRef &other)
+	: _page{other._page} {
+		if(_page)
+			_page->refCount++;
+	}
+
+	PageRef(PageRef &&other)
+	: _page{std::exchange(other._page, nullptr)} { }
+
+	~PageRef() {
+		if(_page)
+			_release();
+	}
+
+	PageRef &operator= (PageRef other) {
+		std::swap(_page, other._page);
+		return *this;
+	}
+
+	explicit operator bool () const {
+		return _page;
+	}
+
+	char *data() const {
+		return _page->data;
+	}
+
+	// True if no other buffer references this page, i.e., the page may be written to.
+	bool isExclusive() const {
+		return _page->refCount == 1;
+	}
+
+private:
+	explicit PageRef(Page *page)
+	: _page{page} { }
+
+	void _release();
+
+	Page *_page;
+};
+
+struct Segment {
+	const char *data() const {
+		return page.data() + offset;
+	}
+
+	PageRef page;
+	size_t offset = 0;
+	size_t length = 0;
+};
+
+// Fixed-capacity ring of segments. Each segment occupies one slot (i.e., one page
+// of the capacity), regardless of its length. This matches the Linux semantics
+// of F_SETPIPE_SZ.
+struct Ring {
+	explicit Ring(size_t capacity = defaultCapacity);
+
+	Ring(const Ring &) = delete;
+	Ring &operator= (const Ring &) = delete;
+
+	size_t capacity() const {
+		return _slots.size() * pageSize;
+	}
+
+	// Number of bytes that are currently buffered.
+	size_t size() const {
+		return _size;
+	}
+
+	bool empty() const {
+		return !_size;
+	}
+
+	size_t numSegments() const {
+		return _count;
+	}
+
+	bool hasFreeSlot() const {
+		return _count < _slots.size();
+	}
+
+	// Number of bytes that can be written without blocking.
+	size_t space() const;
+
+	// Changes the number of slots. Fails if the buffered data does not fit.
+	// The capacity is rounded up to a power of two number of pages.
+	bool setCapacity(size_t capacity);
+
+	// Copies data into the ring. Appends to the last page if it is not shared.
+	// Returns the number of bytes that were written.
+	size_t write(const void *data, size_t length);
+
+	// Copies data out of the ring and consumes it.
+	size_t read(void *data, size_t length);
+
+	// Appends a segment without copying. Returns false if all slots are in use.
+	bool push(Segment segment);
+
+	// Removes up to length bytes from the front of the ring without copying.
+	Segment pop(size_t length);
+
+	// Returns the n-th segment (counted from the front of the ring).
+	const Segment &peek(size_t n) const {
+		assert(n < _count);
+		return _slots[(_head + n) & (_slots.size() - 1)];
+	}
+
+	void clear();
+
+private:
+	Segment &_at(size_t n) {
+		return _slots[(_head + n) & (_slots.size() - 1)];
+	}
+
+	std::vector<Segment> _slots;
+	size_t _head = 0;
+	size_t _count = 0;
+	size_t _size = 0;
+};
+
+} // namespace pipe_buffer
@@ -1,4 +1,5 @@
 
+#include <sched.h>
 #include <signal.h>
 #include <string.h>
 
@@ -344,9 +345,12 @@ std::shared_ptr<FileContext> FileContext::clone(std::shared_ptr<FileContext> ori
 	context->_fileTableMemory = helix::UniqueDescriptor(memory);
 	context->_fileTableWindow = reinterpret_cast<HelHandle *>(window);
 
-	for(auto entry : original->_fileTable) {
-		//std::cout << "Clone FD " << entry.first << std::endl;
-		context->attachFile(entry.first, entry.second.file, entry.second.closeOnExec);
+	{
+		std::lock_guard lock{original->_mutex};
+		for(auto entry : original->_fileTable) {
+			//std::cout << "Clone FD " << entry.first << std::endl;
+			context->_attachFile(entry.first, entry.second.file, entry.second.closeOnExec);
+		}
 	}
 
 	HEL_CHECK(helTransferDescriptor(posixMbusClient,
@@ -362,42 +366,12 @@ FileContext::~FileContext() {
 
 int FileContext::attachFile(smarter::shared_ptr<File, FileHandle> file,
 		bool close_on_exec) {
-	HelHandle handle;
-	HEL_CHECK(helTransferDescriptor(file->getPassthroughLane().getHandle(),
-			_universe.getHandle(), &handle));
-
-	for(int fd = 0; ; fd++) {
-		if(_fileTable.find(fd) != _fileTable.end())
-			continue;
-
-		if(logFileAttach)
-			std::cout << "posix: Attaching FD " << fd << std::endl;
-
-		_fileTable.insert({fd, {std::move(file), close_on_exec}});
-		_fileTableWindow[fd] = handle;
-		return fd;
-	}
-}
-
-void FileContext::attachFile(int fd, smarter::shared_ptr<File, FileHandle> file,
-		bool close_on_exec) {
-	HelHandle handle;
-	HEL_CHECK(helTransferDescriptor(file->getPassthroughLane().getHandle(),
-			_universe.getHandle(), &handle));
-
-	if(logFileAttach)
-		std::cout << "posix: Attaching fixed FD " << fd << std::endl;
-
-	auto it = _fileTable.find(fd);
-	if(it != _fileTable.end()) {
-		it->second = {std::move(file), close_on_exec};
-	}else{
-		_fileTable.insert({fd, {std::move(file), close_on_exec}});
-	}
-	_fileTableWindow[fd] = handle;
+	std::lock_guard lock{_mutex};
+	return _attachFile(std::move(file), close_on_exec);
 }
 
 std::optional<FileDescriptor> FileContext::getDescriptor(int fd) {
+	std::lock_guard lock{_mutex};
 	auto file = _fileTable.find(fd);
 	if(file == _fileTable.end())
 		return std::nullopt;
@@ -405,6 +379,7 @@ std::optional<FileDescriptor> FileContext::getDescriptor(int fd) {
 }
 
 Error FileContext::setDescriptor(int fd, bool close_on_exec) {
+	std::lock_guard lock{_mutex};
 	auto it = _fileTable.find(fd);
 	if(it == _fileTable.end()) {
 		return Error::noSuchFile;
@@ -414,35 +389,63 @@ Error FileContext::setDescriptor(int fd, bool close_on_exec) {
 }
 
 smarter::shared_ptr<File, FileHandle> FileContext::getFile(int fd) {
+	std::lock_guard lock{_mutex};
 	auto file = _fileTable.find(fd);
 	if(file == _fileTable.end())
 		return smarter::shared_ptr<File, FileHandle>{};
 	return file->second.file;
 }
 
-void FileContext::closeFile(int fd) {
+frg::expected<Error, int> FileContext::duplicateFile(int fd, bool close_on_exec) {
+	std::lock_guard lock{_mutex};
+	auto it = _fileTable.find(fd);
+	if(it == _fileTable.end())
+		return Error::noSuchFile;
+	// The table keeps a reference, hence the copy is never the last one.
+	return _attachFile(it->second.file, close_on_exec);
+}
+
+frg::expected<Error, smarter::shared_ptr<File, FileHandle>>
+FileContext::duplicateFileTo(int fd, int newfd) {
+	if(newfd < 0)
+		return Error::badFd;
+	std::lock_guard lock{_mutex};
+	auto it = _fileTable.find(fd);
+	if(it == _fileTable.end())
+		return Error::noSuchFile;
+	return _attachFile(newfd, it->second.file, false);
+}
+
+smarter::shared_ptr<File, FileHandle> FileContext::closeFile(int fd) {
 	if(logFileAttach)
 		std::cout << "posix: Closing FD " << fd << std::endl;
+	std::lock_guard lock{_mutex};
 	auto it = _fileTable.find(fd);
 	if(it == _fileTable.end()) {
 		std::cout << "\e[31m" "posix: Trying to close non-existant FD "
 				<< fd << "\e[39m" << std::endl;
-		return;
+		return smarter::shared_ptr<File, FileHandle>{};
 	}
 
 	HEL_CHECK(helCloseDescriptor(_universe.getHandle(), _fileTableWindow[fd]));
 
 	_fileTableWindow[fd] = 0;
+	auto file = std::move(it->second.file);
 	_fileTable.erase(it);
+	return file;
 }
 
 void FileContext::closeOnExec() {
+	// Declared before the lock such that the files are released without holding _mutex.
+	std::vector<smarter::shared_ptr<File, FileHandle>> closed;
+	std::lock_guard lock{_mutex};
 	auto it = _fileTable.begin();
 	while(it != _fileTable.end()) {
 		if(it->second.closeOnExec) {
 			HEL_CHECK(helCloseDescriptor(_universe.getHandle(), _fileTableWindow[it->first]));
 
 			_fileTableWindow[it->first] = 0;
+			closed.push_back(std::move(it->second.file));
 			it = _fileTable.erase(it);
 		}else{
 			it++;
@@ -450,6 +453,46 @@ void FileContext::closeOnExec() {
 	}
 }
 
+int FileContext::_attachFile(smarter::shared_ptr<File, FileHandle> file,
+		bool close_on_exec) {
+	HelHandle handle;
+	HEL_CHECK(helTransferDescriptor(file->getPassthroughLane().getHandle(),
+			_universe.getHandle(), &handle));
+
+	for(int fd = 0; ; fd++) {
+		if(_fileTable.find(fd) != _fileTable.end())
+			continue;
+
+		if(logFileAttach)
+			std::cout << "posix: Attaching FD " << fd << std::endl;
+
+		_fileTable.insert({fd, {std::move(file), close_on_exec}});
+		_fileTableWindow[fd] = handle;
+		return fd;
+	}
+}
+
+smarter::shared_ptr<File, FileHandle> FileContext::_attachFile(int fd,
+		smarter::shared_ptr<File, FileHandle> file, bool close_on_exec) {
+	HelHandle handle;
+	HEL_CHECK(helTransferDescriptor(file->getPassthroughLane().getHandle(),
+			_universe.getHandle(), &handle));
+
+	if(logFileAttach)
+		std::cout << "posix: Attaching fixed FD " << fd << std::endl;
+
+	smarter::shared_ptr<File, FileHandle> previous;
+	auto it = _fileTable.find(fd);
+	if(it != _fileTable.end()) {
+		previous = std::move(it->second.file);
+		it->second = {std::move(file), close_on_exec};
+	}else{
+		_fileTable.insert({fd, {std::move(file), close_on_exec}});
+	}
+	_fileTableWindow[fd] = handle;
+	return previous;
+}
+
 // ----------------------------------------------------------------------------
 // SignalContext.
 // ----------------------------------------------------------------------------
@@ -839,6 +882,8 @@ async::result<std::shared_ptr<Process>> Process::init(std::string path) {
 	auto process = std::make_shared<Process>(std::move(hull), nullptr);
 	process->_path = path;
 	process->_vmContext = VmContext::create();
+	HEL_CHECK(helSetSpaceName(process->_vmContext->getSpace().getHandle(),
+			path.data(), path.size()));
 	process->_fsContext = FsContext::create();
 	process->_fileContext = FileContext::create();
 	process->_signalContext = SignalContext::create();
@@ -875,6 +920,7 @@ async::result<std::shared_ptr<Process>> Process::init(std::string path) {
 	process->_euid = 0;
 	process->_gid = 0;
 	process->_egid = 0;
+	process->_fairSchedPolicy = SCHED_OTHER;
 	process->_hull->initializeProcess(process.get());
 
 	// TODO: Do not pass an empty argument vector?
@@ -910,6 +956,8 @@ std::shared_ptr<Process> Process::fork(std::shared_ptr<Process> original) {
 	auto process = std::make_shared<Process>(std::move(hull), original.get());
 	process->_path = original->path();
 	process->_vmContext = VmContext::clone(original->_vmContext);
+	HEL_CHECK(helSetSpaceName(process->_vmContext->getSpace().getHandle(),
+			process->_path.data(), process->_path.size()));
 	process->_fsContext = FsContext::clone(original->_fsContext);
 	process->_fileContext = FileContext::clone(original->_fileContext);
 	process->_signalContext = SignalContext::clone(original->_signalContext);
@@ -948,6 +996,7 @@ std::shared_ptr<Process> Process::fork(std::shared_ptr<Process> original) {
 	process->_euid = original->_euid;
 	process->_gid = original->_gid;
 	process->_egid = original->_egid;
+	process->_fairSchedPolicy = original->_fairSchedPolicy;
 	original->_children.push_back(process);
 	process->_hull->initializeProcess(process.get());
 	process->_didExecute = false;
@@ -1008,6 +1057,7 @@ std::shared_ptr<Process> Process::clone(std::shared_ptr<Process> original, void
 	process->_euid = original->_euid;
 	process->_gid = original->_gid;
 	process->_egid = original->_egid;
+	process->_fairSchedPolicy = original->_fairSchedPolicy;
 	original->_children.push_back(process);
 	process->_hull->initializeProcess(process.get());
 	process->_didExecute = false;
@@ -1029,6 +1079,9 @@ std::shared_ptr<Process> Process::clone(std::shared_ptr<Process> original, void
 async::result<Error> Process::exec(std::shared_ptr<Process> process,
 		std::string path, std::vector<std::string> args, std::vector<std::string> env) {
 	auto exec_vm_context = VmContext::create();
+	// Lets kernel profiles attribute samples of the new image to its binary.
+	HEL_CHECK(helSetSpaceName(exec_vm_context->getSpace().getHandle(),
+			path.data(), path.size()));
 
 	// Perform the exec() in a new VM context so that we
 	// can catch errors before trashing the calling process.
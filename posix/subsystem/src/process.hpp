@@ -2,6 +2,7 @@
 
 #include <map>
 #include <memory>
+#include <mutex>
 #include <unordered_map>
 
 #include <async/result.hpp>
@@ -153,6 +154,10 @@ struct FileDescriptor {
 	bool closeOnExec;
 };
 
+// FileContexts are shared by all threads of a process. These threads can be served
+// by different workers (see workers.hpp), hence the file table is protected by a mutex.
+// Files are never released while the mutex is held since the release of the last
+// reference runs File::handleClose().
 struct FileContext {
 public:
 	static std::shared_ptr<FileContext> create();
@@ -170,15 +175,20 @@ public:
 
 	int attachFile(smarter::shared_ptr<File, FileHandle> file, bool close_on_exec = false);
 
-	void attachFile(int fd, smarter::shared_ptr<File, FileHandle> file, bool close_on_exec = false);
-
 	std::optional<FileDescriptor> getDescriptor(int fd);
 
 	Error setDescriptor(int fd, bool close_on_exec);
 
 	smarter::shared_ptr<File, FileHandle> getFile(int fd);
 
-	void closeFile(int fd);
+	// Attaches the file of fd to the lowest free FD. Returns the new FD.
+	frg::expected<Error, int> duplicateFile(int fd, bool close_on_exec);
+
+	// Attaches the file of fd to newfd. Returns the file that was attached to newfd before.
+	frg::expected<Error, smarter::shared_ptr<File, FileHandle>> duplicateFileTo(int fd, int newfd);
+
+	// Returns the file such that the caller can control where it is released.
+	smarter::shared_ptr<File, FileHandle> closeFile(int fd);
 
 	void closeOnExec();
 
@@ -187,8 +197,16 @@ public:
 	}
 
 private:
+	// The following functions must be called with _mutex held.
+	int _attachFile(smarter::shared_ptr<File, FileHandle> file, bool close_on_exec);
+
+	smarter::shared_ptr<File, FileHandle> _attachFile(int fd,
+			smarter::shared_ptr<File, FileHandle> file, bool close_on_exec);
+
 	helix::UniqueDescriptor _universe;
 
+	std::mutex _mutex;
+
 	// TODO: replace this by a tree that remembers gaps between keys.
 	std::unordered_map<int, FileDescriptor> _fileTable;
 
@@ -322,6 +340,9 @@ struct Generation {
 	~Generation();
 
 	bool inTermination = false;
+	// Worker that receives the requests of this generation (-1 for the home thread).
+	// See workers.hpp.
+	int worker = -1;
 	async::cancellation_event cancelServe;
 	async::oneshot_event signalsDone;
 	async::oneshot_event requestsDone;
@@ -440,6 +461,16 @@ public:
 		return _euid;
 	}
 
+	// The kernel does not distinguish SCHED_OTHER, SCHED_BATCH and SCHED_IDLE.
+	// We remember which of them was requested such that it can be reported back.
+	int fairSchedPolicy() {
+		return _fairSchedPolicy;
+	}
+
+	void setFairSchedPolicy(int policy) {
+		_fairSchedPolicy = policy;
+	}
+
 	Error setGid(int gid) {
 		if(gid < 0) {
 			return Error::illegalArguments;
@@ -574,6 +605,7 @@ private:
 	int _euid;
 	int _gid;
 	int _egid;
+	int _fairSchedPolicy;
 	bool _didExecute;
 	std::string _path;
 	helix::UniqueLane _posixLane;
@@ -0,0 +1,170 @@
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <iomanip>
+#include <sstream>
+
+#include <helix/ipc.hpp>
+#include <posix.bragi.hpp>
+
+#include "request-stats.hpp"
+
+namespace request_stats {
+
+namespace {
+
+struct Entry {
+	uint64_t count = 0;
+	uint64_t totalNanos = 0;
+	uint64_t histogram[numBuckets] = {};
+};
+
+// Non-request messages never reach the request loop but share the message ID space.
+static_assert(messageKey<managarm::posix::CntRequest>() < legacyKeyBase);
+static_assert(messageKey<managarm::posix::SvrResponse>() < legacyKeyBase);
+
+Entry entries[numKeys];
+Entry unknownEntry;
+
+constexpr std::array<const char *, numKeys> requestNames = [] {
+	std::array<const char *, numKeys> names{};
+	names[messageKey<managarm::posix::AcceptRequest>()] = "AcceptRequest";
+	names[messageKey<managarm::posix::CloseRequest>()] = "CloseRequest";
+	names[messageKey<managarm::posix::EventfdCreateRequest>()] = "EventfdCreateRequest";
+	names[messageKey<managarm::posix::FchmodAtRequest>()] = "FchmodAtRequest";
+	names[messageKey<managarm::posix::FstatAtRequest>()] = "FstatAtRequest";
+	names[messageKey<managarm::posix::GetEgidRequest>()] = "GetEgidRequest";
+	names[messageKey<managarm::posix::GetEuidRequest>()] = "GetEuidRequest";
+	names[messageKey<managarm::posix::GetGidRequest>()] = "GetGidRequest";
+	names[messageKey<managarm::posix::GetPgidRequest>()] = "GetPgidRequest";
+	names[messageKey<managarm::posix::GetPpidRequest>()] = "GetPpidRequest";
+	names[messageKey<managarm::posix::GetSchedulerRequest>()] = "GetSchedulerRequest";
+	names[messageKey<managarm::posix::GetSidRequest>()] = "GetSidRequest";
+	names[messageKey<managarm::posix::GetTidRequest>()] = "GetTidRequest";
+	names[messageKey<managarm::posix::GetUidRequest>()] = "GetUidRequest";
+	names[messageKey<managarm::posix::InotifyAddRequest>()] = "InotifyAddRequest";
+	names[messageKey<managarm::posix::InotifyCreateRequest>()] = "InotifyCreateRequest";
+	names[messageKey<managarm::posix::IoctlFioclexRequest>()] = "IoctlFioclexRequest";
+	names[messageKey<managarm::posix::IsTtyRequest>()] = "IsTtyRequest";
+	names[messageKey<managarm::posix::LinkAtRequest>()] = "LinkAtRequest";
+	names[messageKey<managarm::posix::MemFdCreateRequest>()] = "MemFdCreateRequest";
+	names[messageKey<managarm::posix::MkfifoAtRequest>()] = "MkfifoAtRequest";
+	names[messageKey<managarm::posix::MknodAtRequest>()] = "MknodAtRequest";
+	names[messageKey<managarm::posix::MountRequest>()] = "MountRequest";
+	names[messageKey<managarm::posix::OpenAtRequest>()] = "OpenAtRequest";
+	names[messageKey<managarm::posix::RenameAtRequest>()] = "RenameAtRequest";
+	names[messageKey<managarm::posix::RmdirRequest>()] = "RmdirRequest";
+	names[messageKey<managarm::posix::SetEgidRequest>()] = "SetEgidRequest";
+	names[messageKey<managarm::posix::SetEuidRequest>()] = "SetEuidRequest";
+	names[messageKey<managarm::posix::SetGidRequest>()] = "SetGidRequest";
+	names[messageKey<managarm::posix::SetPgidRequest>()] = "SetPgidRequest";
+	names[messageKey<managarm::posix::SetSchedulerRequest>()] = "SetSchedulerRequest";
+	names[messageKey<managarm::posix::SetUidRequest>()] = "SetUidRequest";
+	names[messageKey<managarm::posix::SocketRequest>()] = "SocketRequest";
+	names[messageKey<managarm::posix::SockpairRequest>()] = "SockpairRequest";
+	names[messageKey<managarm::posix::SpliceRequest>()] = "SpliceRequest";
+	names[messageKey<managarm::posix::SymlinkAtRequest>()] = "SymlinkAtRequest";
+	names[messageKey<managarm::posix::TeeRequest>()] = "TeeRequest";
+	names[messageKey<managarm::posix::UnlinkAtRequest>()] = "UnlinkAtRequest";
+	names[messageKey<managarm::posix::UtimensAtRequest>()] = "UtimensAtRequest";
+	names[messageKey<managarm::posix::VmMapRequest>()] = "VmMapRequest";
+	names[messageKey<managarm::posix::VmspliceRequest>()] = "VmspliceRequest";
+	names[legacyKey(managarm::posix::CntReqType::ACCESSAT)] = "ACCESSAT";
+	names[legacyKey(managarm::posix::CntReqType::CHDIR)] = "CHDIR";
+	names[legacyKey(managarm::posix::CntReqType::CHROOT)] = "CHROOT";
+	names[legacyKey(managarm::posix::CntReqType::DUP)] = "DUP";
+	names[legacyKey(managarm::posix::CntReqType::DUP2)] = "DUP2";
+	names[legacyKey(managarm::posix::CntReqType::EPOLL_ADD)] = "EPOLL_ADD";
+	names[legacyKey(managarm::posix::CntReqType::EPOLL_CALL)] = "EPOLL_CALL";
+	names[legacyKey(managarm::posix::CntReqType::EPOLL_CREATE)] = "EPOLL_CREATE";
+	names[legacyKey(managarm::posix::CntReqType::EPOLL_DELETE)] = "EPOLL_DELETE";
+	names[legacyKey(managarm::posix::CntReqType::EPOLL_MODIFY)] = "EPOLL_MODIFY";
+	names[legacyKey(managarm::posix::CntReqType::EPOLL_WAIT)] = "EPOLL_WAIT";
+	names[legacyKey(managarm::posix::CntReqType::FCHDIR)] = "FCHDIR";
+	names[legacyKey(managarm::posix::CntReqType::FD_GET_FLAGS)] = "FD_GET_FLAGS";
+	names[legacyKey(managarm::posix::CntReqType::FD_SET_FLAGS)] = "FD_SET_FLAGS";
+	names[legacyKey(managarm::posix::CntReqType::GETCWD)] = "GETCWD";
+	names[legacyKey(managarm::posix::CntReqType::GET_PID)] = "GET_PID";
+	names[legacyKey(managarm::posix::CntReqType::GET_RESOURCE_USAGE)] = "GET_RESOURCE_USAGE";
+	names[legacyKey(managarm::posix::CntReqType::MKDIRAT)] = "MKDIRAT";
+	names[legacyKey(managarm::posix::CntReqType::PIPE_CREATE)] = "PIPE_CREATE";
+	names[legacyKey(managarm::posix::CntReqType::READLINK)] = "READLINK";
+	names[legacyKey(managarm::posix::CntReqType::SETSID)] = "SETSID";
+	names[legacyKey(managarm::posix::CntReqType::SIGNALFD_CREATE)] = "SIGNALFD_CREATE";
+	names[legacyKey(managarm::posix::CntReqType::SIG_ACTION)] = "SIG_ACTION";
+	names[legacyKey(managarm::posix::CntReqType::TIMERFD_CREATE)] = "TIMERFD_CREATE";
+	names[legacyKey(managarm::posix::CntReqType::TIMERFD_SETTIME)] = "TIMERFD_SETTIME";
+	names[legacyKey(managarm::posix::CntReqType::TTY_NAME)] = "TTY_NAME";
+	names[legacyKey(managarm::posix::CntReqType::VM_PROTECT)] = "VM_PROTECT";
+	names[legacyKey(managarm::posix::CntReqType::VM_REMAP)] = "VM_REMAP";
+	names[legacyKey(managarm::posix::CntReqType::VM_UNMAP)] = "VM_UNMAP";
+	names[legacyKey(managarm::posix::CntReqType::WAIT)] = "WAIT";
+	return names;
+}();
+
+uint64_t currentNanos() {
+	uint64_t nanos;
+	HEL_CHECK(helGetClock(&nanos));
+	return nanos;
+}
+
+struct StatsNode final : procfs::RegularNode {
+	async::result<std::string> show() override {
+		std::stringstream stream;
+		stream << "request count avg_us";
+		for(int i = 0; i < numBuckets - 1; i++)
+			stream << " <" << (uint64_t{1} << i) << "us";
+		// The last bucket is unbounded (see record()).
+		stream << " >=" << (uint64_t{1} << (numBuckets - 2)) << "us";
+		stream << "\n";
+
+		auto showEntry = [&] (const char *name, uint32_t key, Entry &entry) {
+			auto count = __atomic_load_n(&entry.count, __ATOMIC_RELAXED);
+			if(!count)
+				return;
+			if(name) {
+				stream << name;
+			}else{
+				stream << "key" << key;
+			}
+			stream << " " << count << " "
+					<< (__atomic_load_n(&entry.totalNanos, __ATOMIC_RELAXED) / count / 1000);
+			for(int i = 0; i < numBuckets; i++)
+				stream << " " << __atomic_load_n(&entry.histogram[i], __ATOMIC_RELAXED);
+			stream << "\n";
+		};
+
+		for(uint32_t key = 0; key < numKeys; key++)
+			showEntry(requestNames[key], key, entries[key]);
+		showEntry("unknown", numKeys, unknownEntry);
+		co_return stream.str();
+	}
+
+	async::result<void> store(std::string) override {
+		throw std::runtime_error("Cannot store to /proc/posix-requests");
+	}
+};
+
+} // anonymous namespace
+
+void record(uint32_t key, uint64_t nanos) {
+	// Requests that are handled on workers are recorded concurrently (see workers.hpp).
+	auto &entry = (key < numKeys) ? entries[key] : unknownEntry;
+	auto bucket = std::min<uint64_t>(std::bit_width(nanos / 1000), numBuckets - 1);
+	__atomic_fetch_add(&entry.count, 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&entry.totalNanos, nanos, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&entry.histogram[bucket], 1, __ATOMIC_RELAXED);
+}
+
+Timer::Timer(uint32_t key)
+: _key{key}, _start{currentNanos()} { }
+
+Timer::~Timer() {
+	record(_key, currentNanos() - _start);
+}
+
+std::shared_ptr<procfs::RegularNode> createStatsNode() {
+	return std::make_shared<StatsNode>();
+}
+
+} // namespace request_stats
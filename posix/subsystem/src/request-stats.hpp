@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+
+#include "procfs.hpp"
+
+// Per-request counts and latency histograms of the posix request loop.
+namespace request_stats {
+
+// Requests are identified by a dense key. bragi messages use their message ID,
+// legacy CntRequests are placed after all message IDs and use their request type.
+inline constexpr uint32_t legacyKeyBase = 128;
+inline constexpr uint32_t numKeys = 256;
+
+constexpr uint32_t legacyKey(uint32_t requestType) {
+	return legacyKeyBase + requestType;
+}
+
+template<typename Message>
+constexpr uint32_t messageKey() {
+	static_assert(Message::message_id < legacyKeyBase,
+			"bragi message IDs must stay below legacyKeyBase");
+	return Message::message_id;
+}
+
+// Bucket n counts latencies in [2^(n - 1), 2^n) microseconds.
+// Bucket 0 counts latencies below one microsecond, the last bucket counts everything above.
+inline constexpr int numBuckets = 20;
+
+void record(uint32_t key, uint64_t nanos);
+
+// Records the latency of a request when it goes out of scope.
+struct Timer {
+	explicit Timer(uint32_t key);
+
+	Timer(const Timer &) = delete;
+
+	~Timer();
+
+	Timer &operator= (const Timer &) = delete;
+
+private:
+	uint32_t _key;
+	uint64_t _start;
+};
+
+std::shared_ptr<procfs::RegularNode> createStatsNode();
+
+} // namespace request_stats
@@ -43,7 +43,8 @@ struct Device final : UnixDevice, drvcore::BlockDevice {
 	async::result<frg::expected<Error, smarter::shared_ptr<File, FileHandle>>>
 	open(std::shared_ptr<MountView> mount, std::shared_ptr<FsLink> link,
 			SemanticFlags semantic_flags) override {
-		return openExternalDevice(_lane, std::move(mount), std::move(link), semantic_flags);
+		return openExternalDevice(_lane, _statusDomain, std::move(mount), std::move(link),
+				semantic_flags);
 	}
 
 	FutureMaybe<std::shared_ptr<FsLink>> mount() override {
@@ -57,6 +58,7 @@ struct Device final : UnixDevice, drvcore::BlockDevice {
 private:
 	std::string _name;
 	helix::UniqueLane _lane;
+	std::shared_ptr<StatusDomain> _statusDomain = std::make_shared<StatusDomain>();
 };
 
 } // anonymous namepsace
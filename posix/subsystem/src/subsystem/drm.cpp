@@ -39,7 +39,8 @@ struct Device final : UnixDevice, drvcore::ClassDevice {
 	async::result<frg::expected<Error, smarter::shared_ptr<File, FileHandle>>>
 	open(std::shared_ptr<MountView> mount, std::shared_ptr<FsLink> link,
 			SemanticFlags semantic_flags) override {
-		return openExternalDevice(_lane, std::move(mount), std::move(link), semantic_flags);
+		return openExternalDevice(_lane, _statusDomain, std::move(mount), std::move(link),
+				semantic_flags);
 	}
 
 	void composeUevent(drvcore::UeventProperties &ue) override {
@@ -49,6 +50,7 @@ struct Device final : UnixDevice, drvcore::ClassDevice {
 private:
 	int _index;
 	helix::UniqueLane _lane;
+	std::shared_ptr<StatusDomain> _statusDomain = std::make_shared<StatusDomain>();
 };
 
 } // anonymous namepsace
@@ -402,6 +402,9 @@ public:
 	async::result<frg::expected<Error, size_t>>
 	writeAll(Process *, const void *buffer, size_t length) override;
 
+	async::result<frg::expected<Error, size_t>>
+	pread(Process *, int64_t offset, void *buffer, size_t max_length) override;
+
 	async::result<frg::expected<Error, size_t>>
 	pwrite(Process *, int64_t offset, const void *buffer, size_t length) override;
 
@@ -409,6 +412,8 @@ public:
 
 	async::result<frg::expected<protocols::fs::Error>> allocate(int64_t offset, size_t size) override;
 
+	async::result<frg::expected<protocols::fs::Error>> punchHole(int64_t offset, size_t size) override;
+
 	FutureMaybe<helix::UniqueDescriptor> accessMemory() override;
 
 	helix::BorrowedDescriptor getPassthroughLane() override {
@@ -466,29 +471,88 @@ struct MemoryNode final : Node {
 	}
 
 private:
+	// The memory object and its mapping grow geometrically (starting at minAreaSize),
+	// such that extending a file by small writes is amortized O(1). Since the kernel only
+	// allocates pages of the memory object on first access, this does not consume memory.
+	static constexpr size_t minAreaSize = 0x10000;
+
 	void _resizeFile(size_t new_size) {
+		if(new_size < _fileSize) {
+			// Release all memory if the file is truncated to zero (e.g., log rotation).
+			// We cannot do this if the memory object was handed out for mmap().
+			if(!new_size && !_memoryShared) {
+				_mapping = helix::Mapping{};
+				_memory = helix::UniqueDescriptor{};
+				_areaSize = 0;
+				_fileSize = 0;
+				return;
+			}
+
+			// Data beyond the new EOF must read back as zeros if the file is extended again.
+			// Only the partial page at the new EOF is cleared; whole pages are decommitted.
+			auto page_end = (new_size + 0xFFF) & ~size_t(0xFFF);
+			memset(reinterpret_cast<char *>(_mapping.get()) + new_size, 0,
+					std::min(page_end, _fileSize) - new_size);
+			_decommit(page_end, (_fileSize + 0xFFF) & ~size_t(0xFFF));
+		}
 		_fileSize = new_size;
+		if(new_size)
+			_reserve((new_size + 0xFFF) & ~size_t(0xFFF));
+	}
 
-		size_t aligned_size = (new_size + 0xFFF) & ~size_t(0xFFF);
-		if(aligned_size <= _areaSize)
+	void _reserve(size_t aligned_size) {
+		if(_memory && aligned_size <= _areaSize)
 			return;
 
+		auto area_size = std::max(minAreaSize, _areaSize);
+		while(area_size < aligned_size)
+			area_size *= 2;
+
 		if(_memory) {
-			HEL_CHECK(helResizeMemory(_memory.getHandle(), aligned_size));
+			HEL_CHECK(helResizeMemory(_memory.getHandle(), area_size));
 		}else{
 			HelHandle handle;
-			HEL_CHECK(helAllocateMemory(aligned_size, 0, nullptr, &handle));
+			HEL_CHECK(helAllocateMemory(area_size, kHelAllocDecommittable, nullptr, &handle));
 			_memory = helix::UniqueDescriptor{handle};
 		}
 
-		_mapping = helix::Mapping{_memory, 0, aligned_size};
-		_areaSize = aligned_size;
+		_mapping = helix::Mapping{_memory, 0, area_size};
+		_areaSize = area_size;
+	}
+
+	// Releases the pages in [begin, end). Both must be page aligned.
+	void _decommit(size_t begin, size_t end) {
+		if(begin >= end)
+			return;
+		HEL_CHECK(helDecommitMemory(_memory.getHandle(), begin, end - begin));
+	}
+
+	void _punchHole(size_t offset, size_t size) {
+		if(offset >= _fileSize)
+			return;
+		auto end = offset + std::min(size, _fileSize - offset);
+
+		// Clear the partial pages at both ends of the hole and decommit the pages in between.
+		// If the hole extends to EOF, the page that contains EOF can be decommitted, too.
+		auto begin_page = (offset + 0xFFF) & ~size_t(0xFFF);
+		auto end_page = (end == _fileSize) ? ((end + 0xFFF) & ~size_t(0xFFF)) : (end & ~size_t(0xFFF));
+		auto data = reinterpret_cast<char *>(_mapping.get());
+		if(begin_page >= end_page) {
+			memset(data + offset, 0, end - offset);
+			return;
+		}
+		memset(data + offset, 0, begin_page - offset);
+		if(end_page < end)
+			memset(data + end_page, 0, end - end_page);
+		_decommit(begin_page, end_page);
 	}
 
 	helix::UniqueDescriptor _memory;
 	helix::Mapping _mapping;
 	size_t _areaSize;
 	size_t _fileSize;
+	// Set once the memory object was passed to accessMemory().
+	bool _memoryShared;
 };
 
 struct Superblock final : FsSuperblock {
@@ -537,7 +601,7 @@ private:
 // ----------------------------------------------------------------------------
 
 MemoryNode::MemoryNode(Superblock *superblock)
-: Node{superblock}, _areaSize{0}, _fileSize{0} { }
+: Node{superblock}, _areaSize{0}, _fileSize{0}, _memoryShared{false} { }
 
 void MemoryFile::handleClose() {
 	_cancelServe.cancel();
@@ -583,6 +647,18 @@ MemoryFile::writeAll(Process *, const void *buffer, size_t length) {
 	co_return length;
 }
 
+async::result<frg::expected<Error, size_t>>
+MemoryFile::pread(Process *, int64_t offset, void *buffer, size_t max_length) {
+	auto node = static_cast<MemoryNode *>(associatedLink()->getTarget().get());
+
+	if(!(static_cast<size_t>(offset) <= node->_fileSize))
+		co_return 0;
+	auto chunk = std::min(node->_fileSize - offset, max_length);
+
+	memcpy(buffer, reinterpret_cast<char *>(node->_mapping.get()) + offset, chunk);
+	co_return chunk;
+}
+
 async::result<frg::expected<Error, size_t>>
 MemoryFile::pwrite(Process *, int64_t offset, const void *buffer, size_t length) {
 	auto node = static_cast<MemoryNode *>(associatedLink()->getTarget().get());
@@ -604,8 +680,6 @@ MemoryFile::truncate(size_t size) {
 
 async::result<frg::expected<protocols::fs::Error>>
 MemoryFile::allocate(int64_t offset, size_t size) {
-	assert(!offset);
-
 	auto node = static_cast<MemoryNode *>(associatedLink()->getTarget().get());
 
 	// TODO: Careful about overflow.
@@ -615,9 +689,20 @@ MemoryFile::allocate(int64_t offset, size_t size) {
 	co_return {};
 }
 
+async::result<frg::expected<protocols::fs::Error>>
+MemoryFile::punchHole(int64_t offset, size_t size) {
+	auto node = static_cast<MemoryNode *>(associatedLink()->getTarget().get());
+
+	node->_punchHole(offset, size);
+	co_return {};
+}
+
 FutureMaybe<helix::UniqueDescriptor>
 MemoryFile::accessMemory() {
 	auto node = static_cast<MemoryNode *>(associatedLink()->getTarget().get());
+	// mmap() of an empty file still needs a memory object.
+	node->_reserve(0);
+	node->_memoryShared = true;
 	co_return node->_memory.dup();
 }
 
@@ -9,6 +9,7 @@
 #include <async/recurring-event.hpp>
 #include <helix/ipc.hpp>
 #include "fs.bragi.hpp"
+#include "pipe-buffer.hpp"
 #include "sockutil.hpp"
 #include "un-socket.hpp"
 #include "process.hpp"
@@ -18,6 +19,9 @@ namespace un_socket {
 
 static constexpr bool logSockets = false;
 
+// Amount of data that can be queued on a socket before senders block.
+static constexpr size_t recvBufferCapacity = 64 * pipe_buffer::pageSize;
+
 struct OpenFile;
 
 // This map associates bound sockets with FS nodes.
@@ -30,8 +34,8 @@ struct Packet {
 	// Sender process information.
 	int senderPid;
 
-	// The actual octet data that the packet consists of.
-	std::vector<char> buffer;
+	// The packet's octet data is stored in the receiver's _recvBuffer.
+	size_t length;
 
 	std::vector<smarter::shared_ptr<File, FileHandle>> files;
 
@@ -74,9 +78,9 @@ public:
 				smarter::shared_ptr<File>{file}, &File::fileOperations, file->_cancelServe));
 	}
 
-	OpenFile(Process *process = nullptr, bool nonBlock = false)
-	: File{StructName::get("un-socket"), File::defaultPipeLikeSeek}, _currentState{State::null},
-			_currentSeq{1}, _inSeq{0}, _ownerPid{0},
+	OpenFile(int socktype, Process *process = nullptr, bool nonBlock = false)
+	: File{StructName::get("un-socket"), File::defaultPipeLikeSeek}, _socktype{socktype},
+			_currentState{State::null}, _currentSeq{1}, _inSeq{0}, _ownerPid{0},
 			_remote{nullptr}, _passCreds{false}, nonBlock_{nonBlock},
 			_sockpath{}, _nameType{NameType::unnamed}, _isInherited{false} {
 		if(process)
@@ -120,13 +124,8 @@ public:
 
 		// TODO: Truncate packets (for SOCK_DGRAM) here.
 		auto packet = &_recvQueue.front();
-		assert(!packet->offset);
 		assert(packet->files.empty());
-		auto size = packet->buffer.size();
-		assert(max_length >= size);
-		memcpy(data, packet->buffer.data(), size);
-		_recvQueue.pop_front();
-		co_return size;
+		co_return _consume(packet, data, max_length);
 	}
 
 	async::result<frg::expected<Error, size_t>>
@@ -137,16 +136,16 @@ public:
 		if(logSockets)
 			std::cout << "posix: Write to socket \e[1;34m" << structName() << "\e[0m" << std::endl;
 
-		Packet packet;
-		packet.senderPid = process->pid();
-		packet.buffer.resize(length);
-		memcpy(packet.buffer.data(), data, length);
-		packet.offset = 0;
-
-		_remote->_recvQueue.push_back(std::move(packet));
-		_remote->_inSeq = ++_remote->_currentSeq;
-		_remote->_statusBell.raise();
-		co_return length;
+		auto result = co_await _transmit(process, data, length, {}, nonBlock_);
+		if(!result) {
+			if(result.error() == protocols::fs::Error::wouldBlock)
+				co_return Error::wouldBlock;
+			if(result.error() == protocols::fs::Error::messageSize)
+				co_return Error::illegalArguments;
+			assert(result.error() == protocols::fs::Error::brokenPipe);
+			co_return Error::brokenPipe;
+		}
+		co_return result.value();
 	}
 
 	async::result<protocols::fs::RecvResult>
@@ -198,12 +197,7 @@ public:
 		}
 
 		// TODO: Truncate packets (for SOCK_DGRAM) here.
-		auto chunk = std::min(packet->buffer.size() - packet->offset, max_length);
-		memcpy(data, packet->buffer.data() + packet->offset, chunk);
-		packet->offset += chunk;
-
-		if(packet->offset == packet->buffer.size())
-			_recvQueue.pop_front();
+		auto chunk = _consume(packet, data, max_length);
 		co_return protocols::fs::RecvResult { protocols::fs::RecvData { chunk, 0, ctrl.buffer() } };
 	}
 
@@ -221,20 +215,8 @@ public:
 		if(logSockets)
 			std::cout << "posix: Send to socket \e[1;34m" << structName() << "\e[0m" << std::endl;
 
-		// We ignore MSG_DONTWAIT here as we never block anyway.
-
-		Packet packet;
-		packet.senderPid = process->pid();
-		packet.buffer.resize(max_length);
-		memcpy(packet.buffer.data(), data, max_length);
-		packet.files = std::move(files);
-		packet.offset = 0;
-
-		_remote->_recvQueue.push_back(std::move(packet));
-		_remote->_inSeq = ++_remote->_currentSeq;
-		_remote->_statusBell.raise();
-
-		co_return max_length;
+		co_return co_await _transmit(process, data, max_length, std::move(files),
+				(flags & MSG_DONTWAIT) || nonBlock_);
 	}
 
 	async::result<int> getOption(int option) override {
@@ -264,7 +246,7 @@ public:
 		_acceptQueue.pop_front();
 
 		// Create a new socket and connect it to the queued one.
-		auto local = smarter::make_shared<OpenFile>(process);
+		auto local = smarter::make_shared<OpenFile>(_socktype, process);
 		local->_sockpath = _sockpath;
 		local->_nameType = _nameType;
 		local->_isInherited = true;
@@ -304,7 +286,9 @@ public:
 
 	async::result<frg::expected<Error, PollStatusResult>>
 	pollStatus(Process *) override {
-		int events = EPOLLOUT;
+		int events = 0;
+		if(_currentState != State::connected || _remote->_recvBuffer.space())
+			events |= EPOLLOUT;
 		if(_currentState == State::remoteShutDown)
 			events |= EPOLLHUP;
 		if(!_acceptQueue.empty() || !_recvQueue.empty())
@@ -463,7 +447,7 @@ public:
 					resp.set_fionread_count(0);
 				} else {
 					auto packet = &_recvQueue.front();
-					resp.set_fionread_count(packet->buffer.size() - packet->offset);
+					resp.set_fionread_count(packet->length - packet->offset);
 				}
 				break;
 			}
@@ -526,9 +510,100 @@ public:
 	}
 
 private:
+	// Copies data out of the receive buffer and wakes up senders that wait for buffer space.
+	size_t _consume(Packet *packet, void *data, size_t max_length) {
+		auto chunk = std::min(packet->length - packet->offset, max_length);
+		auto progress = _recvBuffer.read(data, chunk);
+		assert(progress == chunk);
+		packet->offset += chunk;
+
+		if(packet->offset == packet->length)
+			_recvQueue.pop_front();
+		if(chunk && _remote) {
+			_remote->_currentSeq++;
+			_remote->_statusBell.raise();
+		}
+		return chunk;
+	}
+
+	// Queues data on the remote socket. Blocks (unless nonBlock is set) while
+	// the remote's receive buffer is full. For SOCK_STREAM, large writes are split into
+	// multiple packets; other socket types preserve message boundaries and wait until
+	// the whole message fits into the receive buffer.
+	async::result<frg::expected<protocols::fs::Error, size_t>>
+	_transmit(Process *process, const void *data, size_t length,
+			std::vector<smarter::shared_ptr<File, FileHandle>> files, bool nonBlock) {
+		if(_socktype != SOCK_STREAM)
+			co_return co_await _transmitMessage(process, data, length, std::move(files), nonBlock);
+
+		auto source = reinterpret_cast<const char *>(data);
+		size_t progress = 0;
+		do {
+			while(_currentState == State::connected && length
+					&& !_remote->_recvBuffer.space()) {
+				if(nonBlock) {
+					if(progress)
+						co_return progress;
+					co_return protocols::fs::Error::wouldBlock;
+				}
+				co_await _statusBell.async_wait();
+			}
+
+			if(_currentState != State::connected) {
+				if(progress)
+					co_return progress;
+				co_return protocols::fs::Error::brokenPipe;
+			}
+
+			// Ancillary data is attached to the first packet (as on Linux).
+			auto chunk = _remote->_recvBuffer.write(source + progress, length - progress);
+			_enqueue(process, chunk, std::move(files));
+			files.clear();
+			progress += chunk;
+		} while(progress < length);
+
+		co_return progress;
+	}
+
+	async::result<frg::expected<protocols::fs::Error, size_t>>
+	_transmitMessage(Process *process, const void *data, size_t length,
+			std::vector<smarter::shared_ptr<File, FileHandle>> files, bool nonBlock) {
+		if(length > recvBufferCapacity)
+			co_return protocols::fs::Error::messageSize;
+
+		while(_currentState == State::connected && _remote->_recvBuffer.space() < length) {
+			if(nonBlock)
+				co_return protocols::fs::Error::wouldBlock;
+			co_await _statusBell.async_wait();
+		}
+
+		if(_currentState != State::connected)
+			co_return protocols::fs::Error::brokenPipe;
+
+		auto chunk = _remote->_recvBuffer.write(data, length);
+		assert(chunk == length);
+		_enqueue(process, length, std::move(files));
+		co_return length;
+	}
+
+	// Adds a packet whose data was already written to the remote's receive buffer.
+	void _enqueue(Process *process, size_t length,
+			std::vector<smarter::shared_ptr<File, FileHandle>> files) {
+		Packet packet;
+		packet.senderPid = process->pid();
+		packet.length = length;
+		packet.files = std::move(files);
+		_remote->_recvQueue.push_back(std::move(packet));
+		_remote->_inSeq = ++_remote->_currentSeq;
+		_remote->_statusBell.raise();
+	}
+
 	helix::UniqueLane _passthrough;
 	async::cancellation_event _cancelServe;
 
+	// SOCK_STREAM, SOCK_SEQPACKET or SOCK_DGRAM.
+	int _socktype;
+
 	State _currentState;
 
 	// Status management for poll().
@@ -542,6 +617,7 @@ private:
 
 	// The actual receive queue of the socket.
 	std::deque<Packet> _recvQueue;
+	pipe_buffer::Ring _recvBuffer{recvBufferCapacity};
 
 	int _ownerPid;
 
@@ -559,16 +635,17 @@ private:
 	bool _isInherited;
 };
 
-smarter::shared_ptr<File, FileHandle> createSocketFile(bool nonBlock) {
-	auto file = smarter::make_shared<OpenFile>(nullptr, nonBlock);
+smarter::shared_ptr<File, FileHandle> createSocketFile(int socktype, bool nonBlock) {
+	auto file = smarter::make_shared<OpenFile>(socktype, nullptr, nonBlock);
 	file->setupWeakFile(file);
 	OpenFile::serve(file);
 	return File::constructHandle(std::move(file));
 }
 
-std::array<smarter::shared_ptr<File, FileHandle>, 2> createSocketPair(Process *process) {
-	auto file0 = smarter::make_shared<OpenFile>(process);
-	auto file1 = smarter::make_shared<OpenFile>(process);
+std::array<smarter::shared_ptr<File, FileHandle>, 2> createSocketPair(Process *process,
+		int socktype) {
+	auto file0 = smarter::make_shared<OpenFile>(socktype, process);
+	auto file1 = smarter::make_shared<OpenFile>(socktype, process);
 	file0->setupWeakFile(file0);
 	file1->setupWeakFile(file1);
 	OpenFile::serve(file0);
@@ -55,12 +55,75 @@ std::shared_ptr<MountView> MountView::getMount(std::shared_ptr<FsLink> link) con
 	return *it;
 }
 
+// --------------------------------------------------------
+// DentryCache implementation.
+// --------------------------------------------------------
+
+std::optional<std::shared_ptr<FsLink>> DentryCache::lookup(FsNode *directory,
+		const std::string &name) {
+	auto it = _entries.find(Key{directory, name});
+	if(it == _entries.end()) {
+		_stats.misses++;
+		return std::nullopt;
+	}
+
+	_lru.splice(_lru.begin(), _lru, it->second);
+	if(it->second->link) {
+		_stats.hits++;
+	}else{
+		_stats.negativeHits++;
+	}
+	return it->second->link;
+}
+
+void DentryCache::insert(std::shared_ptr<FsNode> directory, std::string name,
+		std::shared_ptr<FsLink> link, uint64_t generation) {
+	if(generation != _generation) {
+		_stats.staleInserts++;
+		return;
+	}
+
+	Key key{directory.get(), name};
+	if(auto it = _entries.find(key); it != _entries.end()) {
+		it->second->link = std::move(link);
+		_lru.splice(_lru.begin(), _lru, it->second);
+		return;
+	}
+
+	if(_entries.size() >= maxEntries) {
+		auto &victim = _lru.back();
+		_entries.erase(Key{victim.directory.get(), victim.name});
+		_lru.pop_back();
+		_stats.evictions++;
+	}
+
+	_lru.push_front(Entry{std::move(directory), std::move(name), std::move(link)});
+	_entries.emplace(std::move(key), _lru.begin());
+}
+
+void DentryCache::invalidate(FsNode *directory, const std::string &name) {
+	_generation++;
+
+	auto it = _entries.find(Key{directory, name});
+	if(it == _entries.end())
+		return;
+	_lru.erase(it->second);
+	_entries.erase(it);
+	_stats.invalidations++;
+}
+
 namespace {
 
 std::shared_ptr<MountView> rootView;
 
+DentryCache globalDentryCache;
+
 } // anonymous namespace
 
+DentryCache &dentryCache() {
+	return globalDentryCache;
+}
+
 async::result<void> populateRootView() {
 	// Create a tmpfs instance for the initrd.
 	auto tree = tmp_fs::createRoot();
@@ -255,7 +318,15 @@ async::result<frg::expected<protocols::fs::Error, void>> PathResolver::resolve(R
 				_currentPath = ViewPath{_currentPath.first, owner->treeLink()};
 			}
 		}else{
-			if (_currentPath.second->getTarget()->hasTraverseLinks()) {
+			auto directory = _currentPath.second->getTarget();
+			bool useCache = directory->supportsDentryCache();
+
+			std::optional<std::shared_ptr<FsLink>> cachedChild;
+			if(useCache)
+				cachedChild = dentryCache().lookup(directory.get(), name);
+			auto cacheGeneration = dentryCache().generation();
+
+			if (!cachedChild && directory->hasTraverseLinks()) {
 				_components.push_front(name);
 				std::string end;
 
@@ -264,12 +335,15 @@ async::result<frg::expected<protocols::fs::Error, void>> PathResolver::resolve(R
 					_components.pop_back();
 				}
 
-				auto result = co_await _currentPath.second->getTarget()->traverseLinks(_components);
+				auto result = co_await directory->traverseLinks(_components);
 
 				if (!result) {
 					assert(result.error() == Error::illegalOperationTarget
 							|| result.error() == Error::noSuchFile
 							|| result.error() == Error::notDirectory);
+					// We only know which component is missing if there was a single one.
+					if(useCache && result.error() == Error::noSuchFile && _components.size() == 1)
+						dentryCache().insert(directory, name, nullptr, cacheGeneration);
 					_currentPath = ViewPath{_currentPath.first, nullptr};
 					if(result.error() == Error::illegalOperationTarget) {
 						std::cout << "\e[33mposix: Illegal operation target in PathResolver::resolve\e[39m" << std::endl;
@@ -289,6 +363,18 @@ async::result<frg::expected<protocols::fs::Error, void>> PathResolver::resolve(R
 
 				assert(nLinks <= _components.size());
 
+				// Cache all links that were traversed by the file system.
+				if(child && useCache) {
+					auto link = child;
+					for(size_t i = 0; i < nLinks; i++) {
+						auto owner = link->getOwner();
+						if(!owner)
+							break;
+						dentryCache().insert(owner, link->getName(), link, cacheGeneration);
+						link = owner->treeLink();
+					}
+				}
+
 				while (nLinks--)
 					_components.pop_front();
 
@@ -333,19 +419,26 @@ async::result<frg::expected<protocols::fs::Error, void>> PathResolver::resolve(R
 					_currentPath = std::move(next);
 				}
 			} else {
-				auto childResult = co_await _currentPath.second->getTarget()->getLink(std::move(name));
-				if(!childResult) {
-					assert(childResult.error() == Error::notDirectory
-							|| childResult.error() == Error::illegalOperationTarget);
-					_currentPath = ViewPath{_currentPath.first, nullptr};
-					if(childResult.error() == Error::notDirectory) {
-						co_return protocols::fs::Error::notDirectory;
-					} else if(childResult.error() == Error::illegalOperationTarget) {
-						std::cout << "\e[33mposix: Illegal operation target in PathResolver::resolve\e[39m" << std::endl;
-						co_return protocols::fs::Error::fileNotFound;
+				std::shared_ptr<FsLink> child;
+				if(cachedChild) {
+					child = std::move(*cachedChild);
+				}else{
+					auto childResult = co_await directory->getLink(name);
+					if(!childResult) {
+						assert(childResult.error() == Error::notDirectory
+								|| childResult.error() == Error::illegalOperationTarget);
+						_currentPath = ViewPath{_currentPath.first, nullptr};
+						if(childResult.error() == Error::notDirectory) {
+							co_return protocols::fs::Error::notDirectory;
+						} else if(childResult.error() == Error::illegalOperationTarget) {
+							std::cout << "\e[33mposix: Illegal operation target in PathResolver::resolve\e[39m" << std::endl;
+							co_return protocols::fs::Error::fileNotFound;
+						}
 					}
+					child = childResult.value();
+					if(useCache)
+						dentryCache().insert(directory, std::move(name), child, cacheGeneration);
 				}
-				auto child = childResult.value();
 
 				if(!child) {
 					_currentPath = ViewPath{_currentPath.first, nullptr};
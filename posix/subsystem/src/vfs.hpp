@@ -2,6 +2,9 @@
 
 #include <string.h>
 #include <iostream>
+#include <list>
+#include <map>
+#include <optional>
 #include <set>
 #include <deque>
 
@@ -104,6 +107,61 @@ private:
 	ViewPath _currentPath;
 };
 
+//! Caches the results of directory lookups for file systems where lookups are expensive.
+//! Both positive and negative (i.e., "name does not exist") results are cached.
+//! Only used for nodes that return true from FsNode::supportsDentryCache().
+struct DentryCache {
+	static constexpr size_t maxEntries = 4096;
+
+	struct Statistics {
+		uint64_t hits = 0;
+		uint64_t negativeHits = 0;
+		uint64_t misses = 0;
+		uint64_t invalidations = 0;
+		uint64_t evictions = 0;
+		uint64_t staleInserts = 0;
+	};
+
+	//! Returns std::nullopt on a cache miss and a null link for a negative entry.
+	std::optional<std::shared_ptr<FsLink>> lookup(FsNode *directory, const std::string &name);
+
+	//! Incremented by every invalidation. Lookups that were started in
+	//! an older generation might be stale and are not inserted.
+	uint64_t generation() {
+		return _generation;
+	}
+
+	//! Inserts a positive (non-null link) or negative (null link) entry.
+	//! generation is the value of generation() before the lookup was started.
+	void insert(std::shared_ptr<FsNode> directory, std::string name,
+			std::shared_ptr<FsLink> link, uint64_t generation);
+
+	//! Must be called after a link was added to or removed from a directory.
+	void invalidate(FsNode *directory, const std::string &name);
+
+	const Statistics &statistics() {
+		return _stats;
+	}
+
+private:
+	struct Entry {
+		// Keeps the directory alive such that the key's pointer cannot be reused.
+		std::shared_ptr<FsNode> directory;
+		std::string name;
+		std::shared_ptr<FsLink> link;
+	};
+
+	using Key = std::pair<FsNode *, std::string>;
+
+	// Ordered from most recently to least recently used.
+	std::list<Entry> _lru;
+	std::map<Key, std::list<Entry>::iterator> _entries;
+	uint64_t _generation = 0;
+	Statistics _stats;
+};
+
+DentryCache &dentryCache();
+
 async::result<void> populateRootView();
 
 ViewPath rootPath();
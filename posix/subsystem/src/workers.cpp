@@ -0,0 +1,134 @@
+#include <iostream>
+#include <sstream>
+
+#include <helix/pool.hpp>
+
+#include "workers.hpp"
+
+namespace workers {
+
+namespace {
+
+// Each thread only increments its own counters. procfs reads them on the home thread.
+struct Counters {
+	uint64_t requests = 0;
+	uint64_t local = 0;
+};
+
+// Queue of the home thread's helix::Dispatcher.
+HelHandle homeQueue = kHelNullHandle;
+
+// The pool is never destructed.
+helix::DispatcherPool *pool = nullptr;
+
+Counters homeCounters;
+std::unique_ptr<Counters[]> workerCounters;
+
+// Only accessed on the home thread.
+unsigned int nextPick = 0;
+
+// Context that drops a file reference on the home thread.
+struct ReleaseFile final : helix::Context {
+	ReleaseFile(smarter::shared_ptr<File, FileHandle> file)
+	: file{std::move(file)} { }
+
+	void complete(helix::ElementHandle) override {
+		delete this;
+	}
+
+	smarter::shared_ptr<File, FileHandle> file;
+};
+
+struct StatsNode final : procfs::RegularNode {
+	async::result<std::string> show() override {
+		auto showCounters = [] (std::stringstream &stream, Counters &counters) {
+			auto requests = __atomic_load_n(&counters.requests, __ATOMIC_RELAXED);
+			auto local = __atomic_load_n(&counters.local, __ATOMIC_RELAXED);
+			stream << " " << requests << " " << local << " " << (requests - local) << "\n";
+		};
+
+		std::stringstream stream;
+		stream << "worker requests local forwarded\n";
+		stream << "home";
+		showCounters(stream, homeCounters);
+		for(unsigned int i = 0; i < numWorkers(); i++) {
+			stream << i;
+			showCounters(stream, workerCounters[i]);
+		}
+		co_return stream.str();
+	}
+
+	async::result<void> store(std::string) override {
+		throw std::runtime_error("Cannot store to /proc/posix-workers");
+	}
+};
+
+} // anonymous namespace
+
+void start(unsigned int count) {
+	assert(helix::DispatcherPool::currentWorker() == -1);
+	assert(homeQueue == kHelNullHandle);
+	homeQueue = helix::Dispatcher::global().acquire();
+	if(!count)
+		return;
+
+	std::cout << "posix: Starting " << count << " worker threads" << std::endl;
+	workerCounters = std::make_unique<Counters[]>(count);
+	pool = new helix::DispatcherPool{count};
+}
+
+unsigned int numWorkers() {
+	if(!pool)
+		return 0;
+	return pool->numWorkers();
+}
+
+int pick() {
+	if(!pool)
+		return -1;
+	return nextPick++ % pool->numWorkers();
+}
+
+bool SwitchTo::await_ready() {
+	return helix::DispatcherPool::currentWorker() == _index;
+}
+
+void SwitchTo::await_suspend(std::coroutine_handle<> handle) {
+	_handle = handle;
+	if(_index == -1) {
+		assert(homeQueue != kHelNullHandle);
+		auto context = static_cast<helix::Context *>(this);
+		HEL_CHECK(helSubmitAsyncNop(homeQueue, reinterpret_cast<uintptr_t>(context)));
+	}else{
+		assert(pool);
+		pool->post(_index, [handle] {
+			handle.resume();
+		});
+	}
+}
+
+void SwitchTo::complete(helix::ElementHandle) {
+	_handle.resume();
+}
+
+void countRequest(bool local) {
+	auto index = helix::DispatcherPool::currentWorker();
+	auto &counters = (index == -1) ? homeCounters : workerCounters[index];
+	__atomic_fetch_add(&counters.requests, 1, __ATOMIC_RELAXED);
+	if(local)
+		__atomic_fetch_add(&counters.local, 1, __ATOMIC_RELAXED);
+}
+
+void releaseOnHome(smarter::shared_ptr<File, FileHandle> file) {
+	if(!file || helix::DispatcherPool::currentWorker() == -1)
+		return;
+
+	auto context = static_cast<helix::Context *>(new ReleaseFile{std::move(file)});
+	HEL_CHECK(helSubmitAsyncNop(homeQueue, reinterpret_cast<uintptr_t>(context)));
+}
+
+std::shared_ptr<procfs::RegularNode> createStatsNode() {
+	return std::make_shared<StatsNode>();
+}
+
+} // namespace workers
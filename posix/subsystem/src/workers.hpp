@@ -0,0 +1,64 @@
+#pragma once
+
+#include <coroutine>
+#include <memory>
+#include <helix/ipc.hpp>
+
+#include "file.hpp"
+#include "procfs.hpp"
+
+// The posix subsystem can receive requests on multiple worker threads. The number of
+// workers is taken from "posix.workers=N" on the kernel command line (default: none).
+//
+// Shared posix state (the VFS, the process tree, files, signals, VM contexts, ...) is owned
+// by the home thread, i.e., the thread that runs main(); code that touches it runs there.
+// Process generations are sharded across the workers. A worker accepts and decodes the
+// requests of its processes and directly handles requests that only touch the file table
+// (which is protected by the FileContext's mutex) or immutable process state. All other
+// requests continue on the home thread.
+namespace workers {
+
+// Starts count workers. Must be called once on the home thread.
+void start(unsigned int count);
+
+unsigned int numWorkers();
+
+// Picks the worker that serves the requests of a new process generation.
+// Returns -1 (i.e., the home thread) if there are no workers.
+int pick();
+
+struct [[nodiscard]] SwitchTo : private helix::Context {
+	explicit SwitchTo(int index)
+	: _index{index} { }
+
+	bool await_ready();
+	void await_suspend(std::coroutine_handle<> handle);
+	void await_resume() { }
+
+private:
+	void complete(helix::ElementHandle element) override;
+
+	int _index;
+	std::coroutine_handle<> _handle;
+};
+
+// Continues the calling coroutine on the given worker (or on the home thread if index is -1).
+inline SwitchTo switchTo(int index) {
+	return SwitchTo{index};
+}
+
+inline SwitchTo switchToHome() {
+	return SwitchTo{-1};
+}
+
+// Counts a request that was received by the calling thread.
+// Local requests are handled without switching to the home thread.
+void countRequest(bool local);
+
+// Workers must not drop file references: dropping the last one runs File::handleClose().
+// Instead, they pass files that they detached from a FileContext to this function.
+void releaseOnHome(smarter::shared_ptr<File, FileHandle> file);
+
+std::shared_ptr<procfs::RegularNode> createStatsNode();
+
+} // namespace workers
@@ -4,6 +4,7 @@
 #include <stdint.h>
 #include <string.h>
 #include <unordered_map>
+#include <vector>
 
 #include <async/result.hpp>
 #include <async/cancellation.hpp>
@@ -29,6 +30,7 @@ struct File {
 	async::result<void> seekAbsolute(int64_t offset);
 
 	async::result<size_t> readSome(void *data, size_t max_length);
+	async::result<frg::expected<Error, size_t>> pread(int64_t offset, void *data, size_t max_length);
 	async::result<size_t> writeSome(const void *data, size_t max_length);
 
 	async::result<frg::expected<Error, PollWaitResult>>
@@ -47,4 +49,20 @@ private:
 
 using _detail::File;
 
+struct PollStatusBatchResult {
+	uint64_t sequence;
+	// If set, changedWatches is empty and any status page of the server might have changed.
+	bool overflow;
+	std::vector<uint64_t> changedWatches;
+};
+
+// Waits until the server's notifier sequence differs from the given sequence and returns
+// the watch IDs (see StatusPage::watchId) of the status pages that changed in between.
+// lane can be the passthrough lane of any file of the server.
+// On cancellation, the result contains the changes so far (i.e., possibly none).
+// Returns Error::brokenPipe if the lane was closed.
+async::result<frg::expected<Error, PollStatusBatchResult>>
+pollStatusBatch(helix::BorrowedDescriptor lane, uint64_t sequence,
+		async::cancellation_token cancellation = {});
+
 } } // namespace protocols::fs
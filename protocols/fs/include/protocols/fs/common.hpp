@@ -32,6 +32,7 @@ enum class Error {
 	noSpaceLeft = 21,
 	noBackingDevice = 23,
 	isDirectory = 22,
+	resourceBusy = 25,
 };
 
 using ReadResult = std::variant<Error, size_t>;
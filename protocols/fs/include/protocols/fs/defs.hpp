@@ -9,6 +9,29 @@ struct StatusPage {
 	uint64_t sequence;
 	int flags;
 	int status;
+
+	// Identifies this page in FILE_POLL_STATUS_BATCH responses of the server,
+	// or is zero if the server does not support that request.
+	// Watch IDs are only unique per server.
+	uint64_t watchId;
 };
 
+// Reads the sequence and status of a status page.
+// Returns false if the page was updated concurrently; callers should
+// fall back to FILE_POLL_STATUS in this case.
+inline bool readStatusPage(const StatusPage *page, uint64_t &sequence, int &status) {
+	// Start the seqlock read.
+	auto seqlock = __atomic_load_n(&page->seqlock, __ATOMIC_ACQUIRE);
+	if(seqlock & 1)
+		return false;
+
+	// Perform the actual loads.
+	sequence = __atomic_load_n(&page->sequence, __ATOMIC_RELAXED);
+	status = __atomic_load_n(&page->status, __ATOMIC_RELAXED);
+
+	// Finish the seqlock read.
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	return __atomic_load_n(&page->seqlock, __ATOMIC_RELAXED) == seqlock;
+}
+
 } // namespace protocols::fs
@@ -48,6 +48,16 @@ using OpenResult = std::pair<helix::UniqueLane, helix::UniqueLane>;
 using MkdirResult = std::pair<std::shared_ptr<void>, int64_t>;
 using SymlinkResult = std::pair<std::shared_ptr<void>, int64_t>;
 
+// Range of a memory object (usually a page cache) that holds the data of a read.
+// The server sends the data directly from this memory object.
+struct ReadView {
+	helix::BorrowedDescriptor memory;
+	uint64_t offset;
+	size_t length;
+};
+
+using ReadViewResult = std::variant<Error, ReadView>;
+
 using TraverseLinksResult = frg::expected<Error, std::tuple<std::vector<std::pair<std::shared_ptr<void>, int64_t>>, FileType, size_t>>;
 
 struct FileOperations {
@@ -85,6 +95,16 @@ struct FileOperations {
 		readEntries = f;
 		return *this;
 	}
+	constexpr FileOperations &withReadView(async::result<ReadViewResult> (*f)(void *object,
+			const char *, size_t length)) {
+		readView = f;
+		return *this;
+	}
+	constexpr FileOperations &withPreadView(async::result<ReadViewResult> (*f)(void *object,
+			int64_t offset, const char *, size_t length)) {
+		preadView = f;
+		return *this;
+	}
 	constexpr FileOperations &withAccessMemory(async::result<helix::BorrowedDescriptor>(*f)(void *object)) {
 		accessMemory = f;
 		return *this;
@@ -95,7 +115,7 @@ struct FileOperations {
 		return *this;
 	}
 	constexpr FileOperations &withFallocate(async::result<frg::expected<protocols::fs::Error>> (*f)(void *object,
-			int64_t offset, size_t size)) {
+			int mode, int64_t offset, size_t size)) {
 		fallocate = f;
 		return *this;
 	}
@@ -152,6 +172,12 @@ struct FileOperations {
 			void *buffer, size_t length);
 	async::result<ReadResult> (*pread)(void *object, int64_t offset, const char *credentials,
 			void *buffer, size_t length);
+	// Optional alternatives to read / pread that avoid copying through an intermediate buffer.
+	// Used for large reads if available.
+	async::result<ReadViewResult> (*readView)(void *object, const char *credentials,
+			size_t length);
+	async::result<ReadViewResult> (*preadView)(void *object, int64_t offset,
+			const char *credentials, size_t length);
 	async::result<frg::expected<protocols::fs::Error, size_t>> (*write)(void *object, const char *credentials,
 			const void *buffer, size_t length);
 	async::result<frg::expected<protocols::fs::Error, size_t>> (*pwrite)(void *object, int64_t offset, const char *credentials,
@@ -159,7 +185,8 @@ struct FileOperations {
 	async::result<ReadEntriesResult> (*readEntries)(void *object);
 	async::result<helix::BorrowedDescriptor>(*accessMemory)(void *object);
 	async::result<frg::expected<protocols::fs::Error>> (*truncate)(void *object, size_t size);
-	async::result<frg::expected<protocols::fs::Error>> (*fallocate)(void *object, int64_t offset, size_t size);
+	async::result<frg::expected<protocols::fs::Error>> (*fallocate)(void *object, int mode,
+			int64_t offset, size_t size);
 	async::result<void> (*ioctl)(void *object, managarm::fs::CntRequest req,
 			helix::UniqueLane conversation);
 	async::result<protocols::fs::Error> (*flock)(void *object, int flags);
@@ -188,6 +215,8 @@ struct FileOperations {
 	async::result<frg::expected<Error, size_t>> (*peername)(void *object, void *addr_ptr, size_t max_addr_length);
 	async::result<frg::expected<Error, int>> (*getSeals)(void *object);
 	async::result<frg::expected<Error, int>> (*addSeals)(void *object, int seals);
+	async::result<frg::expected<Error, size_t>> (*getPipeSize)(void *object);
+	async::result<frg::expected<Error, size_t>> (*setPipeSize)(void *object, size_t size);
 
 	bool logRequests = false;
 };
@@ -204,6 +233,7 @@ struct StatusPageProvider {
 private:
 	helix::UniqueDescriptor _memory;
 	helix::Mapping _mapping;
+	uint64_t _watchId;
 };
 
 struct NodeOperations {
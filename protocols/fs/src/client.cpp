@@ -70,6 +70,46 @@ async::result<size_t> File::readSome(void *data, size_t max_length) {
 	co_return recv_data.actualLength();
 }
 
+async::result<frg::expected<Error, size_t>> File::pread(int64_t offset, void *data,
+		size_t max_length) {
+	managarm::fs::CntRequest req;
+	req.set_req_type(managarm::fs::CntReqType::PT_PREAD);
+	req.set_offset(offset);
+	req.set_size(max_length);
+
+	auto ser = req.SerializeAsString();
+	uint8_t buffer[128];
+
+	auto [offer, send_req, imbue_creds, recv_resp, recv_data] =
+		co_await helix_ng::exchangeMsgs(
+			_lane,
+			helix_ng::offer(
+				helix_ng::sendBuffer(ser.data(), ser.size()),
+				helix_ng::imbueCredentials(),
+				helix_ng::recvBuffer(buffer, 128),
+				helix_ng::recvBuffer(data, max_length)
+			)
+		);
+
+	HEL_CHECK(offer.error());
+	HEL_CHECK(send_req.error());
+	HEL_CHECK(imbue_creds.error());
+	HEL_CHECK(recv_resp.error());
+
+	// On errors, the server does not send any data.
+	managarm::fs::SvrResponse resp;
+	resp.ParseFromArray(buffer, recv_resp.actualLength());
+	if(resp.error() == managarm::fs::Errors::END_OF_FILE)
+		co_return 0;
+	if(resp.error() == managarm::fs::Errors::ILLEGAL_OPERATION_TARGET)
+		co_return Error::illegalOperationTarget;
+	if(resp.error() == managarm::fs::Errors::ILLEGAL_ARGUMENT)
+		co_return Error::illegalArguments;
+	assert(resp.error() == managarm::fs::Errors::SUCCESS);
+	HEL_CHECK(recv_data.error());
+	co_return recv_data.actualLength();
+}
+
 async::result<size_t> File::writeSome(const void *data, size_t maxLength) {
 	managarm::fs::CntRequest req;
 	req.set_req_type(managarm::fs::CntReqType::WRITE);
@@ -173,6 +213,64 @@ async::result<frg::expected<Error, PollStatusResult>> File::pollStatus() {
 	co_return PollStatusResult(resp.sequence(), resp.status());
 }
 
+async::result<frg::expected<Error, PollStatusBatchResult>>
+pollStatusBatch(helix::BorrowedDescriptor lane, uint64_t sequence,
+		async::cancellation_token cancellation) {
+	HelHandle cancelHandle;
+	HEL_CHECK(helCreateOneshotEvent(&cancelHandle));
+	helix::UniqueDescriptor cancelEvent{cancelHandle};
+
+	// The server waits for the event until it is raised, hence we raise it exactly once:
+	// either on cancellation or after the response arrived.
+	bool raised = false;
+	auto raiseCancel = [&] {
+		if(raised)
+			return;
+		HEL_CHECK(helRaiseEvent(cancelEvent.getHandle()));
+		raised = true;
+	};
+
+	managarm::fs::CntRequest req;
+	req.set_req_type(managarm::fs::CntReqType::FILE_POLL_STATUS_BATCH);
+	req.set_sequence(sequence);
+
+	auto ser = req.SerializeAsString();
+	// Large enough for the maximal number of watches per response.
+	std::vector<uint8_t> buffer(8192);
+
+	async::cancellation_callback cancelCallback{cancellation, raiseCancel};
+
+	auto [offer, send_req, push_cancel, recv_resp] =
+		co_await helix_ng::exchangeMsgs(
+			lane,
+			helix_ng::offer(
+				helix_ng::sendBuffer(ser.data(), ser.size()),
+				helix_ng::pushDescriptor(cancelEvent),
+				helix_ng::recvBuffer(buffer.data(), buffer.size())
+			)
+		);
+	raiseCancel();
+
+	if(offer.error() == kHelErrEndOfLane || recv_resp.error() == kHelErrEndOfLane)
+		co_return Error::brokenPipe;
+	HEL_CHECK(offer.error());
+	HEL_CHECK(send_req.error());
+	HEL_CHECK(push_cancel.error());
+	HEL_CHECK(recv_resp.error());
+
+	managarm::fs::SvrResponse resp;
+	resp.ParseFromArray(buffer.data(), recv_resp.actualLength());
+
+	if(resp.error() != managarm::fs::Errors::SUCCESS)
+		co_return static_cast<Error>(resp.error());
+
+	PollStatusBatchResult result;
+	result.sequence = resp.sequence();
+	result.overflow = resp.watches_overflowed();
+	result.changedWatches = resp.changed_watches();
+	co_return std::move(result);
+}
+
 async::result<helix::UniqueDescriptor> File::accessMemory() {
 	managarm::fs::CntRequest req;
 	req.set_req_type(managarm::fs::CntReqType::MMAP);
@@ -2,9 +2,13 @@
 #include <stdio.h>
 #include <string.h>
 #include <unistd.h>
+#include <algorithm>
+#include <bit>
 #include <iostream>
+#include <memory>
 #include <vector>
 
+#include <async/recurring-event.hpp>
 #include <helix/ipc.hpp>
 
 #include <protocols/fs/server.hpp>
@@ -15,6 +19,170 @@ namespace fs {
 
 namespace {
 
+// Tracks which StatusPageProviders of this process changed their status.
+// Clients wait for changes of all pages at once using FILE_POLL_STATUS_BATCH
+// instead of issuing one FILE_POLL_WAIT per file.
+struct StatusNotifier {
+	// Number of changes that we remember for FILE_POLL_STATUS_BATCH.
+	static constexpr size_t maxLogSize = 1024;
+	// If more pages changed, we only report an overflow.
+	static constexpr size_t maxBatchSize = 512;
+
+	static StatusNotifier &global() {
+		static StatusNotifier notifier;
+		return notifier;
+	}
+
+	void markChanged(uint64_t watchId) {
+		currentSeq++;
+		log.push_back({currentSeq, watchId});
+		if(log.size() > maxLogSize)
+			log.pop_front();
+		bell.raise();
+	}
+
+	// Zero is reserved for status pages without batch support.
+	uint64_t nextWatchId = 1;
+	uint64_t currentSeq = 0;
+	// Pairs of (sequence, watch ID), ordered by sequence.
+	std::deque<std::pair<uint64_t, uint64_t>> log;
+	async::recurring_event bell;
+};
+
+// Clients raise the event exactly once: either to cancel a FILE_POLL_STATUS_BATCH request
+// or after they received the response. Hence, this coroutine always terminates.
+async::detached awaitStatusBatchCancel(helix::UniqueDescriptor event,
+		std::shared_ptr<bool> cancelled) {
+	auto await = co_await helix_ng::awaitEvent(event, 1);
+	HEL_CHECK(await.error());
+	*cancelled = true;
+	StatusNotifier::global().bell.raise();
+}
+
+// Reads of at least this size are served via readView / preadView (if available).
+// For smaller reads, locking and mapping the memory costs more than the copy.
+constexpr size_t minViewReadSize = 16 * 1024;
+
+// Buffer for the data of READ / PT_PREAD. In contrast to std::string::resize(),
+// the memory is not zero-initialized. Buffers of up to maxPooledSize are recycled.
+struct ReadBuffer {
+	static constexpr size_t minPooledSize = 0x1000;
+	static constexpr size_t maxPooledSize = 0x100000;
+	static constexpr size_t maxPooledPerClass = 4;
+
+	explicit ReadBuffer(size_t size) {
+		if(size > maxPooledSize) {
+			// Unpooled buffers are allocated with their exact size.
+			_class = size;
+			_data.reset(new char[size]);
+			return;
+		}
+
+		_class = std::max(minPooledSize, std::bit_ceil(size));
+		auto &list = _freeList(_class);
+		if(!list.empty()) {
+			_data = std::move(list.back());
+			list.pop_back();
+			return;
+		}
+		_data.reset(new char[_class]);
+	}
+
+	ReadBuffer(const ReadBuffer &) = delete;
+
+	ReadBuffer &operator= (const ReadBuffer &) = delete;
+
+	~ReadBuffer() {
+		if(_class > maxPooledSize)
+			return;
+		auto &list = _freeList(_class);
+		if(list.size() < maxPooledPerClass)
+			list.push_back(std::move(_data));
+	}
+
+	char *data() {
+		return _data.get();
+	}
+
+private:
+	static std::vector<std::unique_ptr<char[]>> &_freeList(size_t size_class) {
+		thread_local std::vector<std::unique_ptr<char[]>>
+				lists[std::countr_zero(maxPooledSize) + 1];
+		return lists[std::countr_zero(size_class)];
+	}
+
+	size_t _class;
+	std::unique_ptr<char[]> _data;
+};
+
+// Sends the response to READ / PT_PREAD.
+async::result<void> sendReadResult(helix::UniqueLane &conversation, ReadResult res,
+		const char *data) {
+	managarm::fs::SvrResponse resp;
+	auto error = std::get_if<Error>(&res);
+	if(error && *error == Error::wouldBlock) {
+		resp.set_error(managarm::fs::Errors::WOULD_BLOCK);
+
+		auto ser = resp.SerializeAsString();
+		auto [send_resp] = co_await helix_ng::exchangeMsgs(
+			conversation,
+			helix_ng::sendBuffer(ser.data(), ser.size())
+		);
+		HEL_CHECK(send_resp.error());
+	}else if(error && *error == Error::illegalArguments) {
+		resp.set_error(managarm::fs::Errors::ILLEGAL_ARGUMENT);
+
+		auto ser = resp.SerializeAsString();
+		auto [send_resp] = co_await helix_ng::exchangeMsgs(
+			conversation,
+			helix_ng::sendBuffer(ser.data(), ser.size())
+		);
+		HEL_CHECK(send_resp.error());
+	}else{
+		assert(!error);
+		resp.set_error(managarm::fs::Errors::SUCCESS);
+
+		auto ser = resp.SerializeAsString();
+		auto [send_resp, send_data] = co_await helix_ng::exchangeMsgs(
+			conversation,
+			helix_ng::sendBuffer(ser.data(), ser.size()),
+			helix_ng::sendBuffer(data, std::get<size_t>(res))
+		);
+		HEL_CHECK(send_resp.error());
+		HEL_CHECK(send_data.error());
+	}
+}
+
+// Sends the response to READ / PT_PREAD directly from the memory object of a ReadView.
+async::result<void> sendReadView(helix::UniqueLane &conversation, ReadViewResult res) {
+	if(auto error = std::get_if<Error>(&res); error) {
+		co_await sendReadResult(conversation, *error, nullptr);
+		co_return;
+	}
+
+	auto view = std::get<ReadView>(res);
+	if(!view.length) {
+		co_await sendReadResult(conversation, size_t{0}, nullptr);
+		co_return;
+	}
+
+	auto mapOffset = view.offset & ~uint64_t(0xFFF);
+	auto mapSize = ((view.offset & 0xFFF) + view.length + 0xFFF) & ~size_t(0xFFF);
+
+	// Make sure that the pages are present while we send from them.
+	helix::LockMemoryView lockMemory;
+	auto &&submit = helix::submitLockMemoryView(view.memory,
+			&lockMemory, mapOffset, mapSize, helix::Dispatcher::global());
+	co_await submit.async_wait();
+	HEL_CHECK(lockMemory.error());
+
+	helix::Mapping mapping{view.memory, static_cast<ptrdiff_t>(mapOffset), mapSize,
+			kHelMapProtRead | kHelMapDontRequireBacking};
+
+	auto data = reinterpret_cast<const char *>(mapping.get()) + (view.offset - mapOffset);
+	co_await sendReadResult(conversation, view.length, data);
+}
+
 async::detached handlePassthrough(smarter::shared_ptr<void> file,
 		const FileOperations *file_ops,
 		managarm::fs::CntRequest req, helix::UniqueLane conversation) {
@@ -123,44 +291,17 @@ async::detached handlePassthrough(smarter::shared_ptr<void> file,
 			co_return;
 		}
 
-		std::string data;
-		data.resize(req.size());
+		if(file_ops->readView && req.size() >= minViewReadSize) {
+			auto res = co_await file_ops->readView(file.get(), extract_creds.credentials(),
+					req.size());
+			co_await sendReadView(conversation, std::move(res));
+			co_return;
+		}
+
+		ReadBuffer data{req.size()};
 		auto res = co_await file_ops->read(file.get(), extract_creds.credentials(),
 				data.data(), req.size());
-
-		managarm::fs::SvrResponse resp;
-		auto error = std::get_if<Error>(&res);
-		if(error && *error == Error::wouldBlock) {
-			resp.set_error(managarm::fs::Errors::WOULD_BLOCK);
-
-			auto ser = resp.SerializeAsString();
-			auto [send_resp] = co_await helix_ng::exchangeMsgs(
-				conversation,
-				helix_ng::sendBuffer(ser.data(), ser.size())
-			);
-			HEL_CHECK(send_resp.error());
-		}else if(error && *error == Error::illegalArguments) {
-			resp.set_error(managarm::fs::Errors::ILLEGAL_ARGUMENT);
-
-			auto ser = resp.SerializeAsString();
-			auto [send_resp] = co_await helix_ng::exchangeMsgs(
-				conversation,
-				helix_ng::sendBuffer(ser.data(), ser.size())
-			);
-			HEL_CHECK(send_resp.error());
-		}else{
-			assert(!error);
-			resp.set_error(managarm::fs::Errors::SUCCESS);
-
-			auto ser = resp.SerializeAsString();
-			auto [send_resp, send_data] = co_await helix_ng::exchangeMsgs(
-				conversation,
-				helix_ng::sendBuffer(ser.data(), ser.size()),
-				helix_ng::sendBuffer(data.data(), std::get<size_t>(res))
-			);
-			HEL_CHECK(send_resp.error());
-			HEL_CHECK(send_data.error());
-		}
+		co_await sendReadResult(conversation, std::move(res), data.data());
 	}else if(req.req_type() == managarm::fs::CntReqType::PT_PREAD) {
 		auto [extract_creds] = co_await helix_ng::exchangeMsgs(
 			conversation,
@@ -181,44 +322,17 @@ async::detached handlePassthrough(smarter::shared_ptr<void> file,
 			co_return;
 		}
 
-		std::string data;
-		data.resize(req.size());
+		if(file_ops->preadView && req.size() >= minViewReadSize) {
+			auto res = co_await file_ops->preadView(file.get(), req.offset(),
+					extract_creds.credentials(), req.size());
+			co_await sendReadView(conversation, std::move(res));
+			co_return;
+		}
+
+		ReadBuffer data{req.size()};
 		auto res = co_await file_ops->pread(file.get(), req.offset(), extract_creds.credentials(),
 				data.data(), req.size());
-
-		managarm::fs::SvrResponse resp;
-		auto error = std::get_if<Error>(&res);
-		if(error && *error == Error::wouldBlock) {
-			resp.set_error(managarm::fs::Errors::WOULD_BLOCK);
-
-			auto ser = resp.SerializeAsString();
-			auto [send_resp] = co_await helix_ng::exchangeMsgs(
-				conversation,
-				helix_ng::sendBuffer(ser.data(), ser.size())
-			);
-			HEL_CHECK(send_resp.error());
-		}else if(error && *error == Error::illegalArguments) {
-			resp.set_error(managarm::fs::Errors::ILLEGAL_ARGUMENT);
-
-			auto ser = resp.SerializeAsString();
-			auto [send_resp] = co_await helix_ng::exchangeMsgs(
-				conversation,
-				helix_ng::sendBuffer(ser.data(), ser.size())
-			);
-			HEL_CHECK(send_resp.error());
-		}else{
-			assert(!error);
-			resp.set_error(managarm::fs::Errors::SUCCESS);
-
-			auto ser = resp.SerializeAsString();
-			auto [send_resp, send_data] = co_await helix_ng::exchangeMsgs(
-				conversation,
-				helix_ng::sendBuffer(ser.data(), ser.size()),
-				helix_ng::sendBuffer(data.data(), std::get<size_t>(res))
-			);
-			HEL_CHECK(send_resp.error());
-			HEL_CHECK(send_data.error());
-		}
+		co_await sendReadResult(conversation, std::move(res), data.data());
 	}else if(req.req_type() == managarm::fs::CntReqType::WRITE) {
 		std::vector<uint8_t> buffer;
 		buffer.resize(req.size());
@@ -255,6 +369,8 @@ async::detached handlePassthrough(smarter::shared_ptr<void> file,
 				resp.set_error(managarm::fs::Errors::WOULD_BLOCK);
 			} else if(res.error() == Error::seekOnPipe) {
 				resp.set_error(managarm::fs::Errors::SEEK_ON_PIPE);
+			} else if(res.error() == Error::brokenPipe) {
+				resp.set_error(managarm::fs::Errors::BROKEN_PIPE);
 			} else {
 				std::cout << "Unknown error from write()" << std::endl;
 				co_return;
@@ -457,7 +573,8 @@ async::detached handlePassthrough(smarter::shared_ptr<void> file,
 			HEL_CHECK(send_resp.error());
 			co_return;
 		}
-		auto result = co_await file_ops->fallocate(file.get(), req.rel_offset(), req.size());
+		auto result = co_await file_ops->fallocate(file.get(), req.flags(),
+				req.rel_offset(), req.size());
 
 		managarm::fs::SvrResponse resp;
 
@@ -617,6 +734,55 @@ async::detached handlePassthrough(smarter::shared_ptr<void> file,
 		resp.set_sequence(std::get<0>(result));
 		resp.set_status(std::get<1>(result));
 
+		auto ser = resp.SerializeAsString();
+		auto [send_resp] = co_await helix_ng::exchangeMsgs(
+			conversation,
+			helix_ng::sendBuffer(ser.data(), ser.size())
+		);
+		HEL_CHECK(send_resp.error());
+	}else if(req.req_type() == managarm::fs::CntReqType::FILE_POLL_STATUS_BATCH) {
+		auto [pull_cancel] = co_await helix_ng::exchangeMsgs(
+			conversation,
+			helix_ng::pullDescriptor()
+		);
+		HEL_CHECK(pull_cancel.error());
+
+		auto cancelled = std::make_shared<bool>(false);
+		awaitStatusBatchCancel(pull_cancel.descriptor(), cancelled);
+
+		// This request does not depend on the file; it covers all status pages of the server.
+		// If the request is cancelled, we report the changes so far (i.e., possibly none).
+		auto &notifier = StatusNotifier::global();
+		auto sequence = req.sequence();
+		while(notifier.currentSeq == sequence && !*cancelled)
+			co_await notifier.bell.async_wait();
+
+		// Report an overflow if some of the changes are not in the log anymore.
+		bool overflow = notifier.currentSeq != sequence
+				&& (sequence > notifier.currentSeq || notifier.log.empty()
+					|| notifier.log.front().first > sequence + 1);
+		std::vector<uint64_t> watches;
+		if(!overflow) {
+			for(auto it = notifier.log.rbegin(); it != notifier.log.rend(); ++it) {
+				if(it->first <= sequence)
+					break;
+				watches.push_back(it->second);
+			}
+			std::sort(watches.begin(), watches.end());
+			watches.erase(std::unique(watches.begin(), watches.end()), watches.end());
+			if(watches.size() > StatusNotifier::maxBatchSize)
+				overflow = true;
+		}
+
+		managarm::fs::SvrResponse resp;
+		resp.set_error(managarm::fs::Errors::SUCCESS);
+		resp.set_sequence(notifier.currentSeq);
+		resp.set_watches_overflowed(overflow);
+		if(!overflow) {
+			for(auto watchId : watches)
+				resp.add_changed_watches(watchId);
+		}
+
 		auto ser = resp.SerializeAsString();
 		auto [send_resp] = co_await helix_ng::exchangeMsgs(
 			conversation,
@@ -947,17 +1113,22 @@ async::detached handlePassthrough(smarter::shared_ptr<void> file,
 		if(!res) {
 			if(res.error() == Error::wouldBlock) {
 				resp.set_error(managarm::fs::Errors::WOULD_BLOCK);
-
-				auto ser = resp.SerializeAsString();
-				auto [send_resp] = co_await helix_ng::exchangeMsgs(
-					conversation,
-					helix_ng::sendBuffer(ser.data(), ser.size())
-				);
-				HEL_CHECK(send_resp.error());
+			} else if(res.error() == Error::brokenPipe) {
+				resp.set_error(managarm::fs::Errors::BROKEN_PIPE);
+			} else if(res.error() == Error::messageSize) {
+				resp.set_error(managarm::fs::Errors::MESSAGE_TOO_LARGE);
 			} else {
 				std::cout << "Unknown error from sendMsg()" << std::endl;
 				co_return;
 			}
+
+			auto ser = resp.SerializeAsString();
+			auto [send_resp] = co_await helix_ng::exchangeMsgs(
+				conversation,
+				helix_ng::sendBuffer(ser.data(), ser.size())
+			);
+			HEL_CHECK(send_resp.error());
+			co_return;
 		}
 
 		resp.set_error(managarm::fs::Errors::SUCCESS);
@@ -1012,6 +1183,47 @@ async::detached handlePassthrough(smarter::shared_ptr<void> file,
 			resp.set_error(managarm::fs::Errors::SUCCESS);
 		}
 
+		auto ser = resp.SerializeAsString();
+		auto [send_resp] = co_await helix_ng::exchangeMsgs(
+			conversation,
+			helix_ng::sendBuffer(ser.data(), ser.size())
+		);
+		HEL_CHECK(send_resp.error());
+	} else if (req.req_type() == managarm::fs::CntReqType::PT_GET_PIPE_SIZE
+			|| req.req_type() == managarm::fs::CntReqType::PT_SET_PIPE_SIZE) {
+		managarm::fs::SvrResponse resp;
+
+		frg::expected<Error, size_t> result = Error::illegalOperationTarget;
+		if(req.req_type() == managarm::fs::CntReqType::PT_GET_PIPE_SIZE) {
+			if(file_ops->getPipeSize)
+				result = co_await file_ops->getPipeSize(file.get());
+		}else{
+			if(req.size() < 0)
+				result = Error::illegalArguments;
+			else if(file_ops->setPipeSize)
+				result = co_await file_ops->setPipeSize(file.get(), req.size());
+		}
+
+		if(!result) {
+			switch(result.error()) {
+				case protocols::fs::Error::resourceBusy: {
+					resp.set_error(managarm::fs::Errors::RESOURCE_BUSY);
+					break;
+				}
+				case protocols::fs::Error::illegalArguments: {
+					resp.set_error(managarm::fs::Errors::ILLEGAL_ARGUMENT);
+					break;
+				}
+				default: {
+					resp.set_error(managarm::fs::Errors::ILLEGAL_OPERATION_TARGET);
+					break;
+				}
+			}
+		} else {
+			resp.set_error(managarm::fs::Errors::SUCCESS);
+			resp.set_size(result.value());
+		}
+
 		auto ser = resp.SerializeAsString();
 		auto [send_resp] = co_await helix_ng::exchangeMsgs(
 			conversation,
@@ -1086,11 +1298,21 @@ StatusPageProvider::StatusPageProvider() {
 	HEL_CHECK(helAllocateMemory(page_size, 0, nullptr, &handle));
 	_memory = helix::UniqueDescriptor{handle};
 	_mapping = helix::Mapping{_memory, 0, page_size};
+
+	_watchId = StatusNotifier::global().nextWatchId++;
+
+	auto page = reinterpret_cast<protocols::fs::StatusPage *>(_mapping.get());
+	__atomic_store_n(&page->watchId, _watchId, __ATOMIC_RELAXED);
 }
 
 void StatusPageProvider::update(uint64_t sequence, int status) {
 	auto page = reinterpret_cast<protocols::fs::StatusPage *>(_mapping.get());
 
+	// Do not wake up clients if nothing changed. We are the only writer of the page.
+	if(__atomic_load_n(&page->sequence, __ATOMIC_RELAXED) == sequence
+			&& __atomic_load_n(&page->status, __ATOMIC_RELAXED) == status)
+		return;
+
 	// State the seqlock write.
 	auto seqlock = __atomic_load_n(&page->seqlock, __ATOMIC_RELAXED);
 	assert(!(seqlock & 1));
@@ -1103,6 +1325,8 @@ void StatusPageProvider::update(uint64_t sequence, int status) {
 
 	// Complete the seqlock write.
 	__atomic_store_n(&page->seqlock, seqlock + 2, __ATOMIC_RELEASE);
+
+	StatusNotifier::global().markChanged(_watchId);
 }
 
 async::detached serveNode(helix::UniqueLane lane, std::shared_ptr<void> node,
@@ -182,9 +182,10 @@ async::detached handleObserver(std::shared_ptr<Connection> connection,
 	while(true) {
 		helix::RecvBuffer recv_req;
 
-		char buffer[1024];
+		// mbus limits ATTACH_BATCH messages to 8 KiB.
+		char buffer[16384];
 		auto &&header = helix::submitAsync(lane, helix::Dispatcher::global(),
-				helix::action(&recv_req, buffer, 1024));
+				helix::action(&recv_req, buffer, 16384));
 		co_await header.async_wait();
 		HEL_CHECK(recv_req.error());
 
@@ -196,6 +197,14 @@ async::detached handleObserver(std::shared_ptr<Connection> connection,
 				properties.insert({ kv.name(), StringItem{kv.item().string_item().value()} });
 
 			handler.attach(Entity{connection, req.id()}, std::move(properties));
+		}else if(req.req_type() == managarm::mbus::SvrReqType::ATTACH_BATCH) {
+			for(auto &info : req.entities()) {
+				Properties properties;
+				for(auto &kv : info.properties())
+					properties.insert({ kv.name(), StringItem{kv.item().string_item().value()} });
+
+				handler.attach(Entity{connection, info.id()}, std::move(properties));
+			}
 		}else{
 			throw std::runtime_error("Unexpected request type");
 		}
@@ -4,6 +4,7 @@
 
 #include <async/result.hpp>
 #include <helix/ipc.hpp>
+#include <helix/memory.hpp>
 #include <ostrace.bragi.hpp>
 
 namespace protocols::ostrace {
@@ -11,9 +12,12 @@ namespace protocols::ostrace {
 enum class EventId : uint64_t { };
 enum class ItemId : uint64_t { };
 
+// Events are written to a shared-memory ring that is owned by the Context.
+// Hence, a Context must not be used by multiple threads concurrently.
 struct Context {
 	Context();
 	Context(helix::UniqueLane lane, bool enabled);
+	Context(helix::UniqueLane lane, helix::Mapping ring);
 
 	inline helix::BorrowedLane getLane() {
 		return lane_;
@@ -27,9 +31,13 @@ struct Context {
 	async::result<EventId> announceEvent(std::string_view name);
 	async::result<ItemId> announceItem(std::string_view name);
 
+	// Appends a record to the ring. Drops the record if the ring is full.
+	void commitRecord(managarm::ostrace::EventRecord &record);
+
 private:
 	helix::UniqueLane lane_;
 	bool enabled_;
+	helix::Mapping ring_;
 };
 
 struct Event {
@@ -37,12 +45,13 @@ struct Event {
 
 	void withCounter(ItemId id, int64_t value);
 
+	// Does not block; the result only exists for compatibility.
 	async::result<void> emit();
 
 private:
 	Context *ctx_;
 	bool live_; // Whether we emit an event at all.
-	managarm::ostrace::EmitEventReq req_;
+	managarm::ostrace::EventRecord record_;
 };
 
 async::result<Context> createContext();
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace protocols::ostrace {
+
+// Emitters write EventRecords into a shared-memory ring that the kernel drains
+// asynchronously. The ring memory consists of a page containing the RingHeader,
+// followed by ringDataSize bytes of data. Each entry in the data area is a
+// 32-bit length followed by a bragi-encoded EventRecord; entries wrap around
+// at the end of the data area.
+struct RingHeader {
+	// Total number of bytes written so far. Only modified by the emitter.
+	uint64_t writePtr;
+	// Total number of bytes consumed so far. Only modified by the kernel.
+	uint64_t readPtr;
+	// Number of records that the emitter dropped because the ring was full.
+	uint64_t numDropped;
+};
+
+inline constexpr size_t ringHeaderSize = 0x1000;
+inline constexpr size_t ringDataSize = 0x10000;
+
+// Maximal size of an entry, including its length.
+inline constexpr size_t maxRingEntrySize = 0x400;
+
+} // namespace protocols::ostrace
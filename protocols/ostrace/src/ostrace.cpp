@@ -1,8 +1,13 @@
+#include <string.h>
+#include <algorithm>
+
 #include <async/oneshot-event.hpp>
 #include <bragi/helpers-std.hpp>
+#include <frg/span.hpp>
 #include <frg/std_compat.hpp>
 #include <protocols/mbus/client.hpp>
 #include <protocols/ostrace/ostrace.hpp>
+#include <protocols/ostrace/ring.hpp>
 #include <ostrace.bragi.hpp>
 
 namespace protocols::ostrace {
@@ -13,6 +18,9 @@ Context::Context()
 Context::Context(helix::UniqueLane lane, bool enabled)
 : lane_{std::move(lane)}, enabled_{enabled} { }
 
+Context::Context(helix::UniqueLane lane, helix::Mapping ring)
+: lane_{std::move(lane)}, enabled_{true}, ring_{std::move(ring)} { }
+
 async::result<EventId> Context::announceEvent(std::string_view name) {
 	managarm::ostrace::AnnounceEventReq req;
 	req.set_name(std::string{name});
@@ -65,10 +73,48 @@ async::result<ItemId> Context::announceItem(std::string_view name) {
 	co_return ItemId{resp.id()};
 }
 
+void Context::commitRecord(managarm::ostrace::EventRecord &record) {
+	auto header = reinterpret_cast<RingHeader *>(ring_.get());
+	auto data = reinterpret_cast<char *>(ring_.get()) + ringHeaderSize;
+
+	// Encode the entry locally, then copy it into the ring.
+	char entry[maxRingEntrySize];
+	uint32_t length = managarm::ostrace::EventRecord::head_size + record.size_of_tail();
+	size_t entrySize = sizeof(uint32_t) + length;
+	if(entrySize > maxRingEntrySize) {
+		__atomic_store_n(&header->numDropped,
+				__atomic_load_n(&header->numDropped, __ATOMIC_RELAXED) + 1, __ATOMIC_RELAXED);
+		return;
+	}
+	memcpy(entry, &length, sizeof(uint32_t));
+	bool encodeSuccess = bragi::write_head_tail(record,
+			frg::span<char>{entry + sizeof(uint32_t), managarm::ostrace::EventRecord::head_size},
+			frg::span<char>{entry + sizeof(uint32_t) + managarm::ostrace::EventRecord::head_size,
+					record.size_of_tail()});
+	assert(encodeSuccess);
+
+	// We are the only writer of writePtr; the kernel only advances readPtr.
+	auto writePtr = __atomic_load_n(&header->writePtr, __ATOMIC_RELAXED);
+	auto readPtr = __atomic_load_n(&header->readPtr, __ATOMIC_ACQUIRE);
+	if(writePtr + entrySize - readPtr > ringDataSize) {
+		__atomic_store_n(&header->numDropped,
+				__atomic_load_n(&header->numDropped, __ATOMIC_RELAXED) + 1, __ATOMIC_RELAXED);
+		return;
+	}
+
+	auto offset = writePtr & (ringDataSize - 1);
+	auto chunk = std::min(entrySize, ringDataSize - offset);
+	memcpy(data + offset, entry, chunk);
+	if(chunk < entrySize)
+		memcpy(data, entry + chunk, entrySize - chunk);
+
+	__atomic_store_n(&header->writePtr, writePtr + entrySize, __ATOMIC_RELEASE);
+}
+
 Event::Event(Context *ctx, EventId id)
 : ctx_{ctx} {
 	live_ = ctx->isActive();
-	req_.set_id(static_cast<uint64_t>(id));
+	record_.set_id(static_cast<uint64_t>(id));
 }
 
 void Event::withCounter(ItemId id, int64_t value) {
@@ -78,31 +124,17 @@ void Event::withCounter(ItemId id, int64_t value) {
 	managarm::ostrace::CounterItem item;
 	item.set_id(static_cast<uint64_t>(id));
 	item.set_value(value);
-	req_.add_ctrs(std::move(item));
+	record_.add_ctrs(std::move(item));
 }
 
 async::result<void> Event::emit() {
 	if(!live_)
 		co_return;
 
-	auto [offer, sendReq, recvResp] =
-		co_await helix_ng::exchangeMsgs(
-			ctx_->getLane(),
-			helix_ng::offer(
-				helix_ng::sendBragiHeadOnly(req_, frg::stl_allocator{}),
-				helix_ng::recvInline()
-			)
-		);
-
-	HEL_CHECK(offer.error());
-	HEL_CHECK(sendReq.error());
-	HEL_CHECK(recvResp.error());
-
-	auto maybeResp = bragi::parse_head_only<managarm::ostrace::Response>(recvResp);
-	recvResp.reset();
-	assert(maybeResp);
-	auto &resp = maybeResp.value();
-	assert(resp.error() == managarm::ostrace::Error::SUCCESS);
+	uint64_t ts;
+	HEL_CHECK(helGetClock(&ts));
+	record_.set_ts(ts);
+	ctx_->commitRecord(record_);
 }
 
 async::result<Context> createContext() {
@@ -155,7 +187,33 @@ async::result<Context> createContext() {
 		co_return Context{std::move(lane), false};
 
 	assert(resp.error() == managarm::ostrace::Error::SUCCESS);
-	co_return Context{std::move(lane), true};
+
+	// Obtain a ring to write events to.
+
+	managarm::ostrace::CreateRingReq ringReq;
+
+	auto [ringOffer, sendRingReq, recvRingResp, pullMemory] =
+		co_await helix_ng::exchangeMsgs(
+			lane,
+			helix_ng::offer(
+				helix_ng::sendBragiHeadOnly(ringReq, frg::stl_allocator{}),
+				helix_ng::recvInline(),
+				helix_ng::pullDescriptor()
+			)
+		);
+
+	HEL_CHECK(ringOffer.error());
+	HEL_CHECK(sendRingReq.error());
+	HEL_CHECK(recvRingResp.error());
+	HEL_CHECK(pullMemory.error());
+
+	auto maybeRingResp = bragi::parse_head_only<managarm::ostrace::Response>(recvRingResp);
+	recvRingResp.reset();
+	assert(maybeRingResp);
+	assert(maybeRingResp.value().error() == managarm::ostrace::Error::SUCCESS);
+
+	helix::Mapping ring{pullMemory.descriptor(), 0, ringHeaderSize + ringDataSize};
+	co_return Context{std::move(lane), std::move(ring)};
 }
 
 } // namespace protocols::ostrace
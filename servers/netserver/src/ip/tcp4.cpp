@@ -192,10 +192,15 @@ struct Tcp4Socket {
 	static auto makeSocket(Tcp4 *parent, bool nonBlock) {
 		auto s = smarter::make_shared<Tcp4Socket>(parent, nonBlock);
 		s->holder_ = s;
+		s->updateStatusPage_();
 		async::detach(s->flushOutPackets_());
 		return s;
 	}
 
+	helix::BorrowedDescriptor statusPageMemory() {
+		return statusPage_.getMemory();
+	}
+
 	static async::result<protocols::fs::Error> bind(void *object,
 			const char *creds,
 			const void *addrPtr, size_t addrLength) {
@@ -310,6 +315,7 @@ struct Tcp4Socket {
 			self->recvRing_.dequeueAdvance(chunk);
 			self->flushEvent_.raise();
 		}
+		self->updateStatusPage_();
 
 		struct sockaddr_in sa;
 		memset(&sa, 0, sizeof(struct sockaddr_in));
@@ -343,6 +349,7 @@ struct Tcp4Socket {
 			size_t chunk = std::min(space, size - progress);
 			self->sendRing_.enqueue(p + progress, chunk);
 			self->flushEvent_.raise();
+			self->updateStatusPage_();
 			progress += chunk;
 		}
 
@@ -377,16 +384,7 @@ struct Tcp4Socket {
 	static async::result<frg::expected<protocols::fs::Error, protocols::fs::PollStatusResult>>
 	pollStatus(void *object) {
 		auto self = static_cast<Tcp4Socket *>(object);
-
-		int active = 0;
-		if(self->recvRing_.availableToDequeue())
-			active |= EPOLLIN;
-		if(self->sendRing_.spaceForEnqueue())
-			active |= EPOLLOUT;
-		if(self->remoteClosed_)
-			active |= EPOLLHUP;
-
-		co_return protocols::fs::PollStatusResult{self->currentSeq_, active};
+		co_return protocols::fs::PollStatusResult{self->currentSeq_, self->activeEvents_()};
 	}
 
 	static async::result<void> setFileFlags(void *object, int flags) {
@@ -489,6 +487,24 @@ private:
 	uint64_t outSeq_ = 0;
 	uint64_t hupSeq_ = 1;
 	async::recurring_event pollEvent_;
+
+	// Mirrors currentSeq_ and activeEvents_() such that clients can poll without IPC.
+	protocols::fs::StatusPageProvider statusPage_;
+
+	int activeEvents_() {
+		int active = 0;
+		if(recvRing_.availableToDequeue())
+			active |= EPOLLIN;
+		if(sendRing_.spaceForEnqueue())
+			active |= EPOLLOUT;
+		if(remoteClosed_)
+			active |= EPOLLHUP;
+		return active;
+	}
+
+	void updateStatusPage_() {
+		statusPage_.update(currentSeq_, activeEvents_());
+	}
 };
 
 async::result<void> Tcp4Socket::flushOutPackets_() {
@@ -695,6 +711,7 @@ void Tcp4Socket::handleInPacket_(TcpPacket packet) {
 				inEvent_.raise();
 				flushEvent_.raise();
 				pollEvent_.raise();
+				updateStatusPage_();
 			}
 		}
 
@@ -708,6 +725,7 @@ void Tcp4Socket::handleInPacket_(TcpPacket packet) {
 				outSeq_ = ++currentSeq_;
 				settleEvent_.raise();
 				pollEvent_.raise();
+				updateStatusPage_();
 			}else{
 				std::cout << "netserver: Rejecting ack-number outside of valid window"
 						<< std::endl;
@@ -756,9 +774,11 @@ bool Tcp4::unbind(TcpEndpoint e) {
 	return binds.erase(e) != 0;
 }
 
-void Tcp4::serveSocket(int flags, helix::UniqueLane lane) {
+helix::UniqueDescriptor Tcp4::serveSocket(int flags, helix::UniqueLane lane) {
 	using protocols::fs::servePassthrough;
 	auto sock = Tcp4Socket::makeSocket(this, flags & SOCK_NONBLOCK);
+	auto statusPage = sock->statusPageMemory().dup();
 	async::detach(servePassthrough(std::move(lane), std::move(sock),
 			&Tcp4Socket::ops));
+	return statusPage;
 }
@@ -118,23 +118,42 @@ async::detached serve(helix::UniqueLane lane) {
 				continue;
 			}
 
+			helix::UniqueDescriptor statusPage;
 			auto err = ip4().serveSocket(std::move(local_lane),
-					req.type(), req.protocol(), req.flags());
+					req.type(), req.protocol(), req.flags(), statusPage);
 			if (err != managarm::fs::Errors::SUCCESS) {
 				co_await sendError(err);
 				continue;
 			}
 
+			if (!statusPage) {
+				auto ser = resp.SerializeAsString();
+				auto [send_resp, push_socket] =
+					co_await helix_ng::exchangeMsgs(
+						conversation,
+						helix_ng::sendBuffer(
+							ser.data(), ser.size()),
+						helix_ng::pushDescriptor(remote_lane)
+					);
+				HEL_CHECK(send_resp.error());
+				HEL_CHECK(push_socket.error());
+				continue;
+			}
+
+			resp.set_caps(managarm::fs::FileCaps::FC_STATUS_PAGE);
+
 			auto ser = resp.SerializeAsString();
-			auto [send_resp, push_socket] =
+			auto [send_resp, push_socket, push_page] =
 				co_await helix_ng::exchangeMsgs(
 					conversation,
 					helix_ng::sendBuffer(
 						ser.data(), ser.size()),
-					helix_ng::pushDescriptor(remote_lane)
+					helix_ng::pushDescriptor(remote_lane),
+					helix_ng::pushDescriptor(statusPage)
 				);
 			HEL_CHECK(send_resp.error());
 			HEL_CHECK(push_socket.error());
+			HEL_CHECK(push_page.error());
 		} else {
 			std::cout << "netserver: received unknown request type: "
 				<< (int32_t)req.req_type() << std::endl;
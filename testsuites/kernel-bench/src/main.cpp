@@ -1,8 +1,10 @@
 #include <math.h>
+#include <thread>
 
 #include <async/result.hpp>
 #include <async/algorithm.hpp>
 #include <helix/ipc.hpp>
+#include <helix/pool.hpp>
 
 namespace {
 
@@ -81,6 +83,50 @@ async::result<void> doAsyncNopBenchmark() {
 	bench.finalizeStatistics();
 }
 
+async::result<void> runPoolNops(IterationsPerSecondBenchmark &bench, uint64_t &total,
+		int &pending) {
+	uint64_t n = 0;
+	while(!bench.isRepetitionDone()) {
+		for(int i = 0; i < 100; ++i) {
+			auto result = co_await helix_ng::asyncNop();
+			HEL_CHECK(result.error());
+			++n;
+		}
+	}
+
+	__atomic_fetch_add(&total, n, __ATOMIC_RELAXED);
+	if(__atomic_sub_fetch(&pending, 1, __ATOMIC_RELEASE) == 0)
+		HEL_CHECK(helFutexWake(&pending));
+}
+
+// Measures how the throughput of async ops scales with the number of workers of a
+// helix::DispatcherPool. Each worker submits to (and drains) its own queue.
+void doPoolScalingBenchmark(unsigned int numWorkers) {
+	std::cout << "ipc ops, " << numWorkers << " pool worker(s)" << std::endl;
+
+	helix::DispatcherPool pool{numWorkers};
+
+	IterationsPerSecondBenchmark bench;
+	for(int k = 0; k < 5; ++k) {
+		uint64_t total = 0;
+		int pending = numWorkers;
+		bench.launchRepetition();
+		for(unsigned int i = 0; i < numWorkers; ++i)
+			pool.post(i, [&] {
+				async::detach(runPoolNops(bench, total, pending));
+			});
+
+		while(true) {
+			auto current = __atomic_load_n(&pending, __ATOMIC_ACQUIRE);
+			if(!current)
+				break;
+			HEL_CHECK(helFutexWait(&pending, current, -1));
+		}
+		bench.announceIterations(__atomic_load_n(&total, __ATOMIC_RELAXED));
+	}
+	bench.finalizeStatistics();
+}
+
 void doFutexBenchmark() {
 	std::cout << "futex waits" << std::endl;
 
@@ -100,6 +146,110 @@ void doFutexBenchmark() {
 	bench.finalizeStatistics();
 }
 
+// Measures the latency of switching between two threads on the same CPU.
+void doThreadPingPongBenchmark() {
+	std::cout << "thread ping-pongs" << std::endl;
+
+	// 0: main thread's turn, 1: partner's turn, 2: partner should exit.
+	int turn = 0;
+
+	auto pinThread = [] {
+		uint8_t mask = 1;
+		HEL_CHECK(helSetAffinity(kHelThisThread, &mask, 1));
+	};
+
+	auto waitWhile = [&] (int value) {
+		while(true) {
+			auto current = __atomic_load_n(&turn, __ATOMIC_ACQUIRE);
+			if(current != value)
+				return current;
+			HEL_CHECK(helFutexWait(&turn, value, -1));
+		}
+	};
+
+	auto pass = [&] (int value) {
+		__atomic_store_n(&turn, value, __ATOMIC_RELEASE);
+		HEL_CHECK(helFutexWake(&turn));
+	};
+
+	pinThread();
+	std::thread partner{[&] {
+		pinThread();
+		while(waitWhile(0) != 2)
+			pass(0);
+	}};
+
+	IterationsPerSecondBenchmark bench;
+	for(int k = 0; k < 5; ++k) {
+		uint64_t n = 0;
+		bench.launchRepetition();
+		while(!bench.isRepetitionDone()) {
+			for(int i = 0; i < 100; ++i) {
+				pass(1);
+				waitWhile(1);
+				++n;
+			}
+		}
+		bench.announceIterations(n);
+	}
+	bench.finalizeStatistics();
+
+	pass(2);
+	partner.join();
+}
+
+// Measures the round-trip latency of synchronous calls between two threads on the same CPU.
+void doSyncCallBenchmark() {
+	std::cout << "sync call round-trips" << std::endl;
+
+	HelHandle clientLane, serverLane;
+	HEL_CHECK(helCreateStream(&clientLane, &serverLane));
+
+	auto pinThread = [] {
+		uint8_t mask = 1;
+		HEL_CHECK(helSetAffinity(kHelThisThread, &mask, 1));
+	};
+
+	pinThread();
+	std::thread server{[&] {
+		pinThread();
+		char buffer[kHelSyncMessageSize];
+		size_t length = 0;
+		bool first = true;
+		while(true) {
+			auto error = helSyncReplyAndWait(serverLane, first ? nullptr : buffer, length,
+					buffer, sizeof(buffer), &length);
+			if(error == kHelErrEndOfLane)
+				break;
+			HEL_CHECK(error);
+			first = false;
+		}
+		HEL_CHECK(helCloseDescriptor(kHelThisUniverse, serverLane));
+	}};
+
+	IterationsPerSecondBenchmark bench;
+	for(int k = 0; k < 5; ++k) {
+		uint64_t n = 0;
+		bench.launchRepetition();
+		while(!bench.isRepetitionDone()) {
+			for(int i = 0; i < 100; ++i) {
+				uint64_t request = n;
+				uint64_t reply;
+				size_t length;
+				HEL_CHECK(helSyncCall(clientLane, &request, sizeof(request),
+						&reply, sizeof(reply), &length));
+				assert(length == sizeof(reply) && reply == request);
+				++n;
+			}
+		}
+		bench.announceIterations(n);
+	}
+	bench.finalizeStatistics();
+
+	HEL_CHECK(helCloseDescriptor(kHelThisUniverse, clientLane));
+	server.join();
+}
+
 void doAllocateBenchmark(size_t size) {
 	std::cout << "allocate memory, size = " << (size / (1024 * 1024)) << " MiB" << std::endl;
 
@@ -262,4 +412,10 @@ int main() {
 	async::run(doSendRecvBufferBenchmark(16 * 1024), helix::currentDispatcher);
 	async::run(doSendRecvBufferBenchmark(64 * 1024), helix::currentDispatcher);
 	async::run(doSendRecvBufferBenchmark(1024 * 1024), helix::currentDispatcher);
+	doPoolScalingBenchmark(1);
+	doPoolScalingBenchmark(2);
+	doPoolScalingBenchmark(4);
+	// These pin the main thread to CPU 0, hence they run last.
+	doThreadPingPongBenchmark();
+	doSyncCallBenchmark();
 }
@@ -2,6 +2,7 @@
 
 import argparse
 import bisect
+import os
 import struct
 import subprocess
 
@@ -12,80 +13,227 @@ parser.add_argument('--aggregate-by',
 	help="aggregate samples by source line of code or by symbol inside the binary")
 parser.add_argument('--line', action='store_true')
 parser.add_argument('--isn', action='store_true')
+parser.add_argument('--kernel', type=str,
+	default='pkg-builds/managarm-kernel/kernel/thor/thor',
+	help="path to the thor binary")
+parser.add_argument('--sysroot', type=str,
+	help="directory that server names are resolved against (e.g., the initrd root)")
+parser.add_argument('--binary', type=str, action='append', default=[],
+	metavar='NAME=PATH',
+	help="binary for the server NAME (takes precedence over --sysroot)")
+parser.add_argument('--pie-base', type=lambda x: int(x, 0), default=0x200000,
+	help="address at which posix loads PIE executables")
+parser.add_argument('--folded', action='store_true',
+	help="emit folded stacks (as consumed by flamegraph.pl) instead of a flat profile")
 
 args = parser.parse_args()
 
-profile = dict()
+# Record layouts; see kernel/thor/generic/thor-internal/profile.hpp.
+KIND_SAMPLE = 1
+KIND_SPACE_NAME = 2
+KIND_SPACE_RETIRED = 3
+sample_header = struct.Struct('<IIQQHHI')
+space_name_header = struct.Struct('<IIQ')
+space_retired_header = struct.Struct('<IIQ')
 
-if args.aggregate_by == 'symbol':
-	nm = subprocess.check_output(
-		[
-			'nm', '-nC',
-			'pkg-builds/managarm-kernel/kernel/thor/thor'
-		],
-		encoding='ascii');
-
-	sym_table = []
-	for line in nm.splitlines():
-		start, attr, symbol = line.split(' ', 2)
-		sym_table.append((int(start, 16), symbol))
-	sym_index = [e[0] for e in sym_table]
-else:
-	addr2line = subprocess.Popen(
-		[
-			'addr2line', '-sfC',
-			'-e', 'pkg-builds/managarm-kernel/kernel/thor/thor'
-		],
-		encoding='ascii',
-		stdin=subprocess.PIPE, stdout=subprocess.PIPE)
+class Symbolizer:
+	def __init__(self, path, bias=0):
+		self.path = path
+		self.bias = bias
+		nm = subprocess.check_output(['nm', '-nCS', path], encoding='ascii')
 
-n_user = 0
-n_kernel = 0
-n_resolved = 0
+		self.table = []
+		for line in nm.splitlines():
+			# Skip undefined symbols.
+			if line.startswith(' '):
+				continue
+			start, second, rest = line.split(' ', 2)
+			if len(second) == 1:
+				self.table.append((int(start, 16), None, rest))
+			else:
+				attr, symbol = rest.split(' ', 1)
+				self.table.append((int(start, 16), int(second, 16), symbol))
+		self.index = [e[0] for e in self.table]
+
+		self.addr2line = None
+
+	def symbol(self, ip):
+		ip -= self.bias
+		idx = bisect.bisect_right(self.index, ip)
+		if idx == 0:
+			return None
+		start, size, symbol = self.table[idx - 1]
+		assert ip >= start
+		if size is not None and ip >= start + size:
+			return None
+		return symbol
+
+	def source(self, ip):
+		if self.addr2line is None:
+			self.addr2line = subprocess.Popen(['addr2line', '-sfC', '-e', self.path],
+				encoding='ascii',
+				stdin=subprocess.PIPE, stdout=subprocess.PIPE)
+		self.addr2line.stdin.write(hex(ip - self.bias) + '\n')
+		self.addr2line.stdin.flush()
+		func = self.addr2line.stdout.readline().rstrip()
+		line = self.addr2line.stdout.readline().rstrip()
+		return func, line
+
+class UserSymbolizer(Symbolizer):
+	def __init__(self, path):
+		# Only the executable itself is symbolized. ld-init and shared libraries
+		# are mapped at addresses that are not recorded in the profile.
+		headers = subprocess.check_output(['readelf', '-hlW', path], encoding='ascii')
+		bias = 0
+		self.segments = []
+		for line in headers.splitlines():
+			fields = line.split()
+			if fields[:1] == ['Type:'] and fields[1] == 'DYN':
+				bias = args.pie_base
+			elif fields[:1] == ['LOAD']:
+				vaddr, memsz = int(fields[2], 16), int(fields[5], 16)
+				self.segments.append((vaddr, vaddr + memsz))
+		super().__init__(path, bias)
+
+	def contains(self, ip):
+		ip -= self.bias
+		return any(start <= ip < end for start, end in self.segments)
+
+kernel_symbolizer = Symbolizer(args.kernel)
+
+server_paths = dict()
+for spec in args.binary:
+	name, path = spec.split('=', 1)
+	server_paths[name] = path
+
+space_names = dict()
+symbolizers = dict()
+
+def user_symbolizer(space_id):
+	name = space_names.get(space_id)
+	if name is None:
+		return None
+	if name in symbolizers:
+		return symbolizers[name]
+
+	path = server_paths.get(name)
+	if path is None and args.sysroot:
+		candidate = os.path.join(args.sysroot, name.lstrip('/'))
+		if os.path.exists(candidate):
+			path = candidate
+	symbolizers[name] = UserSymbolizer(path) if path else None
+	return symbolizers[name]
+
+def space_label(space_id):
+	if not space_id:
+		return '[kernel]'
+	name = space_names.get(space_id)
+	if name is None:
+		return 'space-{:x}'.format(space_id)
+	return name
+
+def frame_label(symbolizer, ip, is_return):
+	if symbolizer is None:
+		return hex(ip)
+	# Return addresses point after the call instruction.
+	lookup_ip = ip - 1 if is_return else ip
+	if isinstance(symbolizer, UserSymbolizer) and not symbolizer.contains(lookup_ip):
+		return '[outside {}] {}'.format(os.path.basename(symbolizer.path), hex(ip))
+	symbol = symbolizer.symbol(lookup_ip)
+	if symbol is None:
+		return hex(ip)
+	return symbol
+
+samples = []
 
 with open(args.profile_path, 'rb') as f:
-	while True:
-		rec = f.read(8)
-		if not rec:
-			break
-		ip = struct.unpack('Q', rec)[0]
-		if ip < (1 << 63):
-			n_user += 1
-			continue
-		else:
-			n_kernel += 1
+	data = f.read()
 
-		if args.aggregate_by == 'symbol':
-			idx = bisect.bisect_left(sym_index, ip)
-			if idx == 0:
-				continue
-			start, symbol = sym_table[idx - 1];
-			assert ip >= start
+offset = 0
+while offset + 4 <= len(data):
+	kind = struct.unpack_from('<I', data, offset)[0]
+	if kind == KIND_SAMPLE:
+		(_, cpu, thread_id, space_id, n_kernel_frames, n_user_frames,
+			_) = sample_header.unpack_from(data, offset)
+		offset += sample_header.size
+		frames = struct.unpack_from('<{}Q'.format(n_kernel_frames + n_user_frames),
+			data, offset)
+		offset += 8 * (n_kernel_frames + n_user_frames)
+		samples.append((cpu, thread_id, space_id,
+			frames[:n_kernel_frames], frames[n_kernel_frames:]))
+	elif kind == KIND_SPACE_NAME:
+		_, length, space_id = space_name_header.unpack_from(data, offset)
+		offset += space_name_header.size
+		space_names[space_id] = data[offset:offset + length].decode('ascii', 'replace')
+		offset += length
+	elif kind == KIND_SPACE_RETIRED:
+		# Space IDs are never reused. Keep the name since samples
+		# that were still queued on other CPUs can follow this record.
+		offset += space_retired_header.size
+	else:
+		raise RuntimeError('Unexpected record kind {} at offset {}'.format(kind, offset))
 
-			loc = symbol, 0
-		else:
-			addr2line.stdin.write(hex(ip) + '\n')
-			addr2line.stdin.flush()
-			func = addr2line.stdout.readline().rstrip()
-			line = addr2line.stdout.readline().rstrip()
-			if args.line:
-				loc = (func, line)
-			elif args.isn:
-				loc = (func, line.split(':')[0] + ':' + hex(ip))
-			else:
-				loc = (func, line.split(':')[0])
+if args.folded:
+	stacks = dict()
+	for cpu, thread_id, space_id, kernel_frames, user_frames in samples:
+		chain = [space_label(space_id)]
+		symbolizer = user_symbolizer(space_id)
+		for i, ip in reversed(list(enumerate(user_frames))):
+			chain.append(frame_label(symbolizer, ip, i > 0))
+		for i, ip in reversed(list(enumerate(kernel_frames))):
+			chain.append(frame_label(kernel_symbolizer, ip, i > 0) + '_[k]')
+		key = ';'.join(chain)
+		stacks[key] = stacks.get(key, 0) + 1
+	for key, count in stacks.items():
+		print(key, count)
+	raise SystemExit(0)
+
+profile = dict()
+user_profile = dict()
+
+n_user = 0
+n_kernel = 0
+n_resolved = 0
+
+for cpu, thread_id, space_id, kernel_frames, user_frames in samples:
+	if user_frames:
+		n_user += 1
+		loc = (space_label(space_id), frame_label(user_symbolizer(space_id),
+			user_frames[0], False))
+		user_profile[loc] = user_profile.get(loc, 0) + 1
+		continue
+	n_kernel += 1
 
-		if loc in profile:
-			profile[loc] += 1
+	ip = kernel_frames[0]
+	if args.aggregate_by == 'symbol':
+		symbol = kernel_symbolizer.symbol(ip)
+		if symbol is None:
+			continue
+		loc = symbol, 0
+	else:
+		func, line = kernel_symbolizer.source(ip)
+		if args.line:
+			loc = (func, line)
+		elif args.isn:
+			loc = (func, line.split(':')[0] + ':' + hex(ip))
 		else:
-			profile[loc] = 1
-		n_resolved += 1
+			loc = (func, line.split(':')[0])
 
-n_all = n_user + n_kernel
+	profile[loc] = profile.get(loc, 0) + 1
+	n_resolved += 1
 
 out = sorted(profile.keys(), key=lambda loc: profile[loc])
 for loc in out:
 	print("{:.2f}% ({} samples) in:".format(profile[loc]/n_kernel*100, profile[loc]))
 	print("    {} in {}".format(loc[0], loc[1]))
-print("{} (= {:.2f}% of all samples) in the kernel".format(n_kernel, n_kernel/(n_user + n_kernel)*100))
-print("{:.2f}% of all kernel samples could be resolved".format(n_resolved/n_kernel*100))
+
+out = sorted(user_profile.keys(), key=lambda loc: user_profile[loc])
+for loc in out:
+	print("{:.2f}% ({} samples) in user space:".format(user_profile[loc]/n_user*100,
+		user_profile[loc]))
+	print("    {} in {}".format(loc[1], loc[0]))
+
+n_all = n_user + n_kernel
+print("{} (= {:.2f}% of all samples) in the kernel".format(n_kernel, n_kernel/n_all*100))
+if n_kernel:
+	print("{:.2f}% of all kernel samples could be resolved".format(n_resolved/n_kernel*100))